@@ -24,6 +24,7 @@ void hash_benchmarking();
 void blake2_benchmarking();
 void bls_benchmarking();
 void merkle_benchmarking();
+void write_queue_benchmarking();
 
 void benchmarking(const std::string& name, const std::function<void()>& func, std::optional<size_t> num_runs = {});
 
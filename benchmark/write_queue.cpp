@@ -0,0 +1,80 @@
+#include <eosio/net_plugin/mpsc_queue.hpp>
+
+#include <benchmark.hpp>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace eosio::benchmark {
+
+namespace {
+
+constexpr uint32_t items_per_producer = 10000;
+
+// write queue of a net_plugin connection before it was made lock free
+template<typename T>
+class locked_queue {
+public:
+   void push(T v) {
+      std::lock_guard g(_mtx);
+      _queue.push_back(std::move(v));
+   }
+   template<typename F>
+   size_t consume_all(F&& f) {
+      std::lock_guard g(_mtx);
+      size_t n = _queue.size();
+      while (!_queue.empty()) {
+         f(std::move(_queue.front()));
+         _queue.pop_front();
+      }
+      return n;
+   }
+private:
+   std::mutex    _mtx;
+   std::deque<T> _queue;
+};
+
+// num_producers threads each enqueue items_per_producer shared buffers, while the connection strand drains them
+template<typename Queue>
+void enqueue_from_producers(uint32_t num_producers) {
+   using buffer_ptr = std::shared_ptr<const std::vector<char>>;
+   const auto buff = std::make_shared<const std::vector<char>>(256);
+   Queue queue;
+   std::atomic<bool> start{false};
+   std::vector<std::thread> producers;
+   for (uint32_t p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&]() {
+         while (!start.load(std::memory_order_acquire)) {}
+         for (uint32_t i = 0; i < items_per_producer; ++i)
+            queue.push(buff);
+      });
+   }
+   start.store(true, std::memory_order_release);
+   const size_t total = size_t{num_producers} * items_per_producer;
+   size_t consumed = 0;
+   while (consumed < total) {
+      const size_t n = queue.consume_all([](buffer_ptr&&) {});
+      if (n == 0)
+         std::this_thread::yield();
+      consumed += n;
+   }
+   for (auto& t : producers)
+      t.join();
+}
+
+} // anonymous namespace
+
+void write_queue_benchmarking() {
+   using buffer_ptr = std::shared_ptr<const std::vector<char>>;
+   const uint32_t num_runs = std::min(get_num_runs(), 100u);
+   for (uint32_t n : {1u, 2u, 4u, 8u}) {
+      const auto suffix = std::to_string(n) + " producers x " + std::to_string(items_per_producer) + ": ";
+      benchmarking("mutex deque, " + suffix, [&]() { enqueue_from_producers<locked_queue<buffer_ptr>>(n); }, num_runs);
+      benchmarking("mpsc queue,  " + suffix, [&]() { enqueue_from_producers<mpsc_queue<buffer_ptr>>(n); }, num_runs);
+   }
+}
+
+} // benchmark
@@ -10,6 +10,7 @@
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/deep_mind.hpp>
+#include <eosio/chain/contract_profiler.hpp>
 #include <boost/container/flat_set.hpp>
 
 using boost::container::flat_set;
@@ -63,6 +64,7 @@ apply_context::apply_context(controller& con, transaction_context& trx_ctx, uint
 void apply_context::exec_one()
 {
    auto start = fc::time_point::now();
+   control.get_mutable_contract_profiler().begin_action();
 
    digest_type act_digest;
 
@@ -207,6 +209,7 @@ void apply_context::finalize_trace( action_trace& trace, const fc::time_point& s
    _pending_console_output.clear();
 
    trace.elapsed = fc::time_point::now() - start;
+   control.get_mutable_contract_profiler().end_action( receiver, act->name, trace.elapsed );
 }
 
 void apply_context::exec()
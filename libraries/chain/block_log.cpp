@@ -6,6 +6,7 @@
 #include <eosio/chain/log_index.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/io/raw.hpp>
+#include <algorithm>
 #include <mutex>
 #include <string>
 
@@ -197,6 +198,78 @@ namespace eosio { namespace chain {
          return bh;
       }
 
+      /// verify that the `size` bytes at data are a serialized block numbered expect_block_num
+      void check_serialized_block_num(const char* data, uint64_t size, uint32_t expect_block_num) {
+         // the block number is the big endian block number in the low 4 bytes of previous + 1, see block_num_at()
+         constexpr uint64_t blknum_offset = 14;
+         EOS_ASSERT(size >= blknum_offset + sizeof(uint32_t), block_log_exception,
+                    "Block ${num} in block log is too small: ${s} bytes", ("num", expect_block_num)("s", size));
+
+         uint32_t prev_block_num;
+         memcpy(&prev_block_num, data + blknum_offset, sizeof(prev_block_num));
+         EOS_ASSERT(fc::endian_reverse_u32(prev_block_num) + 1 == expect_block_num, block_log_exception,
+                    "Wrong block was read from block log.",
+                    ("returned", fc::endian_reverse_u32(prev_block_num) + 1)("expected", expect_block_num));
+      }
+
+      /// append the `size` bytes of the serialized block at the current position of ds to dest, without unpacking it
+      template <typename Stream>
+      void read_serialized_block(Stream&& ds, uint64_t size, uint32_t expect_block_num, std::vector<char>& dest) {
+         const size_t start = dest.size();
+         dest.resize(start + size);
+         ds.read(dest.data() + start, size);
+         check_serialized_block_num(dest.data() + start, size, expect_block_num);
+      }
+
+      /// consecutive serialized blocks read from the log with a single read, see block_log::read_serialized_block_range
+      struct serialized_block_chunk {
+         static constexpr uint64_t max_bytes  = 8 * 1024 * 1024;
+         static constexpr uint32_t max_blocks = 16 * 1024;
+
+         std::vector<char>     data;    ///< blocks as stored in the log, each followed by its position trailer
+         std::vector<uint64_t> offsets; ///< offset of each block in data, followed by data.size()
+
+         uint32_t num_blocks() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+         std::span<const char> block(uint32_t i) const {
+            return { data.data() + offsets[i], offsets[i + 1] - offsets[i] - sizeof(uint64_t) };
+         }
+      };
+
+      /**
+       * Read the blocks starting at positions[0], the first one numbered first_block_num, into chunk with a single read.
+       * positions holds the position of each block followed by the position following the last one. Only as many blocks
+       * as fit in serialized_block_chunk::max_bytes are read, but at least one. The kernel is asked to read ahead as much
+       * again, so that the next chunk is already cached by the time it is read.
+       */
+      void read_block_chunk(fc::cfile& file, uint32_t first_block_num, std::vector<uint64_t>& positions,
+                            serialized_block_chunk& chunk) {
+         size_t n = 1;
+         while (n + 1 < positions.size() && positions[n + 1] - positions[0] <= serialized_block_chunk::max_bytes)
+            ++n;
+         positions.resize(n + 1);
+
+         const uint64_t begin = positions.front();
+         const uint64_t end   = positions.back();
+         chunk.offsets.clear();
+         for (size_t i = 0; i < n; ++i) {
+            EOS_ASSERT(positions[i + 1] >= positions[i] + sizeof(uint64_t), block_log_exception,
+                       "Invalid position ${e} following block ${num} at ${p}",
+                       ("e", positions[i + 1])("num", first_block_num + i)("p", positions[i]));
+            chunk.offsets.push_back(positions[i] - begin);
+         }
+         chunk.offsets.push_back(end - begin);
+
+         file.advise_sequential_read(begin, end + (end - begin));
+         chunk.data.resize(end - begin);
+         file.seek(begin);
+         file.read(chunk.data.data(), chunk.data.size());
+
+         for (uint32_t i = 0; i < n; ++i) {
+            auto b = chunk.block(i);
+            check_serialized_block_num(b.data(), b.size(), first_block_num + i);
+         }
+      }
+
       /// Provide the read only view of the blocks.log file
       class block_log_data : public chain::log_data_base<block_log_data> {
          block_log_preamble preamble;
@@ -486,6 +559,9 @@ namespace eosio { namespace chain {
 
          virtual signed_block_ptr                   read_block_by_num(uint32_t block_num)        = 0;
          virtual std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num) = 0;
+         virtual bool append_serialized_block_by_num(uint32_t block_num, std::vector<char>& dest)   = 0;
+         virtual bool read_serialized_block_chunk(uint32_t block_num, uint32_t end_block_num,
+                                                  serialized_block_chunk& chunk)                     = 0;
 
          virtual uint32_t version() const = 0;
 
@@ -519,6 +595,10 @@ namespace eosio { namespace chain {
 
          signed_block_ptr read_block_by_num(uint32_t block_num) final { return {}; };
          std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num) final { return {}; };
+         bool append_serialized_block_by_num(uint32_t block_num, std::vector<char>& dest) final { return false; }
+         bool read_serialized_block_chunk(uint32_t block_num, uint32_t end_block_num, serialized_block_chunk& chunk) final {
+            return false;
+         }
 
          uint32_t         version() const final { return 0; }
          signed_block_ptr read_head() final { return {}; };
@@ -530,6 +610,12 @@ namespace eosio { namespace chain {
          block_log_preamble        preamble;
          bool                      genesis_written_to_block_log = false;
 
+         // block positions are looked up in a read only mapping of blocks.index as of the last remap_index(), followed
+         // by the positions appended since, so a lookup never seeks or reads index_file
+         static constexpr uint32_t index_tail_max_blocks = 64 * 1024;
+         block_log_index           index_map;
+         std::vector<uint64_t>     index_tail;
+
          basic_block_log() = default;
 
          explicit basic_block_log(std::filesystem::path log_dir) { open(log_dir); }
@@ -548,6 +634,7 @@ namespace eosio { namespace chain {
                update_head(read_head());
                if (head) {
                   index_file.open(fc::cfile::update_rw_mode);
+                  remap_index();
                   vacuum(first_block_num_from_pruned_log(), preamble.first_block_num);
                } else {
                   std::filesystem::resize_file(index_file.get_file_path(), 0);
@@ -563,6 +650,28 @@ namespace eosio { namespace chain {
          virtual void             post_append(uint64_t pos) {}
          virtual signed_block_ptr retry_read_block_by_num(uint32_t block_num) { return {}; }
          virtual std::optional<signed_block_header> retry_read_block_header_by_num(uint32_t block_num) { return {}; }
+         virtual bool retry_append_serialized_block_by_num(uint32_t block_num, std::vector<char>& dest) { return false; }
+         virtual bool retry_read_serialized_block_chunk(uint32_t block_num, uint32_t end_block_num,
+                                                        serialized_block_chunk& chunk) { return false; }
+
+         /// must be called whenever blocks.index is changed other than by append()
+         void remap_index() {
+            if (index_file.is_open())
+               index_file.flush();
+            index_tail.clear();
+            index_map.open(index_file.get_file_path());
+         }
+
+         /// position of the n-th block of blocks.index
+         uint64_t index_position(uint32_t n) const {
+            const uint32_t mapped = index_map.num_blocks();
+            if (n < mapped)
+               return index_map.nth_block_position(n);
+            EOS_ASSERT(n - mapped < index_tail.size(), block_log_exception,
+                       "Block ${n} is past the ${count} blocks of ${index_file}",
+                       ("n", n)("count", mapped + index_tail.size())("index_file", index_file.get_file_path().string()));
+            return index_tail[n - mapped];
+         }
 
          void append(const signed_block_ptr& b, const block_id_type& id,
                      const std::vector<char>& packed_block) override {
@@ -585,6 +694,9 @@ namespace eosio { namespace chain {
                block_file.write((char*)&pos, sizeof(pos));
                index_file.write((char*)&pos, sizeof(pos));
                index_file.flush();
+               index_tail.push_back(pos);
+               if (index_tail.size() >= index_tail_max_blocks)
+                  remap_index();
                update_head(b, id);
 
                post_append(pos);
@@ -597,10 +709,7 @@ namespace eosio { namespace chain {
             if (!(head && block_num <= block_header::num_from_id(head->id) &&
                   block_num >= working_block_file_first_block_num()))
                return block_log::npos;
-            index_file.seek(sizeof(uint64_t) * (block_num - index_first_block_num()));
-            uint64_t pos;
-            index_file.read((char*)&pos, sizeof(pos));
-            return pos;
+            return index_position(block_num - index_first_block_num());
          }
 
          signed_block_ptr read_block_by_num(uint32_t block_num) final {
@@ -627,6 +736,59 @@ namespace eosio { namespace chain {
             FC_LOG_AND_RETHROW()
          }
 
+         bool append_serialized_block_by_num(uint32_t block_num, std::vector<char>& dest) final {
+            try {
+               uint64_t pos = get_block_pos(block_num);
+               if (pos != block_log::npos) {
+                  // a block ends where the next one starts, less the position trailer that follows every block
+                  uint64_t end;
+                  if (block_num < block_header::num_from_id(head->id)) {
+                     end = get_block_pos(block_num + 1);
+                  } else {
+                     block_file.seek_end(0);
+                     end = block_file.tellp();
+                     if (preamble.is_currently_pruned())
+                        end -= sizeof(uint32_t);
+                  }
+                  EOS_ASSERT(end >= pos + sizeof(uint64_t), block_log_exception,
+                             "Invalid position ${e} following block ${num} at ${p}", ("e", end)("num", block_num)("p", pos));
+                  block_file.seek(pos);
+                  read_serialized_block(block_file, end - pos - sizeof(uint64_t), block_num, dest);
+                  return true;
+               }
+               return retry_append_serialized_block_by_num(block_num, dest);
+            }
+            FC_LOG_AND_RETHROW()
+         }
+
+         bool read_serialized_block_chunk(uint32_t block_num, uint32_t end_block_num, serialized_block_chunk& chunk) final {
+            try {
+               if (get_block_pos(block_num) == block_log::npos)
+                  return retry_read_serialized_block_chunk(block_num, end_block_num, chunk);
+
+               const uint32_t head_num = block_header::num_from_id(head->id);
+               const uint32_t count    = std::min({end_block_num - block_num, head_num - block_num + 1,
+                                                   serialized_block_chunk::max_blocks});
+               // positions of the blocks, and of the block following them unless the chunk ends at the head block
+               const bool     ends_at_head = block_num + count > head_num;
+               const uint32_t first        = block_num - index_first_block_num();
+               std::vector<uint64_t> positions;
+               positions.reserve(count + 1);
+               for (uint32_t i = 0; i < (ends_at_head ? count : count + 1); ++i)
+                  positions.push_back(index_position(first + i));
+               if (ends_at_head) {
+                  block_file.seek_end(0);
+                  uint64_t end = block_file.tellp();
+                  if (preamble.is_currently_pruned())
+                     end -= sizeof(uint32_t);
+                  positions.push_back(end);
+               }
+               read_block_chunk(block_file, block_num, positions, chunk);
+               return true;
+            }
+            FC_LOG_AND_RETHROW()
+         }
+
          void open(const std::filesystem::path& data_dir) {
 
             if (!std::filesystem::is_directory(data_dir))
@@ -691,6 +853,7 @@ namespace eosio { namespace chain {
                }
                log_data.close();
 
+               remap_index();
                transform_block_log();
 
             } else if (index_size) {
@@ -702,6 +865,7 @@ namespace eosio { namespace chain {
                block_file.open(fc::cfile::update_rw_mode);
             if (!index_file.is_open())
                index_file.open(fc::cfile::update_rw_mode);
+            remap_index();
             if (log_size && !head)
                update_head(read_head());
          }
@@ -728,7 +892,7 @@ namespace eosio { namespace chain {
             static_assert(block_log::max_supported_version > 0, "a version number of zero is not supported");
 
             index_file.open(fc::cfile::truncate_rw_mode);
-            index_file.flush();
+            remap_index();
          }
 
          void reset(const genesis_state& gs, const signed_block_ptr& first_block) override {
@@ -853,6 +1017,7 @@ namespace eosio { namespace chain {
                }
             }
             std::filesystem::resize_file(index_file.get_file_path(), num_blocks_in_log * sizeof(uint64_t));
+            remap_index();
 
             preamble.first_block_num = first_block_num;
          }
@@ -1006,6 +1171,7 @@ namespace eosio { namespace chain {
 
             block_file.set_file_path(block_file_path);
             index_file.set_file_path(index_file_path);
+            remap_index();
 
             preamble.ver             = block_log::max_supported_version;
             preamble.chain_context   = preamble.chain_id();
@@ -1039,6 +1205,36 @@ namespace eosio { namespace chain {
             return {};
          }
 
+         bool retry_append_serialized_block_by_num(uint32_t block_num, std::vector<char>& dest) final {
+            auto pos = catalog.get_block_position(block_num);
+            if (!pos)
+               return false;
+            // get_block_position() opened the retained log containing block_num
+            const uint32_t n   = block_num - catalog.log_data.first_block_num();
+            const uint64_t end = n + 1 < catalog.log_index.num_blocks() ? catalog.log_index.nth_block_position(n + 1)
+                                                                        : catalog.log_data.end_of_block_position();
+            EOS_ASSERT(end >= *pos + sizeof(uint64_t), block_log_exception,
+                       "Invalid position ${e} following block ${num} at ${p}", ("e", end)("num", block_num)("p", *pos));
+            read_serialized_block(catalog.log_data.ro_stream_at(*pos), end - *pos - sizeof(uint64_t), block_num, dest);
+            return true;
+         }
+
+         bool retry_read_serialized_block_chunk(uint32_t block_num, uint32_t end_block_num,
+                                                serialized_block_chunk& chunk) final {
+            auto pos = catalog.get_block_position(block_num);
+            if (!pos)
+               return false;
+            // get_block_position() opened the retained log containing block_num, a chunk does not extend past it
+            const uint32_t n          = block_num - catalog.log_data.first_block_num();
+            const uint32_t num_blocks = catalog.log_index.num_blocks();
+            const uint32_t count      = std::min({end_block_num - block_num, num_blocks - n, serialized_block_chunk::max_blocks});
+            std::vector<uint64_t> positions = catalog.log_index.block_positions(n, n + count < num_blocks ? count + 1 : count);
+            if (positions.size() == count)
+               positions.push_back(catalog.log_data.end_of_block_position());
+            read_block_chunk(catalog.log_data.ro_stream_at(*pos), block_num, positions, chunk);
+            return true;
+         }
+
          void reset(const chain_id_type& chain_id, uint32_t first_block_num) final {
 
             EOS_ASSERT(catalog.verifier.chain_id.empty() || chain_id == catalog.verifier.chain_id, block_log_exception,
@@ -1235,6 +1431,31 @@ namespace eosio { namespace chain {
       return my->read_block_header_by_num(block_num);
    }
 
+   bool block_log::append_serialized_block_by_num(uint32_t block_num, std::vector<char>& dest) const {
+      std::lock_guard g(my->mtx);
+      return my->append_serialized_block_by_num(block_num, dest);
+   }
+
+   uint32_t block_log::read_serialized_block_range(
+         uint32_t start_block_num, uint32_t end_block_num,
+         const std::function<bool(uint32_t block_num, std::span<const char> block)>& f) const {
+      serialized_block_chunk chunk;
+      uint32_t block_num = start_block_num;
+      while (block_num < end_block_num) {
+         {
+            std::lock_guard g(my->mtx);
+            if (!my->read_serialized_block_chunk(block_num, end_block_num, chunk))
+               break;
+         }
+         // the log is not locked while f processes the chunk
+         for (uint32_t i = 0; i < chunk.num_blocks(); ++i) {
+            if (!f(block_num++, chunk.block(i)))
+               return block_num - start_block_num;
+         }
+      }
+      return block_num - start_block_num;
+   }
+
    std::optional<block_id_type> block_log::read_block_id_by_num(uint32_t block_num) const {
       // read_block_header_by_num acquires mutex
       auto bh = read_block_header_by_num(block_num);
@@ -11,23 +11,33 @@ namespace eosio::chain {
 
 namespace detail {
 
-   inline void verify_signee(const signature_type& producer_signature, const block_id_type& block_id,
-                             const std::vector<signature_type>& additional_signatures,
-                             const block_signing_authority& valid_block_signing_authority)
+   inline std::vector<public_key_type> recover_signee_keys(const signature_type& producer_signature, const block_id_type& block_id,
+                                                           const std::vector<signature_type>& additional_signatures)
    {
+      std::vector<public_key_type> keys;
+      keys.reserve(1 + additional_signatures.size());
+      keys.emplace_back(producer_signature, block_id, true);
+      for (const auto& s : additional_signatures)
+         keys.emplace_back(s, block_id, true);
+      return keys;
+   }
+
+   // recovered_keys: producer signature key followed by the additional signature keys
+   inline void verify_signee_keys(const std::vector<public_key_type>& recovered_keys,
+                                  const block_signing_authority& valid_block_signing_authority)
+   {
+      assert(!recovered_keys.empty());
       auto num_keys_in_authority = std::visit([](const auto& a) { return a.keys.size(); },
                                               valid_block_signing_authority);
-      EOS_ASSERT(1 + additional_signatures.size() <= num_keys_in_authority, wrong_signing_key,
+      EOS_ASSERT(recovered_keys.size() <= num_keys_in_authority, wrong_signing_key,
                  "number of block signatures (${num_block_signatures}) exceeds number of keys (${num_keys}) in block"
                  " signing authority: ${authority}",
-                 ("num_block_signatures", 1 + additional_signatures.size())("num_keys", num_keys_in_authority)
+                 ("num_block_signatures", recovered_keys.size())("num_keys", num_keys_in_authority)
                  ("authority", valid_block_signing_authority));
 
       std::set<public_key_type> keys;
-      keys.emplace(fc::crypto::public_key(producer_signature, block_id, true));
-
-      for (const auto& s : additional_signatures) {
-         auto res = keys.emplace(s, block_id, true);
+      for (const auto& k : recovered_keys) {
+         auto res = keys.emplace(k);
          EOS_ASSERT(res.second, wrong_signing_key, "block signed by same key twice: ${key}", ("key", *res.first));
       }
 
@@ -46,6 +56,22 @@ namespace detail {
                  ("signing_keys", keys)("authority", valid_block_signing_authority));
    }
 
+   inline void verify_signee(const signature_type& producer_signature, const block_id_type& block_id,
+                             const std::vector<signature_type>& additional_signatures,
+                             const block_signing_authority& valid_block_signing_authority)
+   {
+      auto num_keys_in_authority = std::visit([](const auto& a) { return a.keys.size(); },
+                                              valid_block_signing_authority);
+      // checked before recovering any keys, recovery is the expensive part
+      EOS_ASSERT(1 + additional_signatures.size() <= num_keys_in_authority, wrong_signing_key,
+                 "number of block signatures (${num_block_signatures}) exceeds number of keys (${num_keys}) in block"
+                 " signing authority: ${authority}",
+                 ("num_block_signatures", 1 + additional_signatures.size())("num_keys", num_keys_in_authority)
+                 ("authority", valid_block_signing_authority));
+
+      verify_signee_keys(recover_signee_keys(producer_signature, block_id, additional_signatures), valid_block_signing_authority);
+   }
+
    // EOS_ASSERTs if signature does not validate
    inline bool verify_block_sig(const block_header_state& prev, const signed_block_ptr& block, bool skip_validate_signee) {
       if (!skip_validate_signee) {
@@ -85,6 +111,15 @@ namespace detail {
 
 using namespace eosio::chain::detail;
 
+std::vector<public_key_type> block_state::recover_signing_keys(const signed_block_ptr& b, const block_id_type& id) {
+   return recover_signee_keys(b->producer_signature, id, extract_additional_signatures(b));
+}
+
+void block_state::verify_signing_keys(const block_header_state& prev, const signed_block_ptr& b,
+                                      const std::vector<public_key_type>& keys) {
+   verify_signee_keys(keys, prev.get_producer_for_block_at(b->timestamp).authority);
+}
+
 // ASSUMPTION FROM controller_impl::apply_block = all untrusted blocks will have their signatures pre-validated here
 block_state::block_state(const block_header_state& prev, signed_block_ptr b, const protocol_feature_set& pfs,
                          const validator_t& validator, bool skip_validate_signee)
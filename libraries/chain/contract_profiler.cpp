@@ -0,0 +1,91 @@
+#include <eosio/chain/contract_profiler.hpp>
+
+namespace eosio { namespace chain {
+
+namespace {
+   std::atomic<uint64_t> next_profiler_id{1};
+
+   // only the thread owning the counter writes it, so no read-modify-write is needed
+   void add(std::atomic<uint64_t>& counter, uint64_t v) {
+      counter.store(counter.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+   }
+}
+
+const char* to_string(intrinsic_category c) {
+   switch(c) {
+      case intrinsic_category::database:      return "database";
+      case intrinsic_category::crypto:        return "crypto";
+      case intrinsic_category::inline_action: return "inline_action";
+      case intrinsic_category::count:         break;
+   }
+   return "unknown";
+}
+
+contract_profiler::contract_profiler(uint32_t intrinsic_sample_interval, size_t max_actions_per_thread)
+   : _id(next_profiler_id.fetch_add(1, std::memory_order_relaxed))
+   , _intrinsic_sample_interval(intrinsic_sample_interval)
+   , _max_actions_per_thread(max_actions_per_thread) {}
+
+contract_profiler::~contract_profiler() = default;
+
+contract_profiler::thread_counters& contract_profiler::counters_of_this_thread() {
+   if(_thread.profiler_id != _id) {
+      std::lock_guard g(_threads_mtx);
+      auto& counters = _threads[std::this_thread::get_id()];
+      if(!counters)
+         counters = std::make_unique<thread_counters>();
+      _thread.profiler_id = _id;
+      _thread.counters = counters.get();
+   }
+   return *_thread.counters;
+}
+
+void contract_profiler::end_action(account_name receiver, action_name act, fc::microseconds elapsed) {
+   thread_counters& tc = counters_of_this_thread();
+   std::pair key{receiver, act};
+   auto it = tc.actions.find(key);
+   if(it == tc.actions.end()) {
+      if(tc.actions.size() >= _max_actions_per_thread)
+         key = {};
+      std::lock_guard g(tc.mtx);
+      it = tc.actions.try_emplace(key).first;
+   }
+
+   action_counters& c = it->second;
+   const uint64_t us = elapsed.count() > 0 ? elapsed.count() : 0;
+   add(c.executions, 1);
+   add(c.wall_us, us);
+   if(us > c.max_wall_us.load(std::memory_order_relaxed))
+      c.max_wall_us.store(us, std::memory_order_relaxed);
+   if(_thread.sampling) {
+      for(size_t i = 0; i < num_intrinsic_categories; ++i)
+         add(c.intrinsic_ns[i], _thread.action_intrinsic_ns[i] * _intrinsic_sample_interval);
+      _thread.sampling = false;
+   }
+}
+
+std::vector<contract_profiler::action_profile> contract_profiler::actions() const {
+   std::unordered_map<std::pair<account_name, action_name>, action_profile, action_key_hash> merged;
+   std::lock_guard g(_threads_mtx);
+   for(const auto& [id, tc] : _threads) {
+      std::lock_guard tg(tc->mtx);
+      for(const auto& [key, c] : tc->actions) {
+         action_profile& p = merged[key];
+         p.receiver = key.first;
+         p.action = key.second;
+         p.executions += c.executions.load(std::memory_order_relaxed);
+         p.wall_us += c.wall_us.load(std::memory_order_relaxed);
+         p.max_wall_us = std::max(p.max_wall_us, c.max_wall_us.load(std::memory_order_relaxed));
+         for(size_t i = 0; i < num_intrinsic_categories; ++i)
+            p.intrinsic_us[i] += c.intrinsic_ns[i].load(std::memory_order_relaxed) / 1000;
+      }
+   }
+
+   std::vector<action_profile> result;
+   result.reserve(merged.size());
+   for(const auto& [key, p] : merged)
+      result.push_back(p);
+   return result;
+}
+
+} } // eosio::chain
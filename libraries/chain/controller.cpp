@@ -22,6 +22,7 @@
 #include <eosio/chain/authorization_manager.hpp>
 #include <eosio/chain/resource_limits.hpp>
 #include <eosio/chain/subjective_billing.hpp>
+#include <eosio/chain/contract_profiler.hpp>
 #include <eosio/chain/chain_snapshot.hpp>
 #include <eosio/chain/snapshot_detail.hpp>
 #include <eosio/chain/thread_utils.hpp>
@@ -43,10 +44,16 @@
 #include <bls12-381/bls12-381.hpp>
 
 #include <future>
+#include <mutex>
 #include <new>
 #include <shared_mutex>
 #include <utility>
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 namespace eosio::chain {
 
 using resource_limits::resource_limits_manager;
@@ -945,6 +952,7 @@ struct controller_impl {
    fork_database                   fork_db;
    resource_limits_manager         resource_limits;
    subjective_billing              subjective_bill;
+   contract_profiler               profiler;
    authorization_manager           authorization;
    protocol_feature_manager        protocol_features;
    controller::config              conf;
@@ -968,6 +976,16 @@ struct controller_impl {
    my_finalizers_t                 my_finalizers;
    std::atomic<bool>               writing_snapshot = false;
 
+   // header validation work done by prevalidate_block() ahead of create_block_state_i()
+   struct prevalidated_block {
+      signed_block_ptr                            block;        // only valid for this instance of the block
+      checksum256_type                            trx_mroot;
+      std::optional<std::vector<public_key_type>> signing_keys; // proper savanna blocks only
+   };
+   static constexpr size_t                     max_prevalidated_blocks = 1024;
+   std::mutex                                  prevalidated_blocks_mtx;
+   std::map<block_id_type, prevalidated_block> prevalidated_blocks; // ordered by block number
+
    thread_local static platform_timer timer; // a copy for main thread and each read-only thread
 #if defined(EOSIO_EOS_VM_RUNTIME_ENABLED) || defined(EOSIO_EOS_VM_JIT_RUNTIME_ENABLED)
    thread_local static vm::wasm_allocator wasm_alloc; // a copy for main thread and each read-only thread
@@ -1220,6 +1238,7 @@ struct controller_impl {
     blog( cfg.blocks_dir, cfg.blog ),
     fork_db(cfg.blocks_dir / config::reversible_blocks_dir_name),
     resource_limits( db, [&s](bool is_trx_transient) { return s.get_deep_mind_logger(is_trx_transient); }),
+    profiler( cfg.contract_profile_sample_interval ),
     authorization( s, db ),
     protocol_features( std::move(pfs), [&s](bool is_trx_transient) { return s.get_deep_mind_logger(is_trx_transient); } ),
     conf( cfg ),
@@ -1227,7 +1246,7 @@ struct controller_impl {
     read_mode( cfg.read_mode ),
     thread_pool(),
     my_finalizers(cfg.finalizers_dir / config::safety_filename),
-    wasmif( conf.wasm_runtime, conf.eosvmoc_tierup, db, conf.state_dir, conf.eosvmoc_config, !conf.profile_accounts.empty() )
+    wasmif( conf.wasm_runtime, conf.eosvmoc_tierup, db, conf.state_dir, conf.eosvmoc_config, !conf.profile_accounts.empty(), conf.wasm_instantiation_cache_size )
    {
       assert(cfg.chain_thread_pool_size > 0);
       thread_pool.start( cfg.chain_thread_pool_size, [this]( const fc::exception& e ) {
@@ -1974,9 +1993,14 @@ struct controller_impl {
       }
 
       if( conf.integrity_hash_on_start )
-         ilog( "chain database started with hash: ${hash}", ("hash", calculate_integrity_hash()) );
+         log_integrity_hash( "started" );
       okay_to_print_integrity_hash_on_stop = true;
 
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      // compile the contracts that were hot before the restart while blocks are replayed
+      wasmif.start_eos_vm_oc_warmup();
+#endif
+
       replay( startup ); // replay any irreversible and reversible blocks ahead of current head
 
       if( check_shutdown() ) return;
@@ -2062,7 +2086,7 @@ struct controller_impl {
       pending.reset();
       //only log this not just if configured to, but also if initialization made it to the point we'd log the startup too
       if(okay_to_print_integrity_hash_on_stop && conf.integrity_hash_on_stop)
-         ilog( "chain database stopped with hash: ${hash}", ("hash", calculate_integrity_hash()) );
+         log_integrity_hash( "stopped" );
    }
 
    void add_indices() {
@@ -2078,13 +2102,13 @@ struct controller_impl {
       db.undo_all();
    }
 
-   void add_contract_rows_to_snapshot( const snapshot_writer_ptr& snapshot, snapshot_written_row_counter& row_counter ) const {
-      contract_database_index_set::walk_indices([this, &snapshot, &row_counter]( auto utils ) {
+   void add_contract_rows_to_snapshot( const snapshot_writer_ptr& snapshot, snapshot_written_row_counter& row_counter, boost::asio::io_context& ctx ) const {
+      contract_database_index_set::walk_indices([this, &snapshot, &row_counter, &ctx]( auto utils ) {
          using utils_t = decltype(utils);
          using value_t = typename decltype(utils)::index_t::value_type;
          using by_table_id = object_to_table_id_tag_t<value_t>;
 
-         snapshot->write_section<value_t>([this, &row_counter]( auto& section ) {
+         snapshot->write_section_via_post<value_t>(ctx, [this, &row_counter]( auto& section ) {
             table_id flattened_table_id = -1; //first table id will be assigned 0 by chainbase
 
             index_utils<table_id_multi_index>::walk(db, [this, &section, &flattened_table_id, &row_counter](const table_id_object& table_row) {
@@ -2201,21 +2225,34 @@ struct controller_impl {
       return ret + authorization.expected_snapshot_row_count() + resource_limits.expected_snapshot_row_count();
    }
 
+   // a forked snapshot process must not log: another thread of the parent may have held a logging lock when it forked
+   enum class forked_t { no, yes };
    void add_to_snapshot( const snapshot_writer_ptr& snapshot ) {
       // clear in case the previous call to clear did not finish in time of deadline
       clear_expired_input_transactions( fc::time_point::maximum() );
 
-      snapshot_written_row_counter row_counter(expected_snapshot_row_count());
+      add_to_snapshot( snapshot, get_block_state_to_snapshot(), forked_t::no );
+   }
+
+   // a forked process is given the block states by its parent, as getting them may take the fork database lock which
+   // another thread of the parent could hold at the fork; it writes every section on its only thread
+   void add_to_snapshot( const snapshot_writer_ptr& snapshot, const block_state_pair& head_states, forked_t forked ) {
+      snapshot_written_row_counter row_counter(expected_snapshot_row_count(), forked == forked_t::no);
 
       snapshot->write_section<chain_snapshot_header>([this]( auto &section ){
          section.add_row(chain_snapshot_header(), db);
       });
 
       snapshot->write_section("eosio::chain::block_state", [&]( auto& section ) {
-         section.add_row(snapshot_detail::snapshot_block_state_data_v8(get_block_state_to_snapshot()), db);
+         section.add_row(snapshot_detail::snapshot_block_state_data_v8(head_states), db);
       });
       
-      controller_index_set::walk_indices([this, &snapshot, &row_counter]( auto utils ){
+      // sections are reserved in order here but written by the workqueue; a threaded writer serializes them
+      // concurrently while any other writer sees them one at a time in the same order
+      sync_threaded_work<struct snapwrite> snapshot_write_workqueue;
+      boost::asio::io_context& snapshot_write_ctx = snapshot_write_workqueue.io_context();
+
+      controller_index_set::walk_indices([this, &snapshot, &row_counter, &snapshot_write_ctx]( auto utils ){
          using value_t = typename decltype(utils)::index_t::value_type;
 
          // skip the database_header as it is only relevant to in-memory database
@@ -2223,7 +2260,7 @@ struct controller_impl {
             return;
          }
 
-         snapshot->write_section<value_t>([this, &row_counter]( auto& section ){
+         snapshot->write_section_via_post<value_t>(snapshot_write_ctx, [this, &row_counter]( auto& section ){
             decltype(utils)::walk(db, [this, &section, &row_counter]( const auto &row ) {
                section.add_row(row, db);
                row_counter.progress();
@@ -2231,10 +2268,18 @@ struct controller_impl {
          });
       });
 
-      add_contract_rows_to_snapshot(snapshot, row_counter);
+      add_contract_rows_to_snapshot(snapshot, row_counter, snapshot_write_ctx);
 
-      authorization.add_to_snapshot(snapshot, row_counter);
-      resource_limits.add_to_snapshot(snapshot, row_counter);
+      authorization.add_to_snapshot(snapshot, row_counter, snapshot_write_ctx);
+      resource_limits.add_to_snapshot(snapshot, row_counter, snapshot_write_ctx);
+
+      // sized as the chain thread pool, which is configured by the operator with chain-threads
+      const unsigned snapshot_write_threads = snapshot->supports_threading() ? conf.chain_thread_pool_size : 1;
+
+      if (forked == forked_t::yes)
+         snapshot_write_ctx.run();
+      else
+         snapshot_write_workqueue.run(snapshot_write_threads);
    }
 
    static std::optional<genesis_state> extract_legacy_genesis_state( snapshot_reader& snapshot, uint32_t version ) {
@@ -2470,6 +2515,90 @@ struct controller_impl {
       return enc.result();
    }
 
+#ifndef _WIN32
+   std::future<void> write_snapshot_in_background( const std::filesystem::path& snapshot_path ) {
+      clear_expired_input_transactions( fc::time_point::maximum() );
+      const block_state_pair head_states = get_block_state_to_snapshot();
+
+      // the child reports a failure by writing its message to the pipe; the parent sees EOF on success
+      int err_pipe[2];
+      EOS_ASSERT( pipe(err_pipe) == 0, snapshot_exception, "Failed to create pipe for background snapshot: ${e}", ("e", strerror(errno)) );
+
+      const pid_t pid = fork();
+      if( pid == -1 ) {
+         const int e = errno;
+         close(err_pipe[0]);
+         close(err_pipe[1]);
+         EOS_THROW( snapshot_exception, "Failed to fork background snapshot process: ${e}", ("e", strerror(e)) );
+      }
+
+      if( pid == 0 ) {
+         // only this thread exists in the child and the state is a private copy-on-write view; locks held by other
+         // threads of the parent at the fork are never released, so only chainbase is read here. never return from here
+         close(err_pipe[0]);
+         std::string error;
+         try {
+            auto writer = std::make_shared<threaded_snapshot_writer>(snapshot_path);
+            add_to_snapshot(writer, head_states, forked_t::yes);
+            writer->finalize();
+         } catch( const fc::exception& e ) {
+            error = e.to_detail_string();
+         } catch( const std::exception& e ) {
+            error = e.what();
+         } catch( ... ) {
+            error = "unknown exception";
+         }
+         if( !error.empty() ) {
+            [[maybe_unused]] ssize_t w = write(err_pipe[1], error.data(), error.size());
+         }
+         _exit(error.empty() ? 0 : 1);
+      }
+
+      close(err_pipe[1]);
+      return std::async(std::launch::async, [pid, err_fd=err_pipe[0], snapshot_path]() {
+         auto close_pipe = fc::make_scoped_exit([&]() { close(err_fd); });
+
+         std::string error;
+         char buf[4096];
+         ssize_t r;
+         while( (r = read(err_fd, buf, sizeof(buf))) != 0 ) {
+            if( r == -1 && errno == EINTR )
+               continue;
+            if( r == -1 )
+               break;
+            error.append(buf, r);
+         }
+
+         int status = 0;
+         pid_t waited;
+         do {
+            waited = waitpid(pid, &status, 0);
+         } while( waited == -1 && errno == EINTR );
+
+         EOS_ASSERT( waited == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0, snapshot_exception,
+                     "Background snapshot ${p} failed: ${e}", ("p", snapshot_path)("e", error.empty() ? "process terminated abnormally" : error) );
+      });
+   }
+#endif
+
+   snapshot_section_hashes calculate_section_integrity_hashes() {
+      auto hash_writer = std::make_shared<section_integrity_hash_snapshot_writer>();
+      add_to_snapshot(hash_writer);
+      return hash_writer->finalize();
+   }
+
+   void log_integrity_hash( const char* when ) {
+      if( !conf.integrity_hash_per_section ) {
+         ilog( "chain database ${w} with hash: ${hash}", ("w", when)("hash", calculate_integrity_hash()) );
+         return;
+      }
+
+      const snapshot_section_hashes hashes = calculate_section_integrity_hashes();
+      ilog( "chain database ${w} with section hash root: ${hash}", ("w", when)("hash", hashes.root) );
+      for( const snapshot_section_hash& section : hashes.sections )
+         ilog( "   section ${n} (${r} rows): ${hash}", ("n", section.name)("r", section.row_count)("hash", section.hash) );
+   }
+
    void create_native_account( const fc::time_point& initial_timestamp, account_name name, const authority& owner, const authority& active, bool is_privileged = false ) {
       db.create<account_object>([&](auto& a) {
          a.name = name;
@@ -4101,6 +4230,7 @@ struct controller_impl {
       assert(is_proper_savanna_block == b->is_proper_svnn_block());
 
       std::optional<qc_t> qc = verify_basic_block_invariants(id, b, prev);
+      std::optional<prevalidated_block> pre = take_prevalidated_block(id, b);
       log_and_drop_future<void> verify_qc_future;
       if constexpr (is_proper_savanna_block) {
          if (qc) {
@@ -4110,12 +4240,18 @@ struct controller_impl {
          }
       }
 
-      auto trx_mroot = calculate_trx_merkle( b->transactions, is_proper_savanna_block );
+      auto trx_mroot = pre ? pre->trx_mroot : calculate_trx_merkle( b->transactions, is_proper_savanna_block );
       EOS_ASSERT( b->transaction_mroot == trx_mroot,
                   block_validate_exception,
                   "invalid block transaction merkle root ${b} != ${c}", ("b", b->transaction_mroot)("c", trx_mroot) );
 
-      const bool skip_validate_signee = false;
+      bool skip_validate_signee = false;
+      if constexpr (is_proper_savanna_block) {
+         if (pre && pre->signing_keys) {
+            block_state::verify_signing_keys(prev, b, *pre->signing_keys);
+            skip_validate_signee = true; // verified above with the keys recovered by prevalidate_block
+         }
+      }
       auto bsp = std::make_shared<BS>(
             prev,
             b,
@@ -4181,6 +4317,45 @@ struct controller_impl {
       return fork_db.apply<std::future<block_handle>>(unlinkable, f);
    }
 
+   // thread safe, expected to be called from thread other than the main thread
+   void prevalidate_block( const block_id_type& id, const signed_block_ptr& b ) {
+      const bool is_proper_savanna_block = b->is_proper_svnn_block();
+      prevalidated_block pre{ .block = b };
+      try {
+         pre.trx_mroot = calculate_trx_merkle( b->transactions, is_proper_savanna_block );
+         // legacy blocks sign a digest that depends on the previous block state
+         if (is_proper_savanna_block)
+            pre.signing_keys = block_state::recover_signing_keys( b, id );
+      } catch( ... ) {
+         return; // create_block_state_i reports the error when it redoes the work
+      }
+
+      std::lock_guard g( prevalidated_blocks_mtx );
+      // the lowest blocks are needed first, when full keep them and give up on the highest
+      if (prevalidated_blocks.size() >= max_prevalidated_blocks && !prevalidated_blocks.contains( id )) {
+         auto highest = std::prev( prevalidated_blocks.end() );
+         if (id > highest->first)
+            return;
+         prevalidated_blocks.erase( highest );
+      }
+      prevalidated_blocks.insert_or_assign( id, std::move(pre) );
+   }
+
+   // thread safe
+   std::optional<prevalidated_block> take_prevalidated_block( const block_id_type& id, const signed_block_ptr& b ) {
+      std::lock_guard g( prevalidated_blocks_mtx );
+      // blocks are validated in order, so earlier blocks still here were prevalidated too late to be used
+      auto i = prevalidated_blocks.erase( prevalidated_blocks.begin(), prevalidated_blocks.lower_bound( id ) );
+      if (i == prevalidated_blocks.end() || i->first != id)
+         return {};
+      std::optional<prevalidated_block> pre;
+      // a different block with the same id, e.g. with a different signature, must be validated on its own
+      if (i->second.block == b)
+         pre = std::move(i->second);
+      prevalidated_blocks.erase( i );
+      return pre;
+   }
+
    // thread safe, expected to be called from thread other than the main thread
    std::optional<block_handle> create_block_handle( const block_id_type& id, const signed_block_ptr& b ) {
       EOS_ASSERT( b, block_validate_exception, "null block" );
@@ -5071,6 +5246,14 @@ subjective_billing& controller::get_mutable_subjective_billing() {
    return my->subjective_bill;
 }
 
+const contract_profiler& controller::get_contract_profiler()const {
+   return my->profiler;
+}
+
+contract_profiler& controller::get_mutable_contract_profiler() {
+   return my->profiler;
+}
+
 
 controller::controller( const controller::config& cfg, const chain_id_type& chain_id )
 :my( new controller_impl( cfg, *this, protocol_feature_set{}, chain_id ) )
@@ -5313,6 +5496,10 @@ std::future<block_handle> controller::create_block_handle_future( const block_id
    return my->create_block_handle_future( id, b );
 }
 
+void controller::prevalidate_block( const block_id_type& id, const signed_block_ptr& b ) const {
+   my->prevalidate_block( id, b );
+}
+
 std::optional<block_handle> controller::create_block_handle( const block_id_type& id, const signed_block_ptr& b ) const {
    return my->create_block_handle( id, b );
 }
@@ -5542,6 +5729,18 @@ signed_block_ptr controller::fetch_block_by_number( uint32_t block_num )const  {
    return my->blog.read_block_by_num(block_num);
 } FC_CAPTURE_AND_RETHROW( (block_num) ) }
 
+bool controller::fetch_serialized_block_by_number( uint32_t block_num, std::vector<char>& dest )const  { try {
+   if (signed_block_ptr b = my->fork_db_fetch_block_on_best_branch_by_num(block_num)) {
+      const size_t start = dest.size();
+      dest.resize(start + fc::raw::pack_size(*b));
+      fc::datastream<char*> ds(dest.data() + start, dest.size() - start);
+      fc::raw::pack(ds, *b);
+      return true;
+   }
+
+   return my->blog.append_serialized_block_by_num(block_num, dest);
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
 std::optional<signed_block_header> controller::fetch_block_header_by_number( uint32_t block_num )const  { try {
    auto b = my->fork_db_fetch_block_on_best_branch_by_num(block_num);
    if (b)
@@ -5572,6 +5771,10 @@ fc::sha256 controller::calculate_integrity_hash() { try {
    return my->calculate_integrity_hash();
 } FC_LOG_AND_RETHROW() }
 
+snapshot_section_hashes controller::calculate_section_integrity_hashes() { try {
+   return my->calculate_section_integrity_hashes();
+} FC_LOG_AND_RETHROW() }
+
 void controller::write_snapshot( const snapshot_writer_ptr& snapshot ) {
    EOS_ASSERT( !my->pending, block_validate_exception, "cannot take a consistent snapshot with a pending block" );
    my->writing_snapshot.store(true, std::memory_order_release);
@@ -5581,6 +5784,26 @@ void controller::write_snapshot( const snapshot_writer_ptr& snapshot ) {
    my->add_to_snapshot(snapshot);
 }
 
+bool controller::can_write_snapshot_in_background() const {
+#ifndef _WIN32
+   // with a shared mapping the parent's writes would be visible to the forked child; every other mode is private to the process
+   return my->conf.db_map_mode != pinnable_mapped_file::map_mode::mapped;
+#else
+   return false;
+#endif
+}
+
+std::future<void> controller::write_snapshot_in_background( const std::filesystem::path& snapshot_path ) {
+   EOS_ASSERT( can_write_snapshot_in_background(), snapshot_exception,
+               "background snapshots require a private database mapping; database-map-mode \"mapped\" is not supported" );
+   EOS_ASSERT( !my->pending, block_validate_exception, "cannot take a consistent snapshot with a pending block" );
+#ifndef _WIN32
+   return my->write_snapshot_in_background( snapshot_path );
+#else
+   return {};
+#endif
+}
+
 bool controller::is_writing_snapshot() const {
    return my->writing_snapshot.load(std::memory_order_acquire);
 }
@@ -5963,6 +6186,14 @@ vm::wasm_allocator& controller::get_wasm_allocator() {
 bool controller::is_eos_vm_oc_enabled() const {
    return my->is_eos_vm_oc_enabled();
 }
+
+size_t controller::eos_vm_oc_warmup_remaining() {
+   return my->wasmif.eos_vm_oc_warmup_remaining();
+}
+
+eosvmoc::code_cache_stats controller::eos_vm_oc_cache_stats() const {
+   return my->wasmif.eos_vm_oc_cache_stats();
+}
 #endif
 
 std::optional<uint64_t> controller::convert_exception_to_error_code( const fc::exception& e ) {
@@ -4,6 +4,9 @@
 #include <eosio/chain/genesis_state.hpp>
 #include <eosio/chain/block_log_config.hpp>
 
+#include <functional>
+#include <span>
+
 namespace eosio { namespace chain {
 
    namespace detail { struct block_log_impl; }
@@ -57,6 +60,27 @@ namespace eosio { namespace chain {
          std::optional<signed_block_header> read_block_header_by_num(uint32_t block_num)const;
          std::optional<block_id_type>       read_block_id_by_num(uint32_t block_num)const;
 
+         /**
+          * Append the serialized block, exactly as stored in the log, to dest without unpacking it. This allows the block
+          * to be forwarded, e.g. to a syncing peer, at the cost of a single copy out of the log.
+          *
+          * @return false if the block is not in the log, in which case dest is not modified
+          */
+         bool append_serialized_block_by_num(uint32_t block_num, std::vector<char>& dest)const;
+
+         /**
+          * Call f for each block in [start_block_num, end_block_num), in order, serialized exactly as stored in the log.
+          * Consecutive blocks are read in chunks of several MiB with a single sequential read each, and the kernel is
+          * asked to read the next chunk ahead while f processes the current one, so that bulk reads run at disk bandwidth
+          * instead of paying for an index lookup and a separate read per block. The log is only locked while a chunk is
+          * read, not while f runs.
+          *
+          * Stops at the first block that is not in the log, or when f returns false.
+          * @return the number of blocks passed to f
+          */
+         uint32_t read_serialized_block_range(uint32_t start_block_num, uint32_t end_block_num,
+                                              const std::function<bool(uint32_t block_num, std::span<const char> block)>& f)const;
+
          signed_block_ptr read_block_by_id(const block_id_type& id)const {
             return read_block_by_num(block_header::num_from_id(id));
          }
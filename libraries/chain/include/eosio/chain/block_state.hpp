@@ -173,6 +173,13 @@ public:
 
    static std::shared_ptr<block_state> create_if_genesis_block(const block_state_legacy& bsp);
 
+   // thread safe, recovers the producer signature key followed by the additional signature keys of proper savanna block b.
+   // Does not depend on the previous block state, so may be done before it is available.
+   static std::vector<public_key_type> recover_signing_keys(const signed_block_ptr& b, const block_id_type& id);
+   // EOS_ASSERTs if keys returned by recover_signing_keys do not satisfy the signing authority of the producer of b
+   static void verify_signing_keys(const block_header_state& prev, const signed_block_ptr& b,
+                                   const std::vector<public_key_type>& keys);
+
    // Constructs a Transition Savanna block state from a Legacy block state.
    static std::shared_ptr<block_state> create_transition_block(
          const block_state&                prev,
@@ -17,6 +17,8 @@ const static auto safety_filename             = "safety.dat";
 const static auto chain_head_filename         = "chain_head.dat";
 const static auto default_state_size          = 1*1024*1024*1024ll;
 const static auto default_state_guard_size    =    128*1024*1024ll;
+const static auto default_wasm_instantiation_cache_size = 1024*1024*1024ull; ///< bytes of wasm of the contracts kept instantiated
+const static uint32_t default_contract_profile_sample_interval = 16; ///< one in this many actions has its intrinsics timed
 
 
 const static name system_account_name    { "eosio"_n };
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+enum class intrinsic_category : uint8_t {
+   database,      ///< db_* intrinsics of the primary and secondary indexes
+   crypto,        ///< hashes, key recovery and elliptic curve intrinsics
+   inline_action, ///< send_inline, send_context_free_inline, send_deferred and cancel_deferred
+   count
+};
+
+const char* to_string(intrinsic_category c);
+
+/**
+ * Wall time spent executing each (receiver, action) and, within it, each intrinsic_category, cheap enough to be always on.
+ *
+ * The time of each action is its action trace elapsed time, already measured. Timing intrinsics costs two clock reads
+ * per call, so only one action in intrinsic_sample_interval has its intrinsics timed, and their time is scaled up by
+ * intrinsic_sample_interval as an estimate of the time of all the actions. The sampled actions are picked at random
+ * rather than every intrinsic_sample_interval-th, so that recurring patterns of actions, such as transactions that
+ * always carry the same number of actions, do not get some actions always sampled and others never.
+ *
+ * Every thread executing actions records to its own counters, only taking a lock the first time it executes a
+ * (receiver, action), so the main thread and the read-only threads do not contend. The counters of all the threads
+ * are merged when read, from any thread. Each thread records at most max_actions_per_thread distinct
+ * (receiver, action); the time of any others is recorded under an empty receiver and action.
+ */
+class contract_profiler {
+   public:
+      static constexpr size_t num_intrinsic_categories = static_cast<size_t>(intrinsic_category::count);
+      using intrinsic_us_t = std::array<uint64_t, num_intrinsic_categories>;
+
+      struct action_profile {
+         account_name   receiver;
+         action_name    action;
+         uint64_t       executions  = 0;
+         uint64_t       wall_us     = 0;
+         uint64_t       max_wall_us = 0;
+         intrinsic_us_t intrinsic_us{}; ///< estimated from the sampled executions
+      };
+
+      /// times the calls to intrinsics of a category made by the sampled actions
+      class intrinsic_timer {
+         public:
+            explicit intrinsic_timer(intrinsic_category c) : _category(c), _timed(_thread.sampling) {
+               if(_timed)
+                  _start = std::chrono::steady_clock::now();
+            }
+            ~intrinsic_timer() {
+               if(_timed)
+                  _thread.action_intrinsic_ns[static_cast<size_t>(_category)] +=
+                     std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+            }
+            intrinsic_timer(const intrinsic_timer&) = delete;
+            intrinsic_timer& operator=(const intrinsic_timer&) = delete;
+
+         private:
+            const intrinsic_category              _category;
+            const bool                            _timed;
+            std::chrono::steady_clock::time_point _start;
+      };
+
+      explicit contract_profiler(uint32_t intrinsic_sample_interval, size_t max_actions_per_thread = 4096);
+      ~contract_profiler();
+      contract_profiler(const contract_profiler&) = delete;
+      contract_profiler& operator=(const contract_profiler&) = delete;
+
+      /// call when an action starts executing on this thread
+      void begin_action() {
+         _thread.sampling = false;
+         if(_intrinsic_sample_interval && next_random() % _intrinsic_sample_interval == 0) {
+            _thread.sampling = true;
+            _thread.action_intrinsic_ns = {};
+         }
+      }
+
+      /// call when the action started by begin_action finishes, successfully or not
+      void end_action(account_name receiver, action_name act, fc::microseconds elapsed);
+
+      /// the counters of all the threads merged, in no particular order. any thread
+      std::vector<action_profile> actions() const;
+
+      uint32_t intrinsic_sample_interval() const { return _intrinsic_sample_interval; }
+
+   private:
+      struct action_counters {
+         std::atomic<uint64_t> executions{0};
+         std::atomic<uint64_t> wall_us{0};
+         std::atomic<uint64_t> max_wall_us{0};
+         std::array<std::atomic<uint64_t>, num_intrinsic_categories> intrinsic_ns{};
+      };
+      struct action_key_hash {
+         size_t operator()(const std::pair<account_name, action_name>& k) const {
+            return std::hash<account_name>()(k.first) ^ (std::hash<action_name>()(k.second) * 0x9e3779b97f4a7c15ull);
+         }
+      };
+      // written only by its thread; mtx guards adding actions against readers iterating them
+      struct thread_counters {
+         mutable std::mutex mtx;
+         std::unordered_map<std::pair<account_name, action_name>, action_counters, action_key_hash> actions;
+      };
+      // zero initialized, as is any thread_local of trivial type
+      struct thread_state {
+         uint64_t         profiler_id; ///< the profiler counters belongs to
+         thread_counters* counters;
+         uint64_t         random_state; ///< of next_random, seeded on first use
+         bool             sampling;
+         std::array<uint64_t, num_intrinsic_categories> action_intrinsic_ns;
+      };
+      inline static thread_local thread_state _thread;
+
+      thread_counters& counters_of_this_thread();
+
+      // splitmix64, cheap enough to draw for every action
+      static uint64_t next_random() {
+         if(!_thread.random_state)
+            _thread.random_state = std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
+         uint64_t z = (_thread.random_state += 0x9e3779b97f4a7c15ull);
+         z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+         z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+         return z ^ (z >> 31);
+      }
+
+      const uint64_t _id;
+      const uint32_t _intrinsic_sample_interval;
+      const size_t   _max_actions_per_thread;
+
+      mutable std::mutex _threads_mtx;
+      std::unordered_map<std::thread::id, std::unique_ptr<thread_counters>> _threads;
+};
+
+/// times the rest of the enclosing scope as a call to an intrinsic of the category, when the action is sampled
+using intrinsic_timer = contract_profiler::intrinsic_timer;
+
+} } // eosio::chain
@@ -8,6 +8,7 @@
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/protocol_feature_manager.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/config.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache_policy.hpp>
 #include <eosio/chain/finality/vote_message.hpp>
 #include <eosio/chain/finality/finalizer.hpp>
 
@@ -53,6 +54,7 @@ namespace eosio::chain {
    class account_object;
    class deep_mind_handler;
    class subjective_billing;
+   class contract_profiler;
    using resource_limits::resource_limits_manager;
    using apply_handler = std::function<void(apply_context&)>;
 
@@ -111,8 +113,10 @@ namespace eosio::chain {
             uint32_t                 num_configured_p2p_peers = 0;
             bool                     integrity_hash_on_start= false;
             bool                     integrity_hash_on_stop = false;
+            bool                     integrity_hash_per_section = false;
 
             wasm_interface::vm_type  wasm_runtime = chain::config::default_wasm_runtime;
+            uint64_t                 wasm_instantiation_cache_size = chain::config::default_wasm_instantiation_cache_size;
             eosvmoc::config          eosvmoc_config;
             wasm_interface::vm_oc_enable eosvmoc_tierup     = wasm_interface::vm_oc_enable::oc_auto;
 
@@ -126,6 +130,7 @@ namespace eosio::chain {
             uint32_t                 greylist_limit         = chain::config::maximum_elastic_resource_multiplier;
 
             flat_set<account_name>   profile_accounts;
+            uint32_t                 contract_profile_sample_interval = chain::config::default_contract_profile_sample_interval;
          };
 
          enum class block_status {
@@ -203,6 +208,11 @@ namespace eosio::chain {
          // thread-safe
          // returns empty optional if block b is not immediately ready to be processed
          std::optional<block_handle> create_block_handle( const block_id_type& id, const signed_block_ptr& b ) const;
+         // thread-safe
+         // computes the transaction merkle root and recovers the signing keys of b ahead of create_block_handle, which
+         // then only verifies them. Neither depends on the previous block, so blocks can be prevalidated in parallel
+         // before their previous block is in the fork database. Only used by create_block_handle for the same b instance.
+         void prevalidate_block( const block_id_type& id, const signed_block_ptr& b ) const;
 
          /**
           * @param br returns statistics for block
@@ -232,6 +242,9 @@ namespace eosio::chain {
          const protocol_feature_manager&       get_protocol_feature_manager()const;
          const subjective_billing&             get_subjective_billing()const;
          subjective_billing&                   get_mutable_subjective_billing();
+         // wall time of the actions executed by this node, safe to read from any thread
+         const contract_profiler&              get_contract_profiler()const;
+         contract_profiler&                    get_mutable_contract_profiler();
 
          const flat_set<account_name>&   get_actor_whitelist() const;
          const flat_set<account_name>&   get_actor_blacklist() const;
@@ -318,6 +331,9 @@ namespace eosio::chain {
 
          // thread-safe, retrieves block according to fork db best branch which can change at any moment
          signed_block_ptr fetch_block_by_number( uint32_t block_num )const;
+         // thread-safe, same as fetch_block_by_number but appends the serialized block to dest, blocks in the block log
+         // are copied out of the log without being unpacked. returns false if the block is not available
+         bool fetch_serialized_block_by_number( uint32_t block_num, std::vector<char>& dest )const;
          // thread-safe
          signed_block_ptr fetch_block_by_id( const block_id_type& id )const;
          // thread-safe
@@ -335,7 +351,14 @@ namespace eosio::chain {
          digest_type get_strong_digest_by_id( const block_id_type& id ) const; // used in unittests
 
          fc::sha256 calculate_integrity_hash();
+         snapshot_section_hashes calculate_section_integrity_hashes();
          void write_snapshot( const snapshot_writer_ptr& snapshot );
+         // true if write_snapshot_in_background() is available for the configured database map mode
+         bool can_write_snapshot_in_background() const;
+         // Forks a process holding a copy-on-write view of the current state which writes a binary snapshot to
+         // snapshot_path while this process continues applying blocks. The returned future is ready once that process
+         // exits and throws if the snapshot could not be written.
+         std::future<void> write_snapshot_in_background( const std::filesystem::path& snapshot_path );
          // thread-safe
          bool is_writing_snapshot()const;
 
@@ -417,6 +440,10 @@ namespace eosio::chain {
 #endif
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
          bool is_eos_vm_oc_enabled() const;
+         // number of contracts hot before the last shutdown still being compiled by EOS VM OC, call in the write window
+         size_t eos_vm_oc_warmup_remaining();
+         // counters of the EOS VM OC code cache, safe to call from any thread
+         eosvmoc::code_cache_stats eos_vm_oc_cache_stats() const;
 #endif
 
          static std::optional<uint64_t> convert_exception_to_error_code( const fc::exception& e );
@@ -2,15 +2,31 @@
 
 #include <fc/io/cfile.hpp>
 
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <vector>
+
 namespace eosio {
 namespace chain {
 /// copy up to n bytes from the current position of src to dest
 void copy_file_content(fc::cfile& src, fc::cfile& dest, uint64_t n = UINT64_MAX);
 
+/**
+ * Read only view of an index file, an array of the uint64_t positions of consecutive blocks in the matching log file.
+ * The file is memory mapped, so looking up a position is a memory read rather than a seek and read of the file.
+ * Lookups are expected to be random, so the mapping is advised against readahead; will_need() prefetches the whole
+ * index for a log that is about to be read heavily. The view does not grow with the file, open() it again to see
+ * positions appended after it was opened.
+ */
 template <typename Exception>
 class log_index {
-   fc::cfile file_;
-   std::size_t num_blocks_ = 0;
+   boost::interprocess::file_mapping  file_;
+   boost::interprocess::mapped_region region_;
+   const uint64_t*                    positions_ = nullptr;
+   std::size_t                        num_blocks_ = 0;
+   bool                               open_ = false;
  public:
    log_index() = default;
    log_index(const std::filesystem::path& path) {
@@ -18,30 +34,55 @@ class log_index {
    }
 
    void open(const std::filesystem::path& path) {
-      if (file_.is_open())
-         file_.close();
-      file_.set_file_path(path);
-      file_.open("rb");
-      file_.seek_end(0);
-      num_blocks_ = file_.tellp()/ sizeof(uint64_t);
-      EOS_ASSERT(file_.tellp() % sizeof(uint64_t) == 0, Exception,
+      close();
+      const auto size = std::filesystem::file_size(path);
+      EOS_ASSERT(size % sizeof(uint64_t) == 0, Exception,
                  "The size of ${file} is not a multiple of sizeof(uint64_t)", ("file", path));
+      // an empty file cannot be mapped, and has nothing to look up
+      if (size) {
+         file_   = boost::interprocess::file_mapping(path.generic_string().c_str(), boost::interprocess::read_only);
+         region_ = boost::interprocess::mapped_region(file_, boost::interprocess::read_only, 0, size);
+         region_.advise(boost::interprocess::mapped_region::advice_random);
+         positions_ = static_cast<const uint64_t*>(region_.get_address());
+      }
+      num_blocks_ = size / sizeof(uint64_t);
+      open_ = true;
+   }
+
+   void close() {
+      region_     = boost::interprocess::mapped_region();
+      file_       = boost::interprocess::file_mapping();
+      positions_  = nullptr;
+      num_blocks_ = 0;
+      open_       = false;
    }
 
-   bool is_open() const { return file_.is_open(); }
+   bool is_open() const { return open_; }
 
-   uint64_t back() { return nth_block_position(num_blocks()-1); }
+   /// asks the kernel to read the whole index in ahead of lookups
+   void will_need() {
+      if (positions_)
+         region_.advise(boost::interprocess::mapped_region::advice_willneed);
+   }
+
+   uint64_t back() const { return nth_block_position(num_blocks()-1); }
    uint32_t num_blocks() const { return num_blocks_; }
-   uint64_t nth_block_position(uint32_t n) {
-      file_.seek(n*sizeof(uint64_t));
-      uint64_t r;
-      file_.read((char*)&r, sizeof(r));
-      return r;
+   uint64_t nth_block_position(uint32_t n) const {
+      EOS_ASSERT(n < num_blocks_, Exception, "Block ${n} is past the ${count} blocks of the index", ("n", n)("count", num_blocks_));
+      return positions_[n];
+   }
+
+   /// positions of blocks n .. n + count - 1
+   std::vector<uint64_t> block_positions(uint32_t n, uint32_t count) const {
+      EOS_ASSERT(uint64_t{n} + count <= num_blocks_, Exception, "Blocks ${n} to ${e} are past the ${count} blocks of the index",
+                 ("n", n)("e", uint64_t{n} + count)("count", num_blocks_));
+      return std::vector<uint64_t>(positions_ + n, positions_ + n + count);
    }
 
-   void copy_to(fc::cfile& dest, uint64_t nbytes) {
-      file_.seek(0);
-      copy_file_content(file_, dest, nbytes);
+   void copy_to(fc::cfile& dest, uint64_t nbytes) const {
+      const uint64_t len = std::min<uint64_t>(nbytes, num_blocks_ * sizeof(uint64_t));
+      if (len)
+         dest.write(reinterpret_cast<const char*>(positions_), len);
    }
 
 };
@@ -3,6 +3,7 @@
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/types.hpp>
 
+#include <future>
 #include <string>
 
 namespace eosio::chain {
@@ -14,13 +15,19 @@ class pending_snapshot {
 public:
    using next_t = eosio::chain::next_function<T>;
 
-   pending_snapshot(const chain::block_id_type& block_id, const next_t& next, std::string pending_path, std::string final_path)
-       : block_id(block_id), next(next), pending_path(std::move(pending_path)), final_path(std::move(final_path)) {}
+   pending_snapshot(const chain::block_id_type& block_id, const next_t& next, std::string pending_path, std::string final_path,
+                    std::shared_future<void> written = {})
+       : block_id(block_id), next(next), pending_path(std::move(pending_path)), final_path(std::move(final_path)), written(std::move(written)) {}
 
    uint32_t get_height() const {
       return chain::block_header::num_from_id(block_id);
    }
 
+   // false while a background snapshot is still being written to pending_path
+   bool is_written() const {
+      return !written.valid() || written.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+   }
+
    static fs::path get_final_path(const chain::block_id_type& block_id, const fs::path& snapshots_dir) {
       return snapshots_dir / fc::format_string("snapshot-${id}.bin", fc::mutable_variant_object()("id", block_id));
    }
@@ -34,6 +41,9 @@ public:
    }
 
    T finalize(const chain::controller& chain) const {
+      if(written.valid())
+         written.get(); // rethrows if the background snapshot failed
+
       auto block_ptr = chain.fetch_block_by_id(block_id);
       auto in_chain = (bool) block_ptr;
       std::error_code ec;
@@ -60,5 +70,6 @@ public:
    next_t next;
    std::string pending_path;
    std::string final_path;
+   std::shared_future<void> written;
 };
 }// namespace eosio::chain
@@ -4,9 +4,17 @@
 #include <eosio/chain/exceptions.hpp>
 #include <fc/variant_object.hpp>
 #include <fc/io/random_access_file.hpp>
+#include <fc/filesystem.hpp>
 #include <boost/core/demangle.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <ostream>
 #include <memory>
+#include <mutex>
 
 namespace eosio { namespace chain {
    /**
@@ -15,6 +23,20 @@ namespace eosio { namespace chain {
     */
    static const uint32_t current_snapshot_version = 1;
 
+   enum class snapshot_compression : uint8_t {
+      none, ///< sections stored raw, see ostream_snapshot_writer
+      zlib  ///< each section independently zlib compressed, located through an index at the end of the file
+   };
+
+   /// Location of a section's row data within a binary snapshot. For an uncompressed snapshot size == uncompressed_size
+   struct snapshot_section_index_entry {
+      std::string name;
+      uint64_t    offset = 0;
+      uint64_t    size = 0;
+      uint64_t    uncompressed_size = 0;
+      uint64_t    row_count = 0;
+   };
+
    namespace detail {
       template<typename T>
       struct snapshot_section_traits {
@@ -146,9 +168,28 @@ namespace eosio { namespace chain {
             write_section(detail::snapshot_section_traits<T>::section_name(), f);
          }
 
+         /// Queue a section to be written when ctx is run. The section's position in the snapshot is fixed at the time
+         /// of this call so the result is identical regardless of how many threads run ctx; writers that do not
+         /// support threading must only have ctx run on a single thread.
+         template<typename F>
+         void write_section_via_post(boost::asio::io_context& ctx, const std::string& section_name, F f) {
+            reserve_section(section_name);
+            boost::asio::post(ctx, [this, section_name, f]() {
+               write_section(section_name, f);
+            });
+         }
+
+         template<typename T, typename F>
+         void write_section_via_post(boost::asio::io_context& ctx, F f) {
+            write_section_via_post(ctx, detail::snapshot_section_traits<T>::section_name(), f);
+         }
+
+         virtual bool supports_threading() const {return false;}
+
       virtual ~snapshot_writer(){};
 
       protected:
+         virtual void reserve_section( const std::string& section_name ) {}
          virtual void write_start_section( const std::string& section_name ) = 0;
          virtual void write_row( const detail::abstract_snapshot_row_writer& row_writer ) = 0;
          virtual void write_end_section() = 0;
@@ -407,6 +448,10 @@ namespace eosio { namespace chain {
          std::unique_ptr<struct istream_json_snapshot_reader_impl> impl;
    };
 
+   /**
+    * Reads binary snapshots, uncompressed or compressed, with sections read concurrently from multiple threads. Sections
+    * of a compressed snapshot are decompressed as they are read so each thread decompresses its own sections.
+    */
    class threaded_snapshot_reader : public snapshot_reader {
       public:
          explicit threaded_snapshot_reader(const std::filesystem::path& snapshot_path);
@@ -420,16 +465,79 @@ namespace eosio { namespace chain {
          size_t total_row_count() override;
          bool supports_threading() const override {return true;}
 
+         snapshot_compression compression() const {return compressed ? snapshot_compression::zlib : snapshot_compression::none;}
+         std::vector<snapshot_section_index_entry> section_index() const;
+         /// writes the section's uncompressed row data to out
+         void copy_section_data( const snapshot_section_index_entry& section, std::ostream& out ) const;
+
       private:
-         fc::random_access_file                   snapshot_file;
-         const boost::interprocess::mapped_region mapped_snap;
-         const char* const                        mapped_snap_addr;
+         std::vector<snapshot_section_index_entry> read_compressed_index() const;
+
+         fc::random_access_file                    snapshot_file;
+         const boost::interprocess::mapped_region  mapped_snap;
+         const char* const                         mapped_snap_addr;
+         const bool                                compressed;
+         std::vector<snapshot_section_index_entry> compressed_index;
 
          thread_local inline static fc::datastream<const char*> ds = fc::datastream<const char*>(nullptr, 0);
          thread_local inline static uint64_t                    num_rows;
          thread_local inline static uint64_t                    cur_row;
+         thread_local inline static bool                        cur_section_compressed = false;
    };
 
+   /**
+    * Writes the same binary format as ostream_snapshot_writer, or its compressed variant, but allows sections to be
+    * written concurrently from multiple threads. Each section is serialized (and compressed) to its own temporary file
+    * next to the snapshot and the sections are stitched together, in reservation order, by finalize().
+    *
+    * The compressed variant starts with compressed_magic_number and the version, followed by each section's
+    * independently compressed row data, a packed vector<snapshot_section_index_entry>, and finally the uint64_t offset of
+    * that index.
+    */
+   class threaded_snapshot_writer : public snapshot_writer {
+      public:
+         explicit threaded_snapshot_writer(const std::filesystem::path& snapshot_path, snapshot_compression compression = snapshot_compression::none);
+
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+         void finalize();
+         bool supports_threading() const override {return true;}
+
+         /// write a section whose uncompressed row data is produced by write_data, e.g. when converting a snapshot
+         void write_raw_section( const std::string& section_name, uint64_t row_count, const std::function<void(std::ostream&)>& write_data );
+
+         static const uint32_t compressed_magic_number = 0x30510551;
+
+      protected:
+         void reserve_section( const std::string& section_name ) override;
+
+      private:
+         struct section_info {
+            std::string           name;
+            std::filesystem::path temp_path;
+            uint64_t              row_count = 0;
+            uint64_t              uncompressed_size = 0;
+            bool                  written   = false;
+         };
+
+         size_t find_or_reserve_section( const std::string& section_name );
+
+         friend void convert_snapshot( const std::filesystem::path&, const std::filesystem::path&, snapshot_compression, unsigned );
+
+         const std::filesystem::path snapshot_path;
+         const snapshot_compression  compression;
+         fc::temp_directory          sections_dir;
+         std::mutex                  sections_mtx;
+         std::deque<section_info>    sections;  // deque so references remain valid as sections are reserved
+
+         thread_local inline static section_info* cur_section = nullptr;
+   };
+
+   /// Converts a binary snapshot, compressed or not, to the given compression. Sections are converted concurrently on threads threads.
+   void convert_snapshot( const std::filesystem::path& in_path, const std::filesystem::path& out_path, snapshot_compression compression,
+                          unsigned threads );
+
    class integrity_hash_snapshot_writer : public snapshot_writer {
       public:
          explicit integrity_hash_snapshot_writer(fc::sha256::encoder&  enc);
@@ -444,16 +552,61 @@ namespace eosio { namespace chain {
 
    };
    
+   struct snapshot_section_hash {
+      std::string name;
+      uint64_t    row_count = 0;
+      fc::sha256  hash;
+   };
+
+   struct snapshot_section_hashes {
+      fc::sha256                         root; ///< merkle root over the section hashes, in snapshot section order
+      std::vector<snapshot_section_hash> sections;
+   };
+
+   /**
+    * Hashes the rows of each section independently so sections can be hashed concurrently and a divergence between two
+    * nodes can be narrowed down to the sections whose hashes differ. The root is not comparable to the hash produced by
+    * integrity_hash_snapshot_writer.
+    */
+   class section_integrity_hash_snapshot_writer : public snapshot_writer {
+      public:
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+         snapshot_section_hashes finalize();
+         bool supports_threading() const override {return true;}
+
+      protected:
+         void reserve_section( const std::string& section_name ) override;
+
+      private:
+         size_t find_or_reserve_section( const std::string& section_name );
+
+         std::mutex                        sections_mtx;
+         std::deque<snapshot_section_hash> sections;
+
+         thread_local inline static std::optional<fc::sha256::encoder> section_enc;
+         thread_local inline static snapshot_section_hash*             cur_section = nullptr;
+   };
+
    struct snapshot_written_row_counter {
-      snapshot_written_row_counter(const size_t total) : total(total) {}
+      snapshot_written_row_counter(const size_t total, const bool log_progress = true) : total(total), log_progress(log_progress) {}
+      // may be called from multiple threads when the snapshot writer supports threading
       void progress() {
-         if(++count % 50000 == 0 && time(NULL) - last_print >= 5) {
-            ilog("Snapshot creation ${pct}% complete", ("pct",std::min((unsigned)(((double)count/total)*100),100u)));
-            last_print = time(NULL);
+         const size_t c = count.fetch_add(1, std::memory_order_relaxed) + 1;
+         if(log_progress && c % 50000 == 0 && time(NULL) - last_print.load(std::memory_order_relaxed) >= 5) {
+            ilog("Snapshot creation ${pct}% complete", ("pct",std::min((unsigned)(((double)c/total)*100),100u)));
+            last_print.store(time(NULL), std::memory_order_relaxed);
          }
       }
-      size_t count = 0;
+      std::atomic<size_t> count = 0;
       const size_t total = 0;
-      time_t last_print = time(NULL);
+      const bool log_progress = true;
+      std::atomic<time_t> last_print = time(NULL);
    };
 }}
+
+FC_REFLECT_ENUM(eosio::chain::snapshot_compression, (none)(zlib))
+FC_REFLECT(eosio::chain::snapshot_section_index_entry, (name)(offset)(size)(uncompressed_size)(row_count))
+FC_REFLECT(eosio::chain::snapshot_section_hash, (name)(row_count)(hash))
+FC_REFLECT(eosio::chain::snapshot_section_hashes, (root)(sections))
@@ -172,6 +172,9 @@ private:
    uint32_t _snapshot_id = 0;
    uint32_t _inflight_sid = 0;
 
+   // write snapshots from a forked copy-on-write process when the database map mode allows it
+   bool _background_snapshots = false;
+
    // path to write the snapshots to
    fs::path _snapshots_dir;
 
@@ -201,6 +204,9 @@ public:
    // set snapshot path
    void set_snapshots_path(fs::path sn_path);
 
+   // write snapshots that become available on irreversibility without pausing block processing
+   void set_background_snapshots(bool enabled);
+
    // add pending snapshot info to inflight snapshot request
    void add_pending_snapshot_info(const snapshot_information& si);
 
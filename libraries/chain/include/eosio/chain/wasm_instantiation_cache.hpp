@@ -0,0 +1,190 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+#include <eosio/chain/webassembly/runtime_interface.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace eosio { namespace chain {
+
+/**
+ * Instantiated modules of the contracts executed by the base runtime.
+ *
+ * The cache is split in shards by code hash, each with its own mutex, so read-only threads looking up or instantiating
+ * different contracts do not wait on each other; in the write window only the main thread runs and no lock is taken.
+ *
+ * Each module is charged the size of its wasm, which its instantiation grows with. Once the charged bytes exceed
+ * max_bytes, the modules used least often are evicted down to 90% of max_bytes and the use counts of the rest are
+ * halved, so contracts that were busy a while ago do not stay ahead of the ones busy now. Modules of replaced code are
+ * also evicted once the block that replaced it is irreversible. Evicting destroys modules, so it only happens in the
+ * write window, when no other thread can be executing one.
+ */
+class wasm_instantiation_cache {
+   public:
+      using module_ptr = std::unique_ptr<wasm_instantiated_module_interface>;
+      static constexpr size_t num_shards = 16;
+
+      explicit wasm_instantiation_cache(uint64_t max_bytes) : _max_bytes(max_bytes) {}
+
+      /// returns the module for the code, calling build() for the module and its charged size if it is not cached yet.
+      /// lock the shard unless called in the write window.
+      template <typename Build>
+      const module_ptr& get_or_build(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, bool lock, Build&& build) {
+         shard& s = shard_for(code_hash);
+         std::unique_lock g(s.mtx, std::defer_lock);
+         if(lock)
+            g.lock();
+         auto it = s.index.find(boost::make_tuple(code_hash, vm_type, vm_version));
+         if(it != s.index.end()) {
+            s.index.modify(it, [](entry& e) { ++e.uses; });
+            // An instantiated module's module should never be null.
+            assert(it->module);
+            return it->module;
+         }
+
+         auto [module, size] = build();
+         _bytes.fetch_add(size, std::memory_order_relaxed);
+         it = s.index.emplace(entry{
+            .code_hash = code_hash,
+            .last_block_num_used = UINT32_MAX,
+            .module = std::move(module),
+            .vm_type = vm_type,
+            .vm_version = vm_version,
+            .size = size,
+            .uses = 1
+         }).first;
+         return it->module;
+      }
+
+      bool contains(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version) const {
+         const shard& s = shard_for(code_hash);
+         std::lock_guard g(s.mtx);
+         return s.index.count(boost::make_tuple(code_hash, vm_type, vm_version));
+      }
+
+      /// call in the write window
+      void code_block_num_last_used(const digest_type& code_hash, uint8_t vm_type, uint8_t vm_version, uint32_t block_num) {
+         shard& s = shard_for(code_hash);
+         auto it = s.index.find(boost::make_tuple(code_hash, vm_type, vm_version));
+         if(it != s.index.end())
+            s.index.modify(it, [block_num](entry& e) {
+               e.last_block_num_used = block_num;
+            });
+      }
+
+      /// evicts the modules last used before or on lib, reporting the code_hash and vm_version of each to on_evict.
+      /// call in the write window
+      template <typename OnEvict>
+      void current_lib(uint32_t lib, OnEvict&& on_evict) {
+         for(shard& s : _shards) {
+            auto& idx = s.index.get<by_last_block_num>();
+            const auto last_it = idx.upper_bound(lib);
+            for(auto it = idx.begin(); it != last_it;) {
+               on_evict(it->code_hash, it->vm_version);
+               _bytes.fetch_sub(it->size, std::memory_order_relaxed);
+               it = idx.erase(it);
+            }
+         }
+         evict_to_fit();
+      }
+
+      /// evicts the modules used least often if over max_bytes, never the module of keep. call in the write window
+      void evict_to_fit(const module_ptr* keep = nullptr) {
+         if(_bytes.load(std::memory_order_relaxed) <= _max_bytes)
+            return;
+
+         struct candidate {
+            shard*            s;
+            index_t::iterator it;
+         };
+         std::vector<candidate> candidates;
+         for(shard& s : _shards) {
+            for(auto it = s.index.begin(); it != s.index.end(); ++it) {
+               if(&it->module != keep)
+                  candidates.push_back({&s, it});
+            }
+         }
+         // least used first, and of those the largest first, to evict as few modules as possible
+         std::sort(candidates.begin(), candidates.end(), [](const candidate& a, const candidate& b) {
+            return a.it->uses < b.it->uses || (a.it->uses == b.it->uses && a.it->size > b.it->size);
+         });
+
+         const uint64_t target = _max_bytes / 10 * 9;
+         for(const candidate& c : candidates) {
+            if(_bytes.load(std::memory_order_relaxed) <= target)
+               break;
+            _bytes.fetch_sub(c.it->size, std::memory_order_relaxed);
+            c.s->index.erase(c.it);
+            ++_evictions;
+         }
+
+         for(shard& s : _shards) {
+            for(auto it = s.index.begin(); it != s.index.end(); ++it)
+               s.index.modify(it, [](entry& e) { e.uses /= 2; });
+         }
+      }
+
+      uint64_t bytes() const { return _bytes.load(std::memory_order_relaxed); }
+      uint64_t evictions() const { return _evictions; }
+
+      /// call in the write window
+      size_t size() const {
+         size_t n = 0;
+         for(const shard& s : _shards)
+            n += s.index.size();
+         return n;
+      }
+
+   private:
+      struct entry {
+         digest_type  code_hash;
+         uint32_t     last_block_num_used;
+         module_ptr   module;
+         uint8_t      vm_type = 0;
+         uint8_t      vm_version = 0;
+         uint64_t     size = 0;
+         uint32_t     uses = 0;
+      };
+      struct by_hash;
+      struct by_last_block_num;
+
+      using index_t = boost::multi_index_container<
+         entry,
+         boost::multi_index::indexed_by<
+            boost::multi_index::ordered_unique<boost::multi_index::tag<by_hash>,
+               boost::multi_index::composite_key< entry,
+                  boost::multi_index::member<entry, digest_type, &entry::code_hash>,
+                  boost::multi_index::member<entry, uint8_t,     &entry::vm_type>,
+                  boost::multi_index::member<entry, uint8_t,     &entry::vm_version>
+               >
+            >,
+            boost::multi_index::ordered_non_unique<boost::multi_index::tag<by_last_block_num>,
+               boost::multi_index::member<entry, uint32_t, &entry::last_block_num_used>>
+         >
+      >;
+
+      struct shard {
+         mutable std::mutex mtx;
+         index_t            index;
+      };
+
+      shard& shard_for(const digest_type& code_hash) { return _shards[code_hash._hash[0] % num_shards]; }
+      const shard& shard_for(const digest_type& code_hash) const { return _shards[code_hash._hash[0] % num_shards]; }
+
+      const uint64_t                 _max_bytes;
+      std::atomic<uint64_t>          _bytes{0};
+      uint64_t                       _evictions = 0;
+      std::array<shard, num_shards>  _shards;
+};
+
+} } // eosio::chain
@@ -1,7 +1,9 @@
 #pragma once
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/types.hpp>
+#include <eosio/chain/config.hpp>
 #include <eosio/chain/whitelisted_intrinsics.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache_policy.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <functional>
 
@@ -48,7 +50,8 @@ namespace eosio { namespace chain {
 
          inline static bool test_disable_tierup = false; // set by unittests to test tierup failing
 
-         wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile);
+         wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                        uint64_t instantiation_cache_size = config::default_wasm_instantiation_cache_size);
          ~wasm_interface();
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
@@ -57,6 +60,15 @@ namespace eosio { namespace chain {
 
          // returns true if EOS VM OC is enabled
          bool is_eos_vm_oc_enabled() const;
+
+         // compiles the contracts executed most before the last shutdown, if EOS VM OC tier-up is configured to warm up
+         void start_eos_vm_oc_warmup();
+
+         // number of warm up compiles not done yet, 0 once the EOS VM OC code cache is warm
+         size_t eos_vm_oc_warmup_remaining();
+
+         // hit, miss and eviction counters of the EOS VM OC code cache, safe to call from any thread
+         eosvmoc::code_cache_stats eos_vm_oc_cache_stats() const;
 #endif
 
          //call before dtor to skip what can be minutes of dtor overhead with some runtimes; can cause leaks
@@ -9,6 +9,7 @@
 #include <eosio/chain/webassembly/runtime_interface.hpp>
 #include <eosio/chain/wasm_eosio_injection.hpp>
 #include <eosio/chain/transaction_context.hpp>
+#include <eosio/chain/wasm_instantiation_cache.hpp>
 #include <eosio/chain/code_object.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/exceptions.hpp>
@@ -22,8 +23,6 @@
 #include <eosio/chain/webassembly/eos-vm.hpp>
 #include <eosio/vm/allocator.hpp>
 
-#include <mutex>
-
 using namespace fc;
 using namespace eosio::chain::webassembly;
 using namespace IR;
@@ -35,16 +34,6 @@ namespace eosio { namespace chain {
    namespace eosvmoc { struct config; }
 
    struct wasm_interface_impl {
-      struct wasm_cache_entry {
-         digest_type                                          code_hash;
-         uint32_t                                             last_block_num_used;
-         std::unique_ptr<wasm_instantiated_module_interface>  module;
-         uint8_t                                              vm_type = 0;
-         uint8_t                                              vm_version = 0;
-      };
-      struct by_hash;
-      struct by_last_block_num;
-
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
 struct eosvmoc_tier {
    // Called from main thread
@@ -70,8 +59,10 @@ struct eosvmoc_tier {
 #endif
 
       wasm_interface_impl(wasm_interface::vm_type vm, wasm_interface::vm_oc_enable eosvmoc_tierup, const chainbase::database& d,
-                          const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile)
-         : db(d)
+                          const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                          uint64_t instantiation_cache_size)
+         : wasm_instantiation_cache(instantiation_cache_size)
+         , db(d)
          , wasm_runtime_time(vm)
       {
 #ifdef EOSIO_EOS_VM_RUNTIME_ENABLED
@@ -105,10 +96,7 @@ struct eosvmoc_tier {
 
       bool is_code_cached(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version) const {
          // This method is only called from tests; performance is not critical.
-         // No need for an additional check if we should lock or not.
-         std::lock_guard g(instantiation_cache_mutex);
-         wasm_cache_index::iterator it = wasm_instantiation_cache.find( boost::make_tuple(code_hash, vm_type, vm_version) );
-         return it != wasm_instantiation_cache.end();
+         return wasm_instantiation_cache.contains(code_hash, vm_type, vm_version);
       }
 
       void code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num) {
@@ -116,11 +104,7 @@ struct eosvmoc_tier {
          // the transaction is not read-only, implying we are
          // in write window. Read-only threads are not running.
          // Safe to update the cache without locking.
-         wasm_cache_index::iterator it = wasm_instantiation_cache.find(boost::make_tuple(code_hash, vm_type, vm_version));
-         if(it != wasm_instantiation_cache.end())
-            wasm_instantiation_cache.modify(it, [block_num](wasm_cache_entry& e) {
-               e.last_block_num_used = block_num;
-            });
+         wasm_instantiation_cache.code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
       }
 
       // reports each code_hash and vm_version that will be erased to callback
@@ -129,13 +113,12 @@ struct eosvmoc_tier {
          // in write window. Read-only threads are not running.
          // Safe to update the cache without locking.
          // Anything last used before or on the LIB can be evicted.
-         const auto first_it = wasm_instantiation_cache.get<by_last_block_num>().begin();
-         const auto last_it  = wasm_instantiation_cache.get<by_last_block_num>().upper_bound(lib);
+         wasm_instantiation_cache.current_lib(lib, [&](const digest_type& code_hash, uint8_t vm_version) {
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
-         if(eosvmoc) for(auto it = first_it; it != last_it; it++)
-            eosvmoc->cc.free_code(it->code_hash, it->vm_version);
+            if(eosvmoc)
+               eosvmoc->cc.free_code(code_hash, vm_version);
 #endif
-         wasm_instantiation_cache.get<by_last_block_num>().erase(first_it, last_it);
+         });
       }
 
 #ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
@@ -150,66 +133,27 @@ struct eosvmoc_tier {
          const uint8_t&       vm_version,
          transaction_context& trx_context)
       {
-         if (trx_context.control.is_write_window()) {
-            // When in write window (either read only threads are not enabled or
-            // they are not schedued to run), only main thread is processing
-            // transactions. No need to lock.
-            return get_or_build_instantiated_module(code_hash, vm_type, vm_version, trx_context);
-         } else {
-            std::lock_guard g(instantiation_cache_mutex);
-            return get_or_build_instantiated_module(code_hash, vm_type, vm_version, trx_context);
-         }
-      }
-
-      // Locked by the caller if required.
-      const std::unique_ptr<wasm_instantiated_module_interface>& get_or_build_instantiated_module(
-         const digest_type&   code_hash,
-         const uint8_t&       vm_type,
-         const uint8_t&       vm_version,
-         transaction_context& trx_context )
-      {
-         wasm_cache_index::iterator it = wasm_instantiation_cache.find( boost::make_tuple(code_hash, vm_type, vm_version) );
-         if (it != wasm_instantiation_cache.end()) {
-            // An instantiated module's module should never be null.
-            assert(it->module);
-            return it->module;
-         }
-
-         const code_object* codeobject = &db.get<code_object,by_code_hash>(boost::make_tuple(code_hash, vm_type, vm_version));
-         it = wasm_instantiation_cache.emplace( wasm_interface_impl::wasm_cache_entry {
-            .code_hash = code_hash,
-            .last_block_num_used = UINT32_MAX,
-            .module = nullptr,
-            .vm_type = vm_type,
-            .vm_version = vm_version
-         } ).first;
-         auto timer_pause = fc::make_scoped_exit([&](){
-            trx_context.resume_billing_timer();
-         });
-         trx_context.pause_billing_timer();
-         wasm_instantiation_cache.modify(it, [&](auto& c) {
-            c.module = runtime_interface->instantiate_module(codeobject->code.data(), codeobject->code.size(), code_hash, vm_type, vm_version);
+         // When in write window (either read only threads are not enabled or
+         // they are not schedued to run), only main thread is processing
+         // transactions. No need to lock, and modules can be evicted.
+         const bool is_write_window = trx_context.control.is_write_window();
+         const auto& module = wasm_instantiation_cache.get_or_build(code_hash, vm_type, vm_version, !is_write_window, [&]() {
+            const code_object* codeobject = &db.get<code_object,by_code_hash>(boost::make_tuple(code_hash, vm_type, vm_version));
+            auto timer_pause = fc::make_scoped_exit([&](){
+               trx_context.resume_billing_timer();
+            });
+            trx_context.pause_billing_timer();
+            return std::make_pair(runtime_interface->instantiate_module(codeobject->code.data(), codeobject->code.size(), code_hash, vm_type, vm_version),
+                                  uint64_t{codeobject->code.size()});
          });
-         return it->module;
+         if (is_write_window)
+            wasm_instantiation_cache.evict_to_fit(&module);
+         return module;
       }
 
       std::unique_ptr<wasm_runtime_interface> runtime_interface;
 
-      typedef boost::multi_index_container<
-         wasm_cache_entry,
-         indexed_by<
-            ordered_unique<tag<by_hash>,
-               composite_key< wasm_cache_entry,
-                  member<wasm_cache_entry, digest_type, &wasm_cache_entry::code_hash>,
-                  member<wasm_cache_entry, uint8_t,     &wasm_cache_entry::vm_type>,
-                  member<wasm_cache_entry, uint8_t,     &wasm_cache_entry::vm_version>
-               >
-            >,
-            ordered_non_unique<tag<by_last_block_num>, member<wasm_cache_entry, uint32_t, &wasm_cache_entry::last_block_num_used>>
-         >
-      > wasm_cache_index;
-      mutable std::mutex instantiation_cache_mutex;
-      wasm_cache_index wasm_instantiation_cache;
+      eosio::chain::wasm_instantiation_cache wasm_instantiation_cache;
 
       const chainbase::database& db;
       const wasm_interface::vm_type wasm_runtime_time;
@@ -4,25 +4,24 @@
 
 #include <eosio/chain/webassembly/eos-vm-oc/eos-vm-oc.hpp>
 #include <eosio/chain/webassembly/eos-vm-oc/ipc_helpers.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/hot_code_tracker.hpp>
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache_policy.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/composite_key.hpp>
 #include <boost/multi_index/key_extractors.hpp>
 
 #include <boost/interprocess/mem_algo/rbtree_best_fit.hpp>
+#include <fc/time.hpp>
 #include <boost/asio/local/datagram_protocol.hpp>
 
 
+#include <atomic>
 #include <thread>
 
-namespace std {
-    template<> struct hash<eosio::chain::eosvmoc::code_tuple> {
-        size_t operator()(const eosio::chain::eosvmoc::code_tuple& ct) const noexcept {
-            return ct.code_id._hash[0];
-        }
-    };
-}
+namespace eosio { namespace chain { class code_object; } }
 
 namespace eosio { namespace chain { namespace eosvmoc {
 
@@ -45,6 +44,12 @@ class code_cache_base {
 
       void free_code(const digest_type& code_id, const uint8_t& vm_version);
 
+      //drops the queued compile of code, if any; a compile already running is left to finish. Call in the write window
+      bool cancel_compile(const digest_type& code_id, const uint8_t& vm_version);
+
+      //safe to call from any thread
+      code_cache_stats stats() const;
+
       // get_descriptor_for_code failure reasons
       enum class get_cd_failure {
          temporary, // oc compile not done yet, users like read-only trxs can retry
@@ -67,6 +72,8 @@ class code_cache_base {
          >
       > code_cache_index;
       code_cache_index _cache_index;
+      //every change to the order of _cache_index goes through _cache_order
+      segmented_lru<code_cache_index> _cache_order;
 
       const chainbase::database& _db;
       eosvmoc::config            _eosvmoc_config;
@@ -79,20 +86,33 @@ class code_cache_base {
       local::datagram_protocol::socket _compile_monitor_read_socket{_ctx};
 
       //these are really only useful to the async code cache, but keep them here so free_code can be shared
+      struct queued_compile {
+         code_tuple code;
+         bool       high_priority   = false;
+         uint64_t   base_runtime_us = 0; //time spent executing the code on the base runtime while its compile waited
+         uint64_t   seq             = 0; //first queued goes first among compiles of the same priority
+      };
+      struct by_priority;
+      //highest priority first: system contracts, then the code that has cost the most time on the base runtime
       using queued_compilies_t = boost::multi_index_container<
-         code_tuple,
+         queued_compile,
          indexed_by<
-            sequenced<>,
-            hashed_unique<tag<by_hash>,
-               composite_key< code_tuple,
-                  member<code_tuple, digest_type, &code_tuple::code_id>,
-                  member<code_tuple, uint8_t,     &code_tuple::vm_version>
-               >
-            >
+            ordered_non_unique<tag<by_priority>,
+               composite_key< queued_compile,
+                  member<queued_compile, bool,     &queued_compile::high_priority>,
+                  member<queued_compile, uint64_t, &queued_compile::base_runtime_us>,
+                  member<queued_compile, uint64_t, &queued_compile::seq>
+               >,
+               composite_key_compare< std::greater<bool>, std::greater<uint64_t>, std::less<uint64_t> >
+            >,
+            hashed_unique<tag<by_hash>, member<queued_compile, code_tuple, &queued_compile::code>, std::hash<code_tuple>>
          >
       >;
       queued_compilies_t _queued_compiles;
+      uint64_t           _queued_compiles_seq = 0;
       std::unordered_map<code_tuple, bool> _outstanding_compiles_and_poison;
+      //when each queued or outstanding compile was first asked for
+      std::unordered_map<code_tuple, fc::time_point> _compile_requested;
 
       size_t _free_bytes_eviction_threshold;
       void check_eviction_threshold(size_t free_bytes);
@@ -100,6 +120,26 @@ class code_cache_base {
 
       void set_on_disk_region_dirty(bool);
 
+      struct {
+         std::atomic<uint64_t> hits{0};
+         std::atomic<uint64_t> misses{0};
+         std::atomic<uint64_t> insertions{0};
+         std::atomic<uint64_t> evictions{0};
+         std::atomic<uint64_t> admission_rejections{0};
+         std::atomic<uint64_t> entries{0};
+         std::atomic<uint64_t> protected_entries{0};
+         std::atomic<uint64_t> queued_compiles{0};
+         std::atomic<uint64_t> outstanding_compiles{0};
+         std::atomic<uint64_t> canceled_compiles{0};
+         atomic_histogram<code_cache_stats::compile_latency_bounds_ms.size()> compile_latency_ms{code_cache_stats::compile_latency_bounds_ms};
+         atomic_histogram<code_cache_stats::queue_depth_bounds.size()>        queue_depth{code_cache_stats::queue_depth_bounds};
+      } _stats;
+      void count_lookup(bool hit) { (hit ? _stats.hits : _stats.misses).fetch_add(1, std::memory_order_relaxed); }
+      //call after any change to _cache_index
+      void update_entries_stats();
+      //call after any change to _queued_compiles or _outstanding_compiles_and_poison
+      void update_compile_stats();
+
       template <typename T>
       void serialize_cache_index(fc::datastream<T>& ds);
 };
@@ -109,18 +149,36 @@ class code_cache_async : public code_cache_base {
       code_cache_async(const std::filesystem::path& data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db);
       ~code_cache_async();
 
-      //If code is in cache: returns pointer & bumps to front of MRU list
-      //If code is not in cache, and not blacklisted, and not currently compiling: return nullptr and kick off compile
+      //If code is in cache: returns pointer & in the write window records the use for eviction ordering
+      //If code is not in cache, and not blacklisted, and not currently compiling: return nullptr and kick off compile once admitted
       //otherwise: return nullptr
       const code_descriptor* const get_descriptor_for_code(bool high_priority, const digest_type& code_id, const uint8_t& vm_version, bool is_write_window, get_cd_failure& failure);
 
+      //Queues compiles of the eosvmoc_config.warmup_contracts codes executed most before the last shutdown that are not
+      // in the cache. Call in the write window
+      void start_warmup();
+      //Number of warm up compiles not done yet, 0 once the cache is warm. Call in the write window
+      size_t warmup_remaining();
+
+      //Adds time code spent executing on the base runtime to the priority of its queued compile, so the compiles that
+      // save the most time go first. Call in the write window
+      void record_base_runtime_us(const digest_type& code_id, const uint8_t& vm_version, uint64_t us);
+
    private:
       std::thread _monitor_reply_thread;
       boost::lockfree::spsc_queue<wasm_compilation_result_message> _result_queue;
       void wait_on_compile_monitor_message();
       std::tuple<size_t, size_t> consume_compile_thread_queue();
+      void process_compile_results();
+      bool start_compile(const code_tuple& ct, const code_object& codeobject);
+      void queue_compile(const code_tuple& ct, bool high_priority);
       std::unordered_set<code_tuple> _blacklist;
       size_t _threads;
+
+      hot_code_tracker               _hot_codes;
+      std::filesystem::path          _hot_codes_path;
+      std::unordered_set<code_tuple> _warmup_pending;
+      admission_filter<code_tuple>   _admission;
 };
 
 class code_cache_sync : public code_cache_base {
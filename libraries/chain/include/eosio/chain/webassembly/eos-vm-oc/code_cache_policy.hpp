@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+/// Counts of the observed values at most each bound, the last count is of the values above every bound
+template <size_t N>
+struct histogram_counts {
+   std::array<uint64_t, N + 1> counts{};
+   uint64_t                    sum = 0;
+};
+
+/// Histogram updated by one thread that any thread can read
+template <size_t N>
+class atomic_histogram {
+   public:
+      explicit atomic_histogram(const std::array<uint64_t, N>& bounds) : _bounds(bounds) {}
+
+      void observe(uint64_t v) {
+         _counts[std::lower_bound(_bounds.begin(), _bounds.end(), v) - _bounds.begin()].fetch_add(1, std::memory_order_relaxed);
+         _sum.fetch_add(v, std::memory_order_relaxed);
+      }
+
+      histogram_counts<N> counts() const {
+         histogram_counts<N> r;
+         for(size_t i = 0; i < r.counts.size(); ++i)
+            r.counts[i] = _counts[i].load(std::memory_order_relaxed);
+         r.sum = _sum.load(std::memory_order_relaxed);
+         return r;
+      }
+
+   private:
+      const std::array<uint64_t, N>&             _bounds;
+      std::array<std::atomic<uint64_t>, N + 1>   _counts{};
+      std::atomic<uint64_t>                      _sum{0};
+};
+
+/// Counters of the code cache, safe to read from any thread
+struct code_cache_stats {
+   static constexpr std::array<uint64_t, 10> compile_latency_bounds_ms{50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000};
+   static constexpr std::array<uint64_t, 9>  queue_depth_bounds{0, 1, 2, 4, 8, 16, 32, 64, 128};
+
+   uint64_t hits                 = 0; // lookups that found compiled code
+   uint64_t misses               = 0; // lookups that did not, so the code ran on the base runtime
+   uint64_t insertions           = 0; // compiled codes added to the cache
+   uint64_t evictions            = 0; // codes evicted to make room for others
+   uint64_t admission_rejections = 0; // misses not compiled because the code has not been executed often enough yet
+   uint64_t entries              = 0;
+   uint64_t protected_entries    = 0;
+
+   uint64_t queued_compiles      = 0; // compiles waiting for a compile thread
+   uint64_t outstanding_compiles = 0; // compiles on a compile thread
+   uint64_t canceled_compiles    = 0; // queued compiles dropped because the code was replaced
+   // from the first execution that queued a compile to its code entering the cache
+   histogram_counts<compile_latency_bounds_ms.size()> compile_latency_ms;
+   // number of compiles already waiting each time another is queued
+   histogram_counts<queue_depth_bounds.size()>        queue_depth;
+};
+
+/**
+ * Segmented LRU ordering of the sequenced index of a multi_index_container: [protected MRU..LRU][probation MRU..LRU].
+ * New entries start at the head of the probation segment and move to the protected segment only when they are used
+ * again, so a burst of codes used once is evicted from the back of the probation segment without pushing out the codes
+ * that are used over and over. The protected segment is capped at protected_percent of the entries; its least recently
+ * used entries drop back to the head of the probation segment. A protected_percent of 0 is plain LRU.
+ * All changes to the container must go through this class. Not thread safe.
+ */
+template <typename Container>
+class segmented_lru {
+   public:
+      using iterator   = typename Container::iterator;
+      using value_type = typename Container::value_type;
+
+      segmented_lru(Container& c, uint32_t protected_percent)
+         : _c(c), _protected_percent(protected_percent), _probation_begin(c.end()) {}
+
+      /// adds v at the head of the probation segment
+      std::pair<iterator, bool> insert(const value_type& v) {
+         auto r = _c.insert(_probation_begin, v);
+         if(r.second)
+            _probation_begin = r.first;
+         return r;
+      }
+
+      /// adds v at the tail of the probation segment, for loading entries in MRU to LRU order
+      std::pair<iterator, bool> push_back(const value_type& v) {
+         auto r = _c.push_back(v);
+         if(r.second && _probation_begin == _c.end())
+            _probation_begin = r.first;
+         return r;
+      }
+
+      /// records a use of it, moving it to the head of the protected segment
+      void touch(iterator it) {
+         if(_protected.count(&*it)) {
+            _c.relocate(_c.begin(), it);
+            return;
+         }
+         if(it == _probation_begin)
+            ++_probation_begin;
+         _c.relocate(_c.begin(), it);
+         _protected.insert(&*it);
+         while(_protected.size() * 100 > _c.size() * _protected_percent) {
+            --_probation_begin;
+            _protected.erase(&*_probation_begin);
+         }
+      }
+
+      iterator erase(iterator it) {
+         _protected.erase(&*it);
+         if(it == _probation_begin)
+            ++_probation_begin;
+         return _c.erase(it);
+      }
+
+      /// removes the entry next in line for eviction
+      void pop_back() { erase(std::prev(_c.end())); }
+
+      bool   is_protected(iterator it) const { return _protected.count(&*it); }
+      size_t protected_size() const { return _protected.size(); }
+
+   private:
+      Container&                            _c;
+      const uint32_t                        _protected_percent;
+      iterator                              _probation_begin;
+      std::unordered_set<const value_type*> _protected;
+};
+
+/**
+ * Admits a key only once it has been seen threshold times, so that keys seen just once or twice do not displace what
+ * is already cached. Like TinyLFU, once sample_size sightings are counted all counts are halved and the keys left at 0
+ * dropped, which both bounds the memory used and lets old sightings fade. A threshold of 0 or 1 admits every key.
+ * Not thread safe.
+ */
+template <typename Key, typename Hash = std::hash<Key>>
+class admission_filter {
+   public:
+      explicit admission_filter(uint32_t threshold, uint64_t sample_size = 64u*1024u)
+         : _threshold(threshold), _sample_size(sample_size) {}
+
+      bool admit(const Key& k) {
+         if(_threshold <= 1)
+            return true;
+         auto it = _counts.try_emplace(k, 0).first;
+         if(++it->second >= _threshold) {
+            _sightings -= it->second - 1;
+            _counts.erase(it);
+            return true;
+         }
+         if(++_sightings >= _sample_size)
+            age();
+         return false;
+      }
+
+      uint32_t count(const Key& k) const {
+         auto it = _counts.find(k);
+         return it == _counts.end() ? 0 : it->second;
+      }
+
+      size_t size() const { return _counts.size(); }
+
+   private:
+      void age() {
+         _sightings = 0;
+         for(auto it = _counts.begin(); it != _counts.end();) {
+            it->second /= 2;
+            _sightings += it->second;
+            it = it->second ? std::next(it) : _counts.erase(it);
+         }
+      }
+
+      const uint32_t                         _threshold;
+      const uint64_t                         _sample_size;
+      uint64_t                               _sightings = 0;
+      std::unordered_map<Key, uint32_t, Hash> _counts;
+};
+
+}}}
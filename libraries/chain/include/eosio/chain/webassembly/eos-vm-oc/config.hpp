@@ -18,6 +18,14 @@ namespace eosio { namespace chain { namespace eosvmoc {
 struct config {
    uint64_t cache_size = 1024u*1024u*1024u;
    uint64_t threads    = 1u;
+   // number of the codes executed most before the last shutdown to compile at startup, 0 disables the warm up.
+   // only used by the code cache, so it is not sent to the compile monitor.
+   uint32_t warmup_contracts = 0u;
+   // percent of the cached codes kept in the protected segment of the segmented LRU eviction, 0 is plain LRU.
+   // codes outside eosio.* are compiled only once they have been executed admission_threshold times.
+   // only used by the code cache, so they are not sent to the compile monitor either.
+   uint32_t protected_percent   = 80u;
+   uint32_t admission_threshold = 1u;
 
    // subjective limits for OC compilation.
    // nodeos enforces the limits by the default values.
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <eosio/chain/webassembly/eos-vm-oc/ipc_protocol.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace eosio { namespace chain { namespace eosvmoc {
+
+/**
+ * Counts how often each code is executed so that the codes that were hot before a restart can be compiled ahead of
+ * their first use after it. The counts are saved on shutdown and halved when loaded again, so codes that are no
+ * longer used age out over a few restarts. Not thread safe.
+ */
+class hot_code_tracker {
+   public:
+      static constexpr uint32_t file_version = 1;
+
+      using entry = std::pair<code_tuple, uint64_t>;
+
+      void record(const code_tuple& ct) { ++_counts[ct]; }
+
+      uint64_t count(const code_tuple& ct) const {
+         auto it = _counts.find(ct);
+         return it == _counts.end() ? 0 : it->second;
+      }
+
+      size_t size() const { return _counts.size(); }
+
+      /// up to n codes with the highest counts, hottest first
+      std::vector<code_tuple> hottest(size_t n) const {
+         std::vector<code_tuple> r;
+         for(const entry& e : top(n))
+            r.push_back(e.first);
+         return r;
+      }
+
+      /// saves the counts of the max_entries hottest codes, replacing path only once they are written out
+      void save(const std::filesystem::path& path, size_t max_entries) const {
+         const std::vector<char> data = fc::raw::pack(file_version, top(max_entries));
+         std::filesystem::path tmp_path = path;
+         tmp_path += ".tmp";
+         {
+            std::ofstream ofs(tmp_path.generic_string(), std::ofstream::binary | std::ofstream::trunc);
+            ofs.write(data.data(), data.size());
+            if(!ofs.good())
+               return;
+         }
+         std::filesystem::rename(tmp_path, path);
+      }
+
+      /// replaces the counts with the halved counts saved to path; a missing or unreadable file leaves no counts
+      void load(const std::filesystem::path& path) {
+         _counts.clear();
+         std::ifstream ifs(path.generic_string(), std::ifstream::binary);
+         if(!ifs.good())
+            return;
+         const std::vector<char> data{std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+         try {
+            fc::datastream<const char*> ds(data.data(), data.size());
+            uint32_t version = 0;
+            fc::raw::unpack(ds, version);
+            if(version != file_version)
+               return;
+            std::vector<entry> entries;
+            fc::raw::unpack(ds, entries);
+            for(const entry& e : entries) {
+               if(e.second / 2)
+                  _counts[e.first] = e.second / 2;
+            }
+         } catch(...) {
+            _counts.clear();
+         }
+      }
+
+   private:
+      std::vector<entry> top(size_t n) const {
+         std::vector<entry> v(_counts.begin(), _counts.end());
+         n = std::min(n, v.size());
+         std::partial_sort(v.begin(), v.begin() + n, v.end(), [](const entry& a, const entry& b) {
+            return a.second > b.second || (a.second == b.second && a.first.code_id < b.first.code_id);
+         });
+         v.resize(n);
+         return v;
+      }
+
+      std::unordered_map<code_tuple, uint64_t> _counts;
+};
+
+}}}
@@ -60,6 +60,14 @@ using eosvmoc_message = std::variant<initialize_message,
                                      wasm_compilation_result_message>;
 }}}
 
+namespace std {
+    template<> struct hash<eosio::chain::eosvmoc::code_tuple> {
+        size_t operator()(const eosio::chain::eosvmoc::code_tuple& ct) const noexcept {
+            return ct.code_id._hash[0];
+        }
+    };
+}
+
 FC_REFLECT(eosio::chain::eosvmoc::initialize_message, )
 FC_REFLECT(eosio::chain::eosvmoc::initalize_response_message, (error_message))
 FC_REFLECT(eosio::chain::eosvmoc::code_tuple, (code_id)(vm_version))
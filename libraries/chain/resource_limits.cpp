@@ -79,9 +79,9 @@ size_t resource_limits_manager::expected_snapshot_row_count() const {
    return ret;
 }
 
-void resource_limits_manager::add_to_snapshot( const snapshot_writer_ptr& snapshot, snapshot_written_row_counter& row_counter ) const {
-   resource_index_set::walk_indices([this, &snapshot, &row_counter]( auto utils ){
-      snapshot->write_section<typename decltype(utils)::index_t::value_type>([this, &row_counter]( auto& section ){
+void resource_limits_manager::add_to_snapshot( const snapshot_writer_ptr& snapshot, snapshot_written_row_counter& row_counter, boost::asio::io_context& ctx ) const {
+   resource_index_set::walk_indices([this, &snapshot, &row_counter, &ctx]( auto utils ){
+      snapshot->write_section_via_post<typename decltype(utils)::index_t::value_type>(ctx, [this, &row_counter]( auto& section ){
          decltype(utils)::walk(_db, [this, &section, &row_counter]( const auto &row ) {
             section.add_row(row, _db);
             row_counter.progress();
@@ -2,15 +2,24 @@
 
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/merkle.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/scoped_exit.hpp>
 #include <fc/io/json.hpp>
 
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/counter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
 #include <rapidjson/document.h>
 #include <rapidjson/filereadstream.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
 using namespace eosio_rapidjson;
+namespace bio = boost::iostreams;
 
 namespace eosio { namespace chain {
 
@@ -470,23 +479,59 @@ size_t istream_json_snapshot_reader::total_row_count() {
    return total;
 }
 
+namespace {
+   using magic_number_t = std::decay_t<decltype(ostream_snapshot_writer::magic_number)>;
+   using version_t = std::decay_t<decltype(current_snapshot_version)>;
+   constexpr uint64_t snapshot_header_size = sizeof(magic_number_t) + sizeof(version_t);
+
+   // per-thread section stream of a threaded_snapshot_writer/threaded_snapshot_reader
+   thread_local bio::filtering_ostream section_out;
+   thread_local bio::filtering_istream section_in;
+}
+
 threaded_snapshot_reader::threaded_snapshot_reader(const std::filesystem::path& snapshot_path) :
   snapshot_file(snapshot_path, fc::random_access_file::read_only),
   mapped_snap(snapshot_file, boost::interprocess::read_only),
-  mapped_snap_addr((char*)mapped_snap.get_address()) {}
+  mapped_snap_addr((char*)mapped_snap.get_address()),
+  compressed(mapped_snap.get_size() >= sizeof(magic_number_t) &&
+             snapshot_file.unpack_from<magic_number_t>(0) == threaded_snapshot_writer::compressed_magic_number) {
+   if(compressed)
+      compressed_index = read_compressed_index();
+}
+
+std::vector<snapshot_section_index_entry> threaded_snapshot_reader::read_compressed_index() const {
+   const uint64_t file_size = mapped_snap.get_size();
+   EOS_ASSERT(file_size >= snapshot_header_size + sizeof(uint64_t), snapshot_exception, "Compressed snapshot too short");
+
+   uint64_t index_offset;
+   memcpy(&index_offset, mapped_snap_addr + file_size - sizeof(uint64_t), sizeof(index_offset));
+   EOS_ASSERT(index_offset >= snapshot_header_size && index_offset <= file_size - sizeof(uint64_t), snapshot_exception,
+              "Compressed snapshot has invalid section index offset");
+
+   std::vector<snapshot_section_index_entry> index;
+   fc::datastream<const char*> index_ds(mapped_snap_addr + index_offset, file_size - sizeof(uint64_t) - index_offset);
+   fc::raw::unpack(index_ds, index);
+
+   for(const snapshot_section_index_entry& e : index)
+      EOS_ASSERT(e.offset >= snapshot_header_size && e.offset <= index_offset && e.size <= index_offset - e.offset, snapshot_exception,
+                 "Compressed snapshot section ${n} out of bounds", ("n", e.name));
+
+   return index;
+}
 
 void threaded_snapshot_reader::validate() {
    try {
-      using magic_number_t = std::decay_t<decltype(ostream_snapshot_writer::magic_number)>;
-      using version_t = std::decay_t<decltype(current_snapshot_version)>;
-
-      EOS_ASSERT(snapshot_file.unpack_from<magic_number_t>(0) == ostream_snapshot_writer::magic_number, snapshot_exception, "Binary snapshot has unexpected magic number!");
+      const magic_number_t expected_magic = compressed ? threaded_snapshot_writer::compressed_magic_number : ostream_snapshot_writer::magic_number;
+      EOS_ASSERT(snapshot_file.unpack_from<magic_number_t>(0) == expected_magic, snapshot_exception, "Binary snapshot has unexpected magic number!");
 
       const version_t actual_version = snapshot_file.unpack_from<version_t>(sizeof(magic_number_t));
       EOS_ASSERT(actual_version == current_snapshot_version, snapshot_exception, "Binary snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
                                                                                  ("expected", current_snapshot_version)("actual", actual_version));
 
-      uint64_t next_section_offs = sizeof(magic_number_t) + sizeof(version_t);
+      if(compressed)
+         return; //index was validated on construction
+
+      uint64_t next_section_offs = snapshot_header_size;
       while(true) {
          const uint64_t this_section_size = snapshot_file.unpack_from<uint64_t>(next_section_offs);
          if(this_section_size == std::numeric_limits<uint64_t>::max())
@@ -497,10 +542,24 @@ void threaded_snapshot_reader::validate() {
 }
 
 void threaded_snapshot_reader::set_section(const string& section_name) {
-   using magic_number_t = std::decay_t<decltype(ostream_snapshot_writer::magic_number)>;
-   using version_t = std::decay_t<decltype(current_snapshot_version)>;
+   if(compressed) {
+      for(const snapshot_section_index_entry& e : compressed_index) {
+         if(e.name == section_name) {
+            cur_row = 0;
+            num_rows = e.row_count;
+            cur_section_compressed = true;
+            section_in.reset();
+            section_in.clear();
+            section_in.push(bio::zlib_decompressor());
+            section_in.push(bio::array_source(mapped_snap_addr + e.offset, e.size));
+            section_in.exceptions(std::istream::failbit | std::istream::eofbit);
+            return;
+         }
+      }
+      EOS_THROW(snapshot_exception, "Binary snapshot has no section named ${n}", ("n", section_name));
+   }
 
-   uint64_t next_section_offs = sizeof(magic_number_t) + sizeof(version_t);
+   uint64_t next_section_offs = snapshot_header_size;
    while(true) {
       const uint64_t this_section_size      = snapshot_file.unpack_from<uint64_t>(next_section_offs);
       const uint64_t this_section_row_count = snapshot_file.unpack_from<uint64_t>(next_section_offs + sizeof(uint64_t));
@@ -513,6 +572,7 @@ void threaded_snapshot_reader::set_section(const string& section_name) {
       if(strncmp(section_name.c_str(), mapped_snap_addr+section_name_offset, section_name.size() + 1) == 0) {
          cur_row = 0;
          num_rows = this_section_row_count;
+         cur_section_compressed = false;
          ds = fc::datastream<const char*>(mapped_snap_addr+section_data_offset, mapped_snap.get_size() - section_data_offset);
          return;
       }
@@ -524,7 +584,10 @@ void threaded_snapshot_reader::set_section(const string& section_name) {
 }
 
 bool threaded_snapshot_reader::read_row(detail::abstract_snapshot_row_reader& row_reader) {
-   row_reader.provide(ds);
+   if(cur_section_compressed)
+      row_reader.provide(section_in);
+   else
+      row_reader.provide(ds);
    return ++cur_row < num_rows;
 }
 
@@ -533,9 +596,13 @@ bool threaded_snapshot_reader::empty ( ) {
 }
 
 void threaded_snapshot_reader::clear_section() {
+   if(cur_section_compressed) {
+      section_in.reset();
+      cur_section_compressed = false;
+   }
 #ifdef __linux__
    //this might work elsewhere, but unsure about alignment requirements on madvise() elsewhere
-   if(num_rows) {
+   else if(num_rows) {
       uintptr_t endp = (uintptr_t)ds.pos();
       ds.seekp(0);
       uintptr_t p = (uintptr_t)ds.pos();
@@ -551,21 +618,176 @@ void threaded_snapshot_reader::return_to_header() {
 }
 
 size_t threaded_snapshot_reader::total_row_count() {
-   using magic_number_t = std::decay_t<decltype(ostream_snapshot_writer::magic_number)>;
-   using version_t = std::decay_t<decltype(current_snapshot_version)>;
-
    size_t total = 0;
-   uint64_t next_section_offs = sizeof(magic_number_t) + sizeof(version_t);
+   for(const snapshot_section_index_entry& e : section_index())
+      total += e.row_count;
+   return total;
+}
+
+std::vector<snapshot_section_index_entry> threaded_snapshot_reader::section_index() const {
+   if(compressed)
+      return compressed_index;
+
+   std::vector<snapshot_section_index_entry> index;
+   uint64_t next_section_offs = snapshot_header_size;
    while(true) {
       const uint64_t this_section_size = snapshot_file.unpack_from<uint64_t>(next_section_offs);
       if(this_section_size == std::numeric_limits<uint64_t>::max())
          break;
 
-      total += snapshot_file.unpack_from<uint64_t>(next_section_offs + sizeof(uint64_t));
-      next_section_offs = next_section_offs + this_section_size + sizeof(uint64_t);
+      snapshot_section_index_entry& e = index.emplace_back();
+      e.row_count = snapshot_file.unpack_from<uint64_t>(next_section_offs + sizeof(uint64_t));
+      const uint64_t section_name_offset = next_section_offs + sizeof(uint64_t) + sizeof(uint64_t);
+      e.name = std::string(mapped_snap_addr + section_name_offset, strnlen(mapped_snap_addr + section_name_offset, mapped_snap.get_size() - section_name_offset));
+      e.offset = section_name_offset + e.name.size() + 1;
+      e.size = e.uncompressed_size = next_section_offs + sizeof(uint64_t) + this_section_size - e.offset;
+
+      next_section_offs += sizeof(this_section_size) + this_section_size;
+   }
+   return index;
+}
+
+void threaded_snapshot_reader::copy_section_data( const snapshot_section_index_entry& section, std::ostream& out ) const {
+   if(!compressed) {
+      out.write(mapped_snap_addr + section.offset, section.size);
+      return;
+   }
+   bio::filtering_istream in;
+   in.push(bio::zlib_decompressor());
+   in.push(bio::array_source(mapped_snap_addr + section.offset, section.size));
+   char buf[64*1024];
+   while(in) {
+      in.read(buf, sizeof(buf));
+      out.write(buf, in.gcount());
    }
+   EOS_ASSERT(in.eof(), snapshot_exception, "Failed to decompress snapshot section ${n}", ("n", section.name));
+}
 
-   return total;
+threaded_snapshot_writer::threaded_snapshot_writer(const std::filesystem::path& snapshot_path, snapshot_compression compression)
+:snapshot_path(snapshot_path)
+,compression(compression)
+,sections_dir(snapshot_path.parent_path().empty() ? std::filesystem::current_path() : snapshot_path.parent_path())
+{
+}
+
+size_t threaded_snapshot_writer::find_or_reserve_section( const std::string& section_name ) {
+   std::lock_guard g(sections_mtx);
+   for(size_t i = 0; i < sections.size(); ++i)
+      if(sections[i].name == section_name)
+         return i;
+   sections.emplace_back(section_info{section_name, sections_dir.path() / (std::to_string(sections.size()) + ".section")});
+   return sections.size() - 1;
+}
+
+void threaded_snapshot_writer::reserve_section( const std::string& section_name ) {
+   find_or_reserve_section(section_name);
+}
+
+void threaded_snapshot_writer::write_start_section( const std::string& section_name ) {
+   EOS_ASSERT(cur_section == nullptr, snapshot_exception, "Attempting to write a new section without closing the previous section");
+   const size_t idx = find_or_reserve_section(section_name);
+   {
+      std::lock_guard g(sections_mtx);
+      cur_section = &sections[idx];
+   }
+   EOS_ASSERT(!cur_section->written, snapshot_exception, "Snapshot section ${n} written more than once", ("n", section_name));
+
+   section_out.reset();
+   section_out.clear();
+   section_out.push(bio::counter());
+   if(compression == snapshot_compression::zlib)
+      section_out.push(bio::zlib_compressor(bio::zlib::default_compression));
+   section_out.push(bio::file_sink(cur_section->temp_path.string(), std::ios::out | std::ios::binary | std::ios::trunc));
+   EOS_ASSERT(section_out.good(), snapshot_exception, "Failed to open temporary snapshot section file ${f}", ("f", cur_section->temp_path));
+   cur_section->row_count = 0;
+}
+
+void threaded_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
+   detail::ostream_wrapper out(section_out);
+   row_writer.write(out);
+   cur_section->row_count++;
+}
+
+void threaded_snapshot_writer::write_end_section( ) {
+   cur_section->uncompressed_size = section_out.component<bio::counter>(0)->characters();
+   section_out.reset(); //flushes and closes the chain
+   EOS_ASSERT(!section_out.fail(), snapshot_exception, "Failed to write temporary snapshot section file ${f}", ("f", cur_section->temp_path));
+   cur_section->written = true;
+   cur_section = nullptr;
+}
+
+void threaded_snapshot_writer::write_raw_section( const std::string& section_name, uint64_t row_count, const std::function<void(std::ostream&)>& write_data ) {
+   write_start_section(section_name);
+   write_data(section_out);
+   cur_section->row_count = row_count;
+   write_end_section();
+}
+
+void threaded_snapshot_writer::finalize() {
+   std::lock_guard g(sections_mtx);
+
+   std::ofstream out(snapshot_path, std::ios::out | std::ios::binary | std::ios::trunc);
+   EOS_ASSERT(out.good(), snapshot_exception, "Failed to open snapshot file ${f}", ("f", snapshot_path));
+
+   auto totem = compression == snapshot_compression::none ? ostream_snapshot_writer::magic_number : compressed_magic_number;
+   out.write((char*)&totem, sizeof(totem));
+   auto version = current_snapshot_version;
+   out.write((char*)&version, sizeof(version));
+
+   std::vector<snapshot_section_index_entry> index;
+   for(section_info& section : sections) {
+      EOS_ASSERT(section.written, snapshot_exception, "Snapshot section ${n} was reserved but never written", ("n", section.name));
+
+      const uint64_t data_size = std::filesystem::file_size(section.temp_path);
+      if(compression == snapshot_compression::none) {
+         // section size does not include the section size record itself; see ostream_snapshot_writer
+         const uint64_t section_size = sizeof(section.row_count) + section.name.size() + 1 + data_size;
+         out.write((char*)&section_size, sizeof(section_size));
+         out.write((char*)&section.row_count, sizeof(section.row_count));
+         out.write(section.name.data(), section.name.size());
+         out.put(0);
+      } else {
+         index.emplace_back(snapshot_section_index_entry{section.name, (uint64_t)out.tellp(), data_size, section.uncompressed_size, section.row_count});
+      }
+
+      if(data_size) {
+         std::ifstream in(section.temp_path, std::ios::in | std::ios::binary);
+         out << in.rdbuf();
+      }
+      std::filesystem::remove(section.temp_path);
+   }
+
+   if(compression == snapshot_compression::none) {
+      uint64_t end_marker = std::numeric_limits<uint64_t>::max();
+      out.write((char*)&end_marker, sizeof(end_marker));
+   } else {
+      const uint64_t index_offset = out.tellp();
+      const std::vector<char> packed_index = fc::raw::pack(index);
+      out.write(packed_index.data(), packed_index.size());
+      out.write((char*)&index_offset, sizeof(index_offset));
+   }
+   out.flush();
+   EOS_ASSERT(!out.fail(), snapshot_exception, "Failed to write snapshot file ${f}", ("f", snapshot_path));
+}
+
+void convert_snapshot( const std::filesystem::path& in_path, const std::filesystem::path& out_path, snapshot_compression compression,
+                       unsigned threads ) {
+   threaded_snapshot_reader reader(in_path);
+   reader.validate();
+   threaded_snapshot_writer writer(out_path, compression);
+
+   sync_threaded_work<struct snapconvert> convert_workqueue;
+   for(const snapshot_section_index_entry& section : reader.section_index()) {
+      writer.reserve_section(section.name);
+      boost::asio::post(convert_workqueue.io_context(), [&reader, &writer, section]() {
+         writer.write_raw_section(section.name, section.row_count, [&](std::ostream& out) {
+            reader.copy_section_data(section, out);
+         });
+      });
+   }
+
+   convert_workqueue.run(std::max(threads, 1u));
+   writer.finalize();
 }
 
 integrity_hash_snapshot_writer::integrity_hash_snapshot_writer(fc::sha256::encoder& enc)
@@ -590,4 +812,55 @@ void integrity_hash_snapshot_writer::finalize() {
    // no-op for structural details
 }
 
+size_t section_integrity_hash_snapshot_writer::find_or_reserve_section( const std::string& section_name ) {
+   std::lock_guard g(sections_mtx);
+   for(size_t i = 0; i < sections.size(); ++i)
+      if(sections[i].name == section_name)
+         return i;
+   sections.emplace_back(snapshot_section_hash{section_name});
+   return sections.size() - 1;
+}
+
+void section_integrity_hash_snapshot_writer::reserve_section( const std::string& section_name ) {
+   find_or_reserve_section(section_name);
+}
+
+void section_integrity_hash_snapshot_writer::write_start_section( const std::string& section_name ) {
+   EOS_ASSERT(cur_section == nullptr, snapshot_exception, "Attempting to hash a new section without closing the previous section");
+   const size_t idx = find_or_reserve_section(section_name);
+   {
+      std::lock_guard g(sections_mtx);
+      cur_section = &sections[idx];
+   }
+   if(!section_enc)
+      section_enc.emplace();
+   section_enc->reset();
+   cur_section->row_count = 0;
+}
+
+void section_integrity_hash_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
+   row_writer.write(*section_enc);
+   cur_section->row_count++;
+}
+
+void section_integrity_hash_snapshot_writer::write_end_section( ) {
+   cur_section->hash = section_enc->result();
+   cur_section = nullptr;
+}
+
+snapshot_section_hashes section_integrity_hash_snapshot_writer::finalize() {
+   std::lock_guard g(sections_mtx);
+
+   snapshot_section_hashes result;
+   result.sections.assign(sections.begin(), sections.end());
+
+   std::vector<digest_type> digests;
+   digests.reserve(result.sections.size());
+   for(const snapshot_section_hash& section : result.sections)
+      digests.push_back(section.hash);
+   result.root = calculate_merkle(digests);
+
+   return result;
+}
+
 }}
@@ -51,6 +51,10 @@ void snapshot_scheduler::on_irreversible_block(const signed_block_ptr& lib, cons
 
    while(!snapshots_by_height.empty() && snapshots_by_height.begin()->get_height() <= lib_height) {
       const auto& pending = snapshots_by_height.begin();
+      // a background snapshot still being written is promoted on a later irreversible block
+      if(!pending->is_written())
+         break;
+
       auto next = pending->next;
 
       try {
@@ -118,6 +122,10 @@ void snapshot_scheduler::set_snapshots_path(fs::path sn_path) {
    _snapshots_dir = std::move(sn_path);
 }
 
+void snapshot_scheduler::set_background_snapshots(bool enabled) {
+   _background_snapshots = enabled;
+}
+
 void snapshot_scheduler::add_pending_snapshot_info(const snapshot_information& si) {
    auto& snapshot_by_id = _snapshot_requests.get<by_snapshot_id>();
    auto snapshot_req = snapshot_by_id.find(_inflight_sid);
@@ -178,12 +186,9 @@ void snapshot_scheduler::create_snapshot(next_function<snapshot_information> nex
    auto write_snapshot = [&](const fs::path& p) -> void {
       if(predicate) predicate();
       fs::create_directory(p.parent_path());
-      auto snap_out = std::ofstream(p.generic_string(), (std::ios::out | std::ios::binary));
-      auto writer = std::make_shared<ostream_snapshot_writer>(snap_out);
+      auto writer = std::make_shared<threaded_snapshot_writer>(p);
       chain.write_snapshot(writer);
       writer->finalize();
-      snap_out.flush();
-      snap_out.close();
    };
 
    // If in irreversible mode, create snapshot and return path to snapshot immediately.
@@ -220,6 +225,30 @@ void snapshot_scheduler::create_snapshot(next_function<snapshot_information> nex
    } else {
       const auto& pending_path = pending_snapshot<snapshot_information>::get_pending_path(head_id, _snapshots_dir);
 
+      if(_background_snapshots && chain.can_write_snapshot_in_background()) {
+         try {
+            if(predicate) predicate();
+            fs::create_directory(temp_path.parent_path());
+
+            ilog("Starting background snapshot creation at block ${bn}", ("bn", head_block_num));
+            std::shared_future<void> written = std::async(std::launch::async, [written=chain.write_snapshot_in_background(temp_path), temp_path, pending_path, head_block_num]() mutable {
+               written.get();
+
+               std::error_code ec;
+               fs::rename(temp_path, pending_path, ec);
+               EOS_ASSERT(!ec, snapshot_finalization_exception,
+                          "Unable to promote temp snapshot ${t} to pending ${p} for block number ${bn}: [code: ${ec}] ${message}",
+                          ("t", temp_path.generic_string())("p", pending_path.generic_string())
+                          ("bn", head_block_num)("ec", ec.value())("message", ec.message()));
+            });
+
+            _pending_snapshot_index.emplace(head_id, next, pending_path.generic_string(), snapshot_path.generic_string(), std::move(written));
+            add_pending_snapshot_info(snapshot_information{head_id, head_block_num, head_block_time, chain_snapshot_header::current_version, pending_path.generic_string()});
+         }
+         CATCH_AND_CALL(next);
+         return;
+      }
+
       try {
          ilog("Starting snapshot creation at block ${bn}", ("bn", head_block_num));
          write_snapshot(temp_path);// create a new pending snapshot
@@ -32,8 +32,9 @@
 
 namespace eosio { namespace chain {
 
-   wasm_interface::wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile)
-     : eosvmoc_tierup(eosvmoc_tierup), my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config, profile) ) {}
+   wasm_interface::wasm_interface(vm_type vm, vm_oc_enable eosvmoc_tierup, const chainbase::database& d, const std::filesystem::path data_dir, const eosvmoc::config& eosvmoc_config, bool profile,
+                                  uint64_t instantiation_cache_size)
+     : eosvmoc_tierup(eosvmoc_tierup), my( new wasm_interface_impl(vm, eosvmoc_tierup, d, data_dir, eosvmoc_config, profile, instantiation_cache_size) ) {}
 
    wasm_interface::~wasm_interface() {}
 
@@ -78,6 +79,12 @@ namespace eosio { namespace chain {
 
    void wasm_interface::code_block_num_last_used(const digest_type& code_hash, const uint8_t& vm_type, const uint8_t& vm_version, const uint32_t& block_num) {
       my->code_block_num_last_used(code_hash, vm_type, vm_version, block_num);
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      // the code was replaced, a queued compile of it would be wasted. The compiled code itself is only freed once the
+      // replacement is irreversible, since the block replacing it may still be dropped
+      if (my->eosvmoc)
+         my->eosvmoc->cc.cancel_compile(code_hash, vm_version);
+#endif
    }
 
    void wasm_interface::current_lib(const uint32_t lib) {
@@ -110,6 +117,15 @@ namespace eosio { namespace chain {
             my->eosvmoc->exec->execute(*cd, *my->eosvmoc->mem, context);
             return;
          }
+         if (context.control.is_write_window()) {
+            // the time the code costs on the base runtime decides how soon it is compiled
+            const auto start = fc::time_point::now();
+            auto record = fc::make_scoped_exit([&]() {
+               my->eosvmoc->cc.record_base_runtime_us(code_hash, vm_version, (fc::time_point::now() - start).count());
+            });
+            my->get_instantiated_module(code_hash, vm_type, vm_version, context.trx_context)->apply(context);
+            return;
+         }
       }
 #endif
 
@@ -124,6 +140,19 @@ namespace eosio { namespace chain {
    bool wasm_interface::is_eos_vm_oc_enabled() const {
       return my->is_eos_vm_oc_enabled();
    }
+
+   void wasm_interface::start_eos_vm_oc_warmup() {
+      if (my->eosvmoc)
+         my->eosvmoc->cc.start_warmup();
+   }
+
+   size_t wasm_interface::eos_vm_oc_warmup_remaining() {
+      return my->eosvmoc ? my->eosvmoc->cc.warmup_remaining() : 0;
+   }
+
+   eosvmoc::code_cache_stats wasm_interface::eos_vm_oc_cache_stats() const {
+      return my->eosvmoc ? my->eosvmoc->cc.stats() : eosvmoc::code_cache_stats{};
+   }
 #endif
 
    wasm_instantiated_module_interface::~wasm_instantiated_module_interface() = default;
@@ -2,6 +2,7 @@
 #include <eosio/chain/protocol_state_object.hpp>
 #include <eosio/chain/transaction_context.hpp>
 #include <eosio/chain/apply_context.hpp>
+#include <eosio/chain/contract_profiler.hpp>
 #include <fc/io/datastream.hpp>
 #include <fc/crypto/modular_arithmetic.hpp>
 #include <fc/crypto/blake2.hpp>
@@ -33,6 +34,7 @@ namespace eosio::chain::webassembly {
    void interface::assert_recover_key( legacy_ptr<const fc::sha256> digest,
                                        legacy_span<const char> sig,
                                        legacy_span<const char> pub ) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       fc::crypto::signature s;
       fc::crypto::public_key p;
       fc::datastream<const char*> ds( sig.data(), sig.size() );
@@ -57,6 +59,7 @@ namespace eosio::chain::webassembly {
    int32_t interface::recover_key( legacy_ptr<const fc::sha256> digest,
                                    legacy_span<const char> sig,
                                    legacy_span<char> pub ) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       fc::crypto::signature s;
       fc::datastream<const char*> ds( sig.data(), sig.size() );
       fc::raw::unpack(ds, s);
@@ -91,42 +94,51 @@ namespace eosio::chain::webassembly {
    }
 
    void interface::assert_sha256(legacy_span<const char> data, legacy_ptr<const fc::sha256> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       auto result = context.trx_context.hash_with_checktime<fc::sha256>( data.data(), data.size() );
       EOS_ASSERT( result == *hash_val, crypto_api_exception, "hash mismatch" );
    }
 
    void interface::assert_sha1(legacy_span<const char> data, legacy_ptr<const fc::sha1> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       auto result = context.trx_context.hash_with_checktime<fc::sha1>( data.data(), data.size() );
       EOS_ASSERT( result == *hash_val, crypto_api_exception, "hash mismatch" );
    }
 
    void interface::assert_sha512(legacy_span<const char> data, legacy_ptr<const fc::sha512> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       auto result = context.trx_context.hash_with_checktime<fc::sha512>( data.data(), data.size() );
       EOS_ASSERT( result == *hash_val, crypto_api_exception, "hash mismatch" );
    }
 
    void interface::assert_ripemd160(legacy_span<const char> data, legacy_ptr<const fc::ripemd160> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       auto result = context.trx_context.hash_with_checktime<fc::ripemd160>( data.data(), data.size() );
       EOS_ASSERT( result == *hash_val, crypto_api_exception, "hash mismatch" );
    }
 
    void interface::sha1(legacy_span<const char> data, legacy_ptr<fc::sha1> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       *hash_val = context.trx_context.hash_with_checktime<fc::sha1>( data.data(), data.size() );
    }
 
    void interface::sha256(legacy_span<const char> data, legacy_ptr<fc::sha256> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       *hash_val = context.trx_context.hash_with_checktime<fc::sha256>( data.data(), data.size() );
    }
 
    void interface::sha512(legacy_span<const char> data, legacy_ptr<fc::sha512> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       *hash_val = context.trx_context.hash_with_checktime<fc::sha512>( data.data(), data.size() );
    }
 
    void interface::ripemd160(legacy_span<const char> data, legacy_ptr<fc::ripemd160> hash_val) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       *hash_val = context.trx_context.hash_with_checktime<fc::ripemd160>( data.data(), data.size() );
    }
 
    int32_t interface::alt_bn128_add(span<const char> op1, span<const char> op2, span<char> result ) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if (op1.size() != 64 ||  op2.size() != 64 ||  result.size() < 64 ||
          bn256::g1_add(std::span<const uint8_t, 64>{(const uint8_t*)op1.data(), 64},
                        std::span<const uint8_t, 64>{(const uint8_t*)op2.data(), 64},
@@ -136,6 +148,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::alt_bn128_mul(span<const char> g1_point, span<const char> scalar, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if (g1_point.size() != 64 ||  scalar.size() != 32 ||  result.size() < 64 ||
          bn256::g1_scalar_mul(std::span<const uint8_t, 64>{(const uint8_t*)g1_point.data(), 64},
                               std::span<const uint8_t, 32>{(const uint8_t*)scalar.data(), 32},
@@ -145,6 +158,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::alt_bn128_pair(span<const char> g1_g2_pairs) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       auto checktime = [this]() { context.trx_context.checktime(); };
       auto res = bn256::pairing_check({(const uint8_t*)g1_g2_pairs.data(), g1_g2_pairs.size()} , checktime);
       if (res == -1)
@@ -157,6 +171,7 @@ namespace eosio::chain::webassembly {
                               span<const char> exp,
                               span<const char> modulus,
                               span<char> out) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if (context.control.is_speculative_block()) {
          unsigned int base_modulus_size = std::max(base.size(), modulus.size());
 
@@ -200,6 +215,7 @@ namespace eosio::chain::webassembly {
                                 span<const char> t1_offset,
                                 int32_t final,
                                 span<char> out) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
 
       bool _final = final == 1;
       bytes bstate(state.data(), state.data() + state.size());
@@ -224,6 +240,7 @@ namespace eosio::chain::webassembly {
    }
 
    void interface::sha3( span<const char> input, span<char> output, int32_t keccak ) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       bool _keccak = keccak == 1;
       const size_t bs = eosio::chain::config::hashing_checktime_block_size;
       const char* data = input.data();
@@ -243,6 +260,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::k1_recover( span<const char> signature, span<const char> digest, span<char> pub) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       bytes bsignature(signature.data(), signature.data() + signature.size());
       bytes bdigest(digest.data(), digest.data() + digest.size());
 
@@ -261,6 +279,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_g1_add(span<const char> op1, span<const char> op2, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(op1.size() != 96 ||  op2.size() != 96 ||  result.size() != 96)
          return return_code::failure;
       std::optional<bls12_381::g1> a = bls12_381::g1::fromAffineBytesLE(std::span<const uint8_t, 96>((const uint8_t*)op1.data(), 96), {.check_valid = true, .to_mont = true});
@@ -273,6 +292,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_g2_add(span<const char> op1, span<const char> op2, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(op1.size() != 192 ||  op2.size() != 192 ||  result.size() != 192)
          return return_code::failure;
       std::optional<bls12_381::g2> a = bls12_381::g2::fromAffineBytesLE(std::span<const uint8_t, 192>((const uint8_t*)op1.data(), 192), {.check_valid = true, .to_mont = true});
@@ -285,6 +305,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_g1_weighted_sum(span<const char> points, span<const char> scalars, const uint32_t n, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(n == 0 || points.size() != n*96 ||  scalars.size() != n*32 ||  result.size() != 96)
          return return_code::failure;
 
@@ -320,6 +341,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_g2_weighted_sum(span<const char> points, span<const char> scalars, const uint32_t n, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(n == 0 || points.size() != n*192 ||  scalars.size() != n*32 ||  result.size() != 192)
          return return_code::failure;
 
@@ -355,6 +377,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_pairing(span<const char> g1_points, span<const char> g2_points, const uint32_t n, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(n == 0 || g1_points.size() != n*96 ||  g2_points.size() != n*192 ||  result.size() != 576)
          return return_code::failure;
       std::vector<std::tuple<bls12_381::g1, bls12_381::g2>> v;
@@ -375,6 +398,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_g1_map(span<const char> e, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(e.size() != 48 ||  result.size() != 96)
          return return_code::failure;
       std::optional<bls12_381::fp> a = bls12_381::fp::fromBytesLE(std::span<const uint8_t, 48>((const uint8_t*)e.data(), 48), {.check_valid = true, .to_mont = true});
@@ -386,6 +410,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_g2_map(span<const char> e, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(e.size() != 96 ||  result.size() != 192)
          return return_code::failure;
       std::optional<bls12_381::fp2> a = bls12_381::fp2::fromBytesLE(std::span<const uint8_t, 96>((const uint8_t*)e.data(), 96), {.check_valid = true, .to_mont = true});
@@ -397,6 +422,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_fp_mod(span<const char> s, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       // s is scalar.
       if(s.size() != 64 ||  result.size() != 48)
          return return_code::failure;  
@@ -407,6 +433,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_fp_mul(span<const char> op1, span<const char> op2, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       if(op1.size() != 48 || op2.size() != 48 || result.size() != 48)
          return return_code::failure;
       std::optional<bls12_381::fp> a = bls12_381::fp::fromBytesLE(std::span<const uint8_t, 48>((const uint8_t*)op1.data(), 48), {.check_valid = true, .to_mont = true});
@@ -419,6 +446,7 @@ namespace eosio::chain::webassembly {
    }
 
    int32_t interface::bls_fp_exp(span<const char> base, span<const char> exp, span<char> result) const {
+      intrinsic_timer timer(intrinsic_category::crypto);
       // exp is scalar.
       if(base.size() != 48 || exp.size() != 64 || result.size() != 48)
          return return_code::failure;
@@ -41,10 +41,15 @@ static_assert(sizeof(code_cache_header) <= header_size, "code_cache_header too b
 code_cache_async::code_cache_async(const std::filesystem::path& data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
    code_cache_base(data_dir, eosvmoc_config, db),
    _result_queue(eosvmoc_config.threads * 2),
-   _threads(eosvmoc_config.threads)
+   _threads(eosvmoc_config.threads),
+   _hot_codes_path(data_dir/"code_cache_hot.bin"),
+   _admission(eosvmoc_config.admission_threshold)
 {
    FC_ASSERT(_threads, "EOS VM OC requires at least 1 compile thread");
 
+   if(_eosvmoc_config.warmup_contracts)
+      _hot_codes.load(_hot_codes_path);
+
    wait_on_compile_monitor_message();
 
    _monitor_reply_thread = std::thread([this]() {
@@ -57,6 +62,15 @@ code_cache_async::~code_cache_async() {
    _compile_monitor_write_socket.shutdown(local::datagram_protocol::socket::shutdown_send);
    _monitor_reply_thread.join();
    consume_compile_thread_queue();
+
+   if(_eosvmoc_config.warmup_contracts) {
+      try {
+         //keep more than are warmed up so codes just below the cut can still rise above it
+         _hot_codes.save(_hot_codes_path, _eosvmoc_config.warmup_contracts * 4u);
+      } catch(const std::exception& e) {
+         wlog("failed to save EOS VM OC hot codes to ${p}: ${e}", ("p", _hot_codes_path)("e", e.what()));
+      }
+   }
 }
 
 //remember again: wait_on_compile_monitor_message's callback is non-main thread!
@@ -87,7 +101,10 @@ std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
       if(_outstanding_compiles_and_poison[result.code] == false) {
          std::visit(overloaded {
             [&](const code_descriptor& cd) {
-               _cache_index.push_front(cd);
+               _cache_order.insert(cd);
+               _stats.insertions.fetch_add(1, std::memory_order_relaxed);
+               if(auto it = _compile_requested.find(result.code); it != _compile_requested.end())
+                  _stats.compile_latency_ms.observe((fc::time_point::now() - it->second).count() / 1000);
             },
             [&](const compilation_result_unknownfailure&) {
                wlog("code ${c} failed to tier-up with EOS VM OC", ("c", result.code.code_id));
@@ -99,18 +116,21 @@ std::tuple<size_t, size_t> code_cache_async::consume_compile_thread_queue() {
          }, result.result);
       }
       _outstanding_compiles_and_poison.erase(result.code);
+      _compile_requested.erase(result.code);
       bytes_remaining = result.cache_free_bytes;
    });
+   if(gotsome)
+      update_entries_stats();
 
    return {gotsome, bytes_remaining};
 }
 
 
-const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high_priority, const digest_type& code_id, const uint8_t& vm_version, bool is_write_window, get_cd_failure& failure) {
+//Only call in the write window: all tasks are running sequentially and read-only threads are not running, so it is
+// safe to update cache entries
+void code_cache_async::process_compile_results() {
    //if there are any outstanding compiles, process the result queue now
-   //When app is in write window, all tasks are running sequentially and read-only threads
-   //are not running. Safe to update cache entries.
-   if(is_write_window && _outstanding_compiles_and_poison.size()) {
+   if(_outstanding_compiles_and_poison.size()) {
       auto [count_processed, bytes_remaining] = consume_compile_thread_queue();
 
       if(count_processed)
@@ -121,23 +141,65 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high
 
          //it's not clear this check is required: if apply() was called for code then it existed in the code_index; and then
          // if we got notification of it no longer existing we would have removed it from queued_compiles
-         const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(nextup->code_id, 0, nextup->vm_version));
+         const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(nextup->code.code_id, 0, nextup->code.vm_version));
          if(codeobject) {
-            _outstanding_compiles_and_poison.emplace(*nextup, false);
-            std::vector<wrapped_fd> fds_to_pass;
-            fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-            FC_ASSERT(write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ *nextup, _eosvmoc_config }, fds_to_pass), "EOS VM failed to communicate to OOP manager");
+            FC_ASSERT(start_compile(nextup->code, *codeobject), "EOS VM failed to communicate to OOP manager");
             --count_processed;
+         } else {
+            _compile_requested.erase(nextup->code);
+            _stats.canceled_compiles.fetch_add(1, std::memory_order_relaxed);
          }
          _queued_compiles.erase(nextup);
       }
+      update_compile_stats();
+   }
+
+   //a warm up compile is done once it is neither compiling nor queued, whether it succeeded, failed or was freed
+   if(_warmup_pending.size()) {
+      std::erase_if(_warmup_pending, [&](const code_tuple& ct) {
+         return !_outstanding_compiles_and_poison.count(ct) && !_queued_compiles.get<by_hash>().count(ct);
+      });
+      if(_warmup_pending.empty())
+         ilog("EOS VM OC code cache warm up complete");
+   }
+}
+
+bool code_cache_async::start_compile(const code_tuple& ct, const code_object& codeobject) {
+   _outstanding_compiles_and_poison.emplace(ct, false);
+   _compile_requested.try_emplace(ct, fc::time_point::now());
+   std::vector<wrapped_fd> fds_to_pass;
+   fds_to_pass.emplace_back(memfd_for_bytearray(codeobject.code));
+   return write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, _eosvmoc_config }, fds_to_pass);
+}
+
+void code_cache_async::queue_compile(const code_tuple& ct, bool high_priority) {
+   _stats.queue_depth.observe(_queued_compiles.size());
+   _queued_compiles.emplace(queued_compile{ .code = ct, .high_priority = high_priority, .seq = _queued_compiles_seq++ });
+   _compile_requested.try_emplace(ct, fc::time_point::now());
+}
+
+void code_cache_async::record_base_runtime_us(const digest_type& code_id, const uint8_t& vm_version, uint64_t us) {
+   auto& idx = _queued_compiles.get<by_hash>();
+   if(auto it = idx.find(code_tuple{code_id, vm_version}); it != idx.end())
+      idx.modify(it, [us](queued_compile& q) { q.base_runtime_us += us; });
+}
+
+const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high_priority, const digest_type& code_id, const uint8_t& vm_version, bool is_write_window, get_cd_failure& failure) {
+   if(is_write_window) {
+      process_compile_results();
+      if(_eosvmoc_config.warmup_contracts)
+         _hot_codes.record(code_tuple{code_id, vm_version});
    }
 
    //check for entry in cache
    code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version));
-   if(it != _cache_index.get<by_hash>().end()) {
-      if (is_write_window)
-         _cache_index.relocate(_cache_index.begin(), _cache_index.project<0>(it));
+   const bool hit = it != _cache_index.get<by_hash>().end();
+   count_lookup(hit);
+   if(hit) {
+      if (is_write_window) {
+         _cache_order.touch(_cache_index.project<0>(it));
+         update_entries_stats();
+      }
       return &*it;
    }
    if(!is_write_window) {
@@ -156,16 +218,21 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high
       it->second = false;
       return nullptr;
    }
-   if(auto it = _queued_compiles.get<by_hash>().find(boost::make_tuple(std::ref(code_id), vm_version)); it != _queued_compiles.get<by_hash>().end()) {
+   if(_queued_compiles.get<by_hash>().count(ct)) {
       failure = get_cd_failure::temporary; // Compile might not be done yet
       return nullptr;
    }
 
+   //system contracts are always compiled, others only once they have been executed often enough to be worth the space
+   if(!high_priority && !_admission.admit(ct)) {
+      _stats.admission_rejections.fetch_add(1, std::memory_order_relaxed);
+      failure = get_cd_failure::temporary; // Compile might start on a later execution
+      return nullptr;
+   }
+
    if(_outstanding_compiles_and_poison.size() >= _threads) {
-      if (high_priority)
-         _queued_compiles.push_front(ct);
-      else
-         _queued_compiles.push_back(ct);
+      queue_compile(ct, high_priority);
+      update_compile_stats();
       failure = get_cd_failure::temporary; // Compile might not be done yet
       return nullptr;
    }
@@ -176,14 +243,43 @@ const code_descriptor* const code_cache_async::get_descriptor_for_code(bool high
       return nullptr;
    }
 
-   _outstanding_compiles_and_poison.emplace(ct, false);
-   std::vector<wrapped_fd> fds_to_pass;
-   fds_to_pass.emplace_back(memfd_for_bytearray(codeobject->code));
-   write_message_with_fds(_compile_monitor_write_socket, compile_wasm_message{ ct, _eosvmoc_config }, fds_to_pass);
+   start_compile(ct, *codeobject);
+   update_compile_stats();
    failure = get_cd_failure::temporary; // Compile might not be done yet
    return nullptr;
 }
 
+void code_cache_async::start_warmup() {
+   if(!_eosvmoc_config.warmup_contracts)
+      return;
+
+   for(const code_tuple& ct : _hot_codes.hottest(_eosvmoc_config.warmup_contracts)) {
+      if(_cache_index.get<by_hash>().count(boost::make_tuple(ct.code_id, ct.vm_version)) ||
+         _blacklist.count(ct) || _outstanding_compiles_and_poison.count(ct) || _queued_compiles.get<by_hash>().count(ct))
+         continue;
+      //the code may have been replaced since it was hot
+      const code_object* const codeobject = _db.find<code_object,by_code_hash>(boost::make_tuple(ct.code_id, 0, ct.vm_version));
+      if(!codeobject)
+         continue;
+
+      //use all the compile threads, the rest is dispatched as compiles complete
+      _warmup_pending.insert(ct);
+      if(_outstanding_compiles_and_poison.size() < _threads)
+         start_compile(ct, *codeobject);
+      else
+         queue_compile(ct, false);
+   }
+   update_compile_stats();
+
+   ilog("EOS VM OC code cache warm up compiling ${n} of the ${h} hottest codes",
+        ("n", _warmup_pending.size())("h", std::min<size_t>(_eosvmoc_config.warmup_contracts, _hot_codes.size())));
+}
+
+size_t code_cache_async::warmup_remaining() {
+   process_compile_results();
+   return _warmup_pending.size();
+}
+
 code_cache_sync::~code_cache_sync() {
    //it's exceedingly critical that we wait for the compile monitor to be done with all its work
    //This is easy in the sync case
@@ -196,9 +292,13 @@ code_cache_sync::~code_cache_sync() {
 const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const digest_type& code_id, const uint8_t& vm_version, bool is_write_window) {
    //check for entry in cache
    code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version));
-   if(it != _cache_index.get<by_hash>().end()) {
-      if (is_write_window)
-         _cache_index.relocate(_cache_index.begin(), _cache_index.project<0>(it));
+   const bool hit = it != _cache_index.get<by_hash>().end();
+   count_lookup(hit);
+   if(hit) {
+      if (is_write_window) {
+         _cache_order.touch(_cache_index.project<0>(it));
+         update_entries_stats();
+      }
       return &*it;
    }
    if(!is_write_window)
@@ -221,10 +321,14 @@ const code_descriptor* const code_cache_sync::get_descriptor_for_code_sync(const
 
    check_eviction_threshold(result.cache_free_bytes);
 
-   return &*_cache_index.push_front(std::move(std::get<code_descriptor>(result.result))).first;
+   const code_descriptor* const cd = &*_cache_order.insert(std::get<code_descriptor>(result.result)).first;
+   _stats.insertions.fetch_add(1, std::memory_order_relaxed);
+   update_entries_stats();
+   return cd;
 }
 
 code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eosvmoc::config& eosvmoc_config, const chainbase::database& db) :
+   _cache_order(_cache_index, eosvmoc_config.protected_percent),
    _db(db),
    _eosvmoc_config(eosvmoc_config),
    _cache_file_path(data_dir/"code_cache.bin") {
@@ -306,13 +410,15 @@ code_cache_base::code_cache_base(const std::filesystem::path& data_dir, const eo
             allocator->deallocate(code_mapping + cd.initdata_begin);
             continue;
          }
-         _cache_index.push_back(std::move(cd));
+         //whether a code was protected is not kept, so each has to be used again after a restart to become protected
+         _cache_order.push_back(cd);
       }
       allocator->deallocate(code_mapping + cache_header.serialized_descriptor_index);
 
       ilog("EOS VM Optimized Compiler code cache loaded with ${c} entries; ${f} of ${t} bytes free", ("c", number_entries)("f", allocator->get_free_memory())("t", allocator->get_size()));
    }
    munmap(code_mapping, eosvmoc_config.cache_size);
+   update_entries_stats();
 
    _free_bytes_eviction_threshold = eosvmoc_config.cache_size * .1;
 
@@ -368,7 +474,7 @@ code_cache_base::~code_cache_base() {
       for(unsigned int i = 0; i < 25 && _cache_index.size(); ++i) {
          allocator->deallocate(code_mapping + _cache_index.back().code_begin);
          allocator->deallocate(code_mapping + _cache_index.back().initdata_begin);
-         _cache_index.pop_back();
+         _cache_order.pop_back();
       }
    }
 
@@ -392,12 +498,12 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
    code_cache_index::index<by_hash>::type::iterator it = _cache_index.get<by_hash>().find(boost::make_tuple(code_id, vm_version));
    if(it != _cache_index.get<by_hash>().end()) {
       write_message_with_fds(_compile_monitor_write_socket, evict_wasms_message{ {*it} });
-      _cache_index.get<by_hash>().erase(it);
+      _cache_order.erase(_cache_index.project<0>(it));
+      update_entries_stats();
    }
 
    //if it's in the queued list, erase it
-   if(auto i = _queued_compiles.get<by_hash>().find(boost::make_tuple(std::ref(code_id), vm_version)); i != _queued_compiles.get<by_hash>().end())
-      _queued_compiles.get<by_hash>().erase(i);
+   cancel_compile(code_id, vm_version);
 
    //however, if it's currently being compiled there is no way to cancel the compile,
    //so instead set a poison boolean that indicates not to insert the code in to the cache
@@ -407,15 +513,57 @@ void code_cache_base::free_code(const digest_type& code_id, const uint8_t& vm_ve
       compiling_it->second = true;
 }
 
+bool code_cache_base::cancel_compile(const digest_type& code_id, const uint8_t& vm_version) {
+   const code_tuple ct{code_id, vm_version};
+   auto& idx = _queued_compiles.get<by_hash>();
+   auto it = idx.find(ct);
+   if(it == idx.end())
+      return false;
+   idx.erase(it);
+   _compile_requested.erase(ct);
+   _stats.canceled_compiles.fetch_add(1, std::memory_order_relaxed);
+   update_compile_stats();
+   return true;
+}
+
 void code_cache_base::run_eviction_round() {
    evict_wasms_message evict_msg;
    for(unsigned int i = 0; i < 25 && _cache_index.size() > 1; ++i) {
       evict_msg.codes.emplace_back(_cache_index.back());
-      _cache_index.pop_back();
+      _cache_order.pop_back();
    }
+   _stats.evictions.fetch_add(evict_msg.codes.size(), std::memory_order_relaxed);
+   update_entries_stats();
    write_message_with_fds(_compile_monitor_write_socket, evict_msg);
 }
 
+void code_cache_base::update_entries_stats() {
+   _stats.entries.store(_cache_index.size(), std::memory_order_relaxed);
+   _stats.protected_entries.store(_cache_order.protected_size(), std::memory_order_relaxed);
+}
+
+void code_cache_base::update_compile_stats() {
+   _stats.queued_compiles.store(_queued_compiles.size(), std::memory_order_relaxed);
+   _stats.outstanding_compiles.store(_outstanding_compiles_and_poison.size(), std::memory_order_relaxed);
+}
+
+code_cache_stats code_cache_base::stats() const {
+   return code_cache_stats{
+      .hits                 = _stats.hits.load(std::memory_order_relaxed),
+      .misses               = _stats.misses.load(std::memory_order_relaxed),
+      .insertions           = _stats.insertions.load(std::memory_order_relaxed),
+      .evictions            = _stats.evictions.load(std::memory_order_relaxed),
+      .admission_rejections = _stats.admission_rejections.load(std::memory_order_relaxed),
+      .entries              = _stats.entries.load(std::memory_order_relaxed),
+      .protected_entries    = _stats.protected_entries.load(std::memory_order_relaxed),
+      .queued_compiles      = _stats.queued_compiles.load(std::memory_order_relaxed),
+      .outstanding_compiles = _stats.outstanding_compiles.load(std::memory_order_relaxed),
+      .canceled_compiles    = _stats.canceled_compiles.load(std::memory_order_relaxed),
+      .compile_latency_ms   = _stats.compile_latency_ms.counts(),
+      .queue_depth          = _stats.queue_depth.counts()
+   };
+}
+
 void code_cache_base::check_eviction_threshold(size_t free_bytes) {
    if(free_bytes < _free_bytes_eviction_threshold)
       run_eviction_round();
@@ -212,6 +212,17 @@ public:
       return false;
    }
 
+   //hints that [begin, end) is about to be read sequentially, so the kernel reads it ahead with larger requests
+   //while the current data is processed; a no-op where posix_fadvise is not available
+   void advise_sequential_read(size_t begin, size_t end) const {
+      if(begin >= end)
+         return;
+#if defined(__linux__)
+      posix_fadvise(fileno(), begin, end-begin, POSIX_FADV_SEQUENTIAL);
+      posix_fadvise(fileno(), begin, end-begin, POSIX_FADV_WILLNEED);
+#endif
+   }
+
    size_t filesystem_block_size() const { return _file_blk_size; }
 
    bool eof() const { return feof(_file.get()) != 0; }
@@ -62,6 +62,52 @@ extern const char* const state_history_plugin_abi = R"({
                 { "name": "fetch_finality_data", "type": "bool" }
             ]
         },
+        {
+            "name": "get_blocks_request_v2", "fields": [
+                { "name": "start_block_num", "type": "uint32" },
+                { "name": "end_block_num", "type": "uint32" },
+                { "name": "max_messages_in_flight", "type": "uint32" },
+                { "name": "have_positions", "type": "block_position[]" },
+                { "name": "irreversible_only", "type": "bool" },
+                { "name": "fetch_block", "type": "bool" },
+                { "name": "fetch_traces", "type": "bool" },
+                { "name": "fetch_deltas", "type": "bool" },
+                { "name": "fetch_finality_data", "type": "bool" },
+                { "name": "max_blocks_per_message", "type": "uint32" },
+                { "name": "max_message_bytes", "type": "uint32" }
+            ]
+        },
+        {
+            "name": "table_delta_filter", "fields": [
+                { "name": "code", "type": "name" },
+                { "name": "table", "type": "name" },
+                { "name": "scope", "type": "name" }
+            ]
+        },
+        {
+            "name": "action_trace_filter", "fields": [
+                { "name": "receiver", "type": "name" },
+                { "name": "account", "type": "name" },
+                { "name": "action", "type": "name" }
+            ]
+        },
+        {
+            "name": "get_blocks_request_v3", "fields": [
+                { "name": "start_block_num", "type": "uint32" },
+                { "name": "end_block_num", "type": "uint32" },
+                { "name": "max_messages_in_flight", "type": "uint32" },
+                { "name": "have_positions", "type": "block_position[]" },
+                { "name": "irreversible_only", "type": "bool" },
+                { "name": "fetch_block", "type": "bool" },
+                { "name": "fetch_traces", "type": "bool" },
+                { "name": "fetch_deltas", "type": "bool" },
+                { "name": "fetch_finality_data", "type": "bool" },
+                { "name": "max_blocks_per_message", "type": "uint32" },
+                { "name": "max_message_bytes", "type": "uint32" },
+                { "name": "delta_filters", "type": "table_delta_filter[]" },
+                { "name": "trace_filters", "type": "action_trace_filter[]" }
+            ]
+        },
         {
             "name": "get_blocks_ack_request_v0", "fields": [
                 { "name": "num_messages", "type": "uint32" }
@@ -90,6 +136,11 @@ extern const char* const state_history_plugin_abi = R"({
                 { "name": "finality_data", "type": "bytes?" }
             ]
         },
+        {
+            "name": "get_blocks_result_v2", "fields": [
+                { "name": "blocks", "type": "get_blocks_result_v1[]" }
+            ]
+        },
         {
             "name": "row", "fields": [
                 { "name": "present", "type": "bool" },
@@ -622,8 +673,8 @@ extern const char* const state_history_plugin_abi = R"({
         { "new_type_name": "transaction_id", "type": "checksum256" }
     ],
     "variants": [
-        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0", "get_blocks_request_v1", "get_status_request_v1"] },
-        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0", "get_blocks_result_v1", "get_status_result_v1"] },
+        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0", "get_blocks_request_v1", "get_status_request_v1", "get_blocks_request_v2", "get_blocks_request_v3"] },
+        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0", "get_blocks_result_v1", "get_status_result_v1", "get_blocks_result_v2"] },
 
         { "name": "action_receipt", "types": ["action_receipt_v0"] },
         { "name": "action_trace", "types": ["action_trace_v0", "action_trace_v1"] },
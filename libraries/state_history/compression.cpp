@@ -0,0 +1,207 @@
+#include <eosio/state_history/compression.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/io/fstream.hpp>
+
+#include <boost/iostreams/filter/zlib.hpp>
+
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+#include <zstd.h>
+#endif
+
+#include <vector>
+
+namespace eosio::state_history {
+
+namespace {
+
+// adapts the type erased functions handed to the impls in to devices for the boost zlib filters
+struct sink_ref {
+   typedef char char_type;
+   struct category : bio::sink_tag {};
+   const detail::sink_write_func& f;
+   std::streamsize write(const char* s, std::streamsize n) { return f(s, n); }
+};
+
+struct source_ref {
+   typedef char char_type;
+   struct category : bio::source_tag {};
+   const detail::source_read_func& f;
+   std::streamsize read(char* s, std::streamsize n) { return f(s, n); }
+};
+
+struct zlib_compressor_impl : detail::log_compressor_impl {
+   bio::zlib_compressor compressor{bio::zlib::no_compression};
+
+   std::streamsize write(const detail::sink_write_func& snk, const char* s, std::streamsize n) override {
+      sink_ref sink{snk};
+      return compressor.write(sink, s, n);
+   }
+   void close(const detail::sink_write_func& snk) override {
+      sink_ref sink{snk};
+      compressor.close(sink, std::ios_base::out);
+   }
+};
+
+struct zlib_decompressor_impl : detail::log_decompressor_impl {
+   bio::zlib_decompressor decompressor;
+
+   std::streamsize read(const detail::source_read_func& src, char* s, std::streamsize n) override {
+      source_ref source{src};
+      return decompressor.read(source, s, n);
+   }
+};
+
+} // namespace
+
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+
+struct log_compression::zstd_dictionary {
+   ZSTD_CDict* cdict = nullptr;
+   ZSTD_DDict* ddict = nullptr;
+
+   zstd_dictionary(const std::string& dict, int level) :
+     cdict(ZSTD_createCDict(dict.data(), dict.size(), level)), ddict(ZSTD_createDDict(dict.data(), dict.size())) {
+      EOS_ASSERT(cdict && ddict, chain::plugin_exception, "failed to load zstd dictionary");
+   }
+   zstd_dictionary(const zstd_dictionary&) = delete;
+   zstd_dictionary& operator=(const zstd_dictionary&) = delete;
+   ~zstd_dictionary() {
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+   }
+};
+
+namespace {
+
+void check_zstd(size_t ret) {
+   EOS_ASSERT(!ZSTD_isError(ret), chain::plugin_exception, "zstd error: ${e}", ("e", ZSTD_getErrorName(ret)));
+}
+
+struct zstd_compressor_impl : detail::log_compressor_impl {
+   std::shared_ptr<const log_compression::zstd_dictionary> dictionary; //keeps cdict alive while referenced by ctx
+   std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)>    ctx{ZSTD_createCCtx(), &ZSTD_freeCCtx};
+   std::vector<char>                                       out = std::vector<char>(ZSTD_CStreamOutSize());
+
+   zstd_compressor_impl(int level, std::shared_ptr<const log_compression::zstd_dictionary> dict) : dictionary(std::move(dict)) {
+      EOS_ASSERT(ctx, chain::plugin_exception, "failed to create zstd compression context");
+      if(dictionary)
+         check_zstd(ZSTD_CCtx_refCDict(ctx.get(), dictionary->cdict));
+      else
+         check_zstd(ZSTD_CCtx_setParameter(ctx.get(), ZSTD_c_compressionLevel, level));
+   }
+
+   void compress(const detail::sink_write_func& snk, ZSTD_inBuffer& in, ZSTD_EndDirective mode) {
+      size_t remaining;
+      do {
+         ZSTD_outBuffer o = {out.data(), out.size(), 0};
+         remaining = ZSTD_compressStream2(ctx.get(), &o, &in, mode);
+         check_zstd(remaining);
+         if(o.pos)
+            snk(out.data(), o.pos);
+      } while(mode == ZSTD_e_end ? remaining != 0 : in.pos != in.size);
+   }
+
+   std::streamsize write(const detail::sink_write_func& snk, const char* s, std::streamsize n) override {
+      ZSTD_inBuffer in = {s, static_cast<size_t>(n), 0};
+      compress(snk, in, ZSTD_e_continue);
+      return n;
+   }
+   void close(const detail::sink_write_func& snk) override {
+      ZSTD_inBuffer in = {nullptr, 0, 0};
+      compress(snk, in, ZSTD_e_end);
+   }
+};
+
+struct zstd_decompressor_impl : detail::log_decompressor_impl {
+   std::shared_ptr<const log_compression::zstd_dictionary> dictionary;
+   std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)>    ctx{ZSTD_createDCtx(), &ZSTD_freeDCtx};
+   std::vector<char>                                       in_buff = std::vector<char>(ZSTD_DStreamInSize());
+   ZSTD_inBuffer                                           in = {in_buff.data(), 0, 0};
+   bool                                                    source_eof = false;
+
+   explicit zstd_decompressor_impl(std::shared_ptr<const log_compression::zstd_dictionary> dict) : dictionary(std::move(dict)) {
+      EOS_ASSERT(ctx, chain::plugin_exception, "failed to create zstd decompression context");
+      if(dictionary)
+         check_zstd(ZSTD_DCtx_refDDict(ctx.get(), dictionary->ddict));
+   }
+
+   std::streamsize read(const detail::source_read_func& src, char* s, std::streamsize n) override {
+      ZSTD_outBuffer o = {s, static_cast<size_t>(n), 0};
+      while(o.pos < o.size) {
+         if(in.pos == in.size && !source_eof) {
+            const std::streamsize red = src(in_buff.data(), in_buff.size());
+            if(red == -1)
+               source_eof = true;
+            else
+               in = {in_buff.data(), static_cast<size_t>(red), 0};
+         }
+         const size_t prev_out = o.pos;
+         check_zstd(ZSTD_decompressStream(ctx.get(), &o, &in));
+         //all input consumed and the decoder could not produce anything more from what it has buffered
+         if(source_eof && in.pos == in.size && o.pos == prev_out)
+            break;
+      }
+      return o.pos ? static_cast<std::streamsize>(o.pos) : -1;
+   }
+};
+
+} // namespace
+
+#else
+
+struct log_compression::zstd_dictionary {};
+
+#endif
+
+log_compression::log_compression(log_codec codec, int zstd_level, const std::filesystem::path& zstd_dictionary) :
+  _codec(codec), zstd_level(zstd_level) {
+   if(codec == log_codec::zlib) {
+      EOS_ASSERT(zstd_dictionary.empty(), chain::plugin_exception, "a compression dictionary can only be used with zstd");
+      return;
+   }
+   EOS_ASSERT(zstd_available(), chain::plugin_exception, "zstd compression is not supported by this build");
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+   EOS_ASSERT(zstd_level >= ZSTD_minCLevel() && zstd_level <= ZSTD_maxCLevel(), chain::plugin_exception,
+              "zstd compression level ${l} out of range ${min}-${max}", ("l", zstd_level)("min", ZSTD_minCLevel())("max", ZSTD_maxCLevel()));
+   if(!zstd_dictionary.empty()) {
+      std::string dict;
+      fc::read_file_contents(zstd_dictionary, dict);
+      EOS_ASSERT(ZSTD_getDictID_fromDict(dict.data(), dict.size()) != 0, chain::plugin_exception,
+                 "${f} is not a zstd dictionary", ("f", zstd_dictionary.string()));
+      dictionary = std::make_shared<const log_compression::zstd_dictionary>(dict, zstd_level);
+   }
+#endif
+}
+
+log_compressor log_compression::compressor() const {
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+   if(_codec == log_codec::zstd)
+      return log_compressor(std::make_shared<zstd_compressor_impl>(zstd_level, dictionary));
+#endif
+   return log_compressor(std::make_shared<zlib_compressor_impl>());
+}
+
+log_decompressor log_compression::decompressor(log_codec entry_codec) const {
+   switch(entry_codec) {
+      case log_codec::zlib:
+         return log_decompressor(std::make_shared<zlib_decompressor_impl>());
+      case log_codec::zstd:
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+         return log_decompressor(std::make_shared<zstd_decompressor_impl>(dictionary));
+#else
+         EOS_THROW(chain::plugin_exception, "log entry is zstd compressed but zstd is not supported by this build");
+#endif
+   }
+   EOS_THROW(chain::plugin_exception, "unknown log entry codec ${c}", ("c", static_cast<unsigned>(entry_codec)));
+}
+
+bool log_compression::zstd_available() {
+#ifdef EOSIO_STATE_HISTORY_ZSTD
+   return true;
+#else
+   return false;
+#endif
+}
+
+}
@@ -0,0 +1,242 @@
+#include <eosio/state_history/filter.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+
+namespace eosio::state_history {
+
+namespace {
+
+// minimal fc stream reading from a streambuf, optionally also capturing every byte read
+class entry_reader {
+public:
+   explicit entry_reader(std::streambuf& buf) : buf(buf) {}
+
+   size_t read(char* d, size_t n) {
+      EOS_ASSERT(buf.sgetn(d, n) == static_cast<std::streamsize>(n), chain::plugin_exception, "unexpected end of state history log entry");
+      if(capture)
+         capture->insert(capture->end(), d, d + n);
+      return n;
+   }
+
+   bool get(char& c) {
+      read(&c, 1);
+      return true;
+   }
+
+   bool get(unsigned char& c) {
+      return get(reinterpret_cast<char&>(c));
+   }
+
+   void skip(size_t n) {
+      char tmp[4096];
+      while(n) {
+         const size_t s = std::min(n, sizeof(tmp));
+         read(tmp, s);
+         n -= s;
+      }
+   }
+
+   template<typename T>
+   T unpack() {
+      T v;
+      fc::raw::unpack(*this, v);
+      return v;
+   }
+
+   uint32_t unpack_size() {
+      return unpack<fc::unsigned_int>().value;
+   }
+
+   void skip_bytes() {
+      skip(unpack_size());
+   }
+
+   std::vector<char>* capture = nullptr;
+
+private:
+   std::streambuf& buf;
+};
+
+template<typename T>
+void append_packed(std::vector<char>& out, const T& v) {
+   const std::vector<char> packed = fc::raw::pack(v);
+   out.insert(out.end(), packed.begin(), packed.end());
+}
+
+bool name_matches(chain::name filter, chain::name n) {
+   return filter.empty() || filter == n;
+}
+
+// reads a transaction_trace (see serialization.hpp) returning whether any of its action traces, or those of the failed
+// deferred transaction it may carry, match
+template<typename ActionMatches>
+bool read_transaction_trace(entry_reader& r, const ActionMatches& action_matches) {
+   bool matched = false;
+
+   r.unpack_size();                                                       //variant index
+   r.skip(sizeof(chain::transaction_id_type) + sizeof(uint8_t) + sizeof(uint32_t)); //id, status, cpu_usage_us
+   r.unpack_size();                                                       //net_usage_words
+   r.skip(sizeof(int64_t) + sizeof(uint64_t) + sizeof(bool));             //elapsed, net_usage, scheduled
+
+   for(uint32_t num_actions = r.unpack_size(); num_actions; --num_actions) {
+      //action_trace_v0 is action_trace_v1 without its return_value, still found in logs written before return values
+      const uint32_t action_trace_version = r.unpack_size();              //variant index
+      EOS_ASSERT(action_trace_version <= 1, chain::plugin_exception, "unknown action_trace version ${v}", ("v", action_trace_version));
+      r.unpack_size();                                                    //action_ordinal
+      r.unpack_size();                                                    //creator_action_ordinal
+      if(r.unpack<bool>()) {                                              //receipt
+         r.unpack_size();                                                 //variant index
+         r.skip(sizeof(uint64_t) + sizeof(chain::digest_type) + 2*sizeof(uint64_t)); //receiver, act_digest, global_sequence, recv_sequence
+         r.skip(r.unpack_size() * 2ull*sizeof(uint64_t));                 //auth_sequence
+         r.unpack_size();                                                 //code_sequence
+         r.unpack_size();                                                 //abi_sequence
+      }
+      const chain::name receiver(r.unpack<uint64_t>());
+      const chain::name account(r.unpack<uint64_t>());
+      const chain::name action(r.unpack<uint64_t>());
+      matched = matched || action_matches(receiver, account, action);
+      r.skip(r.unpack_size() * 2ull*sizeof(uint64_t));                    //authorization
+      r.skip_bytes();                                                     //data
+      r.skip(sizeof(bool) + sizeof(int64_t));                             //context_free, elapsed
+      r.skip_bytes();                                                     //console
+      r.skip(r.unpack_size() * 2ull*sizeof(uint64_t));                    //account_ram_deltas
+      if(r.unpack<bool>())                                                //except
+         r.skip_bytes();
+      if(r.unpack<bool>())                                                //error_code
+         r.skip(sizeof(uint64_t));
+      if(action_trace_version == 1)
+         r.skip_bytes();                                                  //return_value
+   }
+
+   if(r.unpack<bool>())                                                   //account_ram_delta
+      r.skip(2*sizeof(uint64_t));
+   if(r.unpack<bool>())                                                   //except
+      r.skip_bytes();
+   if(r.unpack<bool>())                                                   //error_code
+      r.skip(sizeof(uint64_t));
+   if(r.unpack<bool>())                                                   //failed_dtrx_trace
+      matched = read_transaction_trace(r, action_matches) || matched;
+   if(r.unpack<bool>()) {                                                 //partial
+      r.unpack_size();                                                    //variant index
+      r.skip(sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint32_t));     //expiration, ref_block_num, ref_block_prefix
+      r.unpack_size();                                                    //max_net_usage_words
+      r.skip(sizeof(uint8_t));                                            //max_cpu_usage_ms
+      r.unpack_size();                                                    //delay_sec
+      for(uint32_t num_extensions = r.unpack_size(); num_extensions; --num_extensions) {
+         r.skip(sizeof(uint16_t));
+         r.skip_bytes();
+      }
+      r.unpack<std::vector<chain::signature_type>>();                     //signatures, variable size
+      for(uint32_t num_cfd = r.unpack_size(); num_cfd; --num_cfd)
+         r.skip_bytes();
+   }
+
+   return matched;
+}
+
+}
+
+bool log_entry_filter::row_matches(chain::name code, chain::name scope, chain::name table) const {
+   return std::any_of(delta_filters.begin(), delta_filters.end(), [&](const table_delta_filter& f) {
+      return name_matches(f.code, code) && name_matches(f.scope, scope) && name_matches(f.table, table);
+   });
+}
+
+bool log_entry_filter::action_matches(chain::name receiver, chain::name account, chain::name action) const {
+   return std::any_of(trace_filters.begin(), trace_filters.end(), [&](const action_trace_filter& f) {
+      return name_matches(f.receiver, receiver) && name_matches(f.account, account) && name_matches(f.action, action);
+   });
+}
+
+std::vector<char> log_entry_filter::apply(log_type type, std::streambuf& entry) const {
+   switch(type) {
+      case log_type::chain_state: return filter_deltas(entry);
+      case log_type::trace:       return filter_traces(entry);
+      default:                    EOS_THROW(chain::plugin_exception, "log entries of type ${t} cannot be filtered", ("t", static_cast<unsigned>(type)));
+   }
+}
+
+std::vector<char> log_entry_filter::filter_deltas(std::streambuf& entry) const {
+   entry_reader r(entry);
+   std::vector<char> tables;
+   uint32_t          num_tables = 0;
+
+   for(uint32_t n = r.unpack_size(); n; --n) {
+      r.unpack_size();                                                    //variant index
+      const std::string name = r.unpack<std::string>();
+      const bool        is_contract_table = name.starts_with("contract_");
+
+      std::vector<char> rows;
+      uint32_t          num_rows = 0;
+      for(uint32_t m = r.unpack_size(); m; --m) {
+         const bool     present = r.unpack<bool>();
+         const uint32_t size    = r.unpack_size();
+         if(!is_contract_table) {
+            r.skip(size);
+            continue;
+         }
+
+         //read the row in place and drop it again if it does not match
+         const size_t start = rows.size();
+         append_packed(rows, present);
+         append_packed(rows, fc::unsigned_int(size));
+         const size_t data_start = rows.size();
+         rows.resize(data_start + size);
+         r.read(rows.data() + data_start, size);
+
+         //every contract_* row starts with its struct version followed by code, scope, and table
+         fc::datastream<const char*> row(rows.data() + data_start, size);
+         fc::unsigned_int version;
+         uint64_t code, scope, table;
+         fc::raw::unpack(row, version);
+         fc::raw::unpack(row, code);
+         fc::raw::unpack(row, scope);
+         fc::raw::unpack(row, table);
+         if(row_matches(chain::name(code), chain::name(scope), chain::name(table)))
+            ++num_rows;
+         else
+            rows.resize(start);
+      }
+
+      if(num_rows) {
+         append_packed(tables, fc::unsigned_int(0));
+         append_packed(tables, name);
+         append_packed(tables, fc::unsigned_int(num_rows));
+         tables.insert(tables.end(), rows.begin(), rows.end());
+         ++num_tables;
+      }
+   }
+
+   std::vector<char> result = fc::raw::pack(fc::unsigned_int(num_tables));
+   result.insert(result.end(), tables.begin(), tables.end());
+   return result;
+}
+
+std::vector<char> log_entry_filter::filter_traces(std::streambuf& entry) const {
+   entry_reader r(entry);
+   std::vector<char> traces;
+   uint32_t          num_traces = 0;
+
+   auto matches = [this](chain::name receiver, chain::name account, chain::name action) {
+      return action_matches(receiver, account, action);
+   };
+
+   for(uint32_t n = r.unpack_size(); n; --n) {
+      const size_t start = traces.size();
+      r.capture = &traces;
+      if(read_transaction_trace(r, matches))
+         ++num_traces;
+      else
+         traces.resize(start);
+      r.capture = nullptr;
+   }
+
+   std::vector<char> result = fc::raw::pack(fc::unsigned_int(num_traces));
+   result.insert(result.end(), traces.begin(), traces.end());
+   return result;
+}
+
+}
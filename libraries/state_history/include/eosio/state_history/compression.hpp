@@ -0,0 +1,109 @@
+#pragma once
+
+#include <boost/iostreams/categories.hpp>
+#include <boost/iostreams/operations.hpp>
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <stdint.h>
+
+namespace eosio::state_history {
+
+namespace bio = boost::iostreams;
+
+/// codec a log entry payload is compressed with; stored per entry so a log may contain a mix of codecs
+enum class log_codec : uint8_t {
+   zlib = 0,
+   zstd = 1
+};
+
+namespace detail {
+using source_read_func = std::function<std::streamsize(char*, std::streamsize)>;
+using sink_write_func  = std::function<std::streamsize(const char*, std::streamsize)>;
+
+struct log_compressor_impl {
+   virtual std::streamsize write(const sink_write_func& snk, const char* s, std::streamsize n) = 0;
+   virtual void close(const sink_write_func& snk) = 0;
+   virtual ~log_compressor_impl() = default;
+};
+
+struct log_decompressor_impl {
+   virtual std::streamsize read(const source_read_func& src, char* s, std::streamsize n) = 0;
+   virtual ~log_decompressor_impl() = default;
+};
+}
+
+/// output filter compressing with whichever codec it was created for, see log_compression::compressor()
+class log_compressor {
+public:
+   typedef char char_type;
+   struct category : bio::output_filter_tag, bio::multichar_tag, bio::closable_tag, bio::optimally_buffered_tag {};
+
+   explicit log_compressor(std::shared_ptr<detail::log_compressor_impl> impl) : impl(std::move(impl)) {}
+
+   std::streamsize optimal_buffer_size() const { return 64*1024; }
+
+   template<typename Sink>
+   std::streamsize write(Sink& snk, const char_type* s, std::streamsize n) {
+      return impl->write([&snk](const char* d, std::streamsize m) { return bio::write(snk, d, m); }, s, n);
+   }
+
+   template<typename Sink>
+   void close(Sink& snk) {
+      impl->close([&snk](const char* d, std::streamsize m) { return bio::write(snk, d, m); });
+   }
+
+private:
+   std::shared_ptr<detail::log_compressor_impl> impl;
+};
+
+/// input filter decompressing whichever codec it was created for, see log_compression::decompressor()
+class log_decompressor {
+public:
+   typedef char char_type;
+   struct category : bio::input_filter_tag, bio::multichar_tag, bio::optimally_buffered_tag {};
+
+   explicit log_decompressor(std::shared_ptr<detail::log_decompressor_impl> impl) : impl(std::move(impl)) {}
+
+   std::streamsize optimal_buffer_size() const { return 64*1024; }
+
+   template<typename Source>
+   std::streamsize read(Source& src, char_type* s, std::streamsize n) {
+      return impl->read([&src](char* d, std::streamsize m) { return bio::read(src, d, m); }, s, n);
+   }
+
+private:
+   std::shared_ptr<detail::log_decompressor_impl> impl;
+};
+
+/**
+ * Compression settings of a state history log: the codec new entries are written with and, for zstd, the compression
+ * level and an optional dictionary (as trained by `zstd --train`). The dictionary is also required to read back entries
+ * that were compressed with it. Entries written with zlib remain readable regardless of the configured codec.
+ */
+class log_compression {
+public:
+   /// zlib without compression; what all logs were written with before the codec was configurable
+   log_compression() = default;
+   log_compression(log_codec codec, int zstd_level = default_zstd_level, const std::filesystem::path& zstd_dictionary = {});
+
+   log_codec codec() const { return _codec; }
+
+   log_compressor   compressor() const;
+   log_decompressor decompressor(log_codec entry_codec) const;
+
+   /// whether this build supports the zstd codec
+   static bool zstd_available();
+
+   static constexpr int default_zstd_level = 3;
+
+   struct zstd_dictionary;
+
+private:
+   log_codec                               _codec = log_codec::zlib;
+   int                                     zstd_level = default_zstd_level;
+   std::shared_ptr<const zstd_dictionary>  dictionary;
+};
+
+}
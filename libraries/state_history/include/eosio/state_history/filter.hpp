@@ -0,0 +1,46 @@
+#pragma once
+
+#include <eosio/state_history/log_entry_cache.hpp>
+#include <eosio/state_history/types.hpp>
+
+#include <streambuf>
+#include <vector>
+
+namespace eosio::state_history {
+
+/**
+ * Reduces decompressed log entries to what a client asked for in a get_blocks_request_v3. Entries are read from a
+ * streambuf so that large entries, such as the initial state, do not need to be held in memory unfiltered. Only the
+ * filtered result is buffered.
+ */
+class log_entry_filter {
+public:
+   log_entry_filter(std::vector<table_delta_filter> delta_filters, std::vector<action_trace_filter> trace_filters) :
+     delta_filters(std::move(delta_filters)), trace_filters(std::move(trace_filters)) {}
+
+   /// whether entries of the given log are modified by this filter at all
+   bool filters(log_type type) const {
+      switch(type) {
+         case log_type::chain_state: return !delta_filters.empty();
+         case log_type::trace:       return !trace_filters.empty();
+         default:                    return false;
+      }
+   }
+
+   /// reads an entry of the given log, which filters(type) must be true for, returning its filtered serialization
+   std::vector<char> apply(log_type type, std::streambuf& entry) const;
+
+   /// filtered serialization of a chain_state log entry (table_delta[]) keeping only matching contract table rows
+   std::vector<char> filter_deltas(std::streambuf& entry) const;
+   /// filtered serialization of a trace log entry (transaction_trace[]) keeping only traces with a matching action
+   std::vector<char> filter_traces(std::streambuf& entry) const;
+
+private:
+   bool row_matches(chain::name code, chain::name scope, chain::name table) const;
+   bool action_matches(chain::name receiver, chain::name account, chain::name action) const;
+
+   const std::vector<table_delta_filter>  delta_filters;
+   const std::vector<action_trace_filter> trace_filters;
+};
+
+}
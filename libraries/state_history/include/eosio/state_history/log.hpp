@@ -3,6 +3,7 @@
 #include <eosio/chain/block_header.hpp>
 #include <eosio/chain/exceptions.hpp>
 #include <eosio/chain/types.hpp>
+#include <eosio/state_history/compression.hpp>
 #include <eosio/state_history/log_config.hpp>
 #include <eosio/state_history/counter.hpp>
 
@@ -10,6 +11,7 @@
 #include <fc/log/logger.hpp>
 #include <fc/log/logger_config.hpp> //set_thread_name
 
+#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/device/file.hpp>
 #include <boost/iostreams/device/file_descriptor.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
@@ -38,6 +40,11 @@ namespace bio = boost::iostreams;
  *    state_history_log_header
  *    payload
  *
+ * payload, Leap 4.0+ zlib (compatible with all readers since Leap 4.0):
+ *    uint32_t 1, uint64_t uncompressed size, zlib stream
+ * payload, any codec (in an entry whose header is of version ship_codec_version, which older readers reject):
+ *    uint32_t 2, uint64_t uncompressed size, uint8_t log_codec, compressed stream
+ *
  * When block pruning is enabled, a slight modification to the format is as followed:
  * For first entry in log, a unique version is used to indicate the log is a "pruned log": this prevents
  *  older versions from trying to read something with holes in it
@@ -56,8 +63,9 @@ inline bool is_ship(uint64_t magic) {
 }
 inline uint16_t       get_ship_version(uint64_t magic) { return magic; }
 inline uint16_t       get_ship_features(uint64_t magic) { return magic>>16; }
-inline bool           is_ship_supported_version(uint64_t magic) { return get_ship_version(magic) == 0; }
 static const uint16_t ship_current_version = 0;
+static const uint16_t ship_codec_version = 1;   //version of the entries whose payload names its codec
+inline bool           is_ship_supported_version(uint64_t magic) { return get_ship_version(magic) <= ship_codec_version; }
 static const uint16_t ship_feature_pruned_log = 1;
 inline bool           is_ship_log_pruned(uint64_t magic) { return get_ship_features(magic) & ship_feature_pruned_log; }
 inline uint64_t       clear_ship_log_pruned_feature(uint64_t magic) { return ship_magic(get_ship_version(magic), get_ship_features(magic) & ~ship_feature_pruned_log); }
@@ -71,26 +79,58 @@ struct log_header_with_sizes : log_header {
    uint32_t compressed_size = 0;
    uint64_t uncompressed_size = 0;
 };
+struct log_header_with_codec : log_header_with_sizes {
+   uint8_t codec = 0;
+};
+//values of log_header_with_sizes::compressed_size identifying what follows it
+static const uint32_t ship_payload_with_size  = 1;
+static const uint32_t ship_payload_with_codec = 2;
 
 struct ship_log_entry {
    uint64_t get_uncompressed_size() {
       if(!uncompressed_size) {
-         bio::filtering_istreambuf buf(bio::zlib_decompressor() | bio::restrict(device, compressed_data_offset, compressed_data_size));
+         bio::filtering_istreambuf buf = get_stream();
          uncompressed_size = bio::copy(buf, bio::null_sink());
       }
       return *uncompressed_size;
    }
 
    bio::filtering_istreambuf get_stream() {
-      return bio::filtering_istreambuf(bio::zlib_decompressor() | bio::restrict(device, compressed_data_offset, compressed_data_size));
+      return bio::filtering_istreambuf(compression.decompressor(codec) | bio::restrict(device, compressed_data_offset, compressed_data_size));
    }
 
    fc::random_access_file::device device;
    uint64_t                       compressed_data_offset;
    uint64_t                       compressed_data_size;
    std::optional<uint64_t>        uncompressed_size;
+   log_codec                      codec = log_codec::zlib;
+   log_compression                compression;  //for the zstd dictionary, if any
+   chain::block_id_type           block_id;     //as recorded in the header of the entry
+};
+
+/// an entry payload compressed ahead of time so that it can be appended to a log via state_history_log::write_entry()
+struct compressed_log_entry {
+   std::vector<char> compressed_data;
+   uint64_t          uncompressed_size = 0;
+   log_codec         codec = log_codec::zlib;
 };
 
+template <typename F>
+compressed_log_entry pack_and_compress_entry(const log_compression& compression, F&& pack_to) {
+   compressed_log_entry entry{.codec = compression.codec()};
+   bio::filtering_ostreambuf buf(eosio::detail::counter() | compression.compressor() | bio::back_inserter(entry.compressed_data));
+   pack_to(buf);
+   bio::close(buf);
+   entry.uncompressed_size = buf.component<eosio::detail::counter>(0)->characters();
+   return entry;
+}
+
+inline compressed_log_entry compress_entry(const log_compression& compression, const std::vector<char>& uncompressed_data) {
+   return pack_and_compress_entry(compression, [&](bio::filtering_ostreambuf& buf) {
+      bio::write(buf, uncompressed_data.data(), uncompressed_data.size());
+   });
+}
+
 class state_history_log {
 public:
    using non_local_get_block_id_func = std::function<std::optional<chain::block_id_type>(chain::block_num_type)>;
@@ -101,6 +141,7 @@ public:
 private:
    std::optional<state_history::prune_config> prune_config;
    non_local_get_block_id_func                non_local_get_block_id;
+   log_compression                            compression;
 
    fc::random_access_file       log;
    fc::random_access_file       index;
@@ -111,6 +152,7 @@ private:
 
    inline static const unsigned packed_header_size = fc::raw::pack_size(log_header());
    inline static const unsigned packed_header_with_sizes_size = fc::raw::pack_size(log_header_with_sizes());
+   inline static const unsigned packed_header_with_codec_size = fc::raw::pack_size(log_header_with_codec());
 
  public:
    state_history_log(const state_history_log&) = delete;
@@ -120,8 +162,9 @@ private:
 
    state_history_log(const std::filesystem::path& log_dir_and_stem,
                      non_local_get_block_id_func non_local_get_block_id = no_non_local_get_block_id_func,
-                     const std::optional<state_history::prune_config>& prune_conf = std::nullopt) :
-     prune_config(prune_conf), non_local_get_block_id(non_local_get_block_id),
+                     const std::optional<state_history::prune_config>& prune_conf = std::nullopt,
+                     const log_compression& compression = {}) :
+     prune_config(prune_conf), non_local_get_block_id(non_local_get_block_id), compression(compression),
      log(std::filesystem::path(log_dir_and_stem).replace_extension("log")),
      index(std::filesystem::path(log_dir_and_stem).replace_extension("index")) {
       EOS_ASSERT(!!non_local_get_block_id, chain::plugin_exception, "misuse of get_block_id");
@@ -184,6 +227,10 @@ private:
       return first == second;
    }
 
+   const log_compression& get_compression() const {
+      return compression;
+   }
+
    std::optional<ship_log_entry> get_entry(uint32_t block_num) {
       if(block_num < _begin_block || block_num >= _end_block)
          return std::nullopt;
@@ -197,23 +244,77 @@ private:
       // 3) Leap 4.0+ would hardcode this uint32_t to 1, and then add an uint64_t with the _uncompressed_ size
       //     (knowing the uncompressed size ahead of time makes it convenient to stream the data to the client which
       //      needs uncompressed size ahead of time)
+      // 4) entries compressed with a codec other than zlib set this uint32_t to 2, and add an uint8_t log_codec after the
+      //     uncompressed size. zlib entries continue to be written as 3) so older versions can read them
       // 1 & 2 are problematic for the current streaming of the logs to clients. There appears to be no option other
       //  then making two passes through the compressed data: once to figure out the uncompressed size to send up front
       //  to the client, then a second time to actually decompress the data to send to the client. But don't do the first
       //  pass here -- delay that until we're on the ship thread.
+      if(header.compressed_size == ship_payload_with_codec) {
+         EOS_ASSERT(get_ship_version(header.magic) == ship_codec_version, chain::plugin_exception,
+                    "corrupt ${name}, entry with a codec has header version ${v}", ("name", log.display_path())("v", get_ship_version(header.magic)));
+         const log_header_with_codec codec_header = log.unpack_from<decltype(codec_header)>(log_pos);
+         const size_t head_size = packed_header_with_codec_size - packed_header_size;
+         return ship_log_entry{
+            .device                 = log.seekable_device(),
+            .compressed_data_offset = log_pos + packed_header_with_codec_size,
+            .compressed_data_size   = header.payload_size - head_size,
+            .uncompressed_size      = header.uncompressed_size,
+            .codec                  = static_cast<log_codec>(codec_header.codec),
+            .compression            = compression,
+            .block_id               = header.block_id
+         };
+      }
+
       constexpr size_t prel4_head_size = sizeof(log_header_with_sizes::compressed_size);
       constexpr size_t l4_head_size = sizeof(log_header_with_sizes::compressed_size) + sizeof(log_header_with_sizes::uncompressed_size);
+      const bool is_l4 = header.compressed_size == ship_payload_with_size;
       return ship_log_entry{
          .device                 = log.seekable_device(),
-         .compressed_data_offset = log_pos + packed_header_size + (header.compressed_size == 1 ? l4_head_size : prel4_head_size),
-         .compressed_data_size   = header.payload_size          - (header.compressed_size == 1 ? l4_head_size : prel4_head_size),
-         .uncompressed_size      =                                (header.compressed_size == 1 ? std::optional<uint64_t>(header.uncompressed_size) : std::nullopt)
+         .compressed_data_offset = log_pos + packed_header_size + (is_l4 ? l4_head_size : prel4_head_size),
+         .compressed_data_size   = header.payload_size          - (is_l4 ? l4_head_size : prel4_head_size),
+         .uncompressed_size      =                                (is_l4 ? std::optional<uint64_t>(header.uncompressed_size) : std::nullopt),
+         .codec                  = log_codec::zlib,
+         .compression            = compression,
+         .block_id               = header.block_id
       };
    }
 
    template <typename F>
    void pack_and_write_entry(const chain::block_id_type& id, const chain::block_id_type& prev_id, F&& pack_to) {
-      log_header_with_sizes header = {{ship_magic(ship_current_version, 0), id}, 1};
+      write_entry_payload(id, prev_id, compression.codec(), [&](ssize_t payload_insert_pos) {
+         bio::filtering_ostreambuf buf(eosio::detail::counter() | compression.compressor() | eosio::detail::counter() | bio::restrict(log.seekable_device(), payload_insert_pos));
+         pack_to(buf);
+         bio::close(buf);
+         return std::make_pair(buf.component<eosio::detail::counter>(0)->characters(), buf.component<eosio::detail::counter>(2)->characters());
+      });
+   }
+
+   void write_entry(const chain::block_id_type& id, const chain::block_id_type& prev_id, const compressed_log_entry& entry) {
+      write_entry_payload(id, prev_id, entry.codec, [&](ssize_t payload_insert_pos) {
+         fc::random_access_file::write_datastream ds = log.write_ds(payload_insert_pos);
+         ds.write(entry.compressed_data.data(), entry.compressed_data.size());
+         ds.flush();
+         return std::make_pair(entry.uncompressed_size, static_cast<uint64_t>(entry.compressed_data.size()));
+      });
+   }
+
+   std::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+      if(block_num >= _begin_block && block_num < _end_block)
+         return log.unpack_from<log_header>(get_pos(block_num)).block_id;
+      return std::nullopt;
+   }
+
+ private:
+   //write_payload writes the compressed payload at the given position and returns its uncompressed and compressed sizes
+   template <typename F>
+   void write_entry_payload(const chain::block_id_type& id, const chain::block_id_type& prev_id, log_codec codec, F&& write_payload) {
+      log_header_with_codec header = {{{ship_magic(ship_current_version, 0), id}, ship_payload_with_size}};
+      if(codec != log_codec::zlib) {
+         header.magic = ship_magic(ship_codec_version, 0);
+         header.compressed_size = ship_payload_with_codec;
+         header.codec = static_cast<uint8_t>(codec);
+      }
       const uint32_t block_num = chain::block_header::num_from_id(header.block_id);
 
       if(!empty())
@@ -244,14 +345,16 @@ private:
             header.magic = ship_magic(get_ship_version(header.magic), ship_feature_pruned_log);
       }
 
-      const ssize_t payload_insert_pos = log_insert_pos + packed_header_with_sizes_size;
+      const unsigned packed_entry_header_size = codec == log_codec::zlib ? packed_header_with_sizes_size : packed_header_with_codec_size;
+      const ssize_t payload_insert_pos = log_insert_pos + packed_entry_header_size;
 
-      bio::filtering_ostreambuf buf(detail::counter() | bio::zlib_compressor(bio::zlib::no_compression) | detail::counter() | bio::restrict(log.seekable_device(), payload_insert_pos));
-      pack_to(buf);
-      bio::close(buf);
-      header.uncompressed_size = buf.component<detail::counter>(0)->characters();
-      header.payload_size = buf.component<detail::counter>(2)->characters() + sizeof(header.compressed_size) + sizeof(header.uncompressed_size);
-      log.pack_to(header, log_insert_pos);
+      uint64_t compressed_size;
+      std::tie(header.uncompressed_size, compressed_size) = write_payload(payload_insert_pos);
+      header.payload_size = compressed_size + packed_entry_header_size - packed_header_size;
+      if(codec == log_codec::zlib)
+         log.pack_to(static_cast<const log_header_with_sizes&>(header), log_insert_pos);
+      else
+         log.pack_to(header, log_insert_pos);
 
       fc::random_access_file::write_datastream appender = log.append_ds();
       fc::raw::pack(appender, (uint64_t)log_insert_pos);
@@ -281,13 +384,6 @@ private:
       appender.flush();
    }
 
-   std::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
-      if(block_num >= _begin_block && block_num < _end_block)
-         return log.unpack_from<log_header>(get_pos(block_num)).block_id;
-      return std::nullopt;
-   }
-
- private:
    void prune() {
       if(!prune_config)
          return;
@@ -510,4 +606,5 @@ private:
 }
 
 FC_REFLECT(eosio::state_history::log_header, (magic)(block_id)(payload_size))
-FC_REFLECT_DERIVED(eosio::state_history::log_header_with_sizes, (eosio::state_history::log_header), (compressed_size)(uncompressed_size));
\ No newline at end of file
+FC_REFLECT_DERIVED(eosio::state_history::log_header_with_sizes, (eosio::state_history::log_header), (compressed_size)(uncompressed_size));
+FC_REFLECT_DERIVED(eosio::state_history::log_header_with_codec, (eosio::state_history::log_header_with_sizes), (codec));
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <filesystem>
+#include <mutex>
 #include <regex>
 
 #include <boost/multi_index_container.hpp>
@@ -45,6 +46,7 @@ class log_catalog {
    uint32_t              log_rotation_stride = std::numeric_limits<decltype(log_rotation_stride)>::max();
 
    const state_history_log::non_local_get_block_id_func non_local_get_block_id;
+   const log_compression                                compression;
 
    struct by_mru {};
    typedef multi_index_container<
@@ -60,13 +62,17 @@ class log_catalog {
 
    size_t global_used_counter = 0;
 
+   //writes may happen on a different thread than reads; everything below the public interface runs with this held
+   mutable std::mutex mtx;
+
 public:
    log_catalog(const log_catalog&) = delete;
    log_catalog& operator=(log_catalog&) = delete;
 
    log_catalog(const std::filesystem::path& log_dir, const state_history::state_history_log_config& config, const std::string& log_name,
-               state_history_log::non_local_get_block_id_func non_local_get_block_id = state_history_log::no_non_local_get_block_id_func) :
-     non_local_get_block_id(non_local_get_block_id), head_log_path_and_basename(log_dir / log_name) {
+               state_history_log::non_local_get_block_id_func non_local_get_block_id = state_history_log::no_non_local_get_block_id_func,
+               const log_compression& compression = {}) :
+     non_local_get_block_id(non_local_get_block_id), compression(compression), head_log_path_and_basename(log_dir / log_name) {
       std::visit(chain::overloaded {
          [this](const std::monostate&) {
             open_head_log();
@@ -85,6 +91,66 @@ public:
 
    template <typename F>
    void pack_and_write_entry(const chain::block_id_type& id, const chain::block_id_type& prev_id, F&& pack_to) {
+      std::lock_guard g(mtx);
+      if(!prepare_head_log_for_write(id))
+         return;
+
+      head_log->pack_and_write_entry(id, prev_id, pack_to);
+      rotate_logs_if_needed(id);
+   }
+
+   /// append an entry whose payload was packed and compressed up front, see pack_and_compress_entry()
+   void write_entry(const chain::block_id_type& id, const chain::block_id_type& prev_id, const compressed_log_entry& entry) {
+      std::lock_guard g(mtx);
+      if(!prepare_head_log_for_write(id))
+         return;
+
+      head_log->write_entry(id, prev_id, entry);
+      rotate_logs_if_needed(id);
+   }
+
+   /// compression new entries are written with
+   const log_compression& get_compression() const {
+      return compression;
+   }
+
+   std::optional<ship_log_entry> get_entry(uint32_t block_num) {
+      std::lock_guard g(mtx);
+      return call_for_log(block_num, [&](state_history_log&& l) {
+         return l.get_entry(block_num);
+      });
+   }
+
+   std::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+      std::lock_guard g(mtx);
+      return get_block_id_locked(block_num);
+   }
+
+   std::pair<uint32_t, uint32_t> block_range() const {
+      std::lock_guard g(mtx);
+      return block_range_locked();
+   }
+
+   bool empty() const {
+      const auto [first, second] = block_range();
+      return first == second;
+   }
+
+   void clear() {
+      std::lock_guard g(mtx);
+      const auto [first, second] = block_range_locked();
+      if(first == second)
+         return;
+
+      while(!retained_log_files.empty())
+         delete_bundle(retained_log_files.extract(retained_log_files.begin()).value().path_and_basename);
+      delete_head_log();
+      open_head_log();
+   }
+
+private:
+   //returns false when the entry is already present in the catalog and there is nothing to write
+   bool prepare_head_log_for_write(const chain::block_id_type& id) {
       const uint32_t block_num = chain::block_header::num_from_id(id);
 
       if(!retained_log_files.empty()) {
@@ -95,8 +161,8 @@ public:
 
          //check if this log already has the same blockid at the given blocknum. This is indicative of a resync or replay and there is no need to write the
          // same log entry again. otherwise we risk unrotating and blowing away existing log files
-         if(get_block_id(block_num) == id)
-            return;
+         if(get_block_id_locked(block_num) == id)
+            return false;
 
          //need to consider "unrotating" the logs. ex: split logs with 234 56789 ABC. "ABC" log is the head log. Any block that is prior to A must result in the removal
          // of the ABC log (this does _not_ invalidate ship_log_entrys from that log!) and then the replacement of 56789 as the head log. If the new block is in the range of 5
@@ -116,25 +182,21 @@ public:
       }
 
       //at this point the head log is certainly the log we want to insert in to
-      head_log->pack_and_write_entry(id, prev_id, pack_to);
-
-      if(block_num % log_rotation_stride == 0)
-         rotate_logs();
+      return true;
    }
 
-   std::optional<ship_log_entry> get_entry(uint32_t block_num) {
-      return call_for_log(block_num, [&](state_history_log&& l) {
-         return l.get_entry(block_num);
-      });
+   void rotate_logs_if_needed(const chain::block_id_type& id) {
+      if(chain::block_header::num_from_id(id) % log_rotation_stride == 0)
+         rotate_logs();
    }
 
-   std::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+   std::optional<chain::block_id_type> get_block_id_locked(uint32_t block_num) {
       return call_for_log(block_num, [&](state_history_log&& l) {
          return l.get_block_id(block_num);
       });
    }
 
-   std::pair<uint32_t, uint32_t> block_range() const {
+   std::pair<uint32_t, uint32_t> block_range_locked() const {
       uint32_t begin = 0;
       uint32_t end = 0;
 
@@ -151,22 +213,6 @@ public:
       return {begin, end};
    }
 
-   bool empty() const {
-      const auto [first, second] = block_range();
-      return first == second;
-   }
-
-   void clear() {
-      if(empty())
-         return;
-
-      while(!retained_log_files.empty())
-         delete_bundle(retained_log_files.extract(retained_log_files.begin()).value().path_and_basename);
-      delete_head_log();
-      open_head_log();
-   }
-
-private:
    template<typename F>
    typename std::invoke_result_t<F,state_history_log&&> call_for_log(const uint32_t block_num, F&& f) {
       //watch out that this check will send any requests for block nums *less than* first retained block to head log too
@@ -175,7 +221,7 @@ private:
          catalog_t::iterator log_it = std::prev(it);
          retained_log_files.modify(log_it, [&](catalogued_log_file& clf) {
             if(!clf.log)
-               clf.log.emplace(clf.path_and_basename, non_local_get_block_id);
+               clf.log.emplace(clf.path_and_basename, non_local_get_block_id, std::nullopt, compression);
             clf.last_used_counter = ++global_used_counter;
          });
 
@@ -208,7 +254,7 @@ private:
 
          const std::filesystem::path path_and_basename = dir_entry.path().parent_path() / dir_entry.path().stem();
 
-         state_history_log log(path_and_basename, [](chain::block_num_type) {return std::nullopt;});
+         state_history_log log(path_and_basename, [](chain::block_num_type) {return std::nullopt;}, std::nullopt, compression);
          if(log.empty())
             continue;
          const auto [begin_bnum, end_bnum] = log.block_range();
@@ -279,7 +325,7 @@ private:
    }
 
    void open_head_log(std::optional<state_history::prune_config> prune_config = std::nullopt) {
-      head_log.emplace(head_log_path_and_basename, non_local_get_block_id, prune_config);
+      head_log.emplace(head_log_path_and_basename, non_local_get_block_id, prune_config, compression);
    }
 
    void delete_head_log() {
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/multi_index/key.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace eosio::state_history {
+
+enum class log_type : uint8_t {
+   trace,
+   chain_state,
+   finality_data
+};
+
+/**
+ * Bounded LRU cache of decompressed log entries shared by all SHiP sessions. Clients following head, or replaying the
+ * same range, would otherwise each decompress the same entries. Entries are keyed by block id so that a fork never
+ * serves a stale entry. Entries larger than max_entry_size() (such as the initial state) are never cached.
+ * Thread safe.
+ */
+class log_entry_cache {
+public:
+   using entry_ptr = std::shared_ptr<const std::vector<char>>;
+   using key_type  = std::pair<log_type, chain::block_id_type>;
+
+   explicit log_entry_cache(uint64_t max_bytes) : max_bytes(max_bytes) {}
+
+   log_entry_cache(const log_entry_cache&) = delete;
+   log_entry_cache& operator=(const log_entry_cache&) = delete;
+
+   bool enabled() const {
+      return max_bytes > 0;
+   }
+
+   uint64_t max_entry_size() const {
+      return max_bytes / 8;
+   }
+
+   /// returns the cached entry, marking it most recently used, or nullptr
+   entry_ptr find(log_type type, const chain::block_id_type& id) {
+      entry_ptr found;
+      {
+         std::lock_guard g(mtx);
+         auto& by_key = entries.get<by_key_tag>();
+         if(auto it = by_key.find(key_type{type, id}); it != by_key.end()) {
+            entries.relocate(entries.begin(), entries.project<0>(it));
+            found = it->data;
+         }
+      }
+      if(found && on_hit)
+         on_hit();
+      else if(!found && on_miss)
+         on_miss();
+      return found;
+   }
+
+   void insert(log_type type, const chain::block_id_type& id, entry_ptr data) {
+      if(!data || data->size() > max_entry_size())
+         return;
+
+      std::lock_guard g(mtx);
+      auto [it, inserted] = entries.push_front(cached_entry{key_type{type, id}, data});
+      if(!inserted)
+         return;
+      size_bytes += data->size();
+
+      while(size_bytes > max_bytes) {
+         size_bytes -= entries.back().data->size();
+         entries.pop_back();
+      }
+   }
+
+   uint64_t size() const {
+      std::lock_guard g(mtx);
+      return size_bytes;
+   }
+
+   /// called outside of the cache's lock on every find(); must be set before the cache is shared
+   std::function<void()> on_hit;
+   std::function<void()> on_miss;
+
+private:
+   struct cached_entry {
+      key_type  key;
+      entry_ptr data;
+   };
+   struct by_key_tag {};
+
+   using entries_t = boost::multi_index_container<
+      cached_entry,
+      boost::multi_index::indexed_by<
+         boost::multi_index::sequenced<>,
+         boost::multi_index::ordered_unique<boost::multi_index::tag<by_key_tag>, boost::multi_index::key<&cached_entry::key>>
+      >
+   >;
+
+   const uint64_t max_bytes;
+   mutable std::mutex mtx;
+   entries_t entries;           //most recently used at the front
+   uint64_t size_bytes = 0;
+};
+
+}
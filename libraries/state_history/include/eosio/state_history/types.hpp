@@ -115,6 +115,35 @@ struct get_blocks_request_v1 : get_blocks_request_v0 {
    bool                        fetch_finality_data    = false;
 };
 
+// results are sent as get_blocks_result_v2, each carrying up to max_blocks_per_message blocks. max_messages_in_flight
+// and get_blocks_ack_request_v0 count messages, not blocks
+struct get_blocks_request_v2 : get_blocks_request_v1 {
+   uint32_t                    max_blocks_per_message = 1;
+   uint32_t                    max_message_bytes      = 0;   // approximate; 0 for the server's default. a message always carries at least one block
+};
+
+// an empty name matches any value
+struct table_delta_filter {
+   chain::name                 code;
+   chain::name                 table;
+   chain::name                 scope;
+};
+
+// an empty name matches any value
+struct action_trace_filter {
+   chain::name                 receiver;
+   chain::name                 account;
+   chain::name                 action;
+};
+
+// when delta_filters is not empty only contract table deltas (contract_table, contract_row, contract_index*) with rows
+// matching at least one filter are sent. when trace_filters is not empty only transaction traces containing an action
+// trace matching at least one filter are sent
+struct get_blocks_request_v3 : get_blocks_request_v2 {
+   std::vector<table_delta_filter>  delta_filters;
+   std::vector<action_trace_filter> trace_filters;
+};
+
 struct get_blocks_ack_request_v0 {
    uint32_t num_messages = 0;
 };
@@ -136,11 +165,15 @@ struct get_blocks_result_v1 : get_blocks_result_v0 {
    std::optional<bytes>          finality_data;
 };
 
+struct get_blocks_result_v2 {
+   std::vector<get_blocks_result_v1> blocks;
+};
+
 // remember to add new request & result messages to end so binary numbering remains fixed for clients that don't consume the given current ABI
-using state_request = std::variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0, get_blocks_request_v1, get_status_request_v1>;
-using state_result  = std::variant<get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1, get_status_result_v1>;
-using get_blocks_request = std::variant<get_blocks_request_v0, get_blocks_request_v1>;
-using get_blocks_result = std::variant<get_blocks_result_v0, get_blocks_result_v1>;
+using state_request = std::variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0, get_blocks_request_v1, get_status_request_v1, get_blocks_request_v2, get_blocks_request_v3>;
+using state_result  = std::variant<get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1, get_status_result_v1, get_blocks_result_v2>;
+using get_blocks_request = std::variant<get_blocks_request_v0, get_blocks_request_v1, get_blocks_request_v2, get_blocks_request_v3>;
+using get_blocks_result = std::variant<get_blocks_result_v0, get_blocks_result_v1, get_blocks_result_v2>;
 
 } // namespace state_history
 } // namespace eosio
@@ -154,8 +187,13 @@ FC_REFLECT(eosio::state_history::get_status_result_v0, (head)(last_irreversible)
 FC_REFLECT_DERIVED(eosio::state_history::get_status_result_v1, (eosio::state_history::get_status_result_v0), (finality_data_begin_block)(finality_data_end_block));
 FC_REFLECT(eosio::state_history::get_blocks_request_v0, (start_block_num)(end_block_num)(max_messages_in_flight)(have_positions)(irreversible_only)(fetch_block)(fetch_traces)(fetch_deltas));
 FC_REFLECT_DERIVED(eosio::state_history::get_blocks_request_v1, (eosio::state_history::get_blocks_request_v0), (fetch_finality_data));
+FC_REFLECT_DERIVED(eosio::state_history::get_blocks_request_v2, (eosio::state_history::get_blocks_request_v1), (max_blocks_per_message)(max_message_bytes));
+FC_REFLECT(eosio::state_history::table_delta_filter, (code)(table)(scope));
+FC_REFLECT(eosio::state_history::action_trace_filter, (receiver)(account)(action));
+FC_REFLECT_DERIVED(eosio::state_history::get_blocks_request_v3, (eosio::state_history::get_blocks_request_v2), (delta_filters)(trace_filters));
 FC_REFLECT(eosio::state_history::get_blocks_ack_request_v0, (num_messages));
 FC_REFLECT(eosio::state_history::get_blocks_result_base, (head)(last_irreversible)(this_block)(prev_block)(block));
 FC_REFLECT_DERIVED(eosio::state_history::get_blocks_result_v0, (eosio::state_history::get_blocks_result_base), (traces)(deltas));
 FC_REFLECT_DERIVED(eosio::state_history::get_blocks_result_v1, (eosio::state_history::get_blocks_result_v0), (finality_data));
+FC_REFLECT(eosio::state_history::get_blocks_result_v2, (blocks));
 // clang-format on
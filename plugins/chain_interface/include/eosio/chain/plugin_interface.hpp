@@ -13,6 +13,11 @@ namespace eosio::chain::plugin_interface {
    using namespace appbase;
    struct chain_plugin_interface;
 
+   struct state_history_entry_cache_stats {
+      uint64_t hits   = 0; ///< entries sent from the decompressed entry cache since startup
+      uint64_t misses = 0; ///< cacheable entries that had to be decompressed since startup
+   };
+
    namespace channels {
       using rejected_block         = channel_decl<struct rejected_block_tag,        signed_block_ptr>;
       using accepted_block_header  = channel_decl<struct accepted_block_header_tag, block_signal_params>;
@@ -20,6 +25,8 @@ namespace eosio::chain::plugin_interface {
       using irreversible_block     = channel_decl<struct irreversible_block_tag,    block_signal_params>;
       using applied_transaction    = channel_decl<struct applied_transaction_tag,   transaction_trace_ptr>;
       using voted_block            = channel_decl<struct voted_block_tag,           vote_message>;
+      // published by the state_history_plugin for each accepted block
+      using state_history_entry_cache = channel_decl<struct state_history_entry_cache_tag, state_history_entry_cache_stats>;
    }
 
    namespace methods {
@@ -286,6 +286,13 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          )
          ("profile-account", boost::program_options::value<vector<string>>()->composing(),
           "The name of an account whose code will be profiled")
+         ("wasm-instantiation-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_wasm_instantiation_cache_size / (1024 * 1024)),
+          "Maximum size (in MiB) of the wasm of the contracts kept instantiated by the wasm runtime. "
+          "Past it, the contracts executed least often are evicted and instantiated again when next executed.")
+         ("contract-profile-sample-interval", bpo::value<uint32_t>()->default_value(config::default_contract_profile_sample_interval),
+          "Time the calls to intrinsics of one in this many actions, picked at random, for the contract profile reported by "
+          "/v1/producer/get_contract_profile and prometheus, which estimates the intrinsic time of all the actions from them. "
+          "0 does not time intrinsics; the time of each action is always recorded.")
          ("abi-serializer-max-time-ms", bpo::value<uint32_t>()->default_value(config::default_abi_serializer_max_time_us / 1000),
           "Override default maximum ABI serialization time allowed in ms")
          ("chain-state-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_state_size / (1024  * 1024)), "Maximum size (in MiB) of the chain state database")
@@ -354,6 +361,20 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
                   EOS_ASSERT(false, plugin_exception, "");
                }
          }), "Number of threads to use for EOS VM OC tier-up")
+         ("eos-vm-oc-warmup-contracts", bpo::value<uint32_t>()->default_value(0u),
+          "Number of the contracts executed most with EOS VM OC before shutdown to compile at startup, ahead of their first use. "
+          "Execution counts are kept in the state directory across restarts. 0 disables the warm up.")
+         ("eos-vm-oc-cache-protected-percent", bpo::value<uint32_t>()->default_value(eosvmoc::config().protected_percent)->notifier([](const auto p) {
+               if(p > 100) {
+                  elog("eos-vm-oc-cache-protected-percent must be at most 100");
+                  EOS_ASSERT(false, plugin_exception, "");
+               }
+         }), "Percent of the EOS VM OC code cache entries reserved for contracts executed more than once since they were compiled. "
+             "Contracts executed just once are evicted before them, so a burst of new contracts does not push out the ones in regular use. "
+             "0 evicts the least recently used contracts regardless of how often they were executed.")
+         ("eos-vm-oc-cache-admission-threshold", bpo::value<uint32_t>()->default_value(eosvmoc::config().admission_threshold),
+          "Number of executions of a contract, outside of eosio.* accounts, needed before it is compiled by EOS VM OC. "
+          "Until then it is executed by the base runtime. 0 or 1 compiles a contract on its first execution.")
          ("eos-vm-oc-enable", bpo::value<chain::wasm_interface::vm_oc_enable>()->default_value(chain::wasm_interface::vm_oc_enable::oc_auto),
           "Enable EOS VM OC tier-up runtime ('auto', 'all', 'none').\n"
           "'auto' - EOS VM OC tier-up is enabled for eosio.* accounts, read-only trxs, and except on producers applying blocks.\n"
@@ -378,7 +399,9 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
          ("disable-replay-opts", bpo::bool_switch()->default_value(false),
           "disable optimizations that specifically target replay")
          ("integrity-hash-on-start", bpo::bool_switch(), "Log the state integrity hash on startup")
-         ("integrity-hash-on-stop", bpo::bool_switch(), "Log the state integrity hash on shutdown");
+         ("integrity-hash-on-stop", bpo::bool_switch(), "Log the state integrity hash on shutdown")
+         ("integrity-hash-per-section", bpo::bool_switch(), "When logging the state integrity hash, hash each snapshot section in parallel, on as many threads as chain-threads, "
+          "and log the per-section hashes along with their merkle root. The root is not comparable to the hash logged without this option.");
 
     cfg.add_options()("block-log-retain-blocks", bpo::value<uint32_t>(), "If set to greater than 0, periodically prune the block log to store only configured number of most recent blocks.\n"
         "If set to 0, no blocks are be written to the block log; block log file is removed after startup.");
@@ -605,6 +628,9 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
 
       LOAD_VALUE_SET( options, "profile-account", chain_config->profile_accounts );
 
+      chain_config->wasm_instantiation_cache_size = options.at( "wasm-instantiation-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
+      chain_config->contract_profile_sample_interval = options.at( "contract-profile-sample-interval" ).as<uint32_t>();
+
       abi_serializer_max_time_us = fc::microseconds(options.at("abi-serializer-max-time-ms").as<uint32_t>() * 1000);
 
       chain_config->finalizers_dir = finalizers_dir;
@@ -775,11 +801,10 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
 
          // recover genesis information from the snapshot
          // used for validation code below
-         auto infile = std::ifstream(snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
-         istream_snapshot_reader reader(infile);
+         // read as startup does, so both uncompressed and compressed snapshots are accepted
+         threaded_snapshot_reader reader(*snapshot_path);
          reader.validate();
          chain_id = controller::extract_chain_id(reader);
-         infile.close();
 
          EOS_ASSERT( options.count( "genesis-timestamp" ) == 0,
                  plugin_config_exception,
@@ -947,6 +972,9 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
          chain_config->eosvmoc_config.cache_size = options.at( "eos-vm-oc-cache-size-mb" ).as<uint64_t>() * 1024u * 1024u;
       if( options.count("eos-vm-oc-compile-threads") )
          chain_config->eosvmoc_config.threads = options.at("eos-vm-oc-compile-threads").as<uint64_t>();
+      chain_config->eosvmoc_config.warmup_contracts = options.at("eos-vm-oc-warmup-contracts").as<uint32_t>();
+      chain_config->eosvmoc_config.protected_percent = options.at("eos-vm-oc-cache-protected-percent").as<uint32_t>();
+      chain_config->eosvmoc_config.admission_threshold = options.at("eos-vm-oc-cache-admission-threshold").as<uint32_t>();
       chain_config->eosvmoc_tierup = options["eos-vm-oc-enable"].as<chain::wasm_interface::vm_oc_enable>();
 #endif
 
@@ -954,6 +982,7 @@ void chain_plugin_impl::plugin_initialize(const variables_map& options) {
 
       chain_config->integrity_hash_on_start = options.at("integrity-hash-on-start").as<bool>();
       chain_config->integrity_hash_on_stop = options.at("integrity-hash-on-stop").as<bool>();
+      chain_config->integrity_hash_per_section = options.at("integrity-hash-per-section").as<bool>();
 
       chain.emplace( *chain_config, std::move(pfs), *chain_id );
 
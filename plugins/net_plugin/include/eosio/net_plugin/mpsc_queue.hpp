@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace eosio {
+
+   /**
+    * Unbounded lock free multi producer, single consumer FIFO queue (Vyukov's intrusive MPSC queue with a stub node).
+    * push() may be called from any thread and is a single atomic exchange. pop(), empty() and clear() must only be
+    * called by the single consumer, e.g. from a strand.
+    *
+    * A push that has exchanged the head but not yet linked its node is not visible to the consumer, so empty() can
+    * transiently report a queue as empty that a producer is pushing to. Producers that need the consumer to notice their
+    * element must signal it after push() returns.
+    */
+   template<typename T>
+   class mpsc_queue {
+   public:
+      mpsc_queue() : _head(&_stub), _tail(&_stub) {}
+
+      ~mpsc_queue() {
+         clear();
+      }
+
+      mpsc_queue(const mpsc_queue&) = delete;
+      mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+      /// thread safe
+      void push(T v) {
+         push_node(new node(std::move(v)));
+      }
+
+      /// consumer only
+      bool empty() const {
+         // any node other than the stub at the tail holds the next element
+         return _tail == &_stub && _stub.next.load(std::memory_order_acquire) == nullptr;
+      }
+
+      /// consumer only, @return the oldest element, or empty if there is none
+      std::optional<T> pop() {
+         node* tail = _tail;
+         node* next = tail->next.load(std::memory_order_acquire);
+         if (tail == &_stub) {
+            if (next == nullptr)
+               return {};
+            // skip the stub
+            _tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+         }
+         if (next != nullptr) {
+            _tail = next;
+            std::optional<T> v{std::move(*tail->value)};
+            delete tail;
+            return v;
+         }
+         if (tail != _head.load(std::memory_order_acquire))
+            return {}; // a producer is between exchanging the head and linking its node
+         // tail is the last node, put the stub back behind it so that tail can be removed
+         push_node(&_stub);
+         next = tail->next.load(std::memory_order_acquire);
+         if (next != nullptr) {
+            _tail = next;
+            std::optional<T> v{std::move(*tail->value)};
+            delete tail;
+            return v;
+         }
+         return {};
+      }
+
+      /// consumer only, calls f for each element in order until the queue is empty or one is still being pushed
+      template<typename F>
+      size_t consume_all(F&& f) {
+         size_t n = 0;
+         while (std::optional<T> v = pop()) {
+            f(std::move(*v));
+            ++n;
+         }
+         return n;
+      }
+
+      /// consumer only
+      void clear() {
+         while (pop()) {}
+      }
+
+   private:
+      struct node {
+         node() = default;
+         explicit node(T&& v) : value(std::move(v)) {}
+         std::atomic<node*> next{nullptr};
+         std::optional<T>   value;
+      };
+
+      void push_node(node* n) {
+         n->next.store(nullptr, std::memory_order_relaxed);
+         node* prev = _head.exchange(n, std::memory_order_acq_rel);
+         prev->next.store(n, std::memory_order_release);
+      }
+
+      alignas(64) std::atomic<node*> _head; // producers
+      alignas(64) node*              _tail; // consumer
+      node                           _stub;
+   };
+
+}
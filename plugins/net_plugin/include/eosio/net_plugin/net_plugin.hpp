@@ -73,6 +73,11 @@ namespace eosio {
             p2p_per_connection_metrics& operator=(const p2p_per_connection_metrics&) = delete;
             std::vector<connection_metric> peers;
         };
+        struct p2p_send_buffer_pool_metrics {
+            uint64_t hits{0};     // send buffers reused from the pool
+            uint64_t misses{0};   // send buffers allocated because the pool had none of the size available
+            uint64_t unpooled{0}; // send buffers too large to be pooled, mostly blocks
+        };
         struct p2p_connections_metrics {
            p2p_connections_metrics(std::size_t peers, std::size_t clients, p2p_per_connection_metrics&& statistics)
               : num_peers{peers}
@@ -83,11 +88,13 @@ namespace eosio {
               : num_peers{std::move(statistics.num_peers)}
               , num_clients{std::move(statistics.num_clients)}
               , stats{std::move(statistics.stats)}
+              , send_buffer_pool{statistics.send_buffer_pool}
            {}
            p2p_connections_metrics(const p2p_connections_metrics&) = delete;
            std::size_t num_peers   = 0;
            std::size_t num_clients = 0;
            p2p_per_connection_metrics stats;
+           p2p_send_buffer_pool_metrics send_buffer_pool;
         };
 
         void register_update_p2p_connection_metrics(std::function<void(p2p_connections_metrics)>&&);
@@ -2,10 +2,14 @@
 
 #include <eosio/chain/exceptions.hpp>
 #include <boost/numeric/conversion/cast.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
 
 #include <string>
 #include <sstream>
 #include <regex>
+#include <string_view>
 
 namespace eosio::net_utils {
 
@@ -40,8 +44,60 @@ namespace detail {
       return block_sync_rate_limit;
    }
 
+   struct decompression_limiter {
+      using char_type = char;
+      using category = boost::iostreams::multichar_output_filter_tag;
+
+      template<typename Sink>
+      std::streamsize write(Sink& sink, const char* s, std::streamsize count) {
+         EOS_ASSERT(total + count <= limit, chain::plugin_exception, "Exceeded maximum decompressed p2p message size ${l}", ("l", limit));
+         total += count;
+         return boost::iostreams::write(sink, s, count);
+      }
+
+      std::streamsize limit = 0;
+      std::streamsize total = 0;
+   };
+
 } // namespace detail
 
+   /// p2p-peer-address option, also advertised in the handshake p2p_address, requesting zlib compression of blocks
+   constexpr std::string_view compression_option = "zlib";
+
+   /// @return true if peer address host:port[:<trx>|<blk>][:zlib], or a handshake p2p_address of that form followed
+   ///         by " - <node id>", requests compression
+   inline bool peer_address_requests_compression( std::string_view peer_add ) {
+      peer_add = peer_add.substr( 0, peer_add.find(' ') );
+      auto last_colon_location = peer_add.rfind(':');
+      if( last_colon_location == peer_add.npos || peer_add.find(']', last_colon_location) != peer_add.npos )
+         return false;
+      return peer_add.substr( last_colon_location + 1 ) == compression_option;
+   }
+
+   inline std::vector<char> zlib_compress( const char* data, size_t size ) {
+      namespace bio = boost::iostreams;
+      std::vector<char> out;
+      bio::filtering_ostream comp;
+      comp.push(bio::zlib_compressor(bio::zlib::best_speed)); // sync throughput matters more than the last few percent
+      comp.push(bio::back_inserter(out));
+      bio::write(comp, data, size);
+      bio::close(comp);
+      return out;
+   }
+
+   /// @throws plugin_exception if the decompressed data would exceed max_size
+   inline std::vector<char> zlib_decompress( const std::vector<char>& data, size_t max_size ) {
+      namespace bio = boost::iostreams;
+      std::vector<char> out;
+      bio::filtering_ostream decomp;
+      decomp.push(bio::zlib_decompressor());
+      decomp.push(detail::decompression_limiter{ .limit = static_cast<std::streamsize>(max_size) }); // zip bomb protection
+      decomp.push(bio::back_inserter(out));
+      bio::write(decomp, data.data(), data.size());
+      bio::close(decomp);
+      return out;
+   }
+
    /// @return listen address and block sync rate limit (in bytes/sec) of address string
    inline std::tuple<std::string, size_t> parse_listen_address( const std::string& address ) {
       auto listen_addr = address;
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <optional>
+#include <utility>
+
+namespace eosio {
+
+   /**
+    * Bookkeeping of the block ranges requested during a parallel sync. Every peer has at most one outstanding range.
+    * Ranges taken back from a stalled or closed peer are queued to be requested again, ahead of new ranges, since the
+    * blocks after them can not be applied until they arrive.
+    */
+   template<typename Peer>
+   class sync_fetch_ranges {
+   public:
+      struct range {
+         uint32_t start = 0;
+         uint32_t end   = 0; // inclusive
+         Peer     peer{};
+      };
+
+      size_t size() const { return _assigned.size(); }
+      bool   empty() const { return _assigned.empty() && _unassigned.empty(); }
+
+      bool has_peer(const Peer& p) const {
+         return std::any_of(_assigned.begin(), _assigned.end(), [&](const range& r) { return r.peer == p; });
+      }
+
+      void assign(uint32_t start, uint32_t end, Peer p) {
+         _assigned.push_back(range{start, end, std::move(p)});
+      }
+
+      /// removes the range assigned to p
+      std::optional<range> remove(const Peer& p) {
+         auto i = std::find_if(_assigned.begin(), _assigned.end(), [&](const range& r) { return r.peer == p; });
+         if (i == _assigned.end())
+            return {};
+         range r = std::move(*i);
+         _assigned.erase(i);
+         return r;
+      }
+
+      /// removes the range assigned to p and queues the part of it at or after next_needed to be requested again
+      void reassign(const Peer& p, uint32_t next_needed) {
+         std::optional<range> r = remove(p);
+         if (r && r->end >= next_needed)
+            requeue(std::max(r->start, next_needed), r->end);
+      }
+
+      /// removes the range assigned to p and queues the rest of it, from block_num on, to be requested again as one range.
+      /// Ignored if block_num is not in the range assigned to p
+      void take_back(const Peer& p, uint32_t block_num) {
+         auto i = std::find_if(_assigned.begin(), _assigned.end(), [&](const range& r) { return r.peer == p; });
+         if (i == _assigned.end() || block_num < i->start || block_num > i->end)
+            return;
+         const uint32_t end = i->end;
+         _assigned.erase(i);
+         requeue(block_num, end);
+      }
+
+      /// queues start..end to be requested again, ahead of any later queued range
+      void requeue(uint32_t start, uint32_t end) {
+         auto i = std::find_if(_unassigned.begin(), _unassigned.end(), [&](const auto& u) { return u.first > start; });
+         _unassigned.insert(i, {start, end});
+      }
+
+      /// next range taken back from a peer that still needs to be requested, dropping any already received
+      std::optional<std::pair<uint32_t, uint32_t>> pop_unassigned(uint32_t next_needed) {
+         while (!_unassigned.empty()) {
+            auto u = _unassigned.front();
+            _unassigned.pop_front();
+            if (u.second >= next_needed)
+               return std::make_pair(std::max(u.first, next_needed), u.second);
+         }
+         return {};
+      }
+
+      void clear() {
+         _assigned.clear();
+         _unassigned.clear();
+      }
+
+   private:
+      std::deque<range>                         _assigned;
+      std::deque<std::pair<uint32_t, uint32_t>> _unassigned;
+   };
+
+   /**
+    * Blocks received during a parallel sync ahead of the next block to be applied, held until every block before them
+    * has arrived so that blocks are handed to the chain in order regardless of which peer delivered them first.
+    */
+   template<typename T>
+   class sync_reorder_buffer {
+   public:
+      explicit sync_reorder_buffer(size_t max_blocks) : _max_blocks(max_blocks) {}
+
+      size_t size() const { return _blocks.size(); }
+      bool   full() const { return _blocks.size() >= _max_blocks; }
+
+      /// false if a block with the same number is already held, or the buffer is full
+      bool add(uint32_t block_num, T v) {
+         if (full())
+            return false;
+         return _blocks.try_emplace(block_num, std::move(v)).second;
+      }
+
+      /**
+       * Calls f for each held block in order starting at next_num, for as long as the block numbers are consecutive.
+       * Blocks before next_num are discarded.
+       * @return the block number following the last block passed to f
+       */
+      template<typename F>
+      uint32_t pop_in_order(uint32_t next_num, F&& f) {
+         auto i = _blocks.begin();
+         while (i != _blocks.end() && i->first < next_num)
+            i = _blocks.erase(i);
+         while (i != _blocks.end() && i->first == next_num) {
+            f(i->first, std::move(i->second));
+            i = _blocks.erase(i);
+            ++next_num;
+         }
+         return next_num;
+      }
+
+      void clear() { _blocks.clear(); }
+
+   private:
+      const size_t           _max_blocks;
+      std::map<uint32_t, T>  _blocks;
+   };
+
+}
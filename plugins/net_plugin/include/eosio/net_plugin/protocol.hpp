@@ -134,6 +134,11 @@ namespace eosio {
       uint32_t end_block{0};
    };
 
+   /// zlib compressed serialization of another net_message, only sent to peers that negotiated compression in the handshake
+   struct compressed_message {
+      std::vector<char> data;
+   };
+
    using net_message = std::variant<handshake_message,
                                     chain_size_message,
                                     go_away_message,
@@ -143,7 +148,8 @@ namespace eosio {
                                     sync_request_message,
                                     signed_block,
                                     packed_transaction,
-                                    vote_message>;
+                                    vote_message,
+                                    compressed_message>;
 
 } // namespace eosio
 
@@ -162,6 +168,7 @@ FC_REFLECT( eosio::time_message, (org)(rec)(xmt)(dst) )
 FC_REFLECT( eosio::notice_message, (known_trx)(known_blocks) )
 FC_REFLECT( eosio::request_message, (req_trx)(req_blocks) )
 FC_REFLECT( eosio::sync_request_message, (start_block)(end_block) )
+FC_REFLECT( eosio::compressed_message, (data) )
 
 /**
  *
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace eosio {
+
+   /**
+    * Fixed size, lock free set of recently seen ids, used to avoid sending a transaction to a peer that already has it.
+    * Ids are added to the current of two bloom filter generations. Once the current generation holds `capacity` ids, or
+    * `period` has passed since it was started, the older generation is cleared and becomes the current one. An id is
+    * therefore remembered for at least `period`, unless more than `capacity` ids arrive within it, and for at most twice
+    * that. Memory is bounded by the capacity no matter the transaction rate.
+    *
+    * Lookups can return a false positive with a probability of about 0.0001 per generation at capacity. Concurrent
+    * inserts and a concurrent rotation can lose an id, so contains() may return a false negative just after a rotation.
+    * Both are acceptable for deduplication: at worst a transaction is not relayed by one peer, or is sent twice.
+    */
+   class rolling_bloom_filter {
+   public:
+      static constexpr uint32_t bits_per_id = 20;
+      static constexpr uint32_t num_hashes  = 14; // bits_per_id * ln(2)
+
+      rolling_bloom_filter(uint32_t capacity, fc::microseconds period, uint64_t seed)
+      : _capacity(std::max(capacity, 1u))
+      , _period(period)
+      , _num_words((uint64_t{_capacity} * bits_per_id + 63) / 64)
+      , _seed(seed | 1) {
+         for (auto& g : _generations)
+            g.bits = std::make_unique<std::atomic<uint64_t>[]>(_num_words);
+      }
+
+      rolling_bloom_filter(const rolling_bloom_filter&) = delete;
+      rolling_bloom_filter& operator=(const rolling_bloom_filter&) = delete;
+
+      /// @return true if id was not in the filter and has been added
+      bool add(const fc::sha256& id, fc::time_point now) {
+         if (contains(id))
+            return false;
+         maybe_rotate(now);
+         generation& g = _generations[_current.load(std::memory_order_acquire)];
+         for_each_bit(id, [&](uint64_t word, uint64_t mask) {
+            g.bits[word].fetch_or(mask, std::memory_order_relaxed);
+            return true;
+         });
+         g.count.fetch_add(1, std::memory_order_relaxed);
+         return true;
+      }
+
+      bool contains(const fc::sha256& id) const {
+         for (const auto& g : _generations) {
+            bool all_set = for_each_bit(id, [&](uint64_t word, uint64_t mask) {
+               return (g.bits[word].load(std::memory_order_relaxed) & mask) != 0;
+            });
+            if (all_set)
+               return true;
+         }
+         return false;
+      }
+
+      /// rotates generations if the current one is full or older than period
+      void maybe_rotate(fc::time_point now) {
+         const uint32_t cur = _current.load(std::memory_order_acquire);
+         if (_generations[cur].count.load(std::memory_order_relaxed) < _capacity &&
+             now.time_since_epoch().count() - _started.load(std::memory_order_relaxed) < _period.count())
+            return;
+         if (_rotating.test_and_set(std::memory_order_acquire))
+            return; // another thread is rotating
+         if (_current.load(std::memory_order_relaxed) == cur) {
+            generation& next = _generations[cur ^ 1];
+            for (uint64_t i = 0; i < _num_words; ++i)
+               next.bits[i].store(0, std::memory_order_relaxed);
+            next.count.store(0, std::memory_order_relaxed);
+            _started.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+            _current.store(cur ^ 1, std::memory_order_release);
+         }
+         _rotating.clear(std::memory_order_release);
+      }
+
+      /// forgets all ids, not safe to call concurrently with add
+      void clear() {
+         for (auto& g : _generations) {
+            for (uint64_t i = 0; i < _num_words; ++i)
+               g.bits[i].store(0, std::memory_order_relaxed);
+            g.count.store(0, std::memory_order_relaxed);
+         }
+      }
+
+      /// number of ids added to the current generation
+      uint32_t current_size() const {
+         return _generations[_current.load(std::memory_order_acquire)].count.load(std::memory_order_relaxed);
+      }
+
+      size_t memory_size() const { return 2 * _num_words * sizeof(uint64_t); }
+
+   private:
+      struct generation {
+         std::unique_ptr<std::atomic<uint64_t>[]> bits;
+         std::atomic<uint32_t>                    count{0};
+      };
+
+      // ids are sha256 digests, so their words are already uniformly distributed; mixing in a per filter secret seed keeps
+      // a peer from choosing ids that collide in our filter. Double hashing derives the num_hashes bit positions.
+      template<typename F>
+      bool for_each_bit(const fc::sha256& id, F&& f) const {
+         const uint64_t total_bits = _num_words * 64;
+         const uint64_t h1 = (id._hash[0] ^ _seed) * 0x9e3779b97f4a7c15ull;
+         const uint64_t h2 = ((id._hash[1] ^ _seed) * 0xc2b2ae3d27d4eb4full) | 1;
+         for (uint32_t i = 0; i < num_hashes; ++i) {
+            const uint64_t bit = (h1 + i * h2) % total_bits;
+            if (!f(bit / 64, uint64_t{1} << (bit % 64)))
+               return false;
+         }
+         return true;
+      }
+
+      const uint32_t           _capacity;
+      const fc::microseconds   _period;
+      const uint64_t           _num_words;
+      const uint64_t           _seed;
+      generation               _generations[2];
+      std::atomic<uint32_t>    _current{0};
+      std::atomic<int64_t>     _started{0};
+      std::atomic_flag         _rotating = ATOMIC_FLAG_INIT;
+   };
+
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace eosio {
+
+   class send_buffer_pool;
+
+   /**
+    * Reference counted buffer holding one framed net message. The same buffer is shared by every connection a message
+    * is broadcast to, and only the reference count is touched per peer. Buffers come from the size classed free lists of
+    * a send_buffer_pool and go back to them when the last reference is released, so that the steady stream of similarly
+    * sized transaction and vote messages does not allocate per message.
+    */
+   class send_buffer {
+   public:
+      char*       data()       { return _data; }
+      const char* data() const { return _data; }
+      size_t      size() const { return _size; }
+
+      send_buffer(const send_buffer&) = delete;
+      send_buffer& operator=(const send_buffer&) = delete;
+
+   private:
+      friend class send_buffer_pool;
+      friend void intrusive_ptr_add_ref(send_buffer* b) { b->_refs.fetch_add(1, std::memory_order_relaxed); }
+      friend void intrusive_ptr_release(send_buffer* b);
+
+      static constexpr uint8_t unpooled = 0xff; ///< allocated with its data, freed on release
+      static constexpr uint8_t adopted  = 0xfe; ///< data owned by _adopted, freed on release
+
+      send_buffer(send_buffer_pool* pool, uint8_t size_class, size_t size, char* data)
+      : _pool(pool), _size_class(size_class), _size(size), _data(data) {}
+      ~send_buffer() = default;
+
+      std::atomic<uint32_t> _refs{0};
+      send_buffer_pool*     _pool;
+      uint8_t               _size_class;
+      size_t                _size;
+      char*                 _data;
+      std::vector<char>     _adopted; ///< storage of a buffer created by send_buffer_pool::adopt
+   };
+
+   using send_buffer_ptr = boost::intrusive_ptr<send_buffer>;
+
+   /**
+    * Thread safe pool of send_buffers. Buffers are rounded up to one of a few size classes, each with a free list bounded
+    * by the bytes it holds, so that at most size_classes.size() * max_free_bytes_per_class stay allocated while unused;
+    * larger buffers are allocated and freed directly. A pool must outlive all the buffers allocated from it.
+    */
+   class send_buffer_pool {
+   public:
+      static constexpr std::array<size_t, 6> size_classes{ 256, 1024, 4*1024, 16*1024, 64*1024, 256*1024 };
+      static constexpr size_t default_max_free_bytes_per_class = 4*1024*1024;
+
+      struct stats {
+         uint64_t hits     = 0; ///< allocations served from a free list
+         uint64_t misses   = 0; ///< allocations of a pooled size class that found its free list empty
+         uint64_t unpooled = 0; ///< allocations larger than the largest size class, or adopted buffers
+      };
+
+      explicit send_buffer_pool(size_t max_free_bytes_per_class = default_max_free_bytes_per_class) {
+         for (size_t i = 0; i < size_classes.size(); ++i)
+            _free_lists[i].max_buffers = max_free_bytes_per_class / size_classes[i];
+      }
+
+      ~send_buffer_pool() {
+         for (auto& fl : _free_lists) {
+            for (send_buffer* b : fl.buffers)
+               destroy(b);
+         }
+      }
+
+      send_buffer_pool(const send_buffer_pool&) = delete;
+      send_buffer_pool& operator=(const send_buffer_pool&) = delete;
+
+      /// pool shared by all connections of the net_plugin
+      static send_buffer_pool& default_pool() {
+         static send_buffer_pool pool;
+         return pool;
+      }
+
+      /// buffer of `size` uninitialized bytes
+      send_buffer_ptr allocate(size_t size) {
+         const uint8_t size_class = size_class_of(size);
+         if (size_class == send_buffer::unpooled) {
+            ++_unpooled;
+            return send_buffer_ptr{ create(send_buffer::unpooled, size, size) };
+         }
+
+         auto& fl = _free_lists[size_class];
+         {
+            std::lock_guard g(fl.mtx);
+            if (!fl.buffers.empty()) {
+               send_buffer* b = fl.buffers.back();
+               fl.buffers.pop_back();
+               ++_hits;
+               b->_size = size;
+               return send_buffer_ptr{b};
+            }
+         }
+         ++_misses;
+         return send_buffer_ptr{ create(size_class, size, size_classes[size_class]) };
+      }
+
+      /// buffer taking ownership of already serialized bytes, avoids copying e.g. a block read from the block log
+      send_buffer_ptr adopt(std::vector<char>&& bytes) {
+         ++_unpooled;
+         auto* b = new send_buffer(this, send_buffer::adopted, bytes.size(), nullptr);
+         b->_adopted = std::move(bytes);
+         b->_data = b->_adopted.data();
+         return send_buffer_ptr{b};
+      }
+
+      stats get_stats() const {
+         return { .hits = _hits.load(std::memory_order_relaxed),
+                  .misses = _misses.load(std::memory_order_relaxed),
+                  .unpooled = _unpooled.load(std::memory_order_relaxed) };
+      }
+
+      size_t free_buffers() const {
+         size_t n = 0;
+         for (auto& fl : _free_lists) {
+            std::lock_guard g(fl.mtx);
+            n += fl.buffers.size();
+         }
+         return n;
+      }
+
+   private:
+      friend void intrusive_ptr_release(send_buffer* b);
+
+      struct free_list {
+         mutable std::mutex         mtx;
+         std::vector<send_buffer*>  buffers;
+         size_t                     max_buffers = 0;
+      };
+
+      static uint8_t size_class_of(size_t size) {
+         for (uint8_t i = 0; i < size_classes.size(); ++i) {
+            if (size <= size_classes[i])
+               return i;
+         }
+         return send_buffer::unpooled;
+      }
+
+      // header and data in a single allocation
+      send_buffer* create(uint8_t size_class, size_t size, size_t capacity) {
+         void* mem = ::operator new(sizeof(send_buffer) + capacity);
+         char* data = static_cast<char*>(mem) + sizeof(send_buffer);
+         return new (mem) send_buffer(this, size_class, size, data);
+      }
+
+      static void destroy(send_buffer* b) {
+         if (b->_size_class == send_buffer::adopted) {
+            delete b;
+         } else {
+            b->~send_buffer();
+            ::operator delete(static_cast<void*>(b));
+         }
+      }
+
+      void release(send_buffer* b) {
+         if (b->_size_class < size_classes.size()) {
+            auto& fl = _free_lists[b->_size_class];
+            std::lock_guard g(fl.mtx);
+            if (fl.buffers.size() < fl.max_buffers) {
+               fl.buffers.push_back(b);
+               return;
+            }
+         }
+         destroy(b);
+      }
+
+      std::array<free_list, size_classes.size()>    _free_lists;
+      std::atomic<uint64_t>                         _hits{0};
+      std::atomic<uint64_t>                         _misses{0};
+      std::atomic<uint64_t>                         _unpooled{0};
+   };
+
+   inline void intrusive_ptr_release(send_buffer* b) {
+      if (b->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+         b->_pool->release(b);
+   }
+
+}
@@ -2,6 +2,10 @@
 #include <eosio/net_plugin/protocol.hpp>
 #include <eosio/net_plugin/net_utils.hpp>
 #include <eosio/net_plugin/auto_bp_peering.hpp>
+#include <eosio/net_plugin/send_buffer_pool.hpp>
+#include <eosio/net_plugin/parallel_sync.hpp>
+#include <eosio/net_plugin/rolling_bloom_filter.hpp>
+#include <eosio/net_plugin/mpsc_queue.hpp>
 #include <eosio/chain/types.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/exceptions.hpp>
@@ -69,7 +73,7 @@ namespace eosio {
 
    using connection_ptr = std::shared_ptr<connection>;
    using connection_wptr = std::weak_ptr<connection>;
-   using send_buffer_type = std::shared_ptr<std::vector<char>>;
+   using send_buffer_type = send_buffer_ptr;
 
    static constexpr int64_t block_interval_ns =
       std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::milliseconds(config::block_interval_ms)).count();
@@ -89,7 +93,6 @@ namespace eosio {
    struct node_transaction_state {
       transaction_id_type id;
       time_point_sec  expires;        /// time after which this may be purged.
-      uint32_t        connection_id = 0;
    };
 
    struct by_expiry;
@@ -99,11 +102,7 @@ namespace eosio {
       indexed_by<
          ordered_unique<
             tag<by_id>,
-            composite_key< node_transaction_state,
-               member<node_transaction_state, transaction_id_type, &node_transaction_state::id>,
-               member<node_transaction_state, uint32_t, &node_transaction_state::connection_id>
-            >,
-            composite_key_compare< std::less<transaction_id_type>, std::less<> >
+            member<node_transaction_state, transaction_id_type, &node_transaction_state::id>
          >,
          ordered_non_unique<
             tag< by_expiry >,
@@ -227,6 +226,16 @@ namespace eosio {
 
       const uint32_t sync_fetch_span {0};
       const uint32_t sync_peer_limit {0};
+      const uint32_t sync_fetch_parallel {1};
+
+      // a block received during parallel sync ahead of sync_next_expected_num
+      struct pending_sync_block {
+         connection_ptr   conn;
+         block_id_type    id;
+         signed_block_ptr block;
+      };
+      sync_fetch_ranges<connection_ptr>       sync_ranges  GUARDED_BY(sync_mtx); // outstanding range requests, parallel sync only
+      sync_reorder_buffer<pending_sync_block> sync_reorder GUARDED_BY(sync_mtx); // blocks waiting for their predecessors, parallel sync only
 
       alignas(hardware_destructive_interference_sz)
       std::atomic<stages> sync_state{in_sync};
@@ -249,6 +258,9 @@ namespace eosio {
       bool is_sync_required( uint32_t fork_head_block_num ) const REQUIRES(sync_mtx);
       bool is_sync_request_ahead_allowed(block_num_type blk_num) const REQUIRES(sync_mtx);
       void request_next_chunk( const connection_ptr& conn = connection_ptr() ) REQUIRES(sync_mtx);
+      bool request_next_chunks( const connection_ptr& conn ) REQUIRES(sync_mtx);
+      void reset_parallel_sync() REQUIRES(sync_mtx);
+      void dispatch_held_blocks( uint32_t next_num ) REQUIRES(sync_mtx);
       connection_ptr find_next_sync_node(); // call with locked mutex
       void start_sync( const connection_ptr& c, uint32_t target ); // locks mutex
       bool sync_recently_active() const;
@@ -258,9 +270,10 @@ namespace eosio {
          immediately,  // closing connection immediately
          handshake     // sending handshake message
       };
-      explicit sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t min_blocks_distance );
+      explicit sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t fetch_parallel, uint32_t min_blocks_distance );
       static void send_handshakes();
       bool syncing_from_peer() const { return sync_state == lib_catchup; }
+      bool parallel_sync() const { return sync_fetch_parallel > 1; }
       bool is_in_sync() const { return sync_state == in_sync; }
       void sync_reset_lib_num( const connection_ptr& conn, bool closing );
       void sync_timeout(const connection_ptr& c, const boost::system::error_code& ec);
@@ -269,6 +282,8 @@ namespace eosio {
       void rejected_block( const connection_ptr& c, uint32_t blk_num, closing_mode mode );
       void sync_recv_block( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied,
                             const fc::microseconds& blk_latency );
+      void sync_dispatch_block( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, signed_block_ptr b );
+      void sync_skip_block( uint32_t blk_num, uint32_t lib_num );
       void recv_handshake( const connection_ptr& c, const handshake_message& msg, uint32_t nblk_combined_latency );
       void sync_recv_notice( const connection_ptr& c, const notice_message& msg );
       void send_handshakes_if_synced(const fc::microseconds& blk_latency);
@@ -281,7 +296,7 @@ namespace eosio {
 
       alignas(hardware_destructive_interference_sz)
       mutable fc::mutex      local_txns_mtx;
-      node_transaction_index  local_txns GUARDED_BY(local_txns_mtx);
+      node_transaction_index  local_txns GUARDED_BY(local_txns_mtx); // every trx received or broadcast
 
       unlinkable_block_state_cache unlinkable_block_cache;
 
@@ -305,9 +320,9 @@ namespace eosio {
       bool have_block(const block_id_type& blkid) const;
       void rm_block(const block_id_type& blkid);
 
-      bool add_peer_txn( const transaction_id_type& id, const time_point_sec& trx_expires, uint32_t connection_id,
-                         const time_point_sec& now = time_point_sec(time_point::now()) );
-      bool have_txn( const transaction_id_type& tid ) const;
+      bool add_txn( const transaction_id_type& id, const time_point_sec& trx_expires,
+                    const time_point_sec& now = time_point_sec(time_point::now()) );
+      bool add_peer_txn( const connection_ptr& c, const transaction_id_type& id, const fc::time_point& now = fc::time_point::now() );
       void expire_txns();
 
       void bcast_vote_msg( uint32_t exclude_peer, send_buffer_type msg );
@@ -338,6 +353,8 @@ namespace eosio {
    constexpr auto     def_txn_expire_wait = std::chrono::seconds(3);
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 1000;
+   constexpr auto     def_sync_prevalidate_window = 256;
+   constexpr auto     def_dedup_filter_capacity = 100000;
    constexpr auto     def_keepalive_interval = 10000;
 
    constexpr auto     message_header_size = sizeof(uint32_t);
@@ -345,6 +362,7 @@ namespace eosio {
    constexpr uint32_t signed_block_which           = fc::get_index<net_message, signed_block>();         // see protocol net_message
    constexpr uint32_t packed_transaction_which     = fc::get_index<net_message, packed_transaction>();   // see protocol net_message
    constexpr uint32_t vote_message_which           = fc::get_index<net_message, vote_message>();         // see protocol net_message
+   constexpr uint32_t compressed_message_which     = fc::get_index<net_message, compressed_message>();   // see protocol net_message
 
    class connections_manager {
    public:
@@ -483,7 +501,11 @@ namespace eosio {
       uint32_t                              max_nodes_per_host = 1;
       bool                                  p2p_accept_transactions = true;
       bool                                  p2p_accept_votes = true;
+      bool                                  p2p_accept_compression = true;
       fc::microseconds                      p2p_dedup_cache_expire_time_us{};
+      uint32_t                              p2p_dedup_filter_capacity = def_dedup_filter_capacity;
+      uint32_t                              sync_prevalidate_window = 0;
+      std::atomic<uint32_t>                 blocks_prevalidating{0};
 
       chain_id_type                         chain_id;
       fc::sha256                            node_id;
@@ -533,10 +555,17 @@ namespace eosio {
       void update_chain_info();
       void update_chain_info(const block_id_type& lib);
       chain_info_t get_chain_info() const;
+      static uint64_t random_seed() {
+         uint64_t seed = 0;
+         fc::rand_pseudo_bytes( reinterpret_cast<char*>(&seed), sizeof(seed) );
+         return seed;
+      }
+
       uint32_t get_chain_lib_num() const;
       uint32_t get_chain_head_num() const;
       uint32_t get_fork_head_num() const;
 
+      void prevalidate_block( const block_id_type& id, const signed_block_ptr& block );
       void on_accepted_block_header( const signed_block_ptr& block, const block_id_type& id );
       void on_accepted_block( const signed_block_ptr& block, const block_id_type& id );
       void broadcast_vote_message( uint32_t connection_id, vote_result_t status,
@@ -672,9 +701,10 @@ namespace eosio {
    constexpr uint16_t proto_leap_initial = 7;              // leap client, needed because none of the 2.1 versions are supported
    constexpr uint16_t proto_block_range = 8;               // include block range in notice_message
    constexpr uint16_t proto_savanna = 9;                   // savanna
+   constexpr uint16_t proto_compression = 10;              // compressed_message, negotiated through the handshake p2p_address
 #pragma GCC diagnostic pop
 
-   constexpr uint16_t net_version_max = proto_savanna;
+   constexpr uint16_t net_version_max = proto_compression;
 
    /**
     * Index by start_block_num
@@ -691,104 +721,83 @@ namespace eosio {
    };
 
    // thread safe
+   // Messages are added to the write queues from any thread without locking, and drained into the out queue, and
+   // written, from the connection strand only.
    class queued_buffer : boost::noncopyable {
    public:
+      // called from connection strand
       void clear_write_queue() {
-         fc::lock_guard g( _mtx );
-         _write_queue.clear();
-         _sync_write_queue.clear();
-         _write_queue_size = 0;
+         auto drop = [this]( queued_write&& m ) { _write_queue_size -= m.buff->size(); };
+         _write_queue.consume_all( drop );
+         _sync_write_queue.consume_all( drop );
       }
 
+      // called from connection strand
       void clear_out_queue() {
-         fc::lock_guard g( _mtx );
          while ( !_out_queue.empty() ) {
             _out_queue.pop_front();
          }
       }
 
+      // thread safe
       uint32_t write_queue_size() const {
-         fc::lock_guard g( _mtx );
          return _write_queue_size;
       }
 
+      // called from connection strand
       bool is_out_queue_empty() const {
-         fc::lock_guard g( _mtx );
          return _out_queue.empty();
       }
 
       // called from connection strand
       bool ready_to_send(uint32_t connection_id) const {
-         fc::unique_lock g( _mtx );
          // if out_queue is not empty then async_write is in progress
          bool async_write_in_progress = !_out_queue.empty();
          bool ready = ((!_sync_write_queue.empty() || !_write_queue.empty()) && !async_write_in_progress);
-         g.unlock();
          if (async_write_in_progress) {
             fc_dlog(logger, "Connection - ${id} not ready to send data, async write in progress", ("id", connection_id));
          }
          return ready;
       }
 
-      // @param callback must not callback into queued_buffer
-      bool add_write_queue( const std::shared_ptr<vector<char>>& buff,
-                            std::function<void( boost::system::error_code, std::size_t )> callback,
-                            bool to_sync_queue ) {
-         fc::lock_guard g( _mtx );
+      // thread safe
+      bool add_write_queue( const send_buffer_type& buff, bool to_sync_queue ) {
+         const uint32_t size = _write_queue_size += buff->size();
          if( to_sync_queue ) {
-            _sync_write_queue.push_back( {buff, std::move(callback)} );
+            _sync_write_queue.push( {buff} );
          } else {
-            _write_queue.push_back( {buff, std::move(callback)} );
+            _write_queue.push( {buff} );
          }
-         _write_queue_size += buff->size();
-         if( _write_queue_size > 2 * def_max_write_queue_size ) {
-            return false;
-         }
-         return true;
+         return size <= 2 * def_max_write_queue_size;
       }
 
+      // called from connection strand
       void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs ) {
-         fc::lock_guard g( _mtx );
          if( !_sync_write_queue.empty() ) { // always send msgs from sync_write_queue first
             fill_out_buffer( bufs, _sync_write_queue );
          } else { // postpone real_time write_queue if sync queue is not empty
             fill_out_buffer( bufs, _write_queue );
-            EOS_ASSERT( _write_queue_size == 0, plugin_exception, "write queue size expected to be zero" );
-         }
-      }
-
-      void out_callback( boost::system::error_code ec, std::size_t w ) {
-         fc::lock_guard g( _mtx );
-         for( auto& m : _out_queue ) {
-            m.callback( ec, w );
          }
       }
 
    private:
-      struct queued_write;
-      void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs,
-                            deque<queued_write>& w_queue ) REQUIRES(_mtx) {
-         while ( !w_queue.empty() ) {
-            auto& m = w_queue.front();
+      struct queued_write {
+         send_buffer_type buff;
+      };
+
+      void fill_out_buffer( std::vector<boost::asio::const_buffer>& bufs, mpsc_queue<queued_write>& w_queue ) {
+         w_queue.consume_all( [&]( queued_write&& m ) {
             bufs.emplace_back( m.buff->data(), m.buff->size() );
             _write_queue_size -= m.buff->size();
-            _out_queue.emplace_back( m );
-            w_queue.pop_front();
-         }
+            _out_queue.emplace_back( std::move(m) );
+         } );
       }
 
-   private:
-      struct queued_write {
-         std::shared_ptr<vector<char>> buff;
-         std::function<void( boost::system::error_code, std::size_t )> callback;
-      };
-
       alignas(hardware_destructive_interference_sz)
-      mutable fc::mutex   _mtx;
-      uint32_t            _write_queue_size GUARDED_BY(_mtx) {0};
-      deque<queued_write> _write_queue      GUARDED_BY(_mtx);
-      deque<queued_write> _sync_write_queue GUARDED_BY(_mtx); // sync_write_queue will be sent first
-      deque<queued_write> _out_queue        GUARDED_BY(_mtx);
+      std::atomic<uint32_t>    _write_queue_size{0};
+      mpsc_queue<queued_write> _write_queue;
+      mpsc_queue<queued_write> _sync_write_queue; // sync_write_queue will be sent first
+      deque<queued_write>      _out_queue;        // being written by async_write
 
    }; // queued_buffer
 
@@ -902,6 +911,10 @@ namespace eosio {
       size_t                          block_sync_rate_limit{0};  // bytes/second, default unlimited
 
       std::atomic<connection_types>   connection_type{both};
+      const bool                      compression_requested{false}; // p2p-peer-address ends with :zlib
+      std::atomic<bool>               compress_blocks{false};       // both sides offered compression in the handshake
+      rolling_bloom_filter            peer_txns;                    // trxs received from or sent to the peer
+      std::atomic<bool>               write_posted{false};          // do_queue_write posted by enqueue_buffer_any_thread
       std::atomic<uint32_t>           peer_start_block_num{0};
       std::atomic<uint32_t>           peer_fork_head_block_num{0};
       std::atomic<uint32_t>           last_received_block_num{0};
@@ -1007,9 +1020,15 @@ namespace eosio {
    private:
       void _close( bool reconnect, bool shutdown ); // for easy capture
 
-      bool process_next_block_message(uint32_t message_length);
-      bool process_next_trx_message(uint32_t message_length);
-      bool process_next_vote_message(uint32_t message_length);
+      template<typename MessageBuffer>
+      bool process_message(MessageBuffer& buffer, uint32_t message_length);
+      bool process_next_compressed_message(uint32_t message_length);
+      template<typename MessageBuffer>
+      bool process_next_block_message(MessageBuffer& buffer, uint32_t message_length);
+      template<typename MessageBuffer>
+      bool process_next_trx_message(MessageBuffer& buffer, uint32_t message_length);
+      template<typename MessageBuffer>
+      bool process_next_vote_message(MessageBuffer& buffer, uint32_t message_length);
       void update_endpoints(const tcp::endpoint& endpoint = tcp::endpoint());
    public:
 
@@ -1064,9 +1083,8 @@ namespace eosio {
 
       void enqueue( const net_message &msg );
       size_t enqueue_block( const signed_block_ptr& sb, bool to_sync_queue = false);
-      void enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
-                           go_away_reason close_after_send,
-                           bool to_sync_queue = false);
+      void enqueue_buffer( const send_buffer_type& send_buffer, bool to_sync_queue = false );
+      void enqueue_buffer_any_thread( const send_buffer_type& send_buffer );
       void cancel_sync();
       void flush_queues();
       bool enqueue_sync_block();
@@ -1075,9 +1093,7 @@ namespace eosio {
       void cancel_sync_wait();
       void sync_wait();
 
-      void queue_write(const std::shared_ptr<vector<char>>& buff,
-                       std::function<void(boost::system::error_code, std::size_t)> callback,
-                       bool to_sync_queue = false);
+      void queue_write(const send_buffer_type& buff, bool to_sync_queue = false);
       void do_queue_write();
 
       bool is_valid( const handshake_message& msg ) const;
@@ -1268,6 +1284,8 @@ namespace eosio {
 
    connection::connection( const string& endpoint, const string& listen_address )
       : peer_addr( endpoint ),
+        compression_requested( net_utils::peer_address_requests_compression( endpoint ) ),
+        peer_txns( my_impl->p2p_dedup_filter_capacity, my_impl->p2p_dedup_cache_expire_time_us, my_impl->random_seed() ),
         strand( my_impl->thread_pool.get_executor() ),
         socket( new tcp::socket( my_impl->thread_pool.get_executor() ) ),
         listen_address( listen_address ),
@@ -1286,6 +1304,7 @@ namespace eosio {
    connection::connection(tcp::socket&& s, const string& listen_address, size_t block_sync_rate_limit)
       : peer_addr(),
         block_sync_rate_limit(block_sync_rate_limit),
+        peer_txns( my_impl->p2p_dedup_filter_capacity, my_impl->p2p_dedup_cache_expire_time_us, my_impl->random_seed() ),
         strand( my_impl->thread_pool.get_executor() ),
         socket( new tcp::socket( std::move(s) ) ),
         listen_address( listen_address ),
@@ -1328,7 +1347,7 @@ namespace eosio {
    // called from connection strand
    void connection::set_connection_type( const std::string& peer_add ) {      
       auto [host, port, type] = split_host_port_type(peer_add);
-      if( type.empty() ) {
+      if( type.empty() || type == net_utils::compression_option ) {
          fc_dlog( logger, "Setting connection - ${c} type for: ${peer} to both transactions and blocks", ("c", connection_id)("peer", peer_add) );
          connection_type = both;
       } else if( type == "trx" ) {
@@ -1655,10 +1674,8 @@ namespace eosio {
    }
 
    // called from connection strand
-   void connection::queue_write(const std::shared_ptr<vector<char>>& buff,
-                                std::function<void(boost::system::error_code, std::size_t)> callback,
-                                bool to_sync_queue) {
-      if( !buffer_queue.add_write_queue( buff, std::move(callback), to_sync_queue )) {
+   void connection::queue_write(const send_buffer_type& buff, bool to_sync_queue) {
+      if( !buffer_queue.add_write_queue( buff, to_sync_queue )) {
          peer_wlog( this, "write_queue full ${s} bytes, giving up on connection", ("s", buffer_queue.write_queue_size()) );
          close();
          return;
@@ -1707,8 +1724,6 @@ namespace eosio {
                c->bytes_sent += w;
                c->last_bytes_sent = c->get_time();
 
-               c->buffer_queue.out_callback( ec, w );
-
                c->enqueue_sync_block();
                c->do_queue_write();
             } catch ( const std::bad_alloc& ) {
@@ -1736,60 +1751,6 @@ namespace eosio {
       enqueue( ( sync_request_message ) {0,0} );
    }
 
-   // called from connection strand
-   bool connection::enqueue_sync_block() {
-      if( !peer_requested ) {
-         return false;
-      } else {
-         peer_dlog( this, "enqueue sync block ${num}", ("num", peer_requested->last + 1) );
-      }
-      uint32_t num = peer_requested->last + 1;
-
-      controller& cc = my_impl->chain_plug->chain();
-      signed_block_ptr sb;
-      try {
-         sb = cc.fetch_block_by_number( num ); // thread-safe
-      } FC_LOG_AND_DROP();
-      if( sb ) {
-         // Skip transmitting block this loop if threshold exceeded
-         if (block_sync_send_start == 0ns) { // start of enqueue blocks
-            block_sync_send_start = get_time();
-            block_sync_frame_bytes_sent = 0;
-         }
-         if( block_sync_rate_limit > 0 && block_sync_frame_bytes_sent > 0 && peer_syncing_from_us ) {
-            auto now = get_time();
-            auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - block_sync_send_start);
-            double current_rate_sec = (double(block_sync_frame_bytes_sent) / elapsed_us.count()) * 100000; // convert from bytes/us => bytes/sec
-            peer_dlog(this, "start enqueue block time ${st}, now ${t}, elapsed ${e}, rate ${r}, limit ${l}",
-                      ("st", block_sync_send_start.count())("t", now.count())("e", elapsed_us.count())("r", current_rate_sec)("l", block_sync_rate_limit));
-            if( current_rate_sec >= block_sync_rate_limit ) {
-               block_sync_throttling = true;
-               peer_dlog( this, "throttling block sync to peer ${host}:${port}", ("host", log_remote_endpoint_ip)("port", log_remote_endpoint_port));
-               return false;
-            }
-         }
-         block_sync_throttling = false;
-         auto sent = enqueue_block( sb, true );
-         block_sync_total_bytes_sent += sent;
-         block_sync_frame_bytes_sent += sent;
-         ++peer_requested->last;
-         if(num == peer_requested->end_block) {
-            peer_requested.reset();
-            block_sync_send_start = 0ns;
-            block_sync_frame_bytes_sent = 0;
-            peer_dlog( this, "completing enqueue_sync_block ${num}", ("num", num) );
-         }
-      } else {
-         peer_ilog( this, "enqueue sync, unable to fetch block ${num}, sending benign_other go away", ("num", num) );
-         peer_requested.reset(); // unable to provide requested blocks
-         block_sync_send_start = 0ns;
-         block_sync_frame_bytes_sent = 0;
-         no_retry = benign_other;
-         enqueue( go_away_message( benign_other ) );
-      }
-      return true;
-   }
-
    //------------------------------------------------------------------------
 
    struct buffer_factory {
@@ -1802,6 +1763,16 @@ namespace eosio {
          return send_buffer;
       }
 
+      /// frames the payload of a framed send_buffer as a compressed_message, for connections that negotiated compression.
+      /// returns send_buffer itself when compressing does not make it smaller
+      static send_buffer_type create_compressed_send_buffer( const send_buffer_type& send_buffer ) {
+         const size_t payload_size = send_buffer->size() - message_header_size;
+         compressed_message cm{ net_utils::zlib_compress( send_buffer->data() + message_header_size, payload_size ) };
+         if( cm.data.size() >= payload_size )
+            return send_buffer;
+         return create_send_buffer( compressed_message_which, cm );
+      }
+
    protected:
       send_buffer_type send_buffer;
 
@@ -1812,7 +1783,7 @@ namespace eosio {
          const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
          const size_t buffer_size = message_header_size + payload_size;
 
-         auto send_buffer = std::make_shared<vector<char>>(buffer_size);
+         auto send_buffer = send_buffer_pool::default_pool().allocate( buffer_size );
          fc::datastream<char*> ds( send_buffer->data(), buffer_size);
          ds.write( header, message_header_size );
          fc::raw::pack( ds, m );
@@ -1829,7 +1800,7 @@ namespace eosio {
          const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
          const size_t buffer_size = message_header_size + payload_size;
 
-         auto send_buffer = std::make_shared<vector<char>>( buffer_size );
+         auto send_buffer = send_buffer_pool::default_pool().allocate( buffer_size );
          fc::datastream<char*> ds( send_buffer->data(), buffer_size );
          ds.write( header, message_header_size );
          fc::raw::pack( ds, unsigned_int( which ) );
@@ -1850,9 +1821,42 @@ namespace eosio {
          return send_buffer;
       }
 
+      /// caches result for subsequent calls, only provide same signed_block_ptr instance for each invocation.
+      const send_buffer_type& get_send_buffer( const signed_block_ptr& sb, bool compressed ) {
+         if( !compressed )
+            return get_send_buffer( sb );
+         if( !compressed_send_buffer ) {
+            compressed_send_buffer = create_compressed_send_buffer( get_send_buffer( sb ) );
+         }
+         return compressed_send_buffer;
+      }
+
+      /// frames block_num as it is serialized in the block log, or fork database, without unpacking and repacking it.
+      /// returns an empty buffer if the block is not available
+      static send_buffer_type create_send_buffer( const controller& cc, uint32_t block_num ) {
+         // matches which of net_message for signed_block
+         const uint32_t which_size = fc::raw::pack_size( unsigned_int( signed_block_which ) );
+         const size_t prefix_size = message_header_size + which_size;
+
+         std::vector<char> bytes( prefix_size );
+         if( !cc.fetch_serialized_block_by_number( block_num, bytes ) )
+            return {};
+
+         const uint32_t payload_size = bytes.size() - message_header_size;
+         const char* const header = reinterpret_cast<const char* const>(&payload_size); // avoid variable size encoding of uint32_t
+         fc::datastream<char*> ds( bytes.data(), prefix_size );
+         ds.write( header, message_header_size );
+         fc::raw::pack( ds, unsigned_int( signed_block_which ) );
+
+         fc_dlog( logger, "sending block ${bn}", ("bn", block_num) );
+         // blocks are mostly larger than the pooled size classes, take ownership of the bytes rather than copying them
+         return send_buffer_pool::default_pool().adopt( std::move(bytes) );
+      }
+
    private:
+      send_buffer_type compressed_send_buffer;
 
-      static std::shared_ptr<std::vector<char>> create_send_buffer( const signed_block_ptr& sb ) {
+      static send_buffer_type create_send_buffer( const signed_block_ptr& sb ) {
          static_assert( signed_block_which == fc::get_index<net_message, signed_block>() );
          // this implementation is to avoid copy of signed_block to net_message
          // matches which of net_message for signed_block
@@ -1873,7 +1877,7 @@ namespace eosio {
 
    private:
 
-      static std::shared_ptr<std::vector<char>> create_send_buffer( const packed_transaction_ptr& trx ) {
+      static send_buffer_type create_send_buffer( const packed_transaction_ptr& trx ) {
          static_assert( packed_transaction_which == fc::get_index<net_message, packed_transaction>() );
          // this implementation is to avoid copy of packed_transaction to net_message
          // matches which of net_message for packed_transaction
@@ -1883,17 +1887,72 @@ namespace eosio {
 
    //------------------------------------------------------------------------
 
+   // called from connection strand
+   bool connection::enqueue_sync_block() {
+      if( !peer_requested ) {
+         return false;
+      } else {
+         peer_dlog( this, "enqueue sync block ${num}", ("num", peer_requested->last + 1) );
+      }
+      uint32_t num = peer_requested->last + 1;
+
+      const controller& cc = my_impl->chain_plug->chain();
+      send_buffer_type sb;
+      try {
+         sb = block_buffer_factory::create_send_buffer( cc, num ); // thread-safe
+         if( sb && compress_blocks )
+            sb = buffer_factory::create_compressed_send_buffer( sb );
+      } FC_LOG_AND_DROP();
+      if( sb ) {
+         // Skip transmitting block this loop if threshold exceeded
+         if (block_sync_send_start == 0ns) { // start of enqueue blocks
+            block_sync_send_start = get_time();
+            block_sync_frame_bytes_sent = 0;
+         }
+         if( block_sync_rate_limit > 0 && block_sync_frame_bytes_sent > 0 && peer_syncing_from_us ) {
+            auto now = get_time();
+            auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(now - block_sync_send_start);
+            double current_rate_sec = (double(block_sync_frame_bytes_sent) / elapsed_us.count()) * 100000; // convert from bytes/us => bytes/sec
+            peer_dlog(this, "start enqueue block time ${st}, now ${t}, elapsed ${e}, rate ${r}, limit ${l}",
+                      ("st", block_sync_send_start.count())("t", now.count())("e", elapsed_us.count())("r", current_rate_sec)("l", block_sync_rate_limit));
+            if( current_rate_sec >= block_sync_rate_limit ) {
+               block_sync_throttling = true;
+               peer_dlog( this, "throttling block sync to peer ${host}:${port}", ("host", log_remote_endpoint_ip)("port", log_remote_endpoint_port));
+               return false;
+            }
+         }
+         block_sync_throttling = false;
+         peer_dlog( this, "enqueue block ${num}", ("num", num) );
+         latest_blk_time = std::chrono::steady_clock::now();
+         enqueue_buffer( sb, true );
+         auto sent = sb->size();
+         block_sync_total_bytes_sent += sent;
+         block_sync_frame_bytes_sent += sent;
+         ++peer_requested->last;
+         if(num == peer_requested->end_block) {
+            peer_requested.reset();
+            block_sync_send_start = 0ns;
+            block_sync_frame_bytes_sent = 0;
+            peer_dlog( this, "completing enqueue_sync_block ${num}", ("num", num) );
+         }
+      } else {
+         peer_ilog( this, "enqueue sync, unable to fetch block ${num}, sending benign_other go away", ("num", num) );
+         peer_requested.reset(); // unable to provide requested blocks
+         block_sync_send_start = 0ns;
+         block_sync_frame_bytes_sent = 0;
+         no_retry = benign_other;
+         enqueue( go_away_message( benign_other ) );
+      }
+      return true;
+   }
+
    // called from connection strand
    void connection::enqueue( const net_message& m ) {
       verify_strand_in_this_thread( strand, __func__, __LINE__ );
-      go_away_reason close_after_send = no_reason;
-      if (std::holds_alternative<go_away_message>(m)) {
-         close_after_send = std::get<go_away_message>(m).reason;
-      }
 
       buffer_factory buff_factory;
       const auto& send_buffer = buff_factory.get_send_buffer( m );
-      enqueue_buffer( send_buffer, close_after_send );
+      enqueue_buffer( send_buffer );
    }
 
    // called from connection strand
@@ -1902,29 +1961,34 @@ namespace eosio {
       verify_strand_in_this_thread( strand, __func__, __LINE__ );
 
       block_buffer_factory buff_factory;
-      const auto& sb = buff_factory.get_send_buffer( b );
+      const auto& sb = buff_factory.get_send_buffer( b, compress_blocks );
       latest_blk_time = std::chrono::steady_clock::now();
-      enqueue_buffer( sb, no_reason, to_sync_queue);
+      enqueue_buffer( sb, to_sync_queue );
       return sb->size();
    }
 
    // called from connection strand
-   void connection::enqueue_buffer( const std::shared_ptr<std::vector<char>>& send_buffer,
-                                    go_away_reason close_after_send,
-                                    bool to_sync_queue)
+   void connection::enqueue_buffer( const send_buffer_type& send_buffer, bool to_sync_queue )
    {
-      connection_ptr self = shared_from_this();
-      queue_write(send_buffer,
-            [conn{std::move(self)}, close_after_send](boost::system::error_code ec, std::size_t ) {
-                        if (ec) return;
-                        if (close_after_send != no_reason) {
-                           fc_ilog( logger, "sent a go away message: ${r}, closing connection ${cid}",
-                                    ("r", reason_str(close_after_send))("cid", conn->connection_id) );
-                           conn->close();
-                           return;
-                        }
-                  },
-                  to_sync_queue);
+      queue_write(send_buffer, to_sync_queue);
+   }
+
+   // thread safe, queues the buffer without going through the strand, which is only posted to when no write is pending
+   void connection::enqueue_buffer_any_thread( const send_buffer_type& send_buffer ) {
+      if( !buffer_queue.add_write_queue( send_buffer, false ) ) {
+         strand.post( [c = shared_from_this()]() {
+            peer_wlog( c, "write_queue full ${s} bytes, giving up on connection", ("s", c->buffer_queue.write_queue_size()) );
+            c->close();
+         } );
+         return;
+      }
+      // the flag is cleared before the queue is drained, so a buffer added after the drain started posts again
+      if( !write_posted.exchange( true ) ) {
+         strand.post( [c = shared_from_this()]() {
+            c->write_posted = false;
+            c->do_queue_write();
+         } );
+      }
    }
 
    // thread safe
@@ -1981,13 +2045,15 @@ namespace eosio {
    }
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t min_blocks_distance )
+    sync_manager::sync_manager( uint32_t span, uint32_t sync_peer_limit, uint32_t fetch_parallel, uint32_t min_blocks_distance )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
       ,sync_source()
       ,sync_fetch_span( span )
       ,sync_peer_limit( sync_peer_limit )
+      ,sync_fetch_parallel( std::max<uint32_t>( fetch_parallel, 1 ) )
+      ,sync_reorder( size_t(span) * std::max<uint32_t>( fetch_parallel, 1 ) )
       ,sync_state(in_sync)
       ,min_blocks_distance(min_blocks_distance)
    {
@@ -2016,6 +2082,7 @@ namespace eosio {
       fc::unique_lock g( sync_mtx );
       if( sync_state == in_sync ) {
          sync_source.reset();
+         reset_parallel_sync();
       }
       if( !c ) return;
       if( !closing ) {
@@ -2034,8 +2101,15 @@ namespace eosio {
          } );
          sync_known_lib_num = highest_lib_num;
 
-         // if closing the connection we are currently syncing from then request from a diff peer
-         if( c == sync_source ) {
+         // if closing a connection we are currently syncing from then request its range from a diff peer
+         if( parallel_sync() ) {
+            if( sync_ranges.has_peer( c ) ) {
+               sync_ranges.reassign( c, sync_next_expected_num );
+               if( c == sync_source )
+                  sync_source.reset();
+               request_next_chunk();
+            }
+         } else if( c == sync_source ) {
             // if starting to sync need to always start from lib as we might be on our own fork
             uint32_t lib_num = my_impl->get_chain_lib_num();
             sync_last_requested_num = 0;
@@ -2050,10 +2124,11 @@ namespace eosio {
       fc_dlog(logger, "Number connections ${s}, sync_next_expected_num: ${e}, sync_known_lib_num: ${l}",
               ("s", my_impl->connections.number_connections())("e", sync_next_expected_num)("l", sync_known_lib_num));
       deque<connection_ptr> conns;
+      const auto& ranges = sync_ranges; // peers with an outstanding parallel sync request are not available
       my_impl->connections.for_each_block_connection([sync_next_expected_num = sync_next_expected_num,
                                                       sync_known_lib_num = sync_known_lib_num,
-                                                      &conns](const auto& c) {
-         if (c->should_sync_from(sync_next_expected_num, sync_known_lib_num)) {
+                                                      &ranges, &conns](const auto& c) {
+         if (c->should_sync_from(sync_next_expected_num, sync_known_lib_num) && !ranges.has_peer(c)) {
             conns.push_back(c);
          }
       });
@@ -2109,15 +2184,9 @@ namespace eosio {
                    ("cc", sync_last_requested_num)("t", sync_known_lib_num)("n", sync_next_expected_num)("h", chain_info.fork_head_num));
       }
 
-      /* ----------
-       * next chunk provider selection criteria
-       * a provider is supplied and able to be used, use it.
-       * otherwise select the next available from the list, round-robin style.
-       */
-      connection_ptr new_sync_source = (conn && conn->current()) ? conn : find_next_sync_node();
-
       auto reset_on_failure = [&]() REQUIRES(sync_mtx) {
          sync_source.reset();
+         reset_parallel_sync();
          sync_known_lib_num = chain_info.lib_num;
          sync_last_requested_num = 0;
          sync_next_expected_num = std::max( sync_known_lib_num + 1, sync_next_expected_num );
@@ -2126,6 +2195,21 @@ namespace eosio {
          send_handshakes();
       };
 
+      if( parallel_sync() ) {
+         if( !request_next_chunks( conn ) ) {
+            fc_wlog( logger, "Unable to continue syncing at this time");
+            reset_on_failure();
+         }
+         return;
+      }
+
+      /* ----------
+       * next chunk provider selection criteria
+       * a provider is supplied and able to be used, use it.
+       * otherwise select the next available from the list, round-robin style.
+       */
+      connection_ptr new_sync_source = (conn && conn->current()) ? conn : find_next_sync_node();
+
       // verify there is an available source
       if( !new_sync_source ) {
          fc_wlog( logger, "Unable to continue syncing at this time");
@@ -2156,6 +2240,57 @@ namespace eosio {
       }
    }
 
+   // call with g_sync locked, called from conn's connection strand
+   // Requests disjoint ranges from up to sync_fetch_parallel peers at a time, re-requesting ranges taken back from stalled
+   // or closed peers first. Returns false if no range is outstanding and no peer is available to request one from.
+   bool sync_manager::request_next_chunks( const connection_ptr& conn ) REQUIRES(sync_mtx) {
+      // blocks received ahead of the next block to apply are held in sync_reorder, bound how far ahead of head they are requested
+      const uint32_t max_ahead = my_impl->get_chain_head_num() + sync_fetch_span * sync_fetch_parallel;
+      connection_ptr preferred = (conn && conn->current() && !sync_ranges.has_peer( conn )) ? conn : connection_ptr();
+
+      while( sync_ranges.size() < sync_fetch_parallel ) {
+         uint32_t start = 0, end = 0;
+         auto retry = sync_ranges.pop_unassigned( sync_next_expected_num );
+         if( sync_reorder.full() && !(retry && retry->first == sync_next_expected_num) ) {
+            // back off until the held blocks are applied, only the range they are waiting for is requested meanwhile
+            if( retry )
+               sync_ranges.requeue( retry->first, retry->second );
+            break;
+         }
+         if( retry ) {
+            std::tie( start, end ) = *retry;
+         } else {
+            start = std::max( sync_next_expected_num, sync_last_requested_num + 1 );
+            end = std::min( start + sync_fetch_span - 1, sync_known_lib_num );
+            if( start > end || start >= max_ahead )
+               break;
+         }
+
+         connection_ptr source = preferred ? std::move( preferred ) : find_next_sync_node();
+         if( !source ) {
+            if( retry )
+               sync_ranges.requeue( start, end );
+            return sync_ranges.size() > 0;
+         }
+
+         sync_ranges.assign( start, end, source );
+         sync_last_requested_num = std::max( sync_last_requested_num, end );
+         sync_source = source;
+         sync_active_time = std::chrono::steady_clock::now();
+         source->strand.post( [source, start, end, outstanding=sync_ranges.size()]() {
+            peer_ilog( source, "requesting range ${s} to ${e}, ${o} ranges outstanding", ("s", start)("e", end)("o", outstanding) );
+            source->request_sync_blocks( start, end );
+         } );
+      }
+      return true;
+   }
+
+   // call with g_sync locked
+   void sync_manager::reset_parallel_sync() REQUIRES(sync_mtx) {
+      sync_ranges.clear();
+      sync_reorder.clear();
+   }
+
    // static, thread safe
    void sync_manager::send_handshakes() {
       my_impl->connections.for_each_connection( []( const connection_ptr& ci ) {
@@ -2175,6 +2310,11 @@ namespace eosio {
    }
 
    bool sync_manager::is_sync_request_ahead_allowed(block_num_type blk_num) const REQUIRES(sync_mtx) {
+      if (parallel_sync()) {
+         // a peer is free and the blocks requested so far are within the reorder window ahead of chain head
+         uint32_t head = my_impl->get_chain_head_num();
+         return sync_ranges.size() < sync_fetch_parallel && sync_last_requested_num < head + sync_fetch_span * sync_fetch_parallel;
+      }
       if (blk_num >= sync_last_requested_num) {
          // do not allow to get too far ahead (sync_fetch_span) of chain head
          // use chain head instead of fork head so we do not get too far ahead of applied blocks
@@ -2202,6 +2342,7 @@ namespace eosio {
 
       if( sync_state != lib_catchup || !sync_recently_active()) {
          set_state( lib_catchup );
+         reset_parallel_sync();
          sync_last_requested_num = 0;
          sync_next_expected_num = chain_info.lib_num + 1;
          request_next_chunk( c );
@@ -2246,7 +2387,17 @@ namespace eosio {
    // called from connection strand
    void sync_manager::sync_reassign_fetch(const connection_ptr& c) {
       fc::unique_lock g( sync_mtx );
-      if( c == sync_source ) {
+      if( parallel_sync() ) {
+         if( sync_ranges.has_peer( c ) ) {
+            peer_ilog(c, "reassign_fetch, our last req is ${cc}, next expected is ${ne}",
+                      ("cc", sync_last_requested_num)("ne", sync_next_expected_num));
+            c->cancel_sync();
+            sync_ranges.reassign( c, sync_next_expected_num );
+            if( c == sync_source )
+               sync_source.reset();
+            request_next_chunk();
+         }
+      } else if( c == sync_source ) {
          peer_ilog(c, "reassign_fetch, our last req is ${cc}, next expected is ${ne}",
                    ("cc", sync_last_requested_num)("ne", sync_next_expected_num));
          c->cancel_sync();
@@ -2456,6 +2607,7 @@ namespace eosio {
       fc::unique_lock g( sync_mtx );
       sync_last_requested_num = 0;
       sync_next_expected_num = my_impl->get_chain_lib_num() + 1;
+      reset_parallel_sync();
       g.unlock();
       if( mode == closing_mode::immediately || c->block_status_monitor_.max_events_violated()) {
          peer_wlog(c, "block ${bn} not accepted, closing connection ${d}",
@@ -2529,6 +2681,7 @@ namespace eosio {
          if( blk_applied && blk_num >= sync_known_lib_num ) {
             peer_dlog(c, "All caught up ${b} with last known lib ${l} resending handshake",
                       ("b", blk_num)("l", sync_known_lib_num));
+            reset_parallel_sync();
             set_state( head_catchup );
             g_sync.unlock();
             send_handshakes();
@@ -2537,7 +2690,13 @@ namespace eosio {
                if (blk_num >= c->sync_last_requested_block) {
                   peer_dlog(c, "calling cancel_sync_wait, block ${b}, sync_last_requested_block ${lrb}",
                             ("b", blk_num)("lrb", c->sync_last_requested_block));
-                  sync_source.reset();
+                  if (parallel_sync()) {
+                     sync_ranges.remove(c);
+                     if (c == sync_source)
+                        sync_source.reset();
+                  } else {
+                     sync_source.reset();
+                  }
                   c->cancel_sync_wait();
                } else {
                   peer_dlog(c, "calling sync_wait, block ${b}", ("b", blk_num));
@@ -2547,7 +2706,7 @@ namespace eosio {
                if (sync_last_requested_num == 0) { // block was rejected
                   sync_next_expected_num = my_impl->get_chain_lib_num() + 1;
                   peer_dlog(c, "Reset sync_next_expected_num to ${n}", ("n", sync_next_expected_num));
-               } else {
+               } else if (!parallel_sync()) { // sync_dispatch_block advances sync_next_expected_num during parallel sync
                   if (blk_num == sync_next_expected_num) {
                      ++sync_next_expected_num;
                   }
@@ -2568,7 +2727,7 @@ namespace eosio {
                   }
                }
             } else { // blk_applied
-               if (blk_num >= sync_last_requested_num) {
+               if (parallel_sync() ? is_sync_request_ahead_allowed(blk_num) : blk_num >= sync_last_requested_num) {
                   // Did not request blocks ahead, likely because too far ahead of head
                   // Do not restrict sync_fetch_span as we want max-reversible-blocks to shut down the node for applied blocks
                   fc_dlog(logger, "Requesting blocks, head: ${h} fhead ${fh} blk_num: ${bn} sync_next_expected_num ${nen} "
@@ -2587,6 +2746,47 @@ namespace eosio {
       }
    }
 
+   // called from c's connection strand during parallel sync
+   // Hands blocks to the chain in block number order, holding blocks received ahead of sync_next_expected_num until the
+   // blocks before them arrive from whichever peers they were requested from.
+   void sync_manager::sync_dispatch_block( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, signed_block_ptr b ) {
+      fc::lock_guard g( sync_mtx );
+      if( blk_num > sync_next_expected_num ) {
+         if( sync_reorder.full() ) {
+            // never handed over ahead of the blocks before it. The rest of the peer's range is requested again, as one
+            // range, once the held blocks are applied; later blocks of the range from the peer are dropped as well
+            peer_dlog( c, "dropping block ${n}, waiting for ${e}, ${s} blocks held", ("n", blk_num)("e", sync_next_expected_num)("s", sync_reorder.size()) );
+            sync_ranges.take_back( c, blk_num );
+            return;
+         }
+         peer_dlog( c, "holding block ${n}, waiting for ${e}, ${s} blocks held", ("n", blk_num)("e", sync_next_expected_num)("s", sync_reorder.size()) );
+         sync_reorder.add( blk_num, pending_sync_block{c, blk_id, std::move(b)} ); // a duplicate of a held block is dropped
+         return;
+      }
+      // handle_message only posts to the dispatcher strand, so blocks reach it in the order they are handed over here
+      c->handle_message( blk_id, std::move(b) );
+      if( blk_num == sync_next_expected_num )
+         dispatch_held_blocks( blk_num + 1 );
+   }
+
+   // called from c's connection strand during parallel sync
+   // A block not handed to sync_dispatch_block, because it was already received or is irreversible, is no longer waited
+   // for by the blocks held after it, nor is any block at or before lib.
+   void sync_manager::sync_skip_block( uint32_t blk_num, uint32_t lib_num ) {
+      fc::lock_guard g( sync_mtx );
+      const uint32_t next_num = std::max( blk_num == sync_next_expected_num ? blk_num + 1 : 0u, lib_num + 1 );
+      if( next_num > sync_next_expected_num )
+         dispatch_held_blocks( next_num );
+   }
+
+   // call with g_sync locked
+   // Hands over the held blocks from next_num on for as long as they are consecutive, dropping any before next_num
+   void sync_manager::dispatch_held_blocks( uint32_t next_num ) REQUIRES(sync_mtx) {
+      sync_next_expected_num = sync_reorder.pop_in_order( next_num, []( uint32_t, pending_sync_block&& pb ) {
+         pb.conn->handle_message( pb.id, std::move(pb.block) );
+      } );
+   }
+
    // thread safe, called when block received
    void sync_manager::send_handshakes_if_synced(const fc::microseconds& blk_latency) {
       sync_active_time = std::chrono::steady_clock::now(); // reset when we receive a block
@@ -2635,42 +2835,37 @@ namespace eosio {
       index.erase(p.first, p.second);
    }
 
-   bool dispatch_manager::add_peer_txn( const transaction_id_type& id, const time_point_sec& trx_expires,
-                                        uint32_t connection_id, const time_point_sec& now ) {
+   // thread safe, false if the trx was already known
+   bool dispatch_manager::add_txn( const transaction_id_type& id, const time_point_sec& trx_expires, const time_point_sec& now ) {
       fc::lock_guard g( local_txns_mtx );
-      auto tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( id ), connection_id ) );
-      bool added = (tptr == local_txns.end());
-      if( added ) {
-         // expire at either transaction expiration or configured max expire time whichever is less
-         time_point_sec expires{now.to_time_point() + my_impl->p2p_dedup_cache_expire_time_us};
-         expires = std::min( trx_expires, expires );
-         local_txns.insert( node_transaction_state{
-            .id = id,
-            .expires = expires,
-            .connection_id = connection_id} );
-      }
-      return added;
+      // expire at either transaction expiration or configured max expire time whichever is less
+      time_point_sec expires{now.to_time_point() + my_impl->p2p_dedup_cache_expire_time_us};
+      expires = std::min( trx_expires, expires );
+      return local_txns.insert( node_transaction_state{ .id = id, .expires = expires } ).second;
    }
 
-   bool dispatch_manager::have_txn( const transaction_id_type& tid ) const {
-      fc::lock_guard g( local_txns_mtx );
-      const auto tptr = local_txns.get<by_id>().find( tid );
-      return tptr != local_txns.end();
+   // thread safe, false if the peer already has the trx
+   bool dispatch_manager::add_peer_txn( const connection_ptr& c, const transaction_id_type& id, const fc::time_point& now ) {
+      return c->peer_txns.add( id, now );
    }
 
    void dispatch_manager::expire_txns() {
       size_t start_size = 0, end_size = 0;
-      fc::time_point_sec now{time_point::now()};
+      const fc::time_point now = time_point::now();
 
       fc::unique_lock g( local_txns_mtx );
       start_size = local_txns.size();
       auto& old = local_txns.get<by_expiry>();
       auto ex_lo = old.lower_bound( fc::time_point_sec( 0 ) );
-      auto ex_up = old.upper_bound( now );
+      auto ex_up = old.upper_bound( fc::time_point_sec( now ) );
       old.erase( ex_lo, ex_up );
+      end_size = local_txns.size();
       g.unlock();
 
-      fc_dlog( logger, "expire_local_txns size ${s} removed ${r}", ("s", start_size)( "r", start_size - end_size ) );
+      my_impl->connections.for_each_connection( [&now]( const connection_ptr& c ) {
+         c->peer_txns.maybe_rotate( now );
+      } );
+      fc_dlog( logger, "expire_local_txns size ${s} removed ${r}", ("s", end_size)( "r", start_size - end_size ) );
    }
 
    void dispatch_manager::expire_blocks( uint32_t lib_num ) {
@@ -2699,14 +2894,14 @@ namespace eosio {
             return;
          }
 
-         send_buffer_type sb = buff_factory.get_send_buffer( b );
+         send_buffer_type sb = buff_factory.get_send_buffer( b, cp->compress_blocks );
 
          cp->strand.post( [cp, bnum, sb{std::move(sb)}]() {
             cp->latest_blk_time = std::chrono::steady_clock::now();
             bool has_block = cp->peer_lib_num >= bnum;
             if( !has_block ) {
                peer_dlog( cp, "bcast block ${b}", ("b", bnum) );
-               cp->enqueue_buffer( sb, no_reason );
+               cp->enqueue_buffer( sb );
             }
          });
       } );
@@ -2719,13 +2914,10 @@ namespace eosio {
       my_impl->connections.for_each_block_connection( [exclude_peer, msg{std::move(msg)}]( auto& cp ) {
          if( !cp->current() ) return true;
          if( cp->connection_id == exclude_peer ) return true;
-         cp->strand.post( [cp, msg]() {
-            if (cp->protocol_version >= proto_savanna) {
-               if (vote_logger.is_enabled(fc::log_level::debug))
-                  peer_dlog(cp, "sending vote msg");
-               cp->enqueue_buffer( msg, no_reason );
-            }
-         });
+         if (cp->protocol_version >= proto_savanna) {
+            fc_dlog(vote_logger, "sending vote msg to connection - ${cid}", ("cid", cp->connection_id));
+            cp->enqueue_buffer_any_thread( msg );
+         }
          return true;
       } );
    }
@@ -2741,20 +2933,19 @@ namespace eosio {
    // called from any thread
    void dispatch_manager::bcast_transaction(const packed_transaction_ptr& trx) {
       trx_buffer_factory buff_factory;
-      const fc::time_point_sec now{fc::time_point::now()};
+      const fc::time_point now = fc::time_point::now();
+      add_txn( trx->id(), trx->expiration(), time_point_sec( now ) );
       my_impl->connections.for_each_connection( [this, &trx, &now, &buff_factory]( const connection_ptr& cp ) {
          if( !cp->is_transactions_connection() || !cp->current() ) {
             return;
          }
-         if( !add_peer_txn(trx->id(), trx->expiration(), cp->connection_id, now) ) {
+         if( !add_peer_txn( cp, trx->id(), now ) ) {
             return;
          }
 
          send_buffer_type sb = buff_factory.get_send_buffer( trx );
          fc_dlog( logger, "sending trx: ${id}, to connection - ${cid}", ("id", trx->id())("cid", cp->connection_id) );
-         cp->strand.post( [cp, sb{std::move(sb)}]() {
-            cp->enqueue_buffer( sb, no_reason );
-         } );
+         cp->enqueue_buffer_any_thread( sb );
       } );
    }
 
@@ -2767,6 +2958,10 @@ namespace eosio {
    // called from c's connection strand
    void dispatch_manager::recv_notice(const connection_ptr& c, const notice_message& msg, bool generated) {
       if (msg.known_trx.mode == normal) {
+         // peer already has these, do not send them to it
+         const fc::time_point now = fc::time_point::now();
+         for( const auto& id : msg.known_trx.ids )
+            add_peer_txn( c, id, now );
       } else if (msg.known_trx.mode != none) {
          peer_wlog( c, "passed a notice_message with something other than a normal on none known_trx" );
          return;
@@ -3041,39 +3236,92 @@ namespace eosio {
       bytes_received += message_length;
       last_bytes_received = get_time();
       try {
-         auto now = latest_msg_time = std::chrono::steady_clock::now();
+         latest_msg_time = std::chrono::steady_clock::now();
 
-         // if next message is a block we already have, exit early
          auto peek_ds = pending_message_buffer.create_peek_datastream();
          unsigned_int which{};
          fc::raw::unpack( peek_ds, which );
 
-         if( which == signed_block_which ) {
-            latest_blk_time = now;
-            return process_next_block_message( message_length );
-         } else if( which == packed_transaction_which ) {
-            return process_next_trx_message( message_length );
-         } else if( which == vote_message_which ) {
-            return process_next_vote_message( message_length );
-         } else {
-            auto ds = pending_message_buffer.create_datastream();
-            net_message msg;
-            fc::raw::unpack( ds, msg );
-            msg_handler m( shared_from_this() );
-            std::visit( m, msg );
+         if( which == compressed_message_which ) {
+            return process_next_compressed_message( message_length );
          }
+         return process_message( pending_message_buffer, message_length );
 
       } catch( const fc::exception& e ) {
          peer_wlog( this, "Exception in handling message: ${s}", ("s", e.to_detail_string()) );
          close();
          return false;
       }
+   }
+
+   /// a decompressed compressed_message, provides the part of the fc::message_buffer interface used to process a message
+   class decompressed_message_buffer {
+   public:
+      explicit decompressed_message_buffer( std::vector<char>&& data ) : data( std::move(data) ) {}
+
+      uint32_t size() const { return data.size(); }
+      fc::datastream<const char*> create_peek_datastream() const { return { data.data() + read_pos, data.size() - read_pos }; }
+      // only ever used to read the rest of the message
+      fc::datastream<const char*> create_datastream() const { return create_peek_datastream(); }
+      void advance_read_ptr( size_t bytes ) { read_pos += bytes; }
+
+   private:
+      std::vector<char> data;
+      size_t            read_pos = 0;
+   };
+
+   // called from connection strand
+   bool connection::process_next_compressed_message( uint32_t message_length ) {
+      // a peer may only send compressed messages once both sides offered compression in the handshake
+      if( !compress_blocks ) {
+         peer_wlog( this, "received compressed_message without negotiating compression" );
+         no_retry = go_away_reason::fatal_other;
+         enqueue( go_away_message( fatal_other ) );
+         return false;
+      }
+
+      auto ds = pending_message_buffer.create_datastream();
+      unsigned_int which{};
+      fc::raw::unpack( ds, which );
+      compressed_message cm;
+      fc::raw::unpack( ds, cm );
+
+      decompressed_message_buffer buffer( net_utils::zlib_decompress( cm.data, def_send_buffer_size*2 ) );
+      auto peek_ds = buffer.create_peek_datastream();
+      fc::raw::unpack( peek_ds, which );
+      EOS_ASSERT( which != compressed_message_which, plugin_exception, "nested compressed_message" );
+      return process_message( buffer, buffer.size() );
+   }
+
+   // called from connection strand
+   template<typename MessageBuffer>
+   bool connection::process_message( MessageBuffer& buffer, uint32_t message_length ) {
+      // if next message is a block we already have, exit early
+      auto peek_ds = buffer.create_peek_datastream();
+      unsigned_int which{};
+      fc::raw::unpack( peek_ds, which );
+
+      if( which == signed_block_which ) {
+         latest_blk_time = latest_msg_time;
+         return process_next_block_message( buffer, message_length );
+      } else if( which == packed_transaction_which ) {
+         return process_next_trx_message( buffer, message_length );
+      } else if( which == vote_message_which ) {
+         return process_next_vote_message( buffer, message_length );
+      } else {
+         auto ds = buffer.create_datastream();
+         net_message msg;
+         fc::raw::unpack( ds, msg );
+         msg_handler m( shared_from_this() );
+         std::visit( m, msg );
+      }
       return true;
    }
 
    // called from connection strand
-   bool connection::process_next_block_message(uint32_t message_length) {
-      auto peek_ds = pending_message_buffer.create_peek_datastream();
+   template<typename MessageBuffer>
+   bool connection::process_next_block_message(MessageBuffer& buffer, uint32_t message_length) {
+      auto peek_ds = buffer.create_peek_datastream();
       unsigned_int which{};
       fc::raw::unpack( peek_ds, which ); // throw away
       block_header bh;
@@ -3085,9 +3333,11 @@ namespace eosio {
       if( my_impl->dispatcher.have_block( blk_id ) ) {
          peer_dlog( this, "already received block ${num}, id ${id}..., latency ${l}ms",
                     ("num", blk_num)("id", blk_id.str().substr(8,16))("l", age.count()/1000) );
+         if( my_impl->sync_master->parallel_sync() && my_impl->sync_master->syncing_from_peer() )
+            my_impl->sync_master->sync_skip_block( blk_num, my_impl->get_chain_lib_num() );
          my_impl->sync_master->sync_recv_block( shared_from_this(), blk_id, blk_num, false, age );
 
-         pending_message_buffer.advance_read_ptr( message_length );
+         buffer.advance_read_ptr( message_length );
          return true;
       }
       peer_dlog( this, "received block ${num}, id ${id}..., latency: ${l}ms, head ${h}, fhead ${f}",
@@ -3106,21 +3356,23 @@ namespace eosio {
             send_handshake();
             cancel_sync_wait();
 
-            pending_message_buffer.advance_read_ptr( message_length );
+            buffer.advance_read_ptr( message_length );
             return true;
          }
       } else {
          block_sync_bytes_received += message_length;
          uint32_t lib_num = my_impl->get_chain_lib_num();
+         if( blk_num <= lib_num && my_impl->sync_master->parallel_sync() )
+            my_impl->sync_master->sync_skip_block( blk_num, lib_num );
          my_impl->sync_master->sync_recv_block(shared_from_this(), blk_id, blk_num, false, age);
          if( blk_num <= lib_num ) {
             peer_dlog( this, "received block ${n} less than lib ${lib} while syncing", ("n", blk_num)("lib", lib_num) );
-            pending_message_buffer.advance_read_ptr( message_length );
+            buffer.advance_read_ptr( message_length );
             return true;
          }
       }
 
-      auto ds = pending_message_buffer.create_datastream();
+      auto ds = buffer.create_datastream();
       fc::raw::unpack( ds, which );
       shared_ptr<signed_block> ptr = std::make_shared<signed_block>();
       fc::raw::unpack( ds, *ptr );
@@ -3143,26 +3395,35 @@ namespace eosio {
          return false;
       }
 
-      handle_message( blk_id, std::move( ptr ) );
+      if( my_impl->sync_master->syncing_from_peer() ) {
+         // get ahead of the serial header validation on the dispatcher strand
+         my_impl->prevalidate_block( blk_id, ptr );
+      }
+      if( my_impl->sync_master->parallel_sync() && my_impl->sync_master->syncing_from_peer() ) {
+         my_impl->sync_master->sync_dispatch_block( shared_from_this(), blk_id, blk_num, std::move( ptr ) );
+      } else {
+         handle_message( blk_id, std::move( ptr ) );
+      }
       return true;
    }
 
    // called from connection strand
-   bool connection::process_next_trx_message(uint32_t message_length) {
+   template<typename MessageBuffer>
+   bool connection::process_next_trx_message(MessageBuffer& buffer, uint32_t message_length) {
       if( !my_impl->p2p_accept_transactions ) {
          peer_dlog( this, "p2p-accept-transaction=false - dropping trx" );
-         pending_message_buffer.advance_read_ptr( message_length );
+         buffer.advance_read_ptr( message_length );
          return true;
       }
       if (my_impl->sync_master->syncing_from_peer()) {
          peer_dlog(this, "syncing, dropping trx");
-         pending_message_buffer.advance_read_ptr( message_length );
+         buffer.advance_read_ptr( message_length );
          return true;
       }
 
       const unsigned long trx_in_progress_sz = this->trx_in_progress_size.load();
 
-      auto ds = pending_message_buffer.create_datastream();
+      auto ds = buffer.create_datastream();
       unsigned_int which{};
       fc::raw::unpack( ds, which );
       // shared_ptr<packed_transaction> needed here because packed_transaction_ptr is shared_ptr<const packed_transaction>
@@ -3181,8 +3442,9 @@ namespace eosio {
          }
          return true;
       }
-      bool have_trx = my_impl->dispatcher.have_txn( ptr->id() );
-      my_impl->dispatcher.add_peer_txn( ptr->id(), ptr->expiration(), connection_id );
+      const fc::time_point now = fc::time_point::now();
+      my_impl->dispatcher.add_peer_txn( shared_from_this(), ptr->id(), now );
+      bool have_trx = !my_impl->dispatcher.add_txn( ptr->id(), ptr->expiration(), time_point_sec( now ) );
 
       if( have_trx ) {
          peer_dlog( this, "got a duplicate transaction - dropping" );
@@ -3194,14 +3456,15 @@ namespace eosio {
    }
 
    // called from connection strand
-   bool connection::process_next_vote_message(uint32_t message_length) {
+   template<typename MessageBuffer>
+   bool connection::process_next_vote_message(MessageBuffer& buffer, uint32_t message_length) {
       if( !my_impl->p2p_accept_votes ) {
          peer_dlog( this, "p2p_accept_votes=false - dropping vote" );
-         pending_message_buffer.advance_read_ptr( message_length );
+         buffer.advance_read_ptr( message_length );
          return true;
       }
 
-      auto ds = pending_message_buffer.create_datastream();
+      auto ds = buffer.create_datastream();
       unsigned_int which{};
       fc::raw::unpack( ds, which );
       assert(which == vote_message_which);
@@ -3431,6 +3694,13 @@ namespace eosio {
          conn_node_id = msg.node_id;
          short_conn_node_id = conn_node_id.str().substr( 0, 7 );
 
+         if( protocol_version >= proto_compression && net_utils::peer_address_requests_compression( msg.p2p_address ) ) {
+            compress_blocks = compression_requested || (incoming() && my_impl->p2p_accept_compression);
+            peer_ilog( this, "Peer offered compression, ${s}", ("s", compress_blocks ? "compressing blocks" : "not accepted") );
+         } else {
+            compress_blocks = false;
+         }
+
          if( !my_impl->authenticate_peer( msg ) ) {
             peer_wlog( this, "Peer not authenticated.  Closing connection." );
             no_retry = go_away_reason::authentication;
@@ -3915,6 +4185,24 @@ namespace eosio {
       }
    }
 
+   // thread safe
+   // Sync blocks are header validated one at a time on the dispatcher strand. The parts of that validation which do not
+   // depend on the previous block are done here in parallel on the net thread pool, for up to sync_prevalidate_window
+   // blocks ahead of the dispatcher strand. The keys of the transactions of the block are recovered on the chain thread
+   // pool so that applying the block does not wait on them.
+   void net_plugin_impl::prevalidate_block( const block_id_type& id, const signed_block_ptr& block ) {
+      if( producer_plug )
+         producer_plug->recover_block_trx_keys( block );
+      if( blocks_prevalidating.fetch_add( 1 ) >= sync_prevalidate_window ) {
+         --blocks_prevalidating; // the dispatcher strand validates it in full
+         return;
+      }
+      boost::asio::post( thread_pool.get_executor(), [this, id, block]() {
+         chain_plug->chain().prevalidate_block( id, block );
+         --blocks_prevalidating;
+      } );
+   }
+
    // thread safe
    void net_plugin_impl::start_expire_timer() {
       if( in_shutdown ) return;
@@ -4160,6 +4448,11 @@ namespace eosio {
       if( !is_blocks_only_connection() && !my_impl->p2p_accept_transactions ) {
          peer_dlog( this, "p2p-accept-transactions=false inform peer blocks only connection ${a}", ("a", hello.p2p_address) );
       }
+      // outgoing connections offer compression when configured to, incoming connections accept the offer in their reply
+      if( compression_requested || compress_blocks ) {
+         hello.p2p_address += ":";
+         hello.p2p_address += net_utils::compression_option;
+      }
       hello.p2p_address += " - " + hello.node_id.str().substr(0,7);
 #if defined( __APPLE__ )
       hello.os = "osx";
@@ -4199,14 +4492,18 @@ namespace eosio {
          ( "p2p-server-address", bpo::value< vector<string> >(), "An externally accessible host:port for identifying this node. Defaults to p2p-listen-endpoint. May be used as many times as p2p-listen-endpoint. If provided, the first address will be used in handshakes with other nodes. Otherwise the default is used.")
          ( "p2p-peer-address", bpo::value< vector<string> >()->composing(),
            "The public endpoint of a peer node to connect to. Use multiple p2p-peer-address options as needed to compose a network.\n"
-           "  Syntax: host:port[:<trx>|<blk>]\n"
+           "  Syntax: host:port[:<trx>|<blk>][:zlib]\n"
            "  The optional 'trx' and 'blk' indicates to node that only transactions 'trx' or blocks 'blk' should be sent."
+           "  The optional 'zlib' requests that blocks are sent zlib compressed in both directions, which is used if the peer"
+           "  supports it and accepts compression. Useful for WAN peers where bandwidth matters more than cpu."
            "  Examples:\n"
            "    p2p.eos.io:9876\n"
            "    p2p.trx.eos.io:9876:trx\n"
-           "    p2p.blk.eos.io:9876:blk\n")
+           "    p2p.blk.eos.io:9876:blk\n"
+           "    p2p.wan.eos.io:9876:blk:zlib\n")
          ( "p2p-max-nodes-per-host", bpo::value<int>()->default_value(def_max_nodes_per_host), "Maximum number of client nodes from any single IP address")
          ( "p2p-accept-transactions", bpo::value<bool>()->default_value(true), "Allow transactions received over p2p network to be evaluated and relayed if valid.")
+         ( "p2p-accept-compression", bpo::value<bool>()->default_value(true), "Compress blocks sent to incoming connections whose p2p-peer-address requested 'zlib' compression.")
          ( "p2p-auto-bp-peer", bpo::value< vector<string> >()->composing(),
            "The account and public p2p endpoint of a block producer node to automatically connect to when the it is in producer schedule proximity\n."
            "   Syntax: account,host:port\n"
@@ -4223,12 +4520,22 @@ namespace eosio {
          ( "connection-cleanup-period", bpo::value<int>()->default_value(def_conn_retry_wait), "number of seconds to wait before cleaning up dead connections")
          ( "max-cleanup-time-msec", bpo::value<uint32_t>()->default_value(10), "max connection cleanup time per cleanup call in milliseconds")
          ( "p2p-dedup-cache-expire-time-sec", bpo::value<uint32_t>()->default_value(10), "Maximum time to track transaction for duplicate optimization")
+         ( "p2p-dedup-filter-capacity", bpo::value<uint32_t>()->default_value(def_dedup_filter_capacity),
+           "Number of transaction ids tracked per peer within p2p-dedup-cache-expire-time-sec before older ones are forgotten early. "
+           "Each tracked id takes 5 bytes per peer.")
          ( "net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
            "Number of worker threads in net_plugin thread pool" )
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span),
            "Number of blocks to retrieve in a chunk from any individual peer during synchronization")
          ( "sync-peer-limit", bpo::value<uint32_t>()->default_value(3),
            "Number of peers to sync from")
+         ( "sync-fetch-parallel", bpo::value<uint32_t>()->default_value(1),
+           "Number of peers to download disjoint sync-fetch-span ranges from concurrently during synchronization. "
+           "Blocks are applied in order as the ranges arrive, and a stalled range is requested again from another peer. "
+           "1 syncs from one peer at a time.")
+         ( "sync-prevalidate-window", bpo::value<uint32_t>()->default_value(def_sync_prevalidate_window),
+           "Number of received sync blocks whose transaction merkle root and signing keys are computed in parallel on the "
+           "net thread pool ahead of header validation. 0 disables.")
          ( "use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable experimental socket read watermark optimization")
          ( "peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" - ${_cid} ${_ip}:${_port}] " ),
            "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
@@ -4262,9 +4569,12 @@ namespace eosio {
 
          txn_exp_period = def_txn_expire_wait;
          p2p_dedup_cache_expire_time_us = fc::seconds( options.at( "p2p-dedup-cache-expire-time-sec" ).as<uint32_t>() );
+         p2p_dedup_filter_capacity = options.at( "p2p-dedup-filter-capacity" ).as<uint32_t>();
          resp_expected_period = def_resp_expected_wait;
          max_nodes_per_host = options.at( "p2p-max-nodes-per-host" ).as<int>();
          p2p_accept_transactions = options.at( "p2p-accept-transactions" ).as<bool>();
+         p2p_accept_compression = options.at( "p2p-accept-compression" ).as<bool>();
+         sync_prevalidate_window = options.at( "sync-prevalidate-window" ).as<uint32_t>();
 
          use_socket_read_watermark = options.at( "use-socket-read-watermark" ).as<bool>();
          keepalive_interval = std::chrono::milliseconds( options.at( "p2p-keepalive-interval-ms" ).as<int>() );
@@ -4279,6 +4589,7 @@ namespace eosio {
          sync_master = std::make_unique<sync_manager>(
              options.at( "sync-fetch-span" ).as<uint32_t>(),
              options.at( "sync-peer-limit" ).as<uint32_t>(),
+             options.at( "sync-fetch-parallel" ).as<uint32_t>(),
              min_blocks_distance);
 
          connections.init( std::chrono::milliseconds( options.at("p2p-keepalive-interval-ms").as<int>() * 2 ),
@@ -4911,7 +5222,10 @@ namespace eosio {
          });
       }
       g.unlock();
-      update_p2p_connection_metrics({num_peers+num_bp_peers, num_clients, std::move(per_connection)});
+      net_plugin::p2p_connections_metrics metrics{num_peers+num_bp_peers, num_clients, std::move(per_connection)};
+      const auto pool_stats = send_buffer_pool::default_pool().get_stats();
+      metrics.send_buffer_pool = { .hits = pool_stats.hits, .misses = pool_stats.misses, .unpooled = pool_stats.unpooled };
+      update_p2p_connection_metrics(std::move(metrics));
       start_conn_timer( connector_period, {}, timer_type::stats );
    }
 } // namespace eosio
@@ -0,0 +1,72 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/mpsc_queue.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_CASE(test_mpsc_queue_fifo) {
+   mpsc_queue<std::unique_ptr<int>> queue;
+   BOOST_CHECK(queue.empty());
+   BOOST_CHECK(!queue.pop());
+
+   for (int i = 0; i < 3; ++i)
+      queue.push(std::make_unique<int>(i));
+   BOOST_CHECK(!queue.empty());
+   for (int i = 0; i < 3; ++i) {
+      auto v = queue.pop();
+      BOOST_REQUIRE(v);
+      BOOST_CHECK_EQUAL(**v, i);
+   }
+   BOOST_CHECK(queue.empty());
+   BOOST_CHECK(!queue.pop());
+
+   // the last element is popped by moving the stub behind it, the queue keeps working after that
+   queue.push(std::make_unique<int>(3));
+   BOOST_CHECK_EQUAL(**queue.pop(), 3);
+   queue.push(std::make_unique<int>(4));
+   queue.push(std::make_unique<int>(5));
+   std::vector<int> consumed;
+   BOOST_CHECK_EQUAL(queue.consume_all([&](std::unique_ptr<int>&& v) { consumed.push_back(*v); }), 2u);
+   BOOST_CHECK((consumed == std::vector<int>{4, 5}));
+
+   // remaining elements are released by clear and by the destructor
+   queue.push(std::make_unique<int>(6));
+   queue.clear();
+   BOOST_CHECK(queue.empty());
+   queue.push(std::make_unique<int>(7));
+}
+
+BOOST_AUTO_TEST_CASE(test_mpsc_queue_producers) {
+   constexpr uint32_t num_producers = 4;
+   constexpr uint32_t per_producer  = 20000;
+   mpsc_queue<std::pair<uint32_t, uint32_t>> queue; // producer, sequence
+
+   std::vector<std::thread> producers;
+   for (uint32_t p = 0; p < num_producers; ++p) {
+      producers.emplace_back([&queue, p]() {
+         for (uint32_t i = 0; i < per_producer; ++i)
+            queue.push({p, i});
+      });
+   }
+
+   // every element is consumed once, and in the order each producer pushed them
+   std::vector<uint32_t> next(num_producers, 0);
+   uint32_t consumed = 0;
+   bool in_order = true;
+   while (consumed < num_producers * per_producer) {
+      consumed += queue.consume_all([&](std::pair<uint32_t, uint32_t>&& v) {
+         in_order = in_order && v.second == next[v.first];
+         ++next[v.first];
+      });
+   }
+   for (auto& t : producers)
+      t.join();
+
+   BOOST_CHECK(in_order);
+   BOOST_CHECK(queue.empty());
+   for (uint32_t n : next)
+      BOOST_CHECK_EQUAL(n, per_producer);
+}
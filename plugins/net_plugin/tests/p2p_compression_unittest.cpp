@@ -0,0 +1,33 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/net_utils.hpp>
+
+BOOST_AUTO_TEST_CASE(test_peer_address_requests_compression) {
+   using eosio::net_utils::peer_address_requests_compression;
+
+   BOOST_CHECK(!peer_address_requests_compression(""));
+   BOOST_CHECK(!peer_address_requests_compression("p2p.eos.io:9876"));
+   BOOST_CHECK(!peer_address_requests_compression("p2p.eos.io:9876:blk"));
+   BOOST_CHECK(peer_address_requests_compression("p2p.eos.io:9876:zlib"));
+   BOOST_CHECK(peer_address_requests_compression("p2p.eos.io:9876:blk:zlib"));
+   BOOST_CHECK(peer_address_requests_compression("[::1]:9876:trx:zlib"));
+   BOOST_CHECK(!peer_address_requests_compression("[::1]:9876"));
+   BOOST_CHECK(!peer_address_requests_compression("[2001:db8:85a3:8d3:1319:8a2e:370:7348]:9876"));
+
+   // handshake p2p_address
+   BOOST_CHECK(peer_address_requests_compression("p2p.eos.io:9876:blk:zlib - 1a2b3c4"));
+   BOOST_CHECK(!peer_address_requests_compression("p2p.eos.io:9876:blk - 1a2b3c4"));
+   BOOST_CHECK(!peer_address_requests_compression("p2p.eos.io:9876 - zlib"));
+}
+
+BOOST_AUTO_TEST_CASE(test_zlib_round_trip) {
+   std::vector<char> data(64*1024);
+   for (size_t i = 0; i < data.size(); ++i)
+      data[i] = static_cast<char>(i % 13);
+
+   const auto compressed = eosio::net_utils::zlib_compress(data.data(), data.size());
+   BOOST_CHECK_LT(compressed.size(), data.size());
+   BOOST_CHECK(eosio::net_utils::zlib_decompress(compressed, data.size()) == data);
+
+   // zip bomb protection
+   BOOST_CHECK_THROW(eosio::net_utils::zlib_decompress(compressed, data.size() - 1), eosio::chain::plugin_exception);
+}
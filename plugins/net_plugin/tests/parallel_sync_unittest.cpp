@@ -0,0 +1,114 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/parallel_sync.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_CASE(test_sync_fetch_ranges_reassign) {
+   sync_fetch_ranges<int> ranges;
+   BOOST_CHECK(ranges.empty());
+
+   ranges.assign(1, 100, 1);
+   ranges.assign(101, 200, 2);
+   ranges.assign(201, 300, 3);
+   BOOST_CHECK_EQUAL(ranges.size(), 3u);
+   BOOST_CHECK(ranges.has_peer(2));
+   BOOST_CHECK(!ranges.has_peer(4));
+
+   // peer 3 stalls after delivering part of its range, peer 1 stalls before delivering anything
+   ranges.reassign(3, 250);
+   ranges.reassign(1, 40);
+   BOOST_CHECK_EQUAL(ranges.size(), 1u);
+   BOOST_CHECK(!ranges.has_peer(1));
+   BOOST_CHECK(!ranges.has_peer(3));
+
+   // completed range is not queued again
+   auto r = ranges.remove(2);
+   BOOST_REQUIRE(r);
+   BOOST_CHECK_EQUAL(r->start, 101u);
+   BOOST_CHECK_EQUAL(r->end, 200u);
+   BOOST_CHECK(!ranges.remove(2));
+   BOOST_CHECK(!ranges.empty());
+
+   // re-requested in block order, starting at the next needed block
+   auto u = ranges.pop_unassigned(40);
+   BOOST_REQUIRE(u);
+   BOOST_CHECK_EQUAL(u->first, 40u);
+   BOOST_CHECK_EQUAL(u->second, 100u);
+
+   // requeued when no peer is available
+   ranges.requeue(u->first, u->second);
+   u = ranges.pop_unassigned(60);
+   BOOST_REQUIRE(u);
+   BOOST_CHECK_EQUAL(u->first, 60u);
+   BOOST_CHECK_EQUAL(u->second, 100u);
+
+   // ranges already received in the meantime are dropped
+   BOOST_CHECK(!ranges.pop_unassigned(301));
+   BOOST_CHECK(ranges.empty());
+
+   // the rest of a range whose blocks could not be held is requested again whole
+   ranges.assign(301, 400, 4);
+   ranges.take_back(4, 450); // not in its range
+   BOOST_CHECK(ranges.has_peer(4));
+   ranges.take_back(4, 320);
+   BOOST_CHECK(!ranges.has_peer(4));
+   ranges.take_back(4, 321); // later blocks of the range taken back
+   u = ranges.pop_unassigned(310);
+   BOOST_REQUIRE(u);
+   BOOST_CHECK_EQUAL(u->first, 320u);
+   BOOST_CHECK_EQUAL(u->second, 400u);
+   BOOST_CHECK(ranges.empty());
+
+   ranges.assign(1, 10, 1);
+   ranges.requeue(11, 20);
+   ranges.clear();
+   BOOST_CHECK(ranges.empty());
+   BOOST_CHECK_EQUAL(ranges.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_sync_reorder_buffer_in_order) {
+   sync_reorder_buffer<std::string> buffer(4);
+   std::vector<uint32_t> dispatched;
+   auto dispatch = [&](uint32_t num, std::string&& v) {
+      BOOST_CHECK_EQUAL(v, std::to_string(num));
+      dispatched.push_back(num);
+   };
+
+   // blocks of a later range arrive before the blocks they build on
+   BOOST_CHECK(buffer.add(12, "12"));
+   BOOST_CHECK(buffer.add(11, "11"));
+   BOOST_CHECK(buffer.add(14, "14"));
+   BOOST_CHECK(!buffer.add(11, "dup"));
+   BOOST_CHECK_EQUAL(buffer.size(), 3u);
+
+   // nothing can be dispatched until block 10 is received
+   BOOST_CHECK_EQUAL(buffer.pop_in_order(10, dispatch), 10u);
+   BOOST_CHECK(dispatched.empty());
+
+   // block 10 was handed over directly, 11 and 12 follow it, 14 waits for 13
+   BOOST_CHECK_EQUAL(buffer.pop_in_order(11, dispatch), 13u);
+   BOOST_CHECK((dispatched == std::vector<uint32_t>{11, 12}));
+   BOOST_CHECK_EQUAL(buffer.size(), 1u);
+
+   BOOST_CHECK(buffer.add(16, "16"));
+   BOOST_CHECK(buffer.add(17, "17"));
+   BOOST_CHECK(buffer.add(18, "18"));
+   BOOST_CHECK(buffer.full());
+   BOOST_CHECK(!buffer.add(19, "19"));
+
+   // blocks before the next needed block are discarded
+   dispatched.clear();
+   BOOST_CHECK_EQUAL(buffer.pop_in_order(15, dispatch), 15u);
+   BOOST_CHECK(dispatched.empty());
+   BOOST_CHECK_EQUAL(buffer.size(), 3u);
+   BOOST_CHECK_EQUAL(buffer.pop_in_order(16, dispatch), 19u);
+   BOOST_CHECK((dispatched == std::vector<uint32_t>{16, 17, 18}));
+   BOOST_CHECK_EQUAL(buffer.size(), 0u);
+
+   BOOST_CHECK(buffer.add(20, "20"));
+   buffer.clear();
+   BOOST_CHECK_EQUAL(buffer.size(), 0u);
+}
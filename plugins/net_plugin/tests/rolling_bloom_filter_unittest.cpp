@@ -0,0 +1,77 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/rolling_bloom_filter.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace eosio;
+
+namespace {
+   std::vector<fc::sha256> make_ids(size_t n, const std::string& prefix) {
+      std::vector<fc::sha256> ids;
+      for (size_t i = 0; i < n; ++i)
+         ids.push_back(fc::sha256::hash(prefix + std::to_string(i)));
+      return ids;
+   }
+}
+
+BOOST_AUTO_TEST_CASE(test_rolling_bloom_filter_dedup) {
+   const fc::time_point start = fc::time_point::now();
+   rolling_bloom_filter filter(1000, fc::seconds(10), 0x1234);
+   BOOST_CHECK_EQUAL(filter.memory_size(), 2 * ((1000 * rolling_bloom_filter::bits_per_id + 63) / 64) * 8);
+
+   auto ids = make_ids(1000, "trx");
+   for (const auto& id : ids)
+      BOOST_CHECK(filter.add(id, start));
+   for (const auto& id : ids) {
+      BOOST_CHECK(filter.contains(id));
+      BOOST_CHECK(!filter.add(id, start));
+   }
+
+   // false positive rate at capacity is well under 0.1%
+   size_t false_positives = 0;
+   for (const auto& id : make_ids(100000, "other"))
+      false_positives += filter.contains(id);
+   BOOST_TEST(false_positives < 100u);
+
+   filter.clear();
+   BOOST_CHECK(!filter.contains(ids.front()));
+}
+
+BOOST_AUTO_TEST_CASE(test_rolling_bloom_filter_rotation) {
+   const fc::time_point start = fc::time_point::now();
+   const fc::microseconds period = fc::seconds(10);
+   rolling_bloom_filter filter(1000, period, 42);
+
+   auto first = make_ids(10, "first");
+   for (const auto& id : first)
+      filter.add(id, start);
+
+   // remembered for at least one period
+   filter.maybe_rotate(start + fc::seconds(5));
+   for (const auto& id : first)
+      BOOST_CHECK(filter.contains(id));
+   filter.maybe_rotate(start + period);
+   for (const auto& id : first)
+      BOOST_CHECK(filter.contains(id));
+   BOOST_CHECK_EQUAL(filter.current_size(), 0u);
+
+   // and forgotten after two
+   auto second = make_ids(10, "second");
+   for (const auto& id : second)
+      filter.add(id, start + period);
+   filter.maybe_rotate(start + period * 2);
+   for (const auto& id : first)
+      BOOST_CHECK(!filter.contains(id));
+   for (const auto& id : second)
+      BOOST_CHECK(filter.contains(id));
+
+   // a full generation rotates early, keeping memory bounded at high trx rates
+   rolling_bloom_filter small(10, period, 7);
+   auto ids = make_ids(25, "burst");
+   for (const auto& id : ids)
+      small.add(id, start);
+   BOOST_CHECK(small.current_size() <= 10u);
+   BOOST_CHECK(!small.contains(ids.front()));
+   BOOST_CHECK(small.contains(ids.back()));
+}
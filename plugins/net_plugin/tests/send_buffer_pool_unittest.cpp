@@ -0,0 +1,73 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/net_plugin/send_buffer_pool.hpp>
+
+#include <cstring>
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_CASE(test_send_buffer_pool_reuse) {
+   send_buffer_pool pool;
+
+   const char* first_data = nullptr;
+   {
+      send_buffer_ptr b = pool.allocate(100);
+      BOOST_REQUIRE(b);
+      BOOST_CHECK_EQUAL(b->size(), 100u);
+      std::memset(b->data(), 'a', b->size());
+      first_data = b->data();
+
+      send_buffer_ptr shared = b; // shared by another "connection", not returned to the pool yet
+      b.reset();
+      BOOST_CHECK_EQUAL(pool.free_buffers(), 0u);
+      BOOST_CHECK_EQUAL(shared->data()[99], 'a');
+   }
+   BOOST_CHECK_EQUAL(pool.free_buffers(), 1u);
+
+   // same size class is served from the free list
+   send_buffer_ptr b = pool.allocate(200);
+   BOOST_CHECK_EQUAL(b->size(), 200u);
+   BOOST_CHECK(b->data() == first_data);
+   BOOST_CHECK_EQUAL(pool.free_buffers(), 0u);
+
+   // different size class is not
+   send_buffer_ptr c = pool.allocate(2000);
+   BOOST_CHECK(c->data() != first_data);
+
+   auto stats = pool.get_stats();
+   BOOST_CHECK_EQUAL(stats.hits, 1u);
+   BOOST_CHECK_EQUAL(stats.misses, 2u);
+   BOOST_CHECK_EQUAL(stats.unpooled, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_send_buffer_pool_unpooled) {
+   send_buffer_pool pool;
+   {
+      send_buffer_ptr big = pool.allocate(send_buffer_pool::size_classes.back() + 1);
+      BOOST_CHECK_EQUAL(big->size(), send_buffer_pool::size_classes.back() + 1);
+      big->data()[big->size() - 1] = 'z';
+
+      std::vector<char> bytes{'b', 'l', 'k'};
+      const char* bytes_data = bytes.data();
+      send_buffer_ptr adopted = pool.adopt(std::move(bytes));
+      BOOST_CHECK_EQUAL(adopted->size(), 3u);
+      BOOST_CHECK(adopted->data() == bytes_data); // not copied
+   }
+   // neither is kept by the pool
+   BOOST_CHECK_EQUAL(pool.free_buffers(), 0u);
+   auto stats = pool.get_stats();
+   BOOST_CHECK_EQUAL(stats.hits, 0u);
+   BOOST_CHECK_EQUAL(stats.misses, 0u);
+   BOOST_CHECK_EQUAL(stats.unpooled, 2u);
+}
+
+BOOST_AUTO_TEST_CASE(test_send_buffer_pool_bounded) {
+   // room for 4 buffers of the smallest class, none of the largest
+   send_buffer_pool pool(4 * send_buffer_pool::size_classes.front());
+   {
+      std::vector<send_buffer_ptr> buffers;
+      for (size_t i = 0; i < 6; ++i)
+         buffers.push_back(pool.allocate(10));
+      buffers.push_back(pool.allocate(send_buffer_pool::size_classes.back()));
+   }
+   BOOST_CHECK_EQUAL(pool.free_buffers(), 4u);
+}
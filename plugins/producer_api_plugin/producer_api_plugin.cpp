@@ -113,6 +113,8 @@ void producer_api_plugin::plugin_startup() {
                      INVOKE_R_R_D(producer, get_unapplied_transactions, producer_plugin::get_unapplied_transactions_params), 200),
        CALL_WITH_400(producer, producer_ro, producer, get_snapshot_requests,
                      INVOKE_R_V(producer, get_snapshot_requests), 201),
+       CALL_WITH_400(producer, producer_ro, producer, get_contract_profile,
+                     INVOKE_R_R_II(producer, get_contract_profile, producer_plugin::get_contract_profile_params), 201),
    }, appbase::exec_queue::read_only, appbase::priority::medium_high);
 
    // Not safe to run in parallel
@@ -137,6 +139,8 @@ void producer_api_plugin::plugin_startup() {
             INVOKE_R_R(producer, unschedule_snapshot, chain::snapshot_scheduler::snapshot_request_id_information), 201),
        CALL_WITH_400(producer, producer_rw, producer, get_integrity_hash,
             INVOKE_R_V(producer, get_integrity_hash), 201),
+       CALL_WITH_400(producer, producer_rw, producer, get_section_integrity_hashes,
+            INVOKE_R_V(producer, get_section_integrity_hashes), 201),
        CALL_WITH_400(producer, producer_rw, producer, schedule_protocol_feature_activations,
             INVOKE_V_R(producer, schedule_protocol_feature_activations, producer_plugin::scheduled_protocol_feature_activations), 201),
    }, appbase::exec_queue::read_write, appbase::priority::medium_high);
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <eosio/chain/block.hpp>
+#include <eosio/chain/transaction_metadata.hpp>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace eosio {
+
+/**
+ * Transaction metadata, with recovered keys, of the transactions of received blocks that have not been applied yet.
+ * Key recovery of all the transactions of a block is fanned out over a thread pool as soon as the block is received,
+ * so that by the time the block is applied, possibly much later while syncing, the controller finds the keys already
+ * recovered through the trx_meta_cache_lookup passed to controller::push_block instead of recovering them itself.
+ * Only blocks within max_blocks of the last applied block are tracked, so that the recovery tasks queued on the thread
+ * pool do not hold up the recovery the controller starts on the same pool for the blocks it applies first.
+ *
+ * Thread safe.
+ */
+class block_trx_key_cache {
+public:
+   static constexpr size_t default_max_blocks = 32;
+
+   explicit block_trx_key_cache(size_t max_blocks = default_max_blocks) : _max_blocks(max_blocks) {}
+
+   /// Starts key recovery of the packed transactions of block on thread_pool. Ignored if the block is already tracked,
+   /// or more than max_blocks past the last applied block, in which case the controller recovers the keys when it
+   /// applies the block.
+   void start_recover_keys(const chain::signed_block_ptr& block, boost::asio::io_context& thread_pool,
+                           const chain::chain_id_type& chain_id) {
+      const uint32_t block_num = block->block_num();
+      std::vector<chain::transaction_id_type> ids;
+      for (const auto& receipt : block->transactions) {
+         if (std::holds_alternative<chain::packed_transaction>(receipt.trx))
+            ids.push_back(std::get<chain::packed_transaction>(receipt.trx).id());
+      }
+      if (ids.empty())
+         return;
+
+      {
+         std::lock_guard g(_mtx);
+         if (block_num <= _applied_num || block_num - _applied_num > _max_blocks ||
+             !_blocks.try_emplace(block_num, ids).second)
+            return;
+      }
+
+      for (const auto& receipt : block->transactions) {
+         if (!std::holds_alternative<chain::packed_transaction>(receipt.trx))
+            continue;
+         chain::packed_transaction_ptr trx(block, &std::get<chain::packed_transaction>(receipt.trx)); // alias block
+         boost::asio::post(thread_pool, [this, block_num, trx{std::move(trx)}, chain_id]() mutable {
+            {
+               std::lock_guard g(_mtx);
+               if (!_blocks.contains(block_num)) // applied before its turn came, the controller recovered the keys
+                  return;
+            }
+            chain::transaction_metadata_ptr trx_meta;
+            try {
+               trx_meta = chain::transaction_metadata::recover_keys(std::move(trx), chain_id, fc::microseconds::maximum(),
+                                                                    chain::transaction_metadata::trx_type::input);
+            } catch (...) {
+               return; // applying the block recovers the keys again and reports the failure
+            }
+            std::lock_guard g(_mtx);
+            if (_blocks.contains(block_num)) // not applied while recovering
+               _trxs.insert_or_assign(trx_meta->id(), std::move(trx_meta));
+         });
+      }
+   }
+
+   /// @return the metadata of a transaction of a tracked block once its keys are recovered, otherwise empty
+   chain::transaction_metadata_ptr get_trx(const chain::transaction_id_type& id) const {
+      std::lock_guard g(_mtx);
+      auto i = _trxs.find(id);
+      return i != _trxs.end() ? i->second : chain::transaction_metadata_ptr{};
+   }
+
+   /// Stops tracking blocks numbered block_num or lower, called once block_num is applied
+   void clear_through(uint32_t block_num) {
+      std::lock_guard g(_mtx);
+      _applied_num = block_num;
+      auto end = _blocks.upper_bound(block_num);
+      for (auto i = _blocks.begin(); i != end; ++i) {
+         for (const auto& id : i->second)
+            _trxs.erase(id);
+      }
+      _blocks.erase(_blocks.begin(), end);
+   }
+
+   size_t num_blocks() const {
+      std::lock_guard g(_mtx);
+      return _blocks.size();
+   }
+
+   size_t num_trxs() const {
+      std::lock_guard g(_mtx);
+      return _trxs.size();
+   }
+
+private:
+   const size_t                                                     _max_blocks;
+   mutable std::mutex                                               _mtx;
+   uint32_t                                                         _applied_num = 0; // last applied block
+   std::map<uint32_t, std::vector<chain::transaction_id_type>>      _blocks; // block num -> ids of its packed trxs
+   std::unordered_map<chain::transaction_id_type, chain::transaction_metadata_ptr> _trxs;
+};
+
+} // namespace eosio
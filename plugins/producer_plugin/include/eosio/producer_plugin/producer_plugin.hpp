@@ -41,6 +41,12 @@ public:
       chain::digest_type   integrity_hash;
    };
 
+   struct section_integrity_hash_information {
+      chain::block_id_type                          head_block_id;
+      chain::digest_type                            integrity_hash_root;
+      std::vector<chain::snapshot_section_hash>     sections;
+   };
+
    struct scheduled_protocol_feature_activations {
       std::vector<chain::digest_type> protocol_features_to_activate;
    };
@@ -95,6 +101,7 @@ public:
    void set_whitelist_blacklist(const whitelist_blacklist& params);
 
    integrity_hash_information get_integrity_hash() const;
+   section_integrity_hash_information get_section_integrity_hashes() const;
 
    void create_snapshot(next_function<chain::snapshot_scheduler::snapshot_information> next);
    chain::snapshot_scheduler::snapshot_schedule_result schedule_snapshot(const chain::snapshot_scheduler::snapshot_request_params& srp);
@@ -135,12 +142,41 @@ public:
 
    get_unapplied_transactions_result get_unapplied_transactions( const get_unapplied_transactions_params& params, const fc::time_point& deadline ) const;
 
+   struct get_contract_profile_params {
+      std::optional<account_name> receiver; ///< only the actions executed by this account
+      uint32_t                    limit = 100;
+   };
+
+   struct contract_action_profile {
+      account_name receiver;
+      action_name  action;
+      uint64_t     executions       = 0;
+      uint64_t     wall_us          = 0;
+      uint64_t     max_wall_us      = 0;
+      // estimated from the sampled executions
+      uint64_t     database_us      = 0;
+      uint64_t     crypto_us        = 0;
+      uint64_t     inline_action_us = 0;
+   };
+
+   struct get_contract_profile_result {
+      uint32_t                             intrinsic_sample_interval = 0; ///< 0 if intrinsics are not timed
+      uint64_t                             wall_us = 0; ///< of all the matching actions, including those past limit
+      std::vector<contract_action_profile> actions; ///< the most wall time first
+   };
+
+   // wall time spent executing each (receiver, action) since startup
+   get_contract_profile_result get_contract_profile( const get_contract_profile_params& params ) const;
+
 
    void log_failed_transaction(const transaction_id_type& trx_id, const chain::packed_transaction_ptr& packed_trx_ptr, const char* reason) const;
 
    // thread-safe, called when a new block is received
    void received_block(uint32_t block_num);
 
+   // thread-safe, starts recovering the keys of the transactions of a received block that is applied later
+   void recover_block_trx_keys(const chain::signed_block_ptr& block);
+
    const std::set<account_name>& producer_accounts() const;
 
    static void set_test_mode(bool m) { test_mode_ = m; }
@@ -201,6 +237,7 @@ FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_i
 FC_REFLECT(eosio::producer_plugin::greylist_params, (accounts));
 FC_REFLECT(eosio::producer_plugin::whitelist_blacklist, (actor_whitelist)(actor_blacklist)(contract_whitelist)(contract_blacklist)(action_blacklist)(key_blacklist) )
 FC_REFLECT(eosio::producer_plugin::integrity_hash_information, (head_block_id)(integrity_hash))
+FC_REFLECT(eosio::producer_plugin::section_integrity_hash_information, (head_block_id)(integrity_hash_root)(sections))
 FC_REFLECT(eosio::producer_plugin::scheduled_protocol_feature_activations, (protocol_features_to_activate))
 FC_REFLECT(eosio::producer_plugin::get_supported_protocol_features_params, (exclude_disabled)(exclude_unactivatable))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_params, (lower_bound)(upper_bound)(limit)(reverse))
@@ -208,3 +245,6 @@ FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_result, (rows)(mo
 FC_REFLECT(eosio::producer_plugin::get_unapplied_transactions_params, (lower_bound)(limit)(time_limit_ms))
 FC_REFLECT(eosio::producer_plugin::unapplied_trx, (trx_id)(expiration)(trx_type)(first_auth)(first_receiver)(first_action)(total_actions)(billed_cpu_time_us)(size))
 FC_REFLECT(eosio::producer_plugin::get_unapplied_transactions_result, (size)(incoming_size)(trxs)(more))
+FC_REFLECT(eosio::producer_plugin::get_contract_profile_params, (receiver)(limit))
+FC_REFLECT(eosio::producer_plugin::contract_action_profile, (receiver)(action)(executions)(wall_us)(max_wall_us)(database_us)(crypto_us)(inline_action_us))
+FC_REFLECT(eosio::producer_plugin::get_contract_profile_result, (intrinsic_sample_interval)(wall_us)(actions))
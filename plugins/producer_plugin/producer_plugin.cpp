@@ -1,5 +1,6 @@
 #include <eosio/producer_plugin/producer_plugin.hpp>
 #include <eosio/producer_plugin/block_timing_util.hpp>
+#include <eosio/producer_plugin/block_trx_key_cache.hpp>
 #include <eosio/producer_plugin/production_pause_vote_tracker.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
@@ -7,6 +8,7 @@
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/snapshot_scheduler.hpp>
 #include <eosio/chain/subjective_billing.hpp>
+#include <eosio/chain/contract_profiler.hpp>
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/unapplied_transaction_queue.hpp>
 #include <eosio/resource_monitor_plugin/resource_monitor_plugin.hpp>
@@ -646,6 +648,22 @@ public:
       return {chain.head().id(), chain.calculate_integrity_hash()};
    }
 
+   producer_plugin::section_integrity_hash_information get_section_integrity_hashes() {
+      chain::controller& chain = chain_plug->chain();
+
+      auto reschedule = fc::make_scoped_exit([this]() { schedule_production_loop(); });
+
+      if (chain.is_building_block()) {
+         // abort the pending block
+         abort_block();
+      } else {
+         reschedule.cancel();
+      }
+
+      chain::snapshot_section_hashes hashes = chain.calculate_section_integrity_hashes();
+      return {chain.head().id(), hashes.root, std::move(hashes.sections)};
+   }
+
    void create_snapshot(producer_plugin::next_function<chain::snapshot_scheduler::snapshot_information> next) {
       chain::controller& chain = chain_plug->chain();
 
@@ -692,6 +710,7 @@ public:
    block_timing_util::producer_watermarks            _producer_watermarks;
    pending_block_mode                                _pending_block_mode = pending_block_mode::speculating;
    unapplied_transaction_queue                       _unapplied_transactions;
+   block_trx_key_cache                               _block_trx_keys;          // filled by chain thread pool
    alignas(hardware_destructive_interference_sz)
    std::atomic<int32_t>                              _max_transaction_time_ms; // modified by app thread, read by net_plugin thread pool
    alignas(hardware_destructive_interference_sz)
@@ -699,6 +718,10 @@ public:
    implicit_production_pause_vote_tracker            _implicit_pause_vote_tracker;
    fc::microseconds                                  _max_irreversible_block_age_us;
    block_num_type                                    _max_reversible_blocks{0};
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+   fc::microseconds                                  _eos_vm_oc_warmup_max_delay;
+   fc::time_point                                    _eos_vm_oc_warmup_deadline; // no production before, unless cache is warm
+#endif
    // produce-block-offset is in terms of the complete round, internally use calculated value for each block of round
    fc::microseconds                                  _produce_block_cpu_effort;
    fc::time_point                                    _pending_block_deadline;
@@ -832,10 +855,18 @@ public:
       return _implicit_pause_vote_tracker.check_pause_status(fc::time_point::now()).should_pause();
    }
 
+   // trx_meta_cache_lookup for applying blocks, transactions of received blocks have their keys recovered ahead of time
+   transaction_metadata_ptr get_trx_meta(const transaction_id_type& id) const {
+      if (auto trx = _unapplied_transactions.get_trx(id))
+         return trx;
+      return _block_trx_keys.get_trx(id);
+   }
+
    void on_accepted_block(const signed_block_ptr& block, const block_id_type& id) {
       auto& chain  = chain_plug->chain();
       auto  before = _unapplied_transactions.size();
       _unapplied_transactions.clear_applied(block);
+      _block_trx_keys.clear_through(block->block_num());
       if (before > 0) {
          fc_dlog(_log, "Removed applied transactions before: ${before}, after: ${after}",
                  ("before", before)("after", _unapplied_transactions.size()));
@@ -945,7 +976,7 @@ public:
             br,
             bh,
             [this](const transaction_metadata_ptr& trx) { _unapplied_transactions.add_forked(trx); },
-            [this](const transaction_id_type& id) { return _unapplied_transactions.get_trx(id); });
+            [this](const transaction_id_type& id) { return get_trx_meta(id); });
       } catch (const guard_exception& e) {
          chain_plugin::handle_guard_exception(e);
          return false;
@@ -1267,6 +1298,11 @@ void producer_plugin::set_program_options(
           "Limits the maximum age (in seconds) of the DPOS Irreversible Block for a chain this node will produce blocks on (use negative value to indicate unlimited)")
          ("max-reversible-blocks", bpo::value<uint32_t>()->default_value(config::default_max_reversible_blocks),
            "Maximum allowed reversible blocks beyond irreversible before block production is paused. Specify 0 to disable.")
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+         ("eos-vm-oc-warmup-max-delay-ms", bpo::value<uint32_t>()->default_value(0),
+          "Maximum time (in milliseconds) after startup that block production waits for the EOS VM OC code cache warm up "
+          "configured by eos-vm-oc-warmup-contracts to complete. Specify 0 to not wait.")
+#endif
          ("producer-name,p", boost::program_options::value<vector<string>>()->composing()->multitoken(),
           "ID of producer controlled by this node (e.g. inita; may specify multiple times)")
          ("signature-provider", boost::program_options::value<vector<string>>()->composing()->multitoken()->default_value(
@@ -1301,6 +1337,9 @@ void producer_plugin::set_program_options(
           "Disable subjective CPU billing for API transactions")
          ("snapshots-dir", bpo::value<std::filesystem::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("background-snapshots", bpo::bool_switch()->default_value(false),
+          "Write snapshots that are returned once their block becomes irreversible from a forked process holding a copy-on-write "
+          "view of the state, so block processing is not paused while they are written. Requires a database-map-mode other than \"mapped\".")
          ("read-only-threads", bpo::value<uint32_t>(),
          ("Number of worker threads in read-only execution thread pool. Defaults to 0 if configured as producer, otherwise defaults to "s + std::to_string(producer_plugin_impl::_ro_default_threads_nonproducer) + ". Max "s + std::to_string(producer_plugin_impl::_ro_max_threads_allowed) + "."s).c_str())
          ("read-only-write-window-time-us", bpo::value<uint32_t>()->default_value(my->_ro_write_window_time_us.count()),
@@ -1406,6 +1445,10 @@ void producer_plugin_impl::plugin_initialize(const boost::program_options::varia
 
    _max_reversible_blocks = options.at("max-reversible-blocks").as<uint32_t>();
 
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+   _eos_vm_oc_warmup_max_delay = fc::milliseconds(options.at("eos-vm-oc-warmup-max-delay-ms").as<uint32_t>());
+#endif
+
    auto max_incoming_transaction_queue_size = options.at("incoming-transaction-queue-size-mb").as<uint16_t>() * 1024 * 1024;
 
    EOS_ASSERT(max_incoming_transaction_queue_size > 0, plugin_config_exception,
@@ -1543,6 +1586,13 @@ void producer_plugin_impl::plugin_initialize(const boost::program_options::varia
 
    _snapshot_scheduler.set_db_path(_snapshots_dir);
    _snapshot_scheduler.set_snapshots_path(_snapshots_dir);
+
+   if (options.at("background-snapshots").as<bool>()) {
+      if (chain.can_write_snapshot_in_background())
+         _snapshot_scheduler.set_background_snapshots(true);
+      else
+         wlog("background-snapshots ignored: database-map-mode \"mapped\" shares state with a forked process");
+   }
 }
 
 void producer_plugin::plugin_initialize(const boost::program_options::variables_map& options) {
@@ -1573,6 +1623,7 @@ void producer_plugin_impl::plugin_startup() {
                     "node cannot have any producer-name configured because no block production is possible with no [api|p2p]-accepted-transactions");
 
          chain.set_node_finalizer_keys(_finalizer_keys);
+         _block_trx_keys.clear_through(chain.head().block_num());
 
          _accepted_block_connection.emplace(chain.accepted_block().connect([this](const block_signal_params& t) {
             const auto& [ block, id ] = t;
@@ -1617,6 +1668,9 @@ void producer_plugin_impl::plugin_startup() {
 
          if (!_producers.empty()) {
             ilog("Launching block production for ${n} producers at ${time}.", ("n", _producers.size())("time", fc::time_point::now()));
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+            _eos_vm_oc_warmup_deadline = fc::time_point::now() + _eos_vm_oc_warmup_max_delay;
+#endif
 
             if (_production_enabled) {
                if (chain.head().block_num() == 0) {
@@ -1784,6 +1838,10 @@ producer_plugin::integrity_hash_information producer_plugin::get_integrity_hash(
    return my->get_integrity_hash();
 }
 
+producer_plugin::section_integrity_hash_information producer_plugin::get_section_integrity_hashes() const {
+   return my->get_section_integrity_hashes();
+}
+
 void producer_plugin::create_snapshot(producer_plugin::next_function<chain::snapshot_scheduler::snapshot_information> next) {
    my->create_snapshot(std::move(next));
 }
@@ -1999,6 +2057,38 @@ producer_plugin::get_unapplied_transactions_result producer_plugin::get_unapplie
    return result;
 }
 
+producer_plugin::get_contract_profile_result producer_plugin::get_contract_profile(const get_contract_profile_params& params) const {
+   const chain::contract_profiler& profiler = my->chain_plug->chain().get_contract_profiler();
+   std::vector<chain::contract_profiler::action_profile> actions = profiler.actions();
+   if (params.receiver) {
+      std::erase_if(actions, [&](const auto& a) { return a.receiver != *params.receiver; });
+   }
+
+   get_contract_profile_result result;
+   result.intrinsic_sample_interval = profiler.intrinsic_sample_interval();
+   for (const auto& a : actions)
+      result.wall_us += a.wall_us;
+
+   const size_t n = std::min<size_t>(params.limit, actions.size());
+   std::partial_sort(actions.begin(), actions.begin() + n, actions.end(), [](const auto& a, const auto& b) {
+      return a.wall_us > b.wall_us;
+   });
+   result.actions.reserve(n);
+   for (size_t i = 0; i < n; ++i) {
+      const auto& a = actions[i];
+      auto intrinsic_us = [&](chain::intrinsic_category c) { return a.intrinsic_us[static_cast<size_t>(c)]; };
+      result.actions.push_back({.receiver         = a.receiver,
+                                .action           = a.action,
+                                .executions       = a.executions,
+                                .wall_us          = a.wall_us,
+                                .max_wall_us      = a.max_wall_us,
+                                .database_us      = intrinsic_us(chain::intrinsic_category::database),
+                                .crypto_us        = intrinsic_us(chain::intrinsic_category::crypto),
+                                .inline_action_us = intrinsic_us(chain::intrinsic_category::inline_action)});
+   }
+   return result;
+}
+
 block_timestamp_type producer_plugin_impl::calculate_pending_block_time() const {
    const chain::controller& chain = chain_plug->chain();
    const fc::time_point     now   = fc::time_point::now();
@@ -2023,7 +2113,7 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
    abort_block();
 
    chain.maybe_switch_forks([this](const transaction_metadata_ptr& trx) { _unapplied_transactions.add_forked(trx); },
-                            [this](const transaction_id_type& id) { return _unapplied_transactions.get_trx(id); });
+                            [this](const transaction_id_type& id) { return get_trx_meta(id); });
 
 
    if (chain.should_terminate()) {
@@ -2103,6 +2193,15 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
       _pending_block_mode = pending_block_mode::speculating;
       not_producing_when_time = true;
    }
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+   else if (const size_t warmup_remaining = now < _eos_vm_oc_warmup_deadline ? chain.eos_vm_oc_warmup_remaining() : 0;
+            warmup_remaining > 0) {
+      fc_wlog(_log, "Not producing block because the EOS VM OC code cache is warming up, ${n} contracts left to compile, block ${t}",
+              ("n", warmup_remaining)("t", block_time));
+      _pending_block_mode = pending_block_mode::speculating;
+      not_producing_when_time = true;
+   }
+#endif
 
    // !not_producing_when_time to avoid tight spin because of error or paused production
    if (in_speculating_mode() && !not_producing_when_time) {
@@ -2982,6 +3081,11 @@ void producer_plugin::received_block(uint32_t block_num) {
    my->_received_block = block_num;
 }
 
+void producer_plugin::recover_block_trx_keys(const chain::signed_block_ptr& block) {
+   auto& chain = my->chain_plug->chain();
+   my->_block_trx_keys.start_recover_keys(block, chain.get_thread_pool(), chain.get_chain_id());
+}
+
 void producer_plugin::log_failed_transaction(const transaction_id_type&    trx_id,
                                              const packed_transaction_ptr& packed_trx_ptr,
                                              const char*                   reason) const {
@@ -0,0 +1,60 @@
+#include <boost/test/unit_test.hpp>
+#include <eosio/producer_plugin/block_trx_key_cache.hpp>
+
+#include <eosio/testing/tester.hpp>
+
+using namespace eosio;
+using namespace eosio::chain;
+using namespace eosio::chain::literals;
+
+BOOST_AUTO_TEST_SUITE(block_trx_key_cache_tests)
+
+BOOST_AUTO_TEST_CASE(test_recover_block_trx_keys) try {
+   testing::tester chain;
+   chain.create_accounts({"alice"_n, "bob"_n});
+   signed_block_ptr b1 = chain.produce_block();
+   chain.create_accounts({"carol"_n});
+   signed_block_ptr b2 = chain.produce_block();
+   BOOST_REQUIRE(!b1->transactions.empty());
+   BOOST_REQUIRE(!b2->transactions.empty());
+   const auto& id1 = std::get<packed_transaction>(b1->transactions.front().trx).id();
+   const auto& id2 = std::get<packed_transaction>(b2->transactions.front().trx).id();
+
+   boost::asio::io_context thread_pool;
+   block_trx_key_cache cache(1);
+   cache.start_recover_keys(b1, thread_pool, chain.get_chain_id()); // too far ahead of the last applied block
+   BOOST_CHECK_EQUAL(cache.num_blocks(), 0u);
+   cache.clear_through(b1->block_num() - 1);
+   cache.start_recover_keys(b1, thread_pool, chain.get_chain_id());
+   cache.start_recover_keys(b1, thread_pool, chain.get_chain_id()); // already tracked
+   cache.start_recover_keys(b2, thread_pool, chain.get_chain_id()); // over max_blocks, left to the controller
+   BOOST_CHECK_EQUAL(cache.num_blocks(), 1u);
+
+   // nothing until recovered
+   BOOST_CHECK(!cache.get_trx(id1));
+   thread_pool.run();
+   BOOST_CHECK_EQUAL(cache.num_trxs(), b1->transactions.size());
+
+   auto trx = cache.get_trx(id1);
+   BOOST_REQUIRE(trx);
+   BOOST_CHECK(*trx->packed_trx() == std::get<packed_transaction>(b1->transactions.front().trx));
+   BOOST_CHECK(trx->recovered_keys().contains(testing::tester::get_public_key(config::system_account_name, "active")));
+   BOOST_CHECK(!cache.get_trx(id2));
+
+   // applied
+   cache.clear_through(b1->block_num());
+   BOOST_CHECK(!cache.get_trx(id1));
+   BOOST_CHECK_EQUAL(cache.num_blocks(), 0u);
+   BOOST_CHECK_EQUAL(cache.num_trxs(), 0u);
+
+   // keys of a block applied before its recovery tasks run are not recovered
+   thread_pool.restart();
+   cache.start_recover_keys(b2, thread_pool, chain.get_chain_id());
+   BOOST_CHECK_EQUAL(cache.num_blocks(), 1u);
+   cache.clear_through(b2->block_num());
+   thread_pool.run();
+   BOOST_CHECK(!cache.get_trx(id2));
+   BOOST_CHECK_EQUAL(cache.num_trxs(), 0u);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
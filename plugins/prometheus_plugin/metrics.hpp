@@ -4,8 +4,10 @@
 #include <eosio/net_plugin/net_plugin.hpp>
 #include <eosio/producer_plugin/producer_plugin.hpp>
 #include <eosio/chain_plugin/tracked_votes.hpp>
+#include <eosio/chain/contract_profiler.hpp>
 
 #include <prometheus/counter.h>
+#include <prometheus/histogram.h>
 #include <prometheus/info.h>
 #include <prometheus/registry.h>
 #include <prometheus/text_serializer.h>
@@ -27,6 +29,11 @@ struct catalog_type {
       return family<T>(name, help).Add({});
    }
 
+   template <size_t N>
+   prometheus::Histogram& build_histogram(const std::string& name, const std::string& help, const std::array<uint64_t, N>& bounds) {
+      return family<prometheus::Histogram>(name, help).Add({}, prometheus::Histogram::BucketBoundaries(bounds.begin(), bounds.end()));
+   }
+
    prometheus::Registry registry;
    // nodeos
    prometheus::Family<prometheus::Info>& info;
@@ -62,8 +69,13 @@ struct catalog_type {
       prometheus::Family<Gauge>& block_sync_throttling;
       prometheus::Family<Gauge>& connection_start_time;
       prometheus::Family<Gauge>& peer_addr; // Empty gauge; we only want the label
+
+      Counter& send_buffer_pool_hits;
+      Counter& send_buffer_pool_misses;
+      Counter& send_buffer_pool_unpooled;
    };
-   p2p_connection_metrics p2p_metrics;
+   p2p_connection_metrics                       p2p_metrics;
+   net_plugin::p2p_send_buffer_pool_metrics     last_send_buffer_pool_stats;
 
    prometheus::Family<Counter>& cpu_usage_us;
    prometheus::Family<Counter>& net_usage_us;
@@ -108,10 +120,43 @@ struct catalog_type {
    Counter& latency_us_incoming_block;
    Counter& blocks_incoming;
 
+   // state history plugin
+   Counter& ship_entry_cache_hits;
+   Counter& ship_entry_cache_misses;
+   chain::plugin_interface::state_history_entry_cache_stats last_ship_entry_cache_stats;
+   chain::plugin_interface::channels::state_history_entry_cache::channel_type::handle ship_entry_cache_subscription;
+
    // prometheus exporter
    Counter& bytes_transferred;
    Counter& num_scrapes;
 
+   // contract profile, of the actions with the most wall time only to bound the number of series
+   static constexpr size_t max_contract_profile_actions = 100;
+   prometheus::Family<Counter>& contract_action_executions;
+   prometheus::Family<Counter>& contract_action_wall_us;
+   prometheus::Family<Counter>& contract_intrinsic_us;
+   std::map<std::pair<chain::account_name, chain::action_name>, chain::contract_profiler::action_profile> last_contract_actions;
+   chain::contract_profiler::intrinsic_us_t last_contract_intrinsic_us{};
+
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+   // EOS VM OC code cache
+   struct eos_vm_oc_cache_metrics {
+      Counter& hits;
+      Counter& misses;
+      Counter& insertions;
+      Counter& evictions;
+      Counter& admission_rejections;
+      Gauge&   entries;
+      Gauge&   protected_entries;
+      Gauge&   queued_compiles;
+      Gauge&   outstanding_compiles;
+      Counter& canceled_compiles;
+      prometheus::Histogram& compile_latency_ms;
+      prometheus::Histogram& queue_depth;
+   };
+   eos_vm_oc_cache_metrics            eos_vm_oc_cache;
+   chain::eosvmoc::code_cache_stats   last_eos_vm_oc_cache_stats;
+#endif
 
    catalog_type()
        : info(family<prometheus::Info>("nodeos", "static information about the server"))
@@ -139,6 +184,9 @@ struct catalog_type {
             , .block_sync_throttling{family<Gauge>("nodeos_p2p_block_sync_throttling", "is block sync throttling currently active")}
             , .connection_start_time{family<Gauge>("nodeos_p2p_connection_start_time", "time of last connection to peer")}
             , .peer_addr{family<Gauge>("nodeos_p2p_peer_addr", "peer address")}
+            , .send_buffer_pool_hits{build<Counter>("nodeos_p2p_send_buffer_pool_hits_total", "total number of p2p send buffers reused from the pool")}
+            , .send_buffer_pool_misses{build<Counter>("nodeos_p2p_send_buffer_pool_misses_total", "total number of p2p send buffers allocated because the pool was empty")}
+            , .send_buffer_pool_unpooled{build<Counter>("nodeos_p2p_send_buffer_pool_unpooled_total", "total number of p2p send buffers too large to be pooled")}
          }
        , cpu_usage_us(family<Counter>("nodeos_cpu_usage_us_total", "total cpu usage in microseconds for blocks"))
        , net_usage_us(family<Counter>("nodeos_net_usage_us_total", "total net usage in microseconds for blocks"))
@@ -184,9 +232,31 @@ struct catalog_type {
        , net_usage_us_incoming_block(net_usage_us.Add({{"block_type", "incoming"}}))
        , latency_us_incoming_block(build<Counter>("nodeos_incoming_us_block_latency", "total incoming block latency"))
        , blocks_incoming(build<Counter>("nodeos_blocks_incoming", "number of incoming blocks"))
+       , ship_entry_cache_hits(build<Counter>("nodeos_ship_entry_cache_hits", "number of state history entries sent from the decompressed entry cache"))
+       , ship_entry_cache_misses(build<Counter>("nodeos_ship_entry_cache_misses", "number of cacheable state history entries that had to be decompressed"))
        , bytes_transferred(build<Counter>("exposer_transferred_bytes_total",
                                           "total number of bytes for responses to prometheus scrape requests"))
-       , num_scrapes(build<Counter>("exposer_scrapes_total", "total number of prometheus scrape requests received")) {}
+       , num_scrapes(build<Counter>("exposer_scrapes_total", "total number of prometheus scrape requests received"))
+       , contract_action_executions(family<Counter>("nodeos_contract_action_executions_total", "number of executions of the actions with the most wall time, by receiver and action"))
+       , contract_action_wall_us(family<Counter>("nodeos_contract_action_wall_us_total", "wall time in microseconds of the actions with the most wall time, by receiver and action"))
+       , contract_intrinsic_us(family<Counter>("nodeos_contract_intrinsic_us_total", "estimated wall time in microseconds of all the actions in intrinsics, by intrinsic category"))
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+       , eos_vm_oc_cache{ .hits{build<Counter>("nodeos_eos_vm_oc_cache_hits", "number of contract executions that found EOS VM OC compiled code")}
+                        , .misses{build<Counter>("nodeos_eos_vm_oc_cache_misses", "number of contract executions that did not find EOS VM OC compiled code")}
+                        , .insertions{build<Counter>("nodeos_eos_vm_oc_cache_insertions", "number of contracts compiled in to the EOS VM OC code cache")}
+                        , .evictions{build<Counter>("nodeos_eos_vm_oc_cache_evictions", "number of contracts evicted from the EOS VM OC code cache to make room")}
+                        , .admission_rejections{build<Counter>("nodeos_eos_vm_oc_cache_admission_rejections", "number of misses not compiled because the contract was not executed often enough yet")}
+                        , .entries{build<Gauge>("nodeos_eos_vm_oc_cache_entries", "current number of contracts in the EOS VM OC code cache")}
+                        , .protected_entries{build<Gauge>("nodeos_eos_vm_oc_cache_protected_entries", "current number of contracts in the protected segment of the EOS VM OC code cache")}
+                        , .queued_compiles{build<Gauge>("nodeos_eos_vm_oc_queued_compiles", "current number of EOS VM OC compiles waiting for a compile thread")}
+                        , .outstanding_compiles{build<Gauge>("nodeos_eos_vm_oc_outstanding_compiles", "current number of EOS VM OC compiles on a compile thread")}
+                        , .canceled_compiles{build<Counter>("nodeos_eos_vm_oc_canceled_compiles", "number of queued EOS VM OC compiles dropped because the contract was replaced")}
+                        , .compile_latency_ms{build_histogram("nodeos_eos_vm_oc_compile_latency_ms", "milliseconds from the first execution that asked for an EOS VM OC compile to the compiled contract entering the cache",
+                                                              chain::eosvmoc::code_cache_stats::compile_latency_bounds_ms)}
+                        , .queue_depth{build_histogram("nodeos_eos_vm_oc_compile_queue_depth", "number of EOS VM OC compiles already waiting each time another is queued",
+                                                       chain::eosvmoc::code_cache_stats::queue_depth_bounds)} }
+#endif
+   {}
 
    std::string report() {
       const prometheus::TextSerializer serializer;
@@ -203,6 +273,11 @@ struct catalog_type {
    void update(const net_plugin::p2p_connections_metrics& metrics) {
       p2p_metrics.num_peers.Set(metrics.num_peers);
       p2p_metrics.num_clients.Set(metrics.num_clients);
+      auto& last_pool = last_send_buffer_pool_stats;
+      p2p_metrics.send_buffer_pool_hits.Increment(metrics.send_buffer_pool.hits - last_pool.hits);
+      p2p_metrics.send_buffer_pool_misses.Increment(metrics.send_buffer_pool.misses - last_pool.misses);
+      p2p_metrics.send_buffer_pool_unpooled.Increment(metrics.send_buffer_pool.unpooled - last_pool.unpooled);
+      last_pool = metrics.send_buffer_pool;
       for(size_t i = 0; i < metrics.stats.peers.size(); ++i) {
          const auto& peer = metrics.stats.peers[i];
          const auto& conn_id = peer.unique_conn_node_id;
@@ -281,6 +356,83 @@ struct catalog_type {
       head_block_num.Set(metrics.head_block_num);
    }
 
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+   void update(const chain::eosvmoc::code_cache_stats& stats) {
+      auto& last = last_eos_vm_oc_cache_stats;
+      eos_vm_oc_cache.hits.Increment(stats.hits - last.hits);
+      eos_vm_oc_cache.misses.Increment(stats.misses - last.misses);
+      eos_vm_oc_cache.insertions.Increment(stats.insertions - last.insertions);
+      eos_vm_oc_cache.evictions.Increment(stats.evictions - last.evictions);
+      eos_vm_oc_cache.admission_rejections.Increment(stats.admission_rejections - last.admission_rejections);
+      eos_vm_oc_cache.entries.Set(stats.entries);
+      eos_vm_oc_cache.protected_entries.Set(stats.protected_entries);
+      eos_vm_oc_cache.queued_compiles.Set(stats.queued_compiles);
+      eos_vm_oc_cache.outstanding_compiles.Set(stats.outstanding_compiles);
+      eos_vm_oc_cache.canceled_compiles.Increment(stats.canceled_compiles - last.canceled_compiles);
+
+      auto observe = [](prometheus::Histogram& h, const auto& now, const auto& before) {
+         std::vector<double> increments(now.counts.size());
+         for(size_t i = 0; i < increments.size(); ++i)
+            increments[i] = now.counts[i] - before.counts[i];
+         h.ObserveMultiple(increments, now.sum - before.sum);
+      };
+      observe(eos_vm_oc_cache.compile_latency_ms, stats.compile_latency_ms, last.compile_latency_ms);
+      observe(eos_vm_oc_cache.queue_depth, stats.queue_depth, last.queue_depth);
+      last = stats;
+   }
+#endif
+
+   void update(const chain::contract_profiler& profiler) {
+      std::vector<chain::contract_profiler::action_profile> actions = profiler.actions();
+
+      chain::contract_profiler::intrinsic_us_t intrinsic_us{};
+      for (const auto& a : actions) {
+         for (size_t i = 0; i < intrinsic_us.size(); ++i)
+            intrinsic_us[i] += a.intrinsic_us[i];
+      }
+      for (size_t i = 0; i < intrinsic_us.size(); ++i) {
+         const auto category = static_cast<chain::intrinsic_category>(i);
+         contract_intrinsic_us.Add({{"category", chain::to_string(category)}}).Increment(intrinsic_us[i] - last_contract_intrinsic_us[i]);
+      }
+      last_contract_intrinsic_us = intrinsic_us;
+
+      const size_t n = std::min(max_contract_profile_actions, actions.size());
+      std::partial_sort(actions.begin(), actions.begin() + n, actions.end(),
+                        [](const auto& a, const auto& b) { return a.wall_us > b.wall_us; });
+      std::map<std::pair<chain::account_name, chain::action_name>, chain::contract_profiler::action_profile> exported;
+      for (size_t i = 0; i < n; ++i) {
+         const auto& a = actions[i];
+         auto& last = last_contract_actions[{a.receiver, a.action}];
+         const prometheus::Labels labels{{"receiver", a.receiver.to_string()}, {"action", a.action.to_string()}};
+         contract_action_executions.Add(labels).Increment(a.executions - last.executions);
+         contract_action_wall_us.Add(labels).Increment(a.wall_us - last.wall_us);
+         exported.emplace(std::pair{a.receiver, a.action}, a);
+      }
+      // drop the series of the actions no longer among those with the most wall time
+      for (const auto& [key, _] : last_contract_actions) {
+         if (exported.contains(key))
+            continue;
+         const prometheus::Labels labels{{"receiver", key.first.to_string()}, {"action", key.second.to_string()}};
+         contract_action_executions.Remove(&contract_action_executions.Add(labels));
+         contract_action_wall_us.Remove(&contract_action_wall_us.Add(labels));
+      }
+      last_contract_actions = std::move(exported);
+   }
+
+   void update(const chain::plugin_interface::state_history_entry_cache_stats& stats) {
+      ship_entry_cache_hits.Increment(stats.hits - last_ship_entry_cache_stats.hits);
+      ship_entry_cache_misses.Increment(stats.misses - last_ship_entry_cache_stats.misses);
+      last_ship_entry_cache_stats = stats;
+   }
+
+   // metrics that are read when scraped rather than pushed by the plugins
+   void update_polled_metrics() {
+      update(app().get_plugin<chain_plugin>().chain().get_contract_profiler());
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+      update(app().get_plugin<chain_plugin>().chain().eos_vm_oc_cache_stats());
+#endif
+   }
+
    void update_prometheus_info() {
       info_details = info.Add({
             {"server_version", chain_apis::itoh(static_cast<uint32_t>(app().version()))},
@@ -323,6 +475,12 @@ struct catalog_type {
           [&strand, this](const producer_plugin::incoming_block_metrics& metrics) {
              strand.post([metrics, this]() { update(metrics); });
           });
+
+      // published only when the state_history_plugin is enabled
+      ship_entry_cache_subscription = app().get_channel<chain::plugin_interface::channels::state_history_entry_cache>().subscribe(
+          [&strand, this](const chain::plugin_interface::state_history_entry_cache_stats& stats) {
+             strand.post([stats, this]() { update(stats); });
+          });
    }
 };
 
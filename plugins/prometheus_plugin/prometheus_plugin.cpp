@@ -41,6 +41,7 @@ namespace eosio {
 
       void metrics(const fc::variant_object&, chain::plugin_interface::next_function<std::string> results) {
          _impl->_prometheus_strand.post([this, results=std::move(results)]() {
+            _impl->_catalog.update_polled_metrics();
             results(_impl->_catalog.report());
          });
       }
@@ -1,5 +1,7 @@
 #pragma once
+#include <eosio/state_history/filter.hpp>
 #include <eosio/state_history/log.hpp>
+#include <eosio/state_history/log_entry_cache.hpp>
 #include <eosio/state_history/serialization.hpp>
 #include <eosio/state_history/types.hpp>
 
@@ -11,6 +13,10 @@
 #include <boost/asio/local/stream_protocol.hpp>
 #include <boost/asio/error.hpp>
 #include <boost/beast/websocket.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream_buffer.hpp>
+#include <deque>
 #include <memory>
 
 extern const char* const state_history_plugin_abi;
@@ -23,6 +29,7 @@ public:
    session_base(const session_base&) = delete;
    session_base& operator=(const session_base&) = delete;
 
+   /// called once all state history of applied_block_num has been written to the logs
    virtual void block_applied(const chain::block_num_type applied_block_num) = 0;
 
    virtual ~session_base() = default;
@@ -37,9 +44,10 @@ class session final : public session_base {
 public:
    session(SocketType&& s, Executor&& st, chain::controller& controller,
               std::optional<log_catalog>& trace_log, std::optional<log_catalog>& chain_state_log, std::optional<log_catalog>& finality_data_log,
+              chain::block_num_type flushed_block_num, log_entry_cache& entry_cache,
               GetBlockID&& get_block_id, GetBlock&& get_block, OnDone&& on_done, fc::logger& logger) :
-    strand(std::move(st)), stream(std::move(s)), wake_timer(strand), controller(controller),
-    trace_log(trace_log), chain_state_log(chain_state_log), finality_data_log(finality_data_log),
+    strand(std::move(st)), stream(std::move(s)), wake_timer(strand), flushed_block_num(flushed_block_num), controller(controller),
+    trace_log(trace_log), chain_state_log(chain_state_log), finality_data_log(finality_data_log), entry_cache(entry_cache),
     get_block_id(get_block_id), get_block(get_block), on_done(on_done), logger(logger), remote_endpoint_string(get_remote_endpoint_string()) {
       fc_ilog(logger, "incoming state history connection from ${a}", ("a", remote_endpoint_string));
 
@@ -50,6 +58,7 @@ public:
       //indicates a fork being applied for already-sent blocks; rewind the cursor
       if(applied_block_num < next_block_cursor)
          next_block_cursor = applied_block_num;
+      flushed_block_num = applied_block_num;
       awake_if_idle();
    }
 
@@ -147,11 +156,21 @@ private:
                   [&self]<typename GetStatusRequestV0orV1, typename = std::enable_if_t<std::is_base_of_v<get_status_request_v0, GetStatusRequestV0orV1>>>(const GetStatusRequestV0orV1&) {
                      self.queued_status_requests.emplace_back(std::is_same_v<GetStatusRequestV0orV1, get_status_request_v1>);
                   },
-                  [&self]<typename GetBlocksRequestV0orV1, typename = std::enable_if_t<std::is_base_of_v<get_blocks_request_v0, GetBlocksRequestV0orV1>>>(const GetBlocksRequestV0orV1& gbr) {
+                  [&self]<typename GetBlocksRequestV0toV3, typename = std::enable_if_t<std::is_base_of_v<get_blocks_request_v0, GetBlocksRequestV0toV3>>>(const GetBlocksRequestV0toV3& gbr) {
                      self.current_blocks_request_v1_finality.reset();
+                     self.current_blocks_request_max_blocks = 0;
+                     self.current_filter.reset();
                      self.current_blocks_request = gbr;
-                     if constexpr(std::is_same_v<GetBlocksRequestV0orV1, get_blocks_request_v1>)
+                     if constexpr(std::is_base_of_v<get_blocks_request_v1, GetBlocksRequestV0toV3>)
                         self.current_blocks_request_v1_finality = gbr.fetch_finality_data;
+                     if constexpr(std::is_base_of_v<get_blocks_request_v2, GetBlocksRequestV0toV3>) {
+                        self.current_blocks_request_max_blocks = std::clamp(gbr.max_blocks_per_message, 1u, max_blocks_per_message_limit);
+                        self.current_blocks_request_max_bytes = gbr.max_message_bytes ? gbr.max_message_bytes : default_max_message_bytes;
+                     }
+                     if constexpr(std::is_same_v<GetBlocksRequestV0toV3, get_blocks_request_v3>) {
+                        if(gbr.delta_filters.size() || gbr.trace_filters.size())
+                           self.current_filter = std::make_shared<const log_entry_filter>(gbr.delta_filters, gbr.trace_filters);
+                     }
 
                      for(const block_position& haveit : self.current_blocks_request.have_positions) {
                         if(self.current_blocks_request.start_block_num <= haveit.block_num)
@@ -189,9 +208,88 @@ private:
       return ret;
    }
 
-   boost::asio::awaitable<void> write_log_entry(std::optional<ship_log_entry>& log_stream) {
+   /// pieces of a result message that are sent together with a single write once flushed
+   struct gathered_buffers {
+      std::vector<boost::asio::const_buffer>  buffers;
+      std::deque<std::vector<char>>           owned;    //deque so that appending never moves the storage buffers point in to
+      std::vector<log_entry_cache::entry_ptr> entries;
+      size_t                                  size = 0;
+
+      void append(std::vector<char>&& v) {
+         size += v.size();
+         buffers.emplace_back(boost::asio::buffer(owned.emplace_back(std::move(v))));
+      }
+      void append(log_entry_cache::entry_ptr e) {
+         size += e->size();
+         buffers.emplace_back(boost::asio::buffer(*e));
+         entries.emplace_back(std::move(e));
+      }
+      void clear() {
+         buffers.clear();
+         owned.clear();
+         entries.clear();
+         size = 0;
+      }
+   };
+
+   boost::asio::awaitable<void> flush(gathered_buffers& gathered, bool fin) {
+      if(gathered.buffers.empty() && !fin)
+         co_return;
+      co_await stream.async_write_some(fin, gathered.buffers);
+      gathered.clear();
+   }
+
+   //entries small enough to be cached are decompressed in full and shared with every other session sending the same block;
+   //  returns nullptr for entries that are not cacheable. keyed by the id in the entry's own header since the log may
+   //  have been rewritten by a fork after the id of the block being sent was looked up
+   log_entry_cache::entry_ptr get_cached_entry(ship_log_entry& log_stream, log_type type) {
+      if(!entry_cache.enabled() || !log_stream.uncompressed_size || *log_stream.uncompressed_size > entry_cache.max_entry_size())
+         return nullptr;
+
+      log_entry_cache::entry_ptr entry = entry_cache.find(type, log_stream.block_id);
+      if(!entry) {
+         auto decompressed = std::make_shared<std::vector<char>>();
+         decompressed->reserve(*log_stream.uncompressed_size);
+         bio::filtering_istreambuf decompression_stream = log_stream.get_stream();
+         bio::copy(decompression_stream, bio::back_inserter(*decompressed));
+         entry = std::move(decompressed);
+         entry_cache.insert(type, log_stream.block_id, entry);
+      }
+      return entry;
+   }
+
+   boost::asio::awaitable<void> write_log_entry(gathered_buffers& gathered, std::optional<ship_log_entry>& log_stream, log_type type,
+                                                const log_entry_filter* filter) {
       if(!log_stream) { //will be unset if either request did not ask for this log entry, or the log isn't enabled
-         co_await stream.async_write_some(false, boost::asio::buffer(fc::raw::pack(false)));
+         gathered.append(fc::raw::pack(false));
+         co_return;
+      }
+
+      log_entry_cache::entry_ptr entry = get_cached_entry(*log_stream, type);
+
+      //filtered entries are read from the cached entry when there is one, otherwise streamed from the log
+      if(filter && filter->filters(type)) {
+         std::vector<char> filtered;
+         if(entry) {
+            bio::stream_buffer<bio::array_source> entry_buf(entry->data(), entry->size());
+            filtered = filter->apply(type, entry_buf);
+         } else {
+            bio::filtering_istreambuf decompression_stream = log_stream->get_stream();
+            filtered = filter->apply(type, decompression_stream);
+         }
+         entry = std::make_shared<const std::vector<char>>(std::move(filtered));
+      }
+
+      if(entry) {
+         std::vector<char> head(16);
+         fc::datastream<char*> ds(head.data(), head.size());
+         fc::raw::pack(ds, true);
+         history_pack_varuint64(ds, entry->size());
+         head.resize(ds.tellp());
+         gathered.append(std::move(head));
+         gathered.append(std::move(entry));
+         if(gathered.size >= max_gathered_bytes)
+            co_await flush(gathered, false);
          co_return;
       }
 
@@ -199,7 +297,8 @@ private:
       fc::datastream<char*> ds(buff, sizeof(buff));
       fc::raw::pack(ds, true);
       history_pack_varuint64(ds, log_stream->get_uncompressed_size());
-      co_await stream.async_write_some(false, boost::asio::buffer(buff, ds.tellp()));
+      gathered.append(std::vector<char>(buff, buff + ds.tellp()));
+      co_await flush(gathered, false);
 
       bio::filtering_istreambuf decompression_stream = log_stream->get_stream();
       std::streamsize red = 0;
@@ -215,10 +314,18 @@ private:
          get_status_result_v1 current_status_result;
          struct block_package {
             get_blocks_result_base blocks_result_base;
-            bool is_v1_request = false;
             std::optional<ship_log_entry> trace_entry;
             std::optional<ship_log_entry> state_entry;
             std::optional<ship_log_entry> finality_entry;
+
+            //approximate contribution to the result message, used to bound batched messages
+            uint64_t estimated_size() {
+               auto entry_size = [](const std::optional<ship_log_entry>& e) -> uint64_t {
+                  return e ? e->uncompressed_size.value_or(e->compressed_data_size) : 0;
+               };
+               return (blocks_result_base.block ? blocks_result_base.block->size() : 0) +
+                      entry_size(trace_entry) + entry_size(state_entry) + entry_size(finality_entry);
+            }
          };
 
          while(true) {
@@ -226,7 +333,9 @@ private:
                break;
 
             std::deque<bool>             status_requests;
-            std::optional<block_package> block_to_send;
+            std::vector<block_package>   blocks_to_send;        //more than one only for a v2 request
+            unsigned                     blocks_result_version = 0;
+            std::shared_ptr<const log_entry_filter> filter;
 
             auto& self = *this; //gcc10 ICE workaround wrt capturing 'this' in a coro
             co_await boost::asio::co_spawn(app().get_io_service(), [&]() -> boost::asio::awaitable<void> {
@@ -236,36 +345,45 @@ private:
                status_requests = std::move(self.queued_status_requests);
 
                //decide what block -- if any -- to send out
-               const chain::block_num_type latest_to_consider = self.current_blocks_request.irreversible_only ?
-                                                                self.controller.last_irreversible_block_num() : self.controller.head().block_num();
-               if(self.send_credits && self.next_block_cursor <= latest_to_consider && self.next_block_cursor < self.current_blocks_request.end_block_num) {
-                  block_to_send.emplace( block_package{
+               //blocks still being written to the logs by the writer thread are not considered yet
+               const chain::block_num_type latest_to_consider = std::min(self.flushed_block_num, self.current_blocks_request.irreversible_only ?
+                                                                self.controller.last_irreversible_block_num() : self.controller.head().block_num());
+               blocks_result_version = self.current_blocks_request_max_blocks ? 2 : self.current_blocks_request_v1_finality ? 1 : 0;
+               filter = self.current_filter;
+               //a v2 request packs as many blocks as are available in to one message, up to its block and byte limits
+               const uint32_t max_blocks = std::max(self.current_blocks_request_max_blocks, 1u);
+               uint64_t message_bytes = 0;
+               while(self.send_credits && blocks_to_send.size() < max_blocks && message_bytes < self.current_blocks_request_max_bytes &&
+                     self.next_block_cursor <= latest_to_consider && self.next_block_cursor < self.current_blocks_request.end_block_num) {
+                  block_package& block_to_send = blocks_to_send.emplace_back( block_package{
                      .blocks_result_base = {
                         .head = {self.controller.head().block_num(), self.controller.head().id()},
                         .last_irreversible = {self.controller.last_irreversible_block_num(), self.controller.last_irreversible_block_id()}
-                     },
-                     .is_v1_request = self.current_blocks_request_v1_finality.has_value()
+                     }
                   });
                   if(const std::optional<chain::block_id_type> this_block_id = self.get_block_id(self.next_block_cursor)) {
-                     block_to_send->blocks_result_base.this_block  = {self.current_blocks_request.start_block_num, *this_block_id};
+                     block_to_send.blocks_result_base.this_block  = {self.current_blocks_request.start_block_num, *this_block_id};
                      if(const std::optional<chain::block_id_type> last_block_id = self.get_block_id(self.next_block_cursor - 1))
-                        block_to_send->blocks_result_base.prev_block = {self.next_block_cursor - 1, *last_block_id};
+                        block_to_send.blocks_result_base.prev_block = {self.next_block_cursor - 1, *last_block_id};
                      if (self.current_blocks_request.fetch_block) {
                         if (chain::signed_block_ptr sbp = get_block(*this_block_id)) {
-                           block_to_send->blocks_result_base.block = fc::raw::pack(*sbp);
+                           block_to_send.blocks_result_base.block = fc::raw::pack(*sbp);
                         }
                      }
                      if(self.current_blocks_request.fetch_traces && self.trace_log)
-                        block_to_send->trace_entry = self.trace_log->get_entry(self.next_block_cursor);
+                        block_to_send.trace_entry = self.trace_log->get_entry(self.next_block_cursor);
                      if(self.current_blocks_request.fetch_deltas && self.chain_state_log)
-                        block_to_send->state_entry = self.chain_state_log->get_entry(self.next_block_cursor);
-                     if(block_to_send->is_v1_request && *self.current_blocks_request_v1_finality && self.finality_data_log)
-                        block_to_send->finality_entry = self.finality_data_log->get_entry(self.next_block_cursor);
+                        block_to_send.state_entry = self.chain_state_log->get_entry(self.next_block_cursor);
+                     if(blocks_result_version >= 1 && *self.current_blocks_request_v1_finality && self.finality_data_log)
+                        block_to_send.finality_entry = self.finality_data_log->get_entry(self.next_block_cursor);
                   }
+                  message_bytes += block_to_send.estimated_size();
                   // increment next_block_cursor even if unable to retrieve block to avoid tight busy loop
                   ++self.next_block_cursor;
-                  --self.send_credits;
                }
+               //credits are per message, regardless of how many blocks it carries
+               if(blocks_to_send.size())
+                  --self.send_credits;
 
                if(status_requests.size())
                   current_status_result = fill_current_status_result();
@@ -273,7 +391,7 @@ private:
             }, boost::asio::use_awaitable);
 
             //if there is nothing to send, go to sleep
-            if(status_requests.empty() && !block_to_send) {
+            if(status_requests.empty() && blocks_to_send.empty()) {
                co_await wake_timer.async_wait();
                continue;
             }
@@ -286,25 +404,35 @@ private:
                   co_await stream.async_write(boost::asio::buffer(fc::raw::pack(state_result(current_status_result))));
             }
 
-            //and then send the block
-            if(block_to_send) {
-               const fc::unsigned_int get_blocks_result_variant_index = block_to_send->is_v1_request ?
-                                                                        state_result(get_blocks_result_v1()).index() :
-                                                                        state_result(get_blocks_result_v0()).index();
-               co_await stream.async_write_some(false, boost::asio::buffer(fc::raw::pack(get_blocks_result_variant_index)));
-               co_await stream.async_write_some(false, boost::asio::buffer(fc::raw::pack(block_to_send->blocks_result_base)));
-
-               co_await write_log_entry(block_to_send->trace_entry);
-               co_await write_log_entry(block_to_send->state_entry);
-               if(block_to_send->is_v1_request)
-                  co_await write_log_entry(block_to_send->finality_entry);
+            //and then send the block(s); a v2 result is the vector of v1 results, so each block is laid out as a v1 result
+            if(blocks_to_send.size()) {
+               gathered_buffers gathered;
+               const fc::unsigned_int get_blocks_result_variant_index = blocks_result_version == 2 ? state_result(get_blocks_result_v2()).index() :
+                                                                        blocks_result_version == 1 ? state_result(get_blocks_result_v1()).index() :
+                                                                                                     state_result(get_blocks_result_v0()).index();
+               gathered.append(fc::raw::pack(get_blocks_result_variant_index));
+               if(blocks_result_version == 2)
+                  gathered.append(fc::raw::pack(fc::unsigned_int(blocks_to_send.size())));
+
+               for(block_package& block_to_send : blocks_to_send) {
+                  gathered.append(fc::raw::pack(block_to_send.blocks_result_base));
+
+                  co_await write_log_entry(gathered, block_to_send.trace_entry, log_type::trace, filter.get());
+                  co_await write_log_entry(gathered, block_to_send.state_entry, log_type::chain_state, filter.get());
+                  if(blocks_result_version >= 1)
+                     co_await write_log_entry(gathered, block_to_send.finality_entry, log_type::finality_data, filter.get());
+               }
 
-               co_await stream.async_write_some(true, boost::asio::const_buffer());
+               co_await flush(gathered, true);
             }
          }
       });
    }
 
+   static constexpr uint32_t max_blocks_per_message_limit = 1000;
+   static constexpr uint64_t default_max_message_bytes    = 4*1024*1024;
+   static constexpr size_t   max_gathered_bytes           = 1024*1024;
+
 private:
    ///these items must only ever be touched by the session's strand
    Executor                          strand;
@@ -317,15 +445,20 @@ private:
    std::deque<bool>                  queued_status_requests;  //false for v0, true for v1
 
    get_blocks_request_v0             current_blocks_request;
-   std::optional<bool>               current_blocks_request_v1_finality; //unset: current request is v0; set means v1; true/false is if finality requested
+   std::optional<bool>               current_blocks_request_v1_finality; //unset: current request is v0; set means v1 or v2; true/false is if finality requested
+   uint32_t                          current_blocks_request_max_blocks = 0; //0: current request is v0 or v1, one block per message
+   uint64_t                          current_blocks_request_max_bytes = default_max_message_bytes;
+   std::shared_ptr<const log_entry_filter> current_filter;  //set for a v3 request with filters
    //current_blocks_request is modified with the current state; bind some more descriptive names to items frequently used
    uint32_t&                         send_credits = current_blocks_request.max_messages_in_flight;
    chain::block_num_type&            next_block_cursor = current_blocks_request.start_block_num;
+   chain::block_num_type             flushed_block_num;  //most recent block whose state history has been completely written
 
    chain::controller&                controller;
    std::optional<log_catalog>&       trace_log;
    std::optional<log_catalog>&       chain_state_log;
    std::optional<log_catalog>&       finality_data_log;
+   log_entry_cache&                  entry_cache;  //shared by all sessions, thread safe
 
    GetBlockID                        get_block_id;
    GetBlock                          get_block;
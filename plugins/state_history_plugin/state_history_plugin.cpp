@@ -16,10 +16,13 @@
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 
+#include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/signals2/connection.hpp>
+#include <condition_variable>
 #include <mutex>
 
 #include <fc/network/listener.hpp>
+#include <fc/scoped_exit.hpp>
 
 namespace eosio {
 using namespace chain;
@@ -62,6 +65,22 @@ private:
 
    named_thread_pool<struct ship>   thread_pool;
 
+   //entries are packed on the main thread but compressed and appended to the logs on this thread. sessions are only told
+   // about a block once all of its entries have been written, tracked via flushed_block_num (main thread only)
+   named_thread_pool<struct shipwr> write_thread;
+   std::mutex                       write_queue_mtx;
+   std::condition_variable          write_queue_cv;
+   uint32_t                         write_queue_size = 0;        //protected by write_queue_mtx
+   uint32_t                         max_write_queue_size = 0;
+   std::atomic<bool>                write_failed = false;
+   chain::block_num_type            flushed_block_num = 0;
+   bool                             chain_state_queued = false;  //main thread only; an initial state entry has been queued
+   std::optional<block_id_type>     writing_chain_previous_id;   //writer thread only; controller's id of the block before the one written
+
+   std::optional<log_entry_cache>   entry_cache;
+   std::atomic<uint64_t>            entry_cache_hits = 0;
+   std::atomic<uint64_t>            entry_cache_misses = 0;
+
    struct connection_map_key_less {
       using is_transparent = void;
       template<typename L, typename R> bool operator()(const L& lhs, const R& rhs) const {
@@ -104,7 +123,7 @@ public:
       fc::create_listener<Protocol>(app().get_io_service(), _log, accept_timeout, address, "", [this](Protocol::socket&& socket) {
          catch_and_log([this, &socket]() {
             connections.emplace(new session(std::move(socket), boost::asio::make_strand(thread_pool.get_executor()), chain_plug->chain(),
-                                            trace_log, chain_state_log, finality_data_log,
+                                            trace_log, chain_state_log, finality_data_log, flushed_block_num, *entry_cache,
                                             [this](const chain::block_num_type block_num) {
                                                return get_block_id(block_num);
                                             },
@@ -138,9 +157,14 @@ public:
 
    void on_accepted_block(const signed_block_ptr& block, const block_id_type& id) {
       try {
-         store_traces(block, id);
-         store_chain_state(id, block->previous, block->block_num());
-         store_finality_data(id, block->previous);
+         EOS_ASSERT(!write_failed, chain::plugin_exception, "State history failed writing a previous block");
+         std::vector<write_task> tasks;
+         store_traces(block, id, tasks);
+         store_chain_state(id, block->previous, block->block_num(), tasks);
+         store_finality_data(id, block->previous, tasks);
+         queue_write(block->block_num(), std::move(tasks));
+         app().get_channel<plugin_interface::channels::state_history_entry_cache>().publish(appbase::priority::low,
+            plugin_interface::state_history_entry_cache_stats{.hits = entry_cache_hits.load(), .misses = entry_cache_misses.load()});
       } catch(const fc::exception& e) {
          fc_elog(_log, "fc::exception: ${details}", ("details", e.to_detail_string()));
          // Both app().quit() and exception throwing are required. Without app().quit(),
@@ -152,9 +176,78 @@ public:
              "State history encountered an Error which it cannot recover from.  Please resolve the error and relaunch "
              "the process");
       }
+   }
+
+   using write_task = std::function<void()>;
+
+   template <typename F>
+   static std::vector<char> pack_entry(F&& pack_to) {
+      std::vector<char> uncompressed;
+      bio::filtering_ostreambuf buf(bio::back_inserter(uncompressed));
+      pack_to(buf);
+      bio::close(buf);
+      return uncompressed;
+   }
+
+   static write_task make_write_task(log_catalog& log, const block_id_type& id, const block_id_type& previous_id, std::vector<char>&& uncompressed) {
+      return [&log, id, previous_id, uncompressed = std::move(uncompressed)]() {
+         log.write_entry(id, previous_id, compress_entry(log.get_compression(), uncompressed));
+      };
+   }
+
+   // called on the main thread; blocks while the writer thread is max_write_queue_size blocks behind
+   void queue_write(block_num_type block_num, std::vector<write_task>&& tasks) {
+      {
+         std::unique_lock lk(write_queue_mtx);
+         write_queue_cv.wait(lk, [&]() { return write_queue_size < max_write_queue_size || write_failed; });
+         EOS_ASSERT(!write_failed, chain::plugin_exception, "State history failed writing a previous block");
+         ++write_queue_size;
+      }
+
+      //the controller is only consulted here, on the main thread, for the fork check of an entry none of the logs precede
+      std::optional<block_id_type> chain_previous_id;
+      try {
+         chain_previous_id = chain_plug->chain().chain_block_id_for_num(block_num - 1);
+      } catch(...) {
+      }
+
+      boost::asio::post(write_thread.get_executor(), [this, block_num, chain_previous_id, tasks = std::move(tasks)]() {
+         try {
+            writing_chain_previous_id = chain_previous_id;
+            auto reset = fc::make_scoped_exit([this]() { writing_chain_previous_id.reset(); });
+            //once a write has failed nothing later may be appended, the logs would no longer line up
+            if(!write_failed)
+               for(const write_task& t : tasks)
+                  t();
+         } catch(const fc::exception& e) {
+            fc_elog(_log, "Unable to write state history for block ${n}: ${details}", ("n", block_num)("details", e.to_detail_string()));
+            write_failed = true;
+         } catch(const std::exception& e) {
+            fc_elog(_log, "Unable to write state history for block ${n}: ${details}", ("n", block_num)("details", e.what()));
+            write_failed = true;
+         }
+
+         {
+            std::lock_guard g(write_queue_mtx);
+            --write_queue_size;
+         }
+         write_queue_cv.notify_all();
+
+         if(write_failed) {
+            appbase::app().quit();
+            return;
+         }
+         boost::asio::post(app().get_io_service(), [this, block_num]() {
+            flushed_block_num = block_num;
+            for(const std::unique_ptr<session_base>& c : connections)
+               c->block_applied(block_num);
+         });
+      });
+   }
 
-      for(const std::unique_ptr<session_base>& c : connections)
-         c->block_applied(block->block_num());
+   void wait_for_writes() {
+      std::unique_lock lk(write_queue_mtx);
+      write_queue_cv.wait(lk, [&]() { return write_queue_size == 0; });
    }
 
    void on_block_start(uint32_t block_num) {
@@ -166,41 +259,58 @@ public:
       trace_converter.onblock_trace.reset();
    }
 
-   void store_traces(const signed_block_ptr& block, const block_id_type& id) {
+   void store_traces(const signed_block_ptr& block, const block_id_type& id, std::vector<write_task>& tasks) {
       if(!trace_log)
          return;
 
-      trace_log->pack_and_write_entry(id, block->previous, [this, &block](bio::filtering_ostreambuf& buf) {
+      tasks.emplace_back(make_write_task(*trace_log, id, block->previous, pack_entry([this, &block](bio::filtering_ostreambuf& buf) {
          trace_converter.pack(buf, trace_debug_mode, block);
-      });
+      })));
    }
 
-   void store_chain_state(const block_id_type& id, const block_id_type& previous_id, uint32_t block_num) {
+   void store_chain_state(const block_id_type& id, const block_id_type& previous_id, uint32_t block_num, std::vector<write_task>& tasks) {
       if(!chain_state_log)
          return;
-      bool fresh = chain_state_log->empty();
+      //the log may not show the initial state yet when it is still queued for writing
+      bool fresh = !chain_state_queued && chain_state_log->empty();
       if(fresh)
          fc_ilog(_log, "Placing initial state in block ${n}", ("n", block_num));
+      chain_state_queued = true;
 
-      chain_state_log->pack_and_write_entry(id, previous_id, [this, fresh](bio::filtering_ostreambuf& buf) {
+      tasks.emplace_back(make_write_task(*chain_state_log, id, previous_id, pack_entry([this, fresh](bio::filtering_ostreambuf& buf) {
          pack_deltas(buf, chain_plug->chain().db(), fresh);
-      });
+      })));
    } // store_chain_state
 
-   void store_finality_data(const block_id_type& id, const block_id_type& previous_id) {
+   void store_finality_data(const block_id_type& id, const block_id_type& previous_id, std::vector<write_task>& tasks) {
       if(!finality_data_log)
          return;
 
       std::optional<finality_data_t> finality_data = chain_plug->chain().head_finality_data();
       if(!finality_data.has_value()) {
-         finality_data_log->clear();
+         tasks.emplace_back([this]() { finality_data_log->clear(); });
          return;
       }
 
-      finality_data_log->pack_and_write_entry(id, previous_id, [finality_data](bio::filtering_ostreambuf& buf) {
+      tasks.emplace_back(make_write_task(*finality_data_log, id, previous_id, pack_entry([&finality_data](bio::filtering_ostreambuf& buf) {
          fc::datastream<boost::iostreams::filtering_ostreambuf&> ds{buf};
          fc::raw::pack(ds, *finality_data);
-      });
+      })));
+   }
+
+   // the logs consult each other for the id of the block preceding a newly written entry. this runs on the writer thread
+   // with the writing log locked, so neither the writing log itself nor the (not thread safe) controller may be consulted;
+   // the controller's id of the preceding block is instead taken by queue_write() on the main thread
+   std::optional<chain::block_id_type> get_block_id_from_other_logs(const std::optional<log_catalog>& writing_log, block_num_type block_num) {
+      for(std::optional<log_catalog>* l : {&trace_log, &chain_state_log, &finality_data_log}) {
+         if(&writing_log == l || !*l)
+            continue;
+         if(std::optional<block_id_type> id = (*l)->get_block_id(block_num))
+            return id;
+      }
+      if(writing_chain_previous_id && block_header::num_from_id(*writing_chain_previous_id) == block_num)
+         return writing_chain_previous_id;
+      return {};
    }
 }; // state_history_plugin_impl
 
@@ -239,6 +349,20 @@ void state_history_plugin::set_program_options(options_description& cli, options
            "the path (relative to data-dir) to create a unix socket upon which to listen for incoming connections.");
    options("trace-history-debug-mode", bpo::bool_switch()->default_value(false), "enable debug mode for trace history");
    options("state-history-log-retain-blocks", bpo::value<uint32_t>(), "if set, periodically prune the state history files to store only configured number of most recent blocks");
+   options("state-history-write-queue-size", bpo::value<uint32_t>()->default_value(32),
+           "the maximum number of blocks whose state history may be waiting to be compressed and written to the logs by the\n"
+           "state history writer thread. Block application waits when the queue is full.");
+   options("state-history-entry-cache-size-mb", bpo::value<uint32_t>()->default_value(128),
+           "the size (in MiB) of the cache of decompressed state history entries shared by all connected clients, 0 to disable");
+   options("state-history-compression", bpo::value<string>()->default_value("zlib"),
+           "codec new state history log entries are compressed with: \"zlib\" or \"zstd\" (if supported by this build).\n"
+           "Existing zlib entries remain readable when changing the codec.");
+   options("state-history-zstd-level", bpo::value<int>()->default_value(log_compression::default_zstd_level),
+           "the zstd compression level for state history log entries");
+   options("state-history-zstd-dictionary", bpo::value<std::filesystem::path>(),
+           "a zstd dictionary, as created by 'zstd --train' from table deltas, used to compress the chain state history log\n"
+           "entries. Trace and finality data entries are compressed without it. It must remain configured for as long as\n"
+           "the chain state history log contains entries compressed with it.");
 }
 
 void state_history_plugin_impl::plugin_initialize(const variables_map& options) {
@@ -292,6 +416,13 @@ void state_history_plugin_impl::plugin_initialize(const variables_map& options)
          trace_debug_mode = true;
       }
 
+      entry_cache.emplace(uint64_t(options.at("state-history-entry-cache-size-mb").as<uint32_t>()) * 1024*1024);
+      entry_cache->on_hit = [this]() { ++entry_cache_hits; };
+      entry_cache->on_miss = [this]() { ++entry_cache_misses; };
+
+      max_write_queue_size = options.at("state-history-write-queue-size").as<uint32_t>();
+      EOS_ASSERT(max_write_queue_size > 0, plugin_exception, "state-history-write-queue-size must be greater than 0");
+
       bool has_state_history_partition_options =
           options.count("state-history-retained-dir") || options.count("state-history-archive-dir") ||
           options.count("state-history-stride") || options.count("max-retained-history-files");
@@ -317,12 +448,31 @@ void state_history_plugin_impl::plugin_initialize(const variables_map& options)
             config.max_retained_files = options.at("max-retained-history-files").as<uint32_t>();
       }
 
+      log_compression compression;        // trace and finality data logs
+      log_compression deltas_compression; // chain state log, the only one compressed with the dictionary
+      const string codec = options.at("state-history-compression").as<string>();
+      if(codec == "zstd") {
+         std::filesystem::path dictionary;
+         if(options.count("state-history-zstd-dictionary")) {
+            dictionary = options.at("state-history-zstd-dictionary").as<std::filesystem::path>();
+            if(dictionary.is_relative())
+               dictionary = app().config_dir() / dictionary;
+         }
+         EOS_ASSERT(log_compression::zstd_available(), plugin_exception, "state-history-compression=zstd is not supported by this build");
+         const int level = options.at("state-history-zstd-level").as<int>();
+         compression = log_compression(log_codec::zstd, level);
+         deltas_compression = log_compression(log_codec::zstd, level, dictionary);
+      } else {
+         EOS_ASSERT(codec == "zlib", plugin_exception, "unknown state-history-compression ${c}", ("c", codec));
+         EOS_ASSERT(!options.count("state-history-zstd-dictionary"), plugin_exception, "state-history-zstd-dictionary requires state-history-compression=zstd");
+      }
+
       if(options.at("trace-history").as<bool>())
-         trace_log.emplace(state_history_dir, ship_log_conf, "trace_history", [this](chain::block_num_type bn) {return get_block_id(bn);});
+         trace_log.emplace(state_history_dir, ship_log_conf, "trace_history", [this](chain::block_num_type bn) {return get_block_id_from_other_logs(trace_log, bn);}, compression);
       if(options.at("chain-state-history").as<bool>())
-         chain_state_log.emplace(state_history_dir, ship_log_conf, "chain_state_history", [this](chain::block_num_type bn) {return get_block_id(bn);});
+         chain_state_log.emplace(state_history_dir, ship_log_conf, "chain_state_history", [this](chain::block_num_type bn) {return get_block_id_from_other_logs(chain_state_log, bn);}, deltas_compression);
       if(options.at("finality-data-history").as<bool>())
-         finality_data_log.emplace(state_history_dir, ship_log_conf, "finality_data_history", [this](chain::block_num_type bn) {return get_block_id(bn);});
+         finality_data_log.emplace(state_history_dir, ship_log_conf, "finality_data_history", [this](chain::block_num_type bn) {return get_block_id_from_other_logs(finality_data_log, bn);}, compression);
    }
    FC_LOG_AND_RETHROW()
 } // state_history_plugin::plugin_initialize
@@ -336,10 +486,19 @@ void state_history_plugin_impl::plugin_startup() {
    try {
       const auto& chain = chain_plug->chain();
 
+      write_thread.start(1, [](const fc::exception& e) {
+         fc_elog( _log, "Exception in SHiP writer thread, exiting: ${e}", ("e", e.to_detail_string()) );
+         app().quit();
+      });
+
       uint32_t block_num = chain.head().block_num();
+      flushed_block_num = block_num;
       if( block_num > 0 && chain_state_log && chain_state_log->empty() ) {
          fc_ilog( _log, "Storing initial state on startup, this can take a considerable amount of time" );
-         store_chain_state( chain.head().id(), chain.head().header().previous, block_num );
+         std::vector<write_task> tasks;
+         store_chain_state( chain.head().id(), chain.head().header().previous, block_num, tasks );
+         queue_write( block_num, std::move(tasks) );
+         wait_for_writes();
          fc_ilog( _log, "Done storing initial state on startup" );
       }
       first_available_block = chain.earliest_available_block_num();
@@ -378,6 +537,9 @@ void state_history_plugin_impl::plugin_shutdown() {
    applied_transaction_connection.reset();
    accepted_block_connection.reset();
    block_start_connection.reset();
+   //everything already accepted is still written out before the logs are closed
+   wait_for_writes();
+   write_thread.stop();
    thread_pool.stop();
 }
 
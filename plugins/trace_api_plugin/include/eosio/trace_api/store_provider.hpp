@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ios>
+#include <map>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -10,6 +11,7 @@
 #include <eosio/trace_api/metadata_log.hpp>
 #include <eosio/trace_api/data_log.hpp>
 #include <eosio/trace_api/compressed_file.hpp>
+#include <eosio/trace_api/trx_id_index.hpp>
 
 namespace eosio::trace_api {
 
@@ -201,6 +203,33 @@ namespace eosio::trace_api {
        */
       bool find_trx_id_slice(uint32_t slice_number, open_state state, fc::cfile& trx_id_file, bool open_file = true) const;
 
+      /**
+       * Find the sorted transaction id index of a sealed slice
+       *
+       * @param slice_number : slice number of the requested index
+       * @return the opened index if the slice has been sealed, otherwise an empty optional
+       */
+      std::optional<trx_id_index> find_trx_id_index(uint32_t slice_number) const;
+
+      /**
+       * Record transaction ids appended to an open trx id slice in that slice's bloom filter.  The first time a slice
+       * is seen, the filter is populated from any ids already in its file
+       *
+       * @param slice_number : slice number of the trx id slice the ids are appended to
+       * @param ids : the transaction ids
+       * @param trx_id_file : the trx id slice, positioned at its end
+       */
+      void add_to_trx_id_filter(uint32_t slice_number, const std::vector<chain::transaction_id_type>& ids, fc::cfile& trx_id_file);
+
+      /**
+       * Check the bloom filter of an open slice
+       *
+       * @param slice_number : slice number of the trx id slice
+       * @param trx_id : the transaction id to check
+       * @return false if the id is definitely not in the slice, true if it may be, empty if the slice has no filter
+       */
+      std::optional<bool> trx_id_filter_may_contain(uint32_t slice_number, const chain::transaction_id_type& trx_id) const;
+
       /**
        * set the LIB for maintenance
        * @param lib
@@ -247,6 +276,10 @@ namespace eosio::trace_api {
       const std::optional<uint32_t> _minimum_uncompressed_irreversible_history_blocks;
       std::optional<uint32_t> _last_compressed_slice;
       const size_t _compression_seek_point_stride;
+      std::optional<uint32_t> _last_indexed_slice;
+
+      mutable std::mutex _trx_id_filter_mtx;
+      std::map<uint32_t, trx_id_bloom_filter> _trx_id_filters; // bloom filters of the open (not yet indexed) slices
 
       std::mutex _maintenance_mtx;
       std::condition_variable _maintenance_condition;
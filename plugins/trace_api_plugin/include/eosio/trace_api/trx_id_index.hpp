@@ -0,0 +1,124 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace eosio::trace_api {
+
+   /**
+    * Sorted, read only index of the transaction ids of a sealed trx id slice. A slice is sealed once all of its blocks
+    * are irreversible, after which its trx id slice no longer changes. The index is memory mapped and searched in place
+    * so lookups are O(log n) and only touch the pages visited by the binary search.
+    *
+    * Each id maps to what a scan of the trx id slice alone would resolve it to: the block it was last recorded in, up to
+    * the first lib entry at or past that block, which makes the block final. To continue a scan started in an earlier
+    * slice, a record also holds the highest lib entry preceding the first time its id was recorded, and the header the
+    * highest lib entry of the slice.
+    *
+    * File layout: header followed by `count` records of a 32 byte transaction id, a uint32_t block number, a uint32_t lib
+    * and a uint8_t irreversible flag, sorted by id.
+    */
+   class trx_id_index {
+   public:
+      struct header {
+         uint32_t magic   = 0;
+         uint32_t version = 0;
+         uint64_t count   = 0;
+         uint32_t max_lib = 0;
+      };
+
+      struct entry {
+         uint32_t block_num = 0;
+         uint32_t lib_before_block = 0; ///< highest lib entry preceding the first block the id was recorded in
+         bool     irreversible = false; ///< a lib entry at or past block_num followed it, so later slices cannot change it
+      };
+
+      static constexpr uint32_t magic           = 0x58444954; // "TIDX"
+      static constexpr uint32_t current_version = 2;
+      static constexpr size_t   record_size     = sizeof(chain::transaction_id_type) + 2 * sizeof(uint32_t) + sizeof(uint8_t);
+
+      /**
+       * Open an existing index
+       *
+       * @param index_path : path of the index file
+       * @throws malformed_slice_file : when the file is not a valid index
+       */
+      explicit trx_id_index(const std::filesystem::path& index_path);
+
+      /**
+       * Find the block a transaction id resolves to within the slice
+       *
+       * @param trx_id : the transaction id to search for
+       * @return the entry, or an empty optional if the id is not in the index
+       */
+      std::optional<entry> find(const chain::transaction_id_type& trx_id) const;
+
+      uint64_t size() const { return _count; }
+
+      /// the highest lib entry of the slice
+      uint32_t max_lib() const { return _max_lib; }
+
+      /**
+       * Build the index for a trx id slice, writing it to a temporary file first so that readers never observe a
+       * partially written index
+       *
+       * @param trx_id_slice_path : path of the trx id slice to index
+       * @param index_path : path of the index file to create
+       */
+      static void build(const std::filesystem::path& trx_id_slice_path, const std::filesystem::path& index_path);
+
+   private:
+      boost::interprocess::file_mapping  _file;
+      boost::interprocess::mapped_region _region;
+      const char*                        _records = nullptr;
+      uint64_t                           _count = 0;
+      uint32_t                           _max_lib = 0;
+   };
+
+   /**
+    * Bloom filter of the transaction ids appended to a slice that is still open. Transaction ids are sha256 digests, so
+    * their words are used directly as the hash functions.
+    */
+   class trx_id_bloom_filter {
+   public:
+      static constexpr size_t   default_bits = 1 << 24;
+      static constexpr uint32_t num_hashes   = 4;
+
+      explicit trx_id_bloom_filter(size_t bits = default_bits) : _bits((bits + 63) / 64) {}
+
+      void add(const chain::transaction_id_type& trx_id) {
+         for(uint32_t i = 0; i < num_hashes; ++i) {
+            const size_t bit = bit_index(trx_id, i);
+            _bits[bit / 64] |= uint64_t(1) << (bit % 64);
+         }
+      }
+
+      /// false if the id was definitely never added
+      bool may_contain(const chain::transaction_id_type& trx_id) const {
+         for(uint32_t i = 0; i < num_hashes; ++i) {
+            const size_t bit = bit_index(trx_id, i);
+            if(!(_bits[bit / 64] & (uint64_t(1) << (bit % 64))))
+               return false;
+         }
+         return true;
+      }
+
+   private:
+      size_t bit_index(const chain::transaction_id_type& trx_id, uint32_t i) const {
+         // double hashing: h1 + i*h2
+         const uint64_t h = trx_id._hash[0] + i * (trx_id._hash[1] | 1);
+         return h % (_bits.size() * 64);
+      }
+
+      std::vector<uint64_t> _bits;
+   };
+
+}
+
+FC_REFLECT(eosio::trace_api::trx_id_index::header, (magic)(version)(count)(max_lib))
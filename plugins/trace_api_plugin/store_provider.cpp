@@ -10,6 +10,7 @@ namespace {
       static constexpr const char* _trace_trx_id_prefix = "trace_trx_id_";
       static constexpr const char* _trace_ext = ".log";
       static constexpr const char* _compressed_trace_ext = ".clog";
+      static constexpr const char* _trx_id_index_ext = ".idx";
       static constexpr int _max_filename_size = std::char_traits<char>::length(_trace_index_prefix) + 10 + 1 + 10 + std::char_traits<char>::length(_compressed_trace_ext) + 1; // "trace_index_" + 10-digits + '-' + 10-digits + ".clog" + null-char
 
       std::string make_filename(const char* slice_prefix, const char* slice_ext, uint32_t slice_number, uint32_t slice_width) {
@@ -66,6 +67,7 @@ namespace eosio::trace_api {
       fc::cfile trx_id_file;
       const uint32_t slice_number = _slice_directory.slice_number(tt.block_num);
       _slice_directory.find_or_create_trx_id_slice(slice_number, open_state::write, trx_id_file);
+      _slice_directory.add_to_trx_id_filter(slice_number, tt.ids, trx_id_file);
       auto entry = metadata_log_entry { std::move(tt) };
       append_store(entry, trx_id_file);
    }
@@ -110,10 +112,33 @@ namespace eosio::trace_api {
       uint32_t trx_block_num = 0; // number of the block that contains the target trx
       uint32_t trx_entries = 0;   // number of entries that contain the target trx
       while (true){
+         // sealed slices are answered by their sorted index, which resolves the id just as the scan below would
+         if (std::optional<trx_id_index> index = _slice_directory.find_trx_id_index(slice_number)) {
+            yield();
+            const std::optional<trx_id_index::entry> found = index->find(trx_id);
+            const uint32_t lib_before_found = found ? found->lib_before_block : index->max_lib();
+            if (trx_entries > 0 && lib_before_found >= trx_block_num)
+               return trx_block_num;
+            if (found) {
+               if (found->irreversible)
+                  return found->block_num;
+               trx_entries++;
+               trx_block_num = found->block_num;
+            }
+            slice_number++;
+            continue;
+         }
+
          const bool found = _slice_directory.find_trx_id_slice(slice_number, open_state::read, trx_id_file);
          if( !found )
             break; // traversed all slices
 
+         // skip scanning open slices which definitely do not contain the id
+         if (_slice_directory.trx_id_filter_may_contain(slice_number, trx_id) == false) {
+            slice_number++;
+            continue;
+         }
+
          metadata_log_entry entry;
          auto ds = trx_id_file.create_datastream();
          const uint64_t end = file_size(trx_id_file.get_file_path());
@@ -287,6 +312,51 @@ namespace eosio::trace_api {
       return true;
    }
 
+   std::optional<trx_id_index> slice_directory::find_trx_id_index(uint32_t slice_number) const {
+      const auto index_path = _slice_dir / make_filename(_trace_trx_id_prefix, _trx_id_index_ext, slice_number, _width);
+      if (!exists(index_path))
+         return {};
+      try {
+         return std::optional<trx_id_index>(std::in_place, index_path);
+      } catch (const boost::interprocess::interprocess_exception&) {
+         // removed by maintenance after the check above
+         return {};
+      } catch (const malformed_slice_file&) {
+         // e.g. written by an older version; the trx id slice it indexes is still there to be scanned
+         return {};
+      }
+   }
+
+   void slice_directory::add_to_trx_id_filter(uint32_t slice_number, const std::vector<chain::transaction_id_type>& ids, fc::cfile& trx_id_file) {
+      std::scoped_lock lock(_trx_id_filter_mtx);
+      auto [it, inserted] = _trx_id_filters.try_emplace(slice_number);
+      if (inserted) {
+         // first append to this slice since startup, pick up the ids that are already in the file
+         const uint64_t end = trx_id_file.tellp();
+         trx_id_file.seek(0);
+         auto ds = trx_id_file.create_datastream();
+         metadata_log_entry entry;
+         while (trx_id_file.tellp() < end) {
+            fc::raw::unpack(ds, entry);
+            if (std::holds_alternative<block_trxs_entry>(entry)) {
+               for (const auto& id : std::get<block_trxs_entry>(entry).ids)
+                  it->second.add(id);
+            }
+         }
+         trx_id_file.seek_end(0);
+      }
+      for (const auto& id : ids)
+         it->second.add(id);
+   }
+
+   std::optional<bool> slice_directory::trx_id_filter_may_contain(uint32_t slice_number, const chain::transaction_id_type& trx_id) const {
+      std::scoped_lock lock(_trx_id_filter_mtx);
+      auto it = _trx_id_filters.find(slice_number);
+      if (it == _trx_id_filters.end())
+         return {};
+      return it->second.may_contain(trx_id);
+   }
+
    void slice_directory::set_lib(uint32_t lib) {
       {
          std::scoped_lock lock(_maintenance_mtx);
@@ -377,6 +447,12 @@ namespace eosio::trace_api {
                log(std::string("Removing: ") + trx_id.get_file_path().generic_string());
                std::filesystem::remove(trx_id.get_file_path());
             }
+            auto trx_id_index_path = trx_id.get_file_path();
+            trx_id_index_path.replace_extension(_trx_id_index_ext);
+            if (exists(trx_id_index_path)) {
+               log(std::string("Removing: ") + trx_id_index_path.generic_string());
+               std::filesystem::remove(trx_id_index_path);
+            }
 
             auto ctrace = find_compressed_trace_slice(slice_to_clean, dont_open_file);
             if (ctrace) {
@@ -386,6 +462,25 @@ namespace eosio::trace_api {
          });
       }
 
+      // Seal every slice whose blocks are all irreversible with a sorted transaction id index.  Its trx id slice is kept
+      // as is, only the index is used for lookups from then on
+      process_irreversible_slice_range(lib, 0, _last_indexed_slice, [this, &log](uint32_t slice_to_index){
+         fc::cfile trx_id;
+         const bool dont_open_file = false;
+         if (!find_trx_id_slice(slice_to_index, open_state::read, trx_id, dont_open_file))
+            return;
+
+         auto index_path = trx_id.get_file_path();
+         index_path.replace_extension(_trx_id_index_ext);
+         if (!exists(index_path)) {
+            log(std::string("Indexing: ") + trx_id.get_file_path().generic_string());
+            trx_id_index::build(trx_id.get_file_path(), index_path);
+         }
+
+         std::scoped_lock lock(_trx_id_filter_mtx);
+         _trx_id_filters.erase(slice_to_index);
+      });
+
       // Only process compression if its configured AND there is a range of irreversible blocks which would not also
       // be deleted
       if (_minimum_uncompressed_irreversible_history_blocks &&
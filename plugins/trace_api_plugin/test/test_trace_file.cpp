@@ -210,6 +210,7 @@ namespace {
       }
       using store_provider::scan_metadata_log_from;
       using store_provider::read_data_log;
+      using store_provider::_slice_directory;
    };
 
    class vslice_datastream;
@@ -1067,4 +1068,74 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
    }
 
 
+   BOOST_FIXTURE_TEST_CASE(test_get_trx_block_number_indexed, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      test_store_provider sp(tempdir.path(), width);
+
+      auto make_id = [](uint64_t n) {
+         chain::transaction_id_type id;
+         id._hash[0] = n;
+         id._hash[3] = n * 7;
+         return id;
+      };
+
+      // slices 0 and 1 get 5 ids per block, lib trails by 3 blocks. one id of block 2 is recorded again in block 4 as if
+      // block 2 was forked out before becoming irreversible; one id of block 3 is recorded again in block 8, after block 3
+      // became irreversible
+      for (uint32_t block_num = 1; block_num < 2 * width; ++block_num) {
+         block_trxs_entry entry{ .block_num = block_num };
+         for (uint64_t i = 0; i < 5; ++i)
+            entry.ids.push_back(make_id(block_num * 5 + i));
+         if (block_num == 4)
+            entry.ids.push_back(make_id(2 * 5 + 3));
+         if (block_num == 8)
+            entry.ids.push_back(make_id(3 * 5 + 1));
+         sp.append_trx_ids(entry);
+         if (block_num > 3)
+            sp.append_lib(block_num - 3);
+      }
+
+      const auto id_in_slice_0 = make_id(4 * 5 + 1);
+      const auto forked_id = make_id(2 * 5 + 3);
+      const auto irreversible_id = make_id(3 * 5 + 1);
+      const auto id_in_slice_1 = make_id(15 * 5 + 2);
+      const auto missing_id = make_id(1000);
+
+      auto verify_lookups = [&]() {
+         BOOST_REQUIRE_EQUAL(sp.get_trx_block_number(id_in_slice_0, {}).value(), 4u);
+         BOOST_REQUIRE_EQUAL(sp.get_trx_block_number(forked_id, {}).value(), 4u);
+         BOOST_REQUIRE_EQUAL(sp.get_trx_block_number(irreversible_id, {}).value(), 3u);
+         BOOST_REQUIRE_EQUAL(sp.get_trx_block_number(id_in_slice_1, {}).value(), 15u);
+         BOOST_REQUIRE(!sp.get_trx_block_number(missing_id, {}));
+      };
+
+      // open slices, answered by scanning the trx id slices
+      BOOST_REQUIRE(!sp._slice_directory.find_trx_id_index(0));
+      BOOST_REQUIRE_EQUAL(sp._slice_directory.trx_id_filter_may_contain(1, id_in_slice_1).value(), true);
+      BOOST_REQUIRE_EQUAL(sp._slice_directory.trx_id_filter_may_contain(1, missing_id).value(), false);
+      verify_lookups();
+
+      // all of slice 0 is irreversible, so it is sealed with an index
+      sp._slice_directory.run_maintenance_tasks(2 * width - 1, {});
+      std::optional<trx_id_index> index = sp._slice_directory.find_trx_id_index(0);
+      BOOST_REQUIRE(index);
+      BOOST_REQUIRE_EQUAL(index->size(), (width - 1) * 5u);
+      BOOST_REQUIRE_EQUAL(index->find(id_in_slice_0).value().block_num, 4u);
+      BOOST_REQUIRE(index->find(id_in_slice_0).value().irreversible);
+      BOOST_REQUIRE_EQUAL(index->find(irreversible_id).value().block_num, 3u);
+      BOOST_REQUIRE_EQUAL(index->max_lib(), width - 1);
+      BOOST_REQUIRE(!index->find(missing_id));
+      BOOST_REQUIRE(!sp._slice_directory.find_trx_id_index(1));
+      verify_lookups();
+
+      // sealing slice 1 drops its bloom filter
+      sp._slice_directory.run_maintenance_tasks(3 * width - 1, {});
+      BOOST_REQUIRE(sp._slice_directory.find_trx_id_index(1));
+      BOOST_REQUIRE(!sp._slice_directory.trx_id_filter_may_contain(1, id_in_slice_1));
+      verify_lookups();
+   }
+
+
 BOOST_AUTO_TEST_SUITE_END()
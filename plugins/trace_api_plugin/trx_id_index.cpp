@@ -0,0 +1,132 @@
+#include <eosio/trace_api/trx_id_index.hpp>
+#include <eosio/trace_api/store_provider.hpp>
+
+#include <fc/io/cfile.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+   constexpr size_t header_size = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint32_t);
+   constexpr size_t id_size = sizeof(eosio::chain::transaction_id_type);
+
+   int compare_ids(const char* lhs, const char* rhs) {
+      return std::memcmp(lhs, rhs, id_size);
+   }
+}
+
+namespace eosio::trace_api {
+
+   trx_id_index::trx_id_index(const std::filesystem::path& index_path)
+   : _file(index_path.generic_string().c_str(), boost::interprocess::read_only)
+   , _region(_file, boost::interprocess::read_only) {
+      const char* const addr = static_cast<const char*>(_region.get_address());
+      const size_t size = _region.get_size();
+      if (size < header_size) {
+         throw malformed_slice_file("Transaction id index: " + index_path.generic_string() + " is too small to contain a header");
+      }
+
+      header h;
+      fc::datastream<const char*> ds(addr, size);
+      fc::raw::unpack(ds, h);
+      if (h.magic != magic || h.version != current_version) {
+         throw malformed_slice_file("Transaction id index: " + index_path.generic_string() + " has an unsupported version: " + std::to_string(h.version));
+      }
+      if (size != header_size + h.count * record_size) {
+         throw malformed_slice_file("Transaction id index: " + index_path.generic_string() + " size does not match its " + std::to_string(h.count) + " entries");
+      }
+
+      _records = addr + header_size;
+      _count = h.count;
+      _max_lib = h.max_lib;
+      // lookups are binary searches, readahead would only pull in pages that are never used
+      _region.advise(boost::interprocess::mapped_region::advice_random);
+   }
+
+   std::optional<trx_id_index::entry> trx_id_index::find(const chain::transaction_id_type& trx_id) const {
+      uint64_t lo = 0;
+      uint64_t hi = _count;
+      while (lo < hi) {
+         const uint64_t mid = lo + (hi - lo) / 2;
+         if (compare_ids(_records + mid * record_size, trx_id.data()) < 0)
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+      if (lo == _count || compare_ids(_records + lo * record_size, trx_id.data()) != 0)
+         return {};
+
+      const char* const record = _records + lo * record_size + id_size;
+      entry e;
+      std::memcpy(&e.block_num, record, sizeof(e.block_num));
+      std::memcpy(&e.lib_before_block, record + sizeof(uint32_t), sizeof(e.lib_before_block));
+      e.irreversible = record[2 * sizeof(uint32_t)] != 0;
+      return e;
+   }
+
+   void trx_id_index::build(const std::filesystem::path& trx_id_slice_path, const std::filesystem::path& index_path) {
+      // resolve every id just as the linear scan of the trx id slice does: an id recorded more than once (e.g. in a block
+      // that was later forked out) resolves to the block it was recorded in last, until a lib entry reaches that block
+      std::unordered_map<chain::transaction_id_type, entry> entries;
+      std::vector<chain::transaction_id_type> reversible; // ids whose entry a later lib entry may still make irreversible
+      header h { .magic = magic, .version = current_version };
+
+      fc::cfile slice;
+      slice.set_file_path(trx_id_slice_path);
+      slice.open("rb");
+      const uint64_t end = file_size(trx_id_slice_path);
+      auto ds = slice.create_datastream();
+      metadata_log_entry log_entry;
+      while (slice.tellp() < end) {
+         fc::raw::unpack(ds, log_entry);
+         if (std::holds_alternative<block_trxs_entry>(log_entry)) {
+            const auto& trxs_entry = std::get<block_trxs_entry>(log_entry);
+            for (const auto& id : trxs_entry.ids) {
+               auto [it, inserted] = entries.try_emplace(id, entry{ .block_num = trxs_entry.block_num, .lib_before_block = h.max_lib });
+               if (!inserted) {
+                  if (it->second.irreversible)
+                     continue;
+                  it->second.block_num = trxs_entry.block_num;
+               }
+               reversible.push_back(id);
+            }
+         } else if (std::holds_alternative<lib_entry_v0>(log_entry)) {
+            const uint32_t lib = std::get<lib_entry_v0>(log_entry).lib;
+            h.max_lib = std::max(h.max_lib, lib);
+            std::erase_if(reversible, [&](const chain::transaction_id_type& id) {
+               entry& e = entries.at(id);
+               if (e.block_num <= lib)
+                  e.irreversible = true;
+               return e.irreversible;
+            });
+         }
+      }
+      slice.close();
+
+      std::vector<std::pair<chain::transaction_id_type, entry>> records(entries.begin(), entries.end());
+      entries.clear();
+      std::sort(records.begin(), records.end(), [](const auto& lhs, const auto& rhs) {
+         return compare_ids(lhs.first.data(), rhs.first.data()) < 0;
+      });
+      h.count = records.size();
+
+      auto tmp_path = index_path;
+      tmp_path += ".tmp";
+      fc::cfile out;
+      out.set_file_path(tmp_path);
+      out.open(fc::cfile::truncate_rw_mode);
+      const auto packed_header = fc::raw::pack(h);
+      out.write(packed_header.data(), packed_header.size());
+      for (const auto& [id, e] : records) {
+         const uint8_t irreversible = e.irreversible;
+         out.write(id.data(), id_size);
+         out.write(reinterpret_cast<const char*>(&e.block_num), sizeof(e.block_num));
+         out.write(reinterpret_cast<const char*>(&e.lib_before_block), sizeof(e.lib_before_block));
+         out.write(reinterpret_cast<const char*>(&irreversible), sizeof(irreversible));
+      }
+      out.flush();
+      out.close();
+      std::filesystem::rename(tmp_path, index_path);
+   }
+}
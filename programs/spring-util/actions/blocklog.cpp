@@ -323,13 +323,17 @@ int blocklog_actions::read_log() {
          *out << fc::json::to_pretty_string(v) << "\n";
    };
    bool contains_obj = false;
-   while((block_num <= opt->last_block) && (next = block_logger.read_block_by_num(block_num))) {
+   const uint32_t end_block_num = std::min(opt->last_block, end->block_num()) + 1;
+   block_num += block_logger.read_serialized_block_range(block_num, end_block_num, [&](uint32_t, std::span<const char> block) {
       if(opt->as_json_array && contains_obj)
          *out << ",";
+      fc::datastream<const char*> ds(block.data(), block.size());
+      next = std::make_shared<signed_block>();
+      fc::raw::unpack(ds, *next);
       print_block(next);
-      ++block_num;
       contains_obj = true;
-   }
+      return true;
+   });
 
    if(!fork_db_branch.empty()) {
       for(auto bitr = fork_db_branch.rbegin(); bitr != fork_db_branch.rend() && block_num <= opt->last_block; ++bitr) {
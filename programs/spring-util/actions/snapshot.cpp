@@ -38,6 +38,45 @@ void snapshot_actions::setup(CLI::App& app) {
          throw(CLI::RuntimeError(-1));
       }
    });
+
+   // subcommand -convert between compressed and uncompressed binary snapshots
+   auto convert = sub->add_subcommand("convert", "Convert a binary snapshot between the uncompressed and compressed formats");
+   convert->add_option("--input-file,-i", opt->input_file, "Binary snapshot file to convert, compressed or not.")->required();
+   convert->add_option("--output-file,-o", opt->output_file, "The file to write the converted snapshot to (absolute or relative path).")->required();
+   convert->add_option("--compression,-c", opt->compression, "Compression of the output snapshot: \"none\" or \"zlib\"")->capture_default_str();
+   convert->add_option("--threads,-t", opt->threads, "Number of threads decompressing and compressing sections")->capture_default_str();
+
+   convert->callback([this]() {
+      try {
+         int rc = run_convert();
+         if(rc) throw(CLI::RuntimeError(rc));
+      } catch(...) {
+         print_exception();
+         throw(CLI::RuntimeError(-1));
+      }
+   });
+}
+
+int snapshot_actions::run_convert() {
+   if(!std::filesystem::exists(opt->input_file)) {
+      std::cerr << "cannot convert snapshot, " << opt->input_file << " does not exist" << std::endl;
+      return -1;
+   }
+
+   snapshot_compression compression;
+   if(opt->compression == "none")
+      compression = snapshot_compression::none;
+   else if(opt->compression == "zlib")
+      compression = snapshot_compression::zlib;
+   else {
+      std::cerr << "unknown compression " << opt->compression << ", expected \"none\" or \"zlib\"" << std::endl;
+      return -1;
+   }
+
+   ilog("Converting snapshot ${i} to ${o}", ("i", opt->input_file)("o", opt->output_file));
+   convert_snapshot(opt->input_file, opt->output_file, compression, opt->threads);
+   ilog("Completed converting snapshot: ${o}", ("o", opt->output_file));
+   return 0;
 }
 
 int snapshot_actions::run_subcommand() {
@@ -59,12 +98,9 @@ int snapshot_actions::run_subcommand() {
       chain_id = chain_id_type(opt->chain_id);
    }
    else { // try to retrieve it
-      auto infile = std::ifstream(snapshot_path.generic_string(),
-                               (std::ios::in | std::ios::binary));
-      istream_snapshot_reader reader(infile);
+      threaded_snapshot_reader reader(snapshot_path);
       reader.validate();
       chain_id = controller::extract_chain_id(reader);
-      infile.close();
    }
 
    // setup controller
@@ -84,9 +120,7 @@ int snapshot_actions::run_subcommand() {
    protocol_feature_set pfs = initialize_protocol_features( std::filesystem::path("protocol_features"), false );
 
    try {
-      auto infile = std::ifstream(snapshot_path.generic_string(),
-                                  (std::ios::in | std::ios::binary));
-      auto reader = std::make_shared<istream_snapshot_reader>(infile);
+      auto reader = std::make_shared<threaded_snapshot_reader>(snapshot_path);
 
       auto check_shutdown = []() { return false; };
       auto shutdown = []() { throw; };
@@ -94,7 +128,6 @@ int snapshot_actions::run_subcommand() {
       control.reset(new controller(cfg, std::move(pfs), chain_id));
       control->add_indices();
       control->startup(shutdown, check_shutdown, reader);
-      infile.close();
 
       ilog("Writing snapshot: ${s}", ("s", json_path));
       auto snap_out = std::ofstream(json_path.generic_string(), (std::ios::out));
@@ -6,6 +6,8 @@ struct snapshot_options {
    uint64_t db_size = 65536ull;
    uint64_t guard_size = 1;
    std::string chain_id = "";
+   std::string compression = "zlib";
+   uint16_t threads = 2;
 };
 
 class snapshot_actions : public sub_command<snapshot_options> {
@@ -15,4 +17,5 @@ public:
 
    // callbacks
    int run_subcommand();
+   int run_convert();
 };
\ No newline at end of file
@@ -643,4 +643,25 @@ BOOST_DATA_TEST_CASE(empty_prune_to_partitioned_transitions, bdata::xrange(1, 11
 
 }  FC_LOG_AND_RETHROW() }
 
+// positions appended since blocks.index was last mapped are looked up in memory until the index is remapped, make sure
+// lookups are right on both sides of a remap and after reopening the log
+BOOST_DATA_TEST_CASE(index_remap_nongenesis, bdata::xrange(2), reopen_on_mark)  { try {
+   block_log_fixture t(true, reopen_on_mark, false, std::optional<uint32_t>());
+
+   t.startup(10);
+
+   const uint32_t num_blocks = 64 * 1024 + 100;
+   for (uint32_t i = 10; i < 10 + num_blocks; ++i)
+      t.add(i, 16, 'A' + i % 26);
+   t.check_n_bounce([&]() {
+      t.check_range_present(10, 10 + num_blocks - 1);
+   });
+
+   t.add(10 + num_blocks, 16, 'Z');
+   t.check_n_bounce([&]() {
+      t.check_range_present(10, 10 + num_blocks);
+   });
+   t.check_not_present(10 + num_blocks + 1);
+}  FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_SUITE_END()
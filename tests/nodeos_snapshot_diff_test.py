@@ -25,6 +25,7 @@ from TestHarness.testUtils import BlockLogAction
 #  - Start nodeos in irreversible mode on blocklog
 #  - Generate snapshot and convert to JSON
 #  - Compare JSON snapshot to original snapshot JSON
+#  - Convert snapshot to the compressed format and start nodeos from it
 #
 ###############################################################
 
@@ -95,10 +96,12 @@ try:
     node0=cluster.getNode(snapshotNodeId)
     irrNodeId = snapshotNodeId+1
     progNodeId = irrNodeId+1
+    compNodeId = progNodeId+1
 
     nodeSnap=cluster.getNode(snapshotNodeId)
     nodeIrr=cluster.getNode(irrNodeId)
     nodeProg=cluster.getNode(progNodeId)
+    nodeComp=cluster.getNode(compNodeId)
 
     Print("Wait for account creation to be irreversible")
     blockNum=node0.getBlockNum(BlockType.head)
@@ -153,6 +156,9 @@ try:
     Print("Convert snapshot to JSON")
     snapshotFile = nodeSnap.getLatestSnapshot()
     Utils.processSpringUtilCmd("snapshot to-json --input-file {}".format(snapshotFile), "snapshot to-json", silentErrors=False)
+    compressedSnapshotFile = snapshotFile + ".zlib"
+    Utils.processSpringUtilCmd("snapshot convert --input-file {} --output-file {} --compression zlib".format(snapshotFile, compressedSnapshotFile),
+                               "snapshot convert", silentErrors=False)
     snapshotFile = snapshotFile + ".json"
 
     Print("Trim programmable blocklog to snapshot head block num and relaunch programmable node")
@@ -207,6 +213,15 @@ try:
     assert Utils.compareFiles(snapshotFile, irrSnapshotFile), f"Snapshot files differ {snapshotFile} != {irrSnapshotFile}"
     assert Utils.compareFiles(progSnapshotFile, irrSnapshotFile), f"Snapshot files differ {progSnapshotFile} != {irrSnapshotFile}"
 
+    Print("Relaunch node from the compressed snapshot")
+    nodeComp.kill(signal.SIGTERM)
+    nodeComp.removeDataDir()
+    nodeComp.rmFromCmd('--p2p-peer-address')
+    isRelaunchSuccess = nodeComp.relaunch(chainArg=f"--snapshot {compressedSnapshotFile}", timeout=relaunchTimeout)
+    assert isRelaunchSuccess, "Failed to relaunch node from compressed snapshot"
+    comp_head_block_num = nodeComp.getBlockNum(BlockType.head)
+    assert comp_head_block_num == ret_head_block_num, f"Compressed snapshot head block number {comp_head_block_num} != {ret_head_block_num}"
+
     testSuccessful=True
 
 finally:
@@ -1176,6 +1176,24 @@ class PluginHttpTest(unittest.TestCase):
         ret_json = self.nodeos.processUrllibRequest(resource, command, payload, endpoint=endpoint)
         self.assertIn("trxs", ret_json["payload"])
 
+        # get_contract_profile with empty parameter
+        command = "get_contract_profile"
+        ret_json = self.nodeos.processUrllibRequest(resource, command, endpoint=endpoint)
+        self.assertIn("wall_us", ret_json["payload"])
+        self.assertIn("actions", ret_json["payload"])
+        # get_contract_profile with empty content parameter
+        ret_json = self.nodeos.processUrllibRequest(resource, command, self.empty_content_dict, endpoint=endpoint)
+        self.assertIn("actions", ret_json["payload"])
+        # get_contract_profile with invalid parameter
+        ret_json = self.nodeos.processUrllibRequest(resource, command, self.http_post_invalid_param, endpoint=endpoint)
+        self.assertEqual(ret_json["code"], 400)
+        self.assertEqual(ret_json["error"]["code"], 3200006)
+        # get_contract_profile with valid parameter
+        payload = {"receiver":"eosio", "limit":1}
+        ret_json = self.nodeos.processUrllibRequest(resource, command, payload, endpoint=endpoint)
+        self.assertIn("actions", ret_json["payload"])
+        self.assertLessEqual(len(ret_json["payload"]["actions"]), 1)
+
     # test all wallet api
     def test_WalletApi(self) :
         endpoint = self.base_wallet_cmd_str
@@ -11,6 +11,7 @@
 #include <fc/io/fstream.hpp>
 
 #include <eosio/state_history/log_catalog.hpp>
+#include <eosio/state_history/log_entry_cache.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
 
@@ -663,6 +664,137 @@ BOOST_AUTO_TEST_CASE(regen_index) try {
    BOOST_REQUIRE_EQUAL(new_index_contents, old_index_contents);
 } FC_LOG_AND_RETHROW();
 
+BOOST_AUTO_TEST_CASE(write_precompressed_entries) try {
+   const fc::temp_directory tmpdir;
+   std::map<block_num_type, std::vector<char>> wrote_data_for_blocknum;
+
+   {
+      eosio::state_history::log_catalog lc(tmpdir.path(), std::monostate(), "precompressed");
+
+      //alternate between entries packed in place and entries compressed ahead of time; they must be indistinguishable
+      for(unsigned i = 2; i < 34; ++i) {
+         std::vector<char>& data = wrote_data_for_blocknum[i];
+         data.resize(1000 + i*97);
+         rand_bytes(data.data(), data.size());
+
+         if(i % 2)
+            lc.pack_and_write_entry(fake_blockid_for_num(i), fake_blockid_for_num(i-1), [&](bio::filtering_ostreambuf& obuf) {
+               bio::write(obuf, data.data(), data.size());
+            });
+         else
+            lc.write_entry(fake_blockid_for_num(i), fake_blockid_for_num(i-1), eosio::state_history::compress_entry(lc.get_compression(), data));
+      }
+
+      //a fork change is still detected for precompressed entries
+      BOOST_REQUIRE_EXCEPTION(lc.write_entry(fake_blockid_for_num(34), fake_blockid_for_num(33, 0xbeefUL), eosio::state_history::compress_entry(lc.get_compression(), {})),
+                              plugin_exception,
+                              [](const plugin_exception& e) {return e.to_detail_string().find("missed a fork change") != std::string::npos;});
+   }
+
+   eosio::state_history::log_catalog lc(tmpdir.path(), std::monostate(), "precompressed");
+   BOOST_REQUIRE_EQUAL(lc.block_range().first, 2u);
+   BOOST_REQUIRE_EQUAL(lc.block_range().second, 34u);
+   for(const auto& [block_num, data] : wrote_data_for_blocknum) {
+      std::optional<state_history::ship_log_entry> entry = lc.get_entry(block_num);
+      BOOST_REQUIRE(!!entry);
+      BOOST_REQUIRE_EQUAL(entry->get_uncompressed_size(), data.size());
+      bio::filtering_istreambuf istream = entry->get_stream();
+      std::vector<char> red;
+      bio::copy(istream, bio::back_inserter(red));
+      BOOST_REQUIRE(red == data);
+   }
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(mixed_codecs, * boost::unit_test::precondition([](boost::unit_test::test_unit_id) -> boost::test_tools::assertion_result {
+   return state_history::log_compression::zstd_available();
+})) try {
+   const fc::temp_directory tmpdir;
+   std::map<block_num_type, std::vector<char>> wrote_data_for_blocknum;
+
+   auto write_blocks = [&](state_history::log_catalog& lc, unsigned begin, unsigned end) {
+      for(unsigned i = begin; i < end; ++i) {
+         std::vector<char>& data = wrote_data_for_blocknum[i];
+         data.assign(5000 + i*13, static_cast<char>(i));
+         lc.pack_and_write_entry(fake_blockid_for_num(i), fake_blockid_for_num(i-1), [&](bio::filtering_ostreambuf& obuf) {
+            bio::write(obuf, data.data(), data.size());
+         });
+      }
+   };
+
+   //start out with zlib, then switch the log over to zstd; everything must remain readable
+   {
+      state_history::log_catalog lc(tmpdir.path(), std::monostate(), "mixed");
+      write_blocks(lc, 2, 10);
+   }
+   const state_history::log_compression zstd(state_history::log_codec::zstd);
+   {
+      state_history::log_catalog lc(tmpdir.path(), std::monostate(), "mixed", state_history::state_history_log::no_non_local_get_block_id_func, zstd);
+      write_blocks(lc, 10, 20);
+      lc.write_entry(fake_blockid_for_num(20), fake_blockid_for_num(19), state_history::compress_entry(zstd, wrote_data_for_blocknum[20] = {'a', 'b', 'c'}));
+   }
+
+   state_history::log_catalog lc(tmpdir.path(), std::monostate(), "mixed", state_history::state_history_log::no_non_local_get_block_id_func, zstd);
+   BOOST_REQUIRE_EQUAL(lc.block_range().first, 2u);
+   BOOST_REQUIRE_EQUAL(lc.block_range().second, 21u);
+   for(const auto& [block_num, data] : wrote_data_for_blocknum) {
+      std::optional<state_history::ship_log_entry> entry = lc.get_entry(block_num);
+      BOOST_REQUIRE(!!entry);
+      BOOST_REQUIRE(entry->codec == (block_num < 10 ? state_history::log_codec::zlib : state_history::log_codec::zstd));
+      BOOST_REQUIRE_EQUAL(entry->get_uncompressed_size(), data.size());
+      bio::filtering_istreambuf istream = entry->get_stream();
+      std::vector<char> red;
+      bio::copy(istream, bio::back_inserter(red));
+      BOOST_REQUIRE(red == data);
+   }
+
+   //these highly repetitive entries compress to a fraction of their size with zstd, but not with the stored zlib entries
+   BOOST_REQUIRE_LT(lc.get_entry(15)->compressed_data_size, wrote_data_for_blocknum[15].size() / 10);
+   BOOST_REQUIRE_GT(lc.get_entry(5)->compressed_data_size, wrote_data_for_blocknum[5].size());
+} FC_LOG_AND_RETHROW();
+
+BOOST_AUTO_TEST_CASE(entry_cache) try {
+   state_history::log_entry_cache cache(8*1000);
+   unsigned hits = 0, misses = 0;
+   cache.on_hit = [&]() {++hits;};
+   cache.on_miss = [&]() {++misses;};
+
+   auto make_entry = [](size_t size) {
+      return std::make_shared<const std::vector<char>>(size, 'x');
+   };
+
+   BOOST_REQUIRE(cache.enabled());
+   BOOST_REQUIRE(!cache.find(state_history::log_type::trace, fake_blockid_for_num(2)));
+   BOOST_REQUIRE_EQUAL(misses, 1u);
+
+   //too large for the cache
+   cache.insert(state_history::log_type::trace, fake_blockid_for_num(2), make_entry(cache.max_entry_size()+1));
+   BOOST_REQUIRE_EQUAL(cache.size(), 0u);
+
+   for(unsigned i = 2; i < 10; ++i)
+      cache.insert(state_history::log_type::trace, fake_blockid_for_num(i), make_entry(1000));
+   BOOST_REQUIRE_EQUAL(cache.size(), 8000u);
+
+   //touch block 2 so it is most recently used, then push out the least recently used (block 3)
+   BOOST_REQUIRE(cache.find(state_history::log_type::trace, fake_blockid_for_num(2)));
+   cache.insert(state_history::log_type::trace, fake_blockid_for_num(10), make_entry(1000));
+   BOOST_REQUIRE_EQUAL(cache.size(), 8000u);
+   BOOST_REQUIRE(cache.find(state_history::log_type::trace, fake_blockid_for_num(2)));
+   BOOST_REQUIRE(!cache.find(state_history::log_type::trace, fake_blockid_for_num(3)));
+   BOOST_REQUIRE(cache.find(state_history::log_type::trace, fake_blockid_for_num(10)));
+
+   //log type and block id (e.g. a block on another fork) are both part of the key
+   BOOST_REQUIRE(!cache.find(state_history::log_type::chain_state, fake_blockid_for_num(10)));
+   BOOST_REQUIRE(!cache.find(state_history::log_type::trace, fake_blockid_for_num(10, 0xbeefUL)));
+
+   BOOST_REQUIRE_EQUAL(hits, 3u);
+   BOOST_REQUIRE_EQUAL(misses, 4u);
+
+   state_history::log_entry_cache disabled(0);
+   BOOST_REQUIRE(!disabled.enabled());
+   disabled.insert(state_history::log_type::trace, fake_blockid_for_num(2), make_entry(1));
+   BOOST_REQUIRE(!disabled.find(state_history::log_type::trace, fake_blockid_for_num(2)));
+} FC_LOG_AND_RETHROW();
+
 BOOST_AUTO_TEST_CASE(empty_empty_empty) try {
    //just opens and closes an empty log a few times
    const fc::temp_directory tmpdir;
@@ -33,6 +33,7 @@ int main(int argc, char* argv[]) {
    bool fetch_traces = false;
    bool fetch_deltas = false;
    bool fetch_finality_data = false;
+   uint32_t max_blocks_per_message = 0;
 
    cli.add_options()
       ("help,h", bpo::bool_switch(&help)->default_value(false), "Print this help message and exit.")
@@ -44,6 +45,7 @@ int main(int argc, char* argv[]) {
       ("fetch-traces", bpo::bool_switch(&fetch_traces)->default_value(fetch_traces), "Fetch traces")
       ("fetch-deltas", bpo::bool_switch(&fetch_deltas)->default_value(fetch_deltas), "Fetch deltas")
       ("fetch-finality-data", bpo::bool_switch(&fetch_finality_data)->default_value(fetch_finality_data), "Fetch finality data")
+      ("max-blocks-per-message", bpo::value<uint32_t>(&max_blocks_per_message)->default_value(max_blocks_per_message), "Request batched get_blocks_result_v2 messages of up to this many blocks; 0 for get_blocks_result_v1")
       ;
    bpo::variables_map varmap;
    bpo::store(bpo::parse_command_line(argc, argv, cli), varmap);
@@ -91,9 +93,14 @@ int main(int argc, char* argv[]) {
       //struct get_blocks_request_v1 : get_blocks_request_v0 {
       //   bool                        fetch_finality_data    = false;
       //};
+      //struct get_blocks_request_v2 : get_blocks_request_v1 {
+      //   uint32_t                    max_blocks_per_message = 1;
+      //   uint32_t                    max_message_bytes      = 0;
+      //};
+      const bool batched = max_blocks_per_message > 0;
       request_writer.StartArray();
 
-         request_writer.String("get_blocks_request_v1"); // always send out latest version of request
+         request_writer.String(batched ? "get_blocks_request_v2" : "get_blocks_request_v1");
          request_writer.StartObject();
          request_writer.Key("start_block_num");
          request_writer.Uint(start_block_num);
@@ -114,6 +121,12 @@ int main(int argc, char* argv[]) {
          request_writer.Bool(fetch_deltas);
          request_writer.Key("fetch_finality_data");
          request_writer.Bool(fetch_finality_data);
+         if(batched) {
+            request_writer.Key("max_blocks_per_message");
+            request_writer.Uint(max_blocks_per_message);
+            request_writer.Key("max_message_bytes");
+            request_writer.Uint(0);
+         }
          request_writer.EndObject();
       request_writer.EndArray();
 
@@ -125,25 +138,15 @@ int main(int argc, char* argv[]) {
       //       block_num,         block_id
       std::map<uint32_t, std::set<std::string>> block_ids;
       bool is_first = true;
-      for(;;) {
-         boost::beast::flat_buffer buffer;
-         stream.read(buffer);
-
-         eosio::input_stream is((const char*)buffer.data().data(), buffer.data().size());
-         rapidjson::Document result_document;
-         result_document.Parse(result_type.bin_to_json(is).c_str());
-
-         eosio::check(!result_document.HasParseError(),                                      "Failed to parse result JSON from abieos");
-         eosio::check(result_document.IsArray(),                                             "result should have been an array (variant) but it's not");
-         eosio::check(result_document.Size() == 2,                                           "result was an array but did not contain 2 items like a variant should");
-         eosio::check(std::string(result_document[0].GetString()) == "get_blocks_result_v1", "result type doesn't look like get_blocks_result_v1");
-         eosio::check(result_document[1].IsObject(),                                         "second item in result array is not an object");
-         eosio::check(result_document[1].HasMember("head"),                                  "cannot find 'head' in result");
-         eosio::check(result_document[1]["head"].IsObject(),                                 "'head' is not an object");
-         eosio::check(result_document[1]["head"].HasMember("block_num"),                     "'head' does not contain 'block_num'");
-         eosio::check(result_document[1]["head"]["block_num"].IsUint(),                      "'head.block_num' isn't a number");
-         eosio::check(result_document[1]["head"].HasMember("block_id"),                      "'head' does not contain 'block_id'");
-         eosio::check(result_document[1]["head"]["block_id"].IsString(),                     "'head.block_id' isn't a string");
+      // streams and validates one block's result; returns false if the block does not link to a previously received one
+      auto process_block = [&](const rapidjson::Value& result, uint32_t& this_block_num) {
+         eosio::check(result.IsObject(),                                         "block result is not an object");
+         eosio::check(result.HasMember("head"),                                  "cannot find 'head' in result");
+         eosio::check(result["head"].IsObject(),                                 "'head' is not an object");
+         eosio::check(result["head"].HasMember("block_num"),                     "'head' does not contain 'block_num'");
+         eosio::check(result["head"]["block_num"].IsUint(),                      "'head.block_num' isn't a number");
+         eosio::check(result["head"].HasMember("block_id"),                      "'head' does not contain 'block_id'");
+         eosio::check(result["head"]["block_id"].IsString(),                     "'head.block_id' isn't a string");
 
          // stream what was received
          if(is_first) {
@@ -156,13 +159,13 @@ int main(int argc, char* argv[]) {
 
          rapidjson::StringBuffer result_sb;
          rapidjson::PrettyWriter<rapidjson::StringBuffer> result_writer(result_sb);
-         result_document[1].Accept(result_writer);
+         result.Accept(result_writer);
          std::cout << result_sb.GetString() << std::endl << "}" << std::endl;
 
          // validate after streaming, so that invalid entry is included in the output
-         uint32_t this_block_num = 0;
-         if( result_document[1].HasMember("this_block") && result_document[1]["this_block"].IsObject() ) {
-            const auto& this_block = result_document[1]["this_block"];
+         this_block_num = 0;
+         if( result.HasMember("this_block") && result["this_block"].IsObject() ) {
+            const auto& this_block = result["this_block"];
             if( this_block.HasMember("block_num") && this_block["block_num"].IsUint() ) {
                this_block_num = this_block["block_num"].GetUint();
             }
@@ -171,8 +174,8 @@ int main(int argc, char* argv[]) {
                this_block_id = this_block["block_id"].GetString();
             }
             std::string prev_block_id;
-            if( result_document[1].HasMember("prev_block") && result_document[1]["prev_block"].IsObject() ) {
-               const auto& prev_block = result_document[1]["prev_block"];
+            if( result.HasMember("prev_block") && result["prev_block"].IsObject() ) {
+               const auto& prev_block = result["prev_block"];
                if ( prev_block.HasMember("block_id") && prev_block["block_id"].IsString() ) {
                   prev_block_id = prev_block["block_id"].GetString();
                }
@@ -184,23 +187,56 @@ int main(int argc, char* argv[]) {
                      std::cerr << "Received block: << " << this_block_num << " that does not link to previous: ";
                      std::copy(block_ids[this_block_num-1].begin(), block_ids[this_block_num-1].end(), std::ostream_iterator<std::string>(std::cerr, " "));
                      std::cerr << std::endl;
-                     return 1;
+                     return false;
                   }
                }
                block_ids[this_block_num].insert(this_block_id);
 
-               if( result_document[1]["last_irreversible"].HasMember("block_num") && result_document[1]["last_irreversible"]["block_num"].IsUint() ) {
-                  uint32_t lib_num = result_document[1]["last_irreversible"]["block_num"].GetUint();
+               if( result["last_irreversible"].HasMember("block_num") && result["last_irreversible"]["block_num"].IsUint() ) {
+                  uint32_t lib_num = result["last_irreversible"]["block_num"].GetUint();
                   auto i = block_ids.lower_bound(lib_num);
                   if (i != block_ids.end()) {
                      block_ids.erase(block_ids.begin(), i);
                   }
                }
             }
+         }
+         return true;
+      };
 
+      for(;;) {
+         boost::beast::flat_buffer buffer;
+         stream.read(buffer);
+
+         eosio::input_stream is((const char*)buffer.data().data(), buffer.data().size());
+         rapidjson::Document result_document;
+         result_document.Parse(result_type.bin_to_json(is).c_str());
+
+         eosio::check(!result_document.HasParseError(),                                      "Failed to parse result JSON from abieos");
+         eosio::check(result_document.IsArray(),                                             "result should have been an array (variant) but it's not");
+         eosio::check(result_document.Size() == 2,                                           "result was an array but did not contain 2 items like a variant should");
+         eosio::check(result_document[1].IsObject(),                                         "second item in result array is not an object");
+
+         bool done = false;
+         uint32_t this_block_num = 0;
+         if(batched) {
+            eosio::check(std::string(result_document[0].GetString()) == "get_blocks_result_v2", "result type doesn't look like get_blocks_result_v2");
+            eosio::check(result_document[1].HasMember("blocks") && result_document[1]["blocks"].IsArray(), "cannot find 'blocks' array in result");
+            const auto& blocks = result_document[1]["blocks"];
+            eosio::check(blocks.Size() > 0 && blocks.Size() <= max_blocks_per_message, "unexpected number of blocks in get_blocks_result_v2");
+            for(const auto& block : blocks.GetArray()) {
+               if(!process_block(block, this_block_num))
+                  return 1;
+               done = done || this_block_num == end_block_num;
+            }
+         } else {
+            eosio::check(std::string(result_document[0].GetString()) == "get_blocks_result_v1", "result type doesn't look like get_blocks_result_v1");
+            if(!process_block(result_document[1], this_block_num))
+               return 1;
+            done = this_block_num == end_block_num;
          }
 
-         if( this_block_num == end_block_num ) break;
+         if( done ) break;
       }
 
       std::cout << "]" << std::endl;
@@ -154,9 +154,11 @@ try:
         outFile = open(f"{shipClientFilePrefix}{i}.out", "w")
         errFile = open(f"{shipClientFilePrefix}{i}.err", "w")
         Print(f"Start client {i}")
-        popen=Utils.delayedCheckOutput(cmd, stdout=outFile, stderr=errFile)
+        # every other client requests batched multi-block messages
+        clientCmd = cmd + (" --max-blocks-per-message 10" if i % 2 else "")
+        popen=Utils.delayedCheckOutput(clientCmd, stdout=outFile, stderr=errFile)
         starts.append(time.perf_counter())
-        clients.append((popen, cmd))
+        clients.append((popen, clientCmd))
         files.append((outFile, errFile))
         Print(f"Client {i} started, Ship node head is: {shipNode.getBlockNum()}")
 
@@ -249,9 +251,11 @@ try:
         outFile = open(f"{shipClientFilePrefix}{i}_replay.out", "w")
         errFile = open(f"{shipClientFilePrefix}{i}_replay.err", "w")
         Print(f"Start client {i}")
-        popen=Utils.delayedCheckOutput(cmd, stdout=outFile, stderr=errFile)
+        # every other client requests batched multi-block messages
+        clientCmd = cmd + (" --max-blocks-per-message 10" if i % 2 else "")
+        popen=Utils.delayedCheckOutput(clientCmd, stdout=outFile, stderr=errFile)
         starts.append(time.perf_counter())
-        clients.append((popen, cmd))
+        clients.append((popen, clientCmd))
         files.append((outFile, errFile))
         Print(f"Client {i} started, Ship node head is: {shipNode.getBlockNum()}")
 
@@ -300,9 +304,11 @@ try:
         outFile = open(f"{shipClientFilePrefix}{i}_snapshot.out", "w")
         errFile = open(f"{shipClientFilePrefix}{i}_snapshot.err", "w")
         Print(f"Start client {i}")
-        popen=Utils.delayedCheckOutput(cmd, stdout=outFile, stderr=errFile)
+        # every other client requests batched multi-block messages
+        clientCmd = cmd + (" --max-blocks-per-message 10" if i % 2 else "")
+        popen=Utils.delayedCheckOutput(clientCmd, stdout=outFile, stderr=errFile)
         starts.append(time.perf_counter())
-        clients.append((popen, cmd))
+        clients.append((popen, clientCmd))
         files.append((outFile, errFile))
         Print(f"Client {i} started, Ship node head is: {shipNode.getBlockNum()}")
 
@@ -384,4 +384,40 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(no_onblock_test, T, testers) { try {
 } FC_LOG_AND_RETHROW() }
 
 
+// blocks prevalidated before the blocks they build on are validated, as during sync, are validated the same as any other
+BOOST_AUTO_TEST_CASE_TEMPLATE( prevalidated_blocks_test, T, testers ) try {
+   T main;
+   main.create_account("newacc"_n);
+   main.produce_blocks(5);
+
+   T validator(setup_policy::none);
+   std::vector<signed_block_ptr> blocks;
+   for( uint32_t n = validator.head().block_num() + 1; n <= main.head().block_num(); ++n ) {
+      signed_block_ptr b = main.fetch_block_by_number(n);
+      validator.control->prevalidate_block(b->calculate_id(), b);
+      blocks.push_back(b);
+   }
+   for( const auto& b : blocks )
+      validator.push_block(b);
+   BOOST_TEST(validator.head().id() == main.head().id());
+
+   if constexpr (std::is_same_v<T, savanna_tester>) {
+      // the keys recovered for a block are not used for a different block with the same id
+      signed_block_ptr b = main.produce_block();
+      BOOST_TEST_REQUIRE(b->is_proper_svnn_block());
+      auto bad_b = std::make_shared<signed_block>(b->clone());
+      bad_b->producer_signature = main.get_private_key("newacc"_n, "active").sign(bad_b->calculate_id());
+      BOOST_TEST_REQUIRE(bad_b->calculate_id() == b->calculate_id());
+
+      validator.control->prevalidate_block(b->calculate_id(), b);
+      BOOST_REQUIRE_EXCEPTION( validator.push_block(bad_b), wrong_signing_key,
+                               fc_exception_message_starts_with("block signed by unexpected key") );
+
+      // and the keys recovered for a badly signed block are not used for the valid block
+      validator.control->prevalidate_block(bad_b->calculate_id(), bad_b);
+      validator.push_block(b);
+      BOOST_TEST(validator.head().id() == main.head().id());
+   }
+} FC_LOG_AND_RETHROW()
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+#include <eosio/chain/contract_profiler.hpp>
+#include <eosio/testing/tester.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+using namespace eosio::chain;
+using namespace eosio::testing;
+
+namespace {
+   const contract_profiler::action_profile* find(const std::vector<contract_profiler::action_profile>& actions,
+                                                 account_name receiver, action_name act) {
+      auto it = std::find_if(actions.begin(), actions.end(), [&](const auto& a) {
+         return a.receiver == receiver && a.action == act;
+      });
+      return it == actions.end() ? nullptr : &*it;
+   }
+
+   void execute(contract_profiler& profiler, account_name receiver, action_name act, int64_t us,
+                std::chrono::nanoseconds crypto_time = {}) {
+      profiler.begin_action();
+      {
+         intrinsic_timer timer(intrinsic_category::crypto);
+         const auto until = std::chrono::steady_clock::now() + crypto_time;
+         while(std::chrono::steady_clock::now() < until) {}
+      }
+      profiler.end_action(receiver, act, fc::microseconds(us));
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(contract_profiler_tests)
+
+BOOST_AUTO_TEST_CASE(merges_threads) {
+   contract_profiler profiler(0);
+   execute(profiler, "alice"_n, "transfer"_n, 10);
+   execute(profiler, "alice"_n, "transfer"_n, 30);
+   std::thread([&]() {
+      execute(profiler, "alice"_n, "transfer"_n, 20);
+      execute(profiler, "bob"_n, "vote"_n, 5);
+   }).join();
+
+   const auto actions = profiler.actions();
+   BOOST_TEST(actions.size() == 2u);
+   const auto* transfer = find(actions, "alice"_n, "transfer"_n);
+   BOOST_REQUIRE(transfer);
+   BOOST_TEST(transfer->executions == 3u);
+   BOOST_TEST(transfer->wall_us == 60u);
+   BOOST_TEST(transfer->max_wall_us == 30u);
+   // intrinsics are not timed with a sample interval of 0
+   BOOST_TEST(transfer->intrinsic_us[static_cast<size_t>(intrinsic_category::crypto)] == 0u);
+   const auto* vote = find(actions, "bob"_n, "vote"_n);
+   BOOST_REQUIRE(vote);
+   BOOST_TEST(vote->executions == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(samples_intrinsics) {
+   contract_profiler profiler(2);
+   // about half of the actions are timed, picked at random, and their time counted twice; 10ms in total expected
+   for(int i = 0; i < 50; ++i)
+      execute(profiler, "alice"_n, "verify"_n, 500, std::chrono::microseconds(200));
+
+   const auto actions = profiler.actions();
+   const auto* verify = find(actions, "alice"_n, "verify"_n);
+   BOOST_REQUIRE(verify);
+   const uint64_t crypto_us = verify->intrinsic_us[static_cast<size_t>(intrinsic_category::crypto)];
+   BOOST_TEST(crypto_us >= 2000u); // at least 5 of the 50 sampled
+   BOOST_TEST(verify->intrinsic_us[static_cast<size_t>(intrinsic_category::database)] == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(bounds_actions_per_thread) {
+   contract_profiler profiler(0, 2);
+   execute(profiler, "alice"_n, "a"_n, 1);
+   execute(profiler, "alice"_n, "b"_n, 1);
+   execute(profiler, "alice"_n, "c"_n, 1);
+   execute(profiler, "alice"_n, "d"_n, 1);
+
+   const auto actions = profiler.actions();
+   BOOST_TEST(actions.size() == 3u);
+   BOOST_TEST(!find(actions, "alice"_n, "c"_n));
+   const auto* other = find(actions, account_name{}, action_name{});
+   BOOST_REQUIRE(other);
+   BOOST_TEST(other->executions == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(profiles_executed_actions) try {
+   tester chain;
+   auto executions = [&]() -> uint64_t {
+      const auto actions = chain.control->get_contract_profiler().actions();
+      const auto* a = find(actions, config::system_account_name, "newaccount"_n);
+      return a ? a->executions : 0;
+   };
+
+   const uint64_t before = executions();
+   chain.create_account("alice"_n);
+   chain.produce_block();
+   BOOST_TEST(executions() > before);
+} FC_LOG_AND_RETHROW()
+
+BOOST_AUTO_TEST_SUITE_END()
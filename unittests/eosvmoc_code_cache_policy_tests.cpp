@@ -0,0 +1,151 @@
+#include <eosio/chain/webassembly/eos-vm-oc/code_cache_policy.hpp>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace eosio::chain::eosvmoc;
+
+namespace {
+   namespace bmi = boost::multi_index;
+
+   struct by_value;
+   using index_t = bmi::multi_index_container<
+      int,
+      bmi::indexed_by<
+         bmi::sequenced<>,
+         bmi::hashed_unique<bmi::tag<by_value>, bmi::identity<int>>
+      >
+   >;
+
+   void touch(index_t& index, segmented_lru<index_t>& order, int v) {
+      order.touch(index.project<0>(index.get<by_value>().find(v)));
+   }
+
+   std::vector<int> contents(const index_t& index) {
+      return {index.begin(), index.end()};
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(eosvmoc_code_cache_policy_tests)
+
+BOOST_AUTO_TEST_CASE(segmented_lru_protects_reused_entries) {
+   index_t index;
+   segmented_lru<index_t> order(index, 50);
+
+   for(int i = 1; i <= 4; ++i)
+      order.insert(i);
+   BOOST_TEST(contents(index) == (std::vector<int>{4, 3, 2, 1}));
+   BOOST_TEST(order.protected_size() == 0u);
+
+   touch(index, order, 1);
+   touch(index, order, 2);
+   BOOST_TEST(contents(index) == (std::vector<int>{2, 1, 4, 3}));
+   BOOST_TEST(order.protected_size() == 2u);
+
+   // protected is capped at half the entries, so its least recently used entry drops back to probation
+   touch(index, order, 3);
+   BOOST_TEST(contents(index) == (std::vector<int>{3, 2, 1, 4}));
+   BOOST_TEST(order.protected_size() == 2u);
+   BOOST_TEST(order.is_protected(index.begin()));
+   BOOST_TEST(!order.is_protected(std::next(index.begin(), 2)));
+
+   // a scan of new entries is inserted behind the protected entries and evicted first
+   for(int i = 5; i <= 7; ++i)
+      order.insert(i);
+   BOOST_TEST(contents(index) == (std::vector<int>{3, 2, 7, 6, 5, 1, 4}));
+   for(int i = 0; i < 5; ++i)
+      order.pop_back();
+   BOOST_TEST(contents(index) == (std::vector<int>{3, 2}));
+   BOOST_TEST(order.protected_size() == 2u);
+
+   // once only protected entries are left they are evicted too, and inserts still go behind them
+   order.pop_back();
+   BOOST_TEST(order.protected_size() == 1u);
+   order.insert(8);
+   BOOST_TEST(contents(index) == (std::vector<int>{3, 8}));
+}
+
+BOOST_AUTO_TEST_CASE(segmented_lru_erase) {
+   index_t index;
+   segmented_lru<index_t> order(index, 80);
+
+   for(int i = 1; i <= 3; ++i)
+      order.push_back(i);
+   touch(index, order, 2);
+   BOOST_TEST(contents(index) == (std::vector<int>{2, 1, 3}));
+
+   // erasing the head of probation and a protected entry keeps the segments intact
+   order.erase(index.project<0>(index.get<by_value>().find(1)));
+   order.erase(index.project<0>(index.get<by_value>().find(2)));
+   BOOST_TEST(order.protected_size() == 0u);
+   order.insert(4);
+   BOOST_TEST(contents(index) == (std::vector<int>{4, 3}));
+   touch(index, order, 3);
+   BOOST_TEST(contents(index) == (std::vector<int>{3, 4}));
+   BOOST_TEST(order.protected_size() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(segmented_lru_zero_percent_is_lru) {
+   index_t index;
+   segmented_lru<index_t> order(index, 0);
+
+   for(int i = 1; i <= 3; ++i)
+      order.insert(i);
+   touch(index, order, 1);
+   order.insert(4);
+   BOOST_TEST(contents(index) == (std::vector<int>{4, 1, 3, 2}));
+   BOOST_TEST(order.protected_size() == 0u);
+   order.pop_back();
+   BOOST_TEST(contents(index) == (std::vector<int>{4, 1, 3}));
+}
+
+BOOST_AUTO_TEST_CASE(admission_after_threshold) {
+   admission_filter<int> always(1);
+   BOOST_TEST(always.admit(1));
+   BOOST_TEST(always.size() == 0u);
+
+   admission_filter<int> filter(3);
+   BOOST_TEST(!filter.admit(1));
+   BOOST_TEST(!filter.admit(1));
+   BOOST_TEST(!filter.admit(2));
+   BOOST_TEST(filter.admit(1));
+   // admitted keys are forgotten, they have to be seen often enough again once evicted
+   BOOST_TEST(filter.count(1) == 0u);
+   BOOST_TEST(filter.count(2) == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(admission_counts_age) {
+   admission_filter<int> filter(10, 4);
+   for(int i = 0; i < 3; ++i)
+      BOOST_TEST(!filter.admit(1));
+   BOOST_TEST(filter.size() == 1u);
+   // the 4th sighting halves all counts, dropping the keys seen once
+   BOOST_TEST(!filter.admit(2));
+   BOOST_TEST(filter.size() == 1u);
+   BOOST_TEST(filter.count(1) == 1u);
+   BOOST_TEST(filter.count(2) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_buckets) {
+   static constexpr std::array<uint64_t, 3> bounds{10, 100, 1000};
+   atomic_histogram<bounds.size()> h(bounds);
+   for(uint64_t v : {0, 10, 11, 100, 5000})
+      h.observe(v);
+
+   const histogram_counts<bounds.size()> c = h.counts();
+   BOOST_TEST(c.counts[0] == 2u);
+   BOOST_TEST(c.counts[1] == 2u);
+   BOOST_TEST(c.counts[2] == 0u);
+   BOOST_TEST(c.counts[3] == 1u);
+   BOOST_TEST(c.sum == 5121u);
+
+   code_cache_stats stats;
+   BOOST_TEST(stats.compile_latency_ms.counts.size() == code_cache_stats::compile_latency_bounds_ms.size() + 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
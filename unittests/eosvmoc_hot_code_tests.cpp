@@ -0,0 +1,84 @@
+#ifdef EOSIO_EOS_VM_OC_RUNTIME_ENABLED
+
+#include <eosio/chain/webassembly/eos-vm-oc/hot_code_tracker.hpp>
+#include <fc/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+using namespace eosio::chain;
+using namespace eosio::chain::eosvmoc;
+
+namespace {
+   code_tuple make_code(const std::string& name) {
+      return code_tuple{fc::sha256::hash(name), 0};
+   }
+}
+
+BOOST_AUTO_TEST_SUITE(eosvmoc_hot_code_tests)
+
+BOOST_AUTO_TEST_CASE(hottest_codes) {
+   hot_code_tracker tracker;
+   BOOST_TEST(tracker.hottest(10).empty());
+
+   const code_tuple a = make_code("a"), b = make_code("b"), c = make_code("c");
+   for(int i = 0; i < 5; ++i)
+      tracker.record(a);
+   for(int i = 0; i < 10; ++i)
+      tracker.record(b);
+   tracker.record(c);
+
+   BOOST_TEST(tracker.size() == 3u);
+   BOOST_TEST(tracker.count(b) == 10u);
+   BOOST_TEST(tracker.count(make_code("d")) == 0u);
+
+   auto hottest = tracker.hottest(2);
+   BOOST_REQUIRE_EQUAL(hottest.size(), 2u);
+   BOOST_CHECK(hottest[0] == b);
+   BOOST_CHECK(hottest[1] == a);
+   BOOST_TEST(tracker.hottest(10).size() == 3u);
+}
+
+BOOST_AUTO_TEST_CASE(save_and_load) {
+   fc::temp_directory dir;
+   const auto path = dir.path() / "code_cache_hot.bin";
+
+   hot_code_tracker tracker;
+   const code_tuple a = make_code("a"), b = make_code("b"), c = make_code("c");
+   for(int i = 0; i < 8; ++i)
+      tracker.record(a);
+   for(int i = 0; i < 20; ++i)
+      tracker.record(b);
+   tracker.record(c);
+   tracker.save(path, 2);
+
+   // only the saved hottest codes come back, with halved counts so that codes no longer used age out
+   hot_code_tracker loaded;
+   loaded.load(path);
+   BOOST_TEST(loaded.size() == 2u);
+   BOOST_TEST(loaded.count(b) == 10u);
+   BOOST_TEST(loaded.count(a) == 4u);
+   BOOST_TEST(loaded.count(c) == 0u);
+
+   loaded.save(path, 10);
+   hot_code_tracker reloaded;
+   for(int i = 0; i < 3; ++i) {
+      reloaded.load(path);
+      reloaded.save(path, 10);
+   }
+   BOOST_TEST(reloaded.size() == 1u);
+   BOOST_TEST(reloaded.count(b) == 1u);
+
+   // a missing or corrupt file is ignored
+   hot_code_tracker missing;
+   missing.record(a);
+   missing.load(dir.path() / "does_not_exist.bin");
+   BOOST_TEST(missing.size() == 0u);
+
+   std::ofstream(path.generic_string(), std::ofstream::binary | std::ofstream::trunc) << "garbage";
+   hot_code_tracker corrupt;
+   corrupt.load(path);
+   BOOST_TEST(corrupt.size() == 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif
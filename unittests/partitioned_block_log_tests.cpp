@@ -132,6 +132,82 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( test_split_log, T, eosio::testing::testers ) {
    BOOST_CHECK(!chain.fetch_block_by_number(160));
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE( test_fetch_serialized_block, T, eosio::testing::testers ) {
+   fc::temp_directory temp_dir;
+
+   T chain(
+         temp_dir,
+         [](eosio::chain::controller::config& config) {
+            config.blog = eosio::chain::partitioned_blocklog_config{ .archive_dir        = "archive",
+                                                                     .stride             = 20,
+                                                                     .max_retained_files = 5 };
+         },
+         true);
+   chain.produce_blocks(150);
+
+   const auto& control = *chain.control;
+   const std::vector<char> prefix{'a', 'b', 'c'};
+
+   // retained logs, blocks.log, and the reversible blocks in the fork database
+   for (uint32_t num = 41; num <= control.head().block_num(); ++num) {
+      auto b = control.fetch_block_by_number(num);
+      BOOST_REQUIRE(b);
+      std::vector<char> serialized = prefix;
+      BOOST_REQUIRE(control.fetch_serialized_block_by_number(num, serialized));
+      std::vector<char> expected = prefix;
+      const auto packed = fc::raw::pack(*b);
+      expected.insert(expected.end(), packed.begin(), packed.end());
+      BOOST_CHECK_MESSAGE(serialized == expected, "block " << num);
+   }
+
+   // archived and not yet produced blocks are not available
+   std::vector<char> serialized = prefix;
+   BOOST_CHECK(!control.fetch_serialized_block_by_number(40, serialized));
+   BOOST_CHECK(!control.fetch_serialized_block_by_number(control.head().block_num() + 1, serialized));
+   BOOST_CHECK(serialized == prefix);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( test_read_serialized_block_range, T, eosio::testing::testers ) {
+   fc::temp_directory temp_dir;
+
+   T chain(
+         temp_dir,
+         [](eosio::chain::controller::config& config) {
+            config.blog = eosio::chain::partitioned_blocklog_config{ .archive_dir        = "archive",
+                                                                     .stride             = 20,
+                                                                     .max_retained_files = 5 };
+         },
+         true);
+   chain.produce_blocks(150);
+   chain.close();
+
+   eosio::chain::block_log blog(chain.get_config().blocks_dir, chain.get_config().blog);
+   const uint32_t head_num = blog.head()->block_num();
+
+   // retained logs followed by blocks.log, the range ends at the head of the log
+   std::vector<uint32_t> nums;
+   auto n = blog.read_serialized_block_range(41, head_num + 10, [&](uint32_t num, std::span<const char> block) {
+      auto b = blog.read_block_by_num(num);
+      BOOST_REQUIRE(b);
+      const auto packed = fc::raw::pack(*b);
+      BOOST_CHECK_MESSAGE(std::equal(block.begin(), block.end(), packed.begin(), packed.end()), "block " << num);
+      nums.push_back(num);
+      return true;
+   });
+   BOOST_CHECK_EQUAL(n, head_num - 40);
+   BOOST_REQUIRE_EQUAL(nums.size(), n);
+   for (uint32_t i = 0; i < n; ++i)
+      BOOST_CHECK_EQUAL(nums[i], 41 + i);
+
+   // stops when f returns false
+   n = blog.read_serialized_block_range(50, 70, [](uint32_t num, std::span<const char>) { return num < 55; });
+   BOOST_CHECK_EQUAL(n, 6u);
+
+   // archived blocks are not in the log
+   n = blog.read_serialized_block_range(1, 60, [](uint32_t, std::span<const char>) { return true; });
+   BOOST_CHECK_EQUAL(n, 0u);
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE( test_split_log_zero_retained_file, T, eosio::testing::testers ) {
    fc::temp_directory temp_dir;
    T chain(
@@ -171,33 +171,27 @@ struct json_snapshot_suite {
 };
 
 struct threaded_snapshot_suite {
-   using writer_t = ostream_snapshot_writer;
+   using writer_t = threaded_snapshot_writer;
    using reader_t = threaded_snapshot_reader;
 
    //externally opaque type that refers to a snapshot. For this suite: filename on disk. This means snapshot must
    // reside on disk and not in memory like other snapshot_suites
    using snapshot_t = std::filesystem::path;
 
-   using write_storage_t = std::ofstream;
-
    struct writer : public writer_t {
-      writer( const std::shared_ptr<write_storage_t>& storage ) : writer_t(*storage), storage(storage) {}
+      explicit writer( const std::filesystem::path& path ) : writer_t(path), path(path) {}
 
-      std::shared_ptr<write_storage_t> storage;
-      std::filesystem::path            path;
+      std::filesystem::path path;
    };
 
    static auto get_writer() {
       const std::filesystem::path new_snap_path = threaded_snapshot_tempdir.path() / (std::to_string(next_tempfile++) + ".bin");
 
-      std::shared_ptr<writer> new_writer = std::make_shared<writer>(std::make_shared<write_storage_t>(new_snap_path, std::ios::binary));
-      new_writer->path = new_snap_path;
-      return new_writer;
+      return std::make_shared<writer>(new_snap_path);
    }
 
    static auto finalize(const std::shared_ptr<writer>& w) {
       w->finalize();
-      w->storage->flush();
       return w->path;
    }
 
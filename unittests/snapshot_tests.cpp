@@ -2,6 +2,7 @@
 
 #include <eosio/chain/block_log.hpp>
 #include <eosio/chain/global_property_object.hpp>
+#include <eosio/chain/merkle.hpp>
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/testing/tester.hpp>
 #include "snapshot_suites.hpp"
@@ -417,8 +418,8 @@ void compatible_versions_test()
    // 5. add the 3 new snapshot files in git.
    // -------------------------------------------------------------------------------------------------------------
    // Only want to save one snapshot, use Savanna as that is the latest
-   // And skip the threaded_snapshot_suite: its saving-to-file ability isn't implemented and, besides, its snapshot
-   //  creation half just uses the ostream snapshot writer again (using writer_t = ostream_snapshot_writer)
+   // And skip the threaded_snapshot_suite: its saving-to-file ability isn't implemented and it produces the same
+   //  binary format as the buffered_snapshot_suite anyway
    if constexpr (std::is_same_v<TESTER, savanna_tester> && !std::is_same_v<SNAPSHOT_SUITE, threaded_snapshot_suite>) {
       if (save_snapshot)
       {
@@ -652,6 +653,171 @@ BOOST_AUTO_TEST_CASE_TEMPLATE( json_snapshot_validity_test, TESTER, testers )
    remove(json_snap_path);
 }
 
+BOOST_AUTO_TEST_CASE_TEMPLATE( threaded_writer_matches_ostream_writer_test, TESTER, testers )
+{
+   TESTER chain;
+
+   chain.create_account("snapshot"_n);
+   chain.produce_block();
+   chain.set_code("snapshot"_n, test_contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, test_contracts::snapshot_test_abi());
+   chain.produce_block();
+   chain.control->abort_block();
+
+   auto writer_bin = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(writer_bin);
+   const std::string snapshot_bin = buffered_snapshot_suite::finalize(writer_bin);
+
+   auto writer_threaded = threaded_snapshot_suite::get_writer();
+   chain.control->write_snapshot(writer_threaded);
+   const std::filesystem::path snapshot_threaded_path = threaded_snapshot_suite::finalize(writer_threaded);
+
+   std::ifstream threaded_in(snapshot_threaded_path, std::ios::binary);
+   const std::string snapshot_threaded((std::istreambuf_iterator<char>(threaded_in)), std::istreambuf_iterator<char>());
+
+   // sections are written concurrently but must be stitched into the exact same byte stream
+   BOOST_REQUIRE(snapshot_bin == snapshot_threaded);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( compressed_snapshot_test, TESTER, testers )
+{
+   fc::temp_directory tempdir;
+   TESTER chain;
+
+   chain.create_account("snapshot"_n);
+   chain.produce_block();
+   chain.set_code("snapshot"_n, test_contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, test_contracts::snapshot_test_abi());
+   chain.produce_block();
+   chain.control->abort_block();
+
+   const std::filesystem::path plain_path = tempdir.path() / "plain.bin";
+   const std::filesystem::path compressed_path = tempdir.path() / "compressed.bin";
+   const std::filesystem::path converted_path = tempdir.path() / "converted.bin";
+
+   {
+      auto writer = std::make_shared<threaded_snapshot_writer>(plain_path);
+      chain.control->write_snapshot(writer);
+      writer->finalize();
+   }
+   {
+      auto writer = std::make_shared<threaded_snapshot_writer>(compressed_path, snapshot_compression::zlib);
+      chain.control->write_snapshot(writer);
+      writer->finalize();
+   }
+   BOOST_REQUIRE_LT(std::filesystem::file_size(compressed_path), std::filesystem::file_size(plain_path));
+
+   auto reader = std::make_shared<threaded_snapshot_reader>(compressed_path);
+   BOOST_REQUIRE(reader->compression() == snapshot_compression::zlib);
+   BOOST_REQUIRE(!reader->section_index().empty());
+
+   // a chain restored from the compressed snapshot is identical
+   snapshotted_tester snap_chain(chain.get_config(), reader, 0);
+   BOOST_REQUIRE_EQUAL(chain.control->calculate_integrity_hash().str(), snap_chain.control->calculate_integrity_hash().str());
+
+   // converting back yields the byte-identical uncompressed snapshot
+   convert_snapshot(compressed_path, converted_path, snapshot_compression::none, 2);
+   std::ifstream plain_in(plain_path, std::ios::binary);
+   std::ifstream converted_in(converted_path, std::ios::binary);
+   const std::string plain((std::istreambuf_iterator<char>(plain_in)), std::istreambuf_iterator<char>());
+   const std::string converted((std::istreambuf_iterator<char>(converted_in)), std::istreambuf_iterator<char>());
+   BOOST_REQUIRE(plain == converted);
+}
+
+#ifndef _WIN32
+BOOST_AUTO_TEST_CASE_TEMPLATE( background_snapshot_test, TESTER, testers )
+{
+   fc::temp_directory tempdir;
+   auto config = tester::default_config(tempdir);
+   config.first.db_map_mode = pinnable_mapped_file::map_mode::heap;
+   TESTER chain(config.first, config.second);
+
+   chain.create_account("snapshot"_n);
+   chain.produce_block();
+   chain.set_code("snapshot"_n, test_contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, test_contracts::snapshot_test_abi());
+   chain.produce_block();
+   chain.control->abort_block();
+
+   BOOST_REQUIRE(chain.control->can_write_snapshot_in_background());
+
+   auto writer_bin = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(writer_bin);
+   const std::string snapshot_bin = buffered_snapshot_suite::finalize(writer_bin);
+
+   const std::filesystem::path background_path = tempdir.path() / "background.bin";
+   std::future<void> written = chain.control->write_snapshot_in_background(background_path);
+
+   // state changes made while the forked process writes must not leak into the snapshot
+   chain.push_action("snapshot"_n, "increment"_n, "snapshot"_n, mutable_variant_object()("value", 1));
+   chain.produce_block();
+   chain.control->abort_block();
+
+   written.get();
+
+   std::ifstream background_in(background_path, std::ios::binary);
+   const std::string snapshot_background((std::istreambuf_iterator<char>(background_in)), std::istreambuf_iterator<char>());
+   BOOST_REQUIRE(snapshot_bin == snapshot_background);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE_TEMPLATE( section_integrity_hashes_test, TESTER, testers )
+{
+   TESTER chain;
+
+   chain.create_account("snapshot"_n);
+   chain.produce_block();
+   chain.set_code("snapshot"_n, test_contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, test_contracts::snapshot_test_abi());
+   chain.produce_block();
+   chain.push_action("snapshot"_n, "increment"_n, "snapshot"_n, mutable_variant_object()("value", 1));
+   chain.produce_block();
+   chain.control->abort_block();
+
+   auto writer = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(writer);
+   auto snapshot = buffered_snapshot_suite::finalize(writer);
+   snapshotted_tester snap_chain(chain.get_config(), buffered_snapshot_suite::get_reader(snapshot), 0);
+
+   const snapshot_section_hashes hashes = chain.control->calculate_section_integrity_hashes();
+   BOOST_REQUIRE(!hashes.sections.empty());
+   BOOST_REQUIRE_EQUAL(hashes.sections.front().name, eosio::chain::detail::snapshot_section_traits<chain_snapshot_header>::section_name());
+
+   std::vector<digest_type> digests;
+   for(const snapshot_section_hash& section : hashes.sections)
+      digests.push_back(section.hash);
+   BOOST_REQUIRE_EQUAL(hashes.root.str(), calculate_merkle(digests).str());
+
+   // a chain restored from a snapshot has identical sections
+   const snapshot_section_hashes snap_hashes = snap_chain.control->calculate_section_integrity_hashes();
+   BOOST_REQUIRE_EQUAL(hashes.root.str(), snap_hashes.root.str());
+
+   // a change to a contract row only changes the contract row section. the row is changed directly, an action would
+   // also change the account sequences, resource usage and block related sections
+   const auto& kv_idx = chain.control->db().get_index<key_value_index, by_scope_primary>();
+   const auto row = std::find_if(kv_idx.begin(), kv_idx.end(), [&](const key_value_object& o) {
+      return chain.control->db().get<table_id_object>(o.t_id).code == "snapshot"_n;
+   });
+   BOOST_REQUIRE(row != kv_idx.end());
+   chain.control->mutable_db().modify(*row, [](key_value_object& o) { o.payer = config::system_account_name; });
+
+   const snapshot_section_hashes new_hashes = chain.control->calculate_section_integrity_hashes();
+   BOOST_REQUIRE_EQUAL(hashes.sections.size(), new_hashes.sections.size());
+   BOOST_REQUIRE_NE(hashes.root.str(), new_hashes.root.str());
+   const auto kv_section = eosio::chain::detail::snapshot_section_traits<key_value_object>::section_name();
+   bool kv_section_found = false;
+   for(size_t i = 0; i < hashes.sections.size(); ++i) {
+      BOOST_REQUIRE_EQUAL(hashes.sections[i].name, new_hashes.sections[i].name);
+      if(hashes.sections[i].name == kv_section) {
+         kv_section_found = true;
+         BOOST_REQUIRE_NE(hashes.sections[i].hash.str(), new_hashes.sections[i].hash.str());
+      } else {
+         BOOST_REQUIRE_EQUAL(hashes.sections[i].hash.str(), new_hashes.sections[i].hash.str());
+      }
+   }
+   BOOST_REQUIRE(kv_section_found);
+}
+
 template<typename TESTER, typename SNAPSHOT_SUITE>
 void jumbo_row_test()
 {
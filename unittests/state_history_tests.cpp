@@ -4,6 +4,7 @@
 #include <contracts.hpp>
 #include <test_contracts.hpp>
 #include <eosio/state_history/create_deltas.hpp>
+#include <eosio/state_history/filter.hpp>
 #include <eosio/state_history/log_catalog.hpp>
 #include <eosio/state_history/trace_converter.hpp>
 #include <eosio/testing/tester.hpp>
@@ -15,8 +16,10 @@
 
 #include <eosio/stream.hpp>
 #include <eosio/ship_protocol.hpp>
+#include <boost/iostreams/device/array.hpp>
 #include <boost/iostreams/device/back_inserter.hpp>
 #include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/stream_buffer.hpp>
 
 using namespace eosio::chain;
 using namespace eosio::testing;
@@ -611,6 +614,153 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_deltas_resources_history, T, table_deltas_tes
       BOOST_CHECK(std::any_of(partial_txns.begin(), partial_txns.end(), contains_transaction_extensions));
    }
 
+   BOOST_AUTO_TEST_CASE_TEMPLATE(test_filtered_deltas_and_traces, T, testers) {
+      T chain;
+      namespace bio = boost::iostreams;
+
+      eosio::state_history::trace_converter converter;
+      std::vector<char> traces_bin;
+      std::vector<char> deltas_bin;
+      chain.control->applied_transaction().connect([&](std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t) {
+         converter.add_transaction(std::get<0>(t), std::get<1>(t));
+      });
+      chain.control->block_start().connect([&](uint32_t) {
+         converter.cached_traces.clear();
+         converter.onblock_trace.reset();
+      });
+      chain.control->accepted_block().connect([&](block_signal_params t) {
+         traces_bin.clear();
+         bio::filtering_ostreambuf traces_buf(bio::back_inserter(traces_bin));
+         converter.pack(traces_buf, false, std::get<0>(t));
+         deltas_bin.clear();
+         bio::filtering_ostreambuf deltas_buf(bio::back_inserter(deltas_bin));
+         eosio::state_history::pack_deltas(deltas_buf, chain.control->db(), false);
+      });
+
+      chain.create_accounts({"tester"_n, "other"_n});
+      for(const name account : {"tester"_n, "other"_n}) {
+         chain.set_code(account, test_contracts::get_table_test_wasm());
+         chain.set_abi(account, test_contracts::get_table_test_abi());
+      }
+      chain.produce_block();
+
+      chain.push_action("tester"_n, "addnumobj"_n, "tester"_n, mutable_variant_object()("input", 2));
+      chain.push_action("other"_n, "addnumobj"_n, "other"_n, mutable_variant_object()("input", 3));
+      chain.push_action("tester"_n, "addhashobj"_n, "tester"_n, mutable_variant_object()("hashinput", "hello"));
+      chain.produce_block();
+
+      const eosio::state_history::log_entry_filter filter({{.code = "tester"_n}}, {{.receiver = "tester"_n, .action = "addnumobj"_n}});
+
+      auto row_code = [](const eosio::state_history::row_pair& row) {
+         fc::datastream<const char*> ds(row.second.data(), row.second.size());
+         fc::unsigned_int version;
+         uint64_t code;
+         fc::raw::unpack(ds, version);
+         fc::raw::unpack(ds, code);
+         return name(code);
+      };
+      auto unpack_deltas = [](const std::vector<char>& bin) {
+         fc::datastream<const char*> ds(bin.data(), bin.size());
+         std::vector<eosio::state_history::table_delta> deltas;
+         fc::raw::unpack(ds, deltas);
+         return deltas;
+      };
+
+      bool other_rows = false;
+      for(const eosio::state_history::table_delta& delta : unpack_deltas(deltas_bin))
+         if(delta.name == "contract_row")
+            for(const auto& row : delta.rows.obj)
+               other_rows = other_rows || row_code(row) == "other"_n;
+      BOOST_REQUIRE(other_rows);
+
+      bio::stream_buffer<bio::array_source> deltas_source(deltas_bin.data(), deltas_bin.size());
+      const std::vector<char> filtered_deltas_bin = filter.filter_deltas(deltas_source);
+      const std::vector<eosio::state_history::table_delta> filtered_deltas = unpack_deltas(filtered_deltas_bin);
+      BOOST_REQUIRE(std::any_of(filtered_deltas.begin(), filtered_deltas.end(), [](const auto& d) { return d.name == "contract_row"; }));
+      for(const eosio::state_history::table_delta& delta : filtered_deltas) {
+         BOOST_REQUIRE(delta.name.starts_with("contract_"));
+         BOOST_REQUIRE(delta.rows.obj.size());
+         for(const auto& row : delta.rows.obj)
+            BOOST_REQUIRE_EQUAL(row_code(row), "tester"_n);
+      }
+
+      auto unpack_traces = [](const std::vector<char>& bin) {
+         std::vector<eosio::ship_protocol::transaction_trace> traces;
+         eosio::input_stream traces_stream{bin.data(), bin.data() + bin.size()};
+         BOOST_REQUIRE_NO_THROW(from_bin(traces, traces_stream));
+         return traces;
+      };
+      BOOST_REQUIRE_EQUAL(unpack_traces(traces_bin).size(), 4u); //onblock and the three actions
+
+      bio::stream_buffer<bio::array_source> traces_source(traces_bin.data(), traces_bin.size());
+      const std::vector<eosio::ship_protocol::transaction_trace> filtered_traces = unpack_traces(filter.filter_traces(traces_source));
+      BOOST_REQUIRE_EQUAL(filtered_traces.size(), 1u);
+      const auto& action_traces = std::get<eosio::ship_protocol::transaction_trace_v0>(filtered_traces[0]).action_traces;
+      BOOST_REQUIRE_EQUAL(action_traces.size(), 1u);
+      std::visit([](const auto& at) {
+         BOOST_REQUIRE_EQUAL(at.receiver.to_string(), "tester");
+         BOOST_REQUIRE_EQUAL(at.act.name.to_string(), "addnumobj");
+      }, action_traces[0]);
+   }
+
+   BOOST_AUTO_TEST_CASE(test_filtered_v0_traces) {
+      //transaction traces whose action_trace_v0 carry no return_value, as in logs written before action return values
+      std::vector<char> traces_bin;
+      auto append = [&](const auto& v) {
+         const std::vector<char> packed = fc::raw::pack(v);
+         traces_bin.insert(traces_bin.end(), packed.begin(), packed.end());
+      };
+      auto append_trace = [&](name receiver, name action) {
+         append(fc::unsigned_int(0));                                             //transaction_trace_v0
+         append(transaction_id_type());
+         append(uint8_t(0));                                                      //status
+         append(uint32_t(100));                                                   //cpu_usage_us
+         append(fc::unsigned_int(12));                                            //net_usage_words
+         append(int64_t(50));                                                     //elapsed
+         append(uint64_t(96));                                                    //net_usage
+         append(false);                                                           //scheduled
+         append(fc::unsigned_int(1));                                             //action_traces
+         append(fc::unsigned_int(0));                                             //action_trace_v0
+         append(fc::unsigned_int(1));                                             //action_ordinal
+         append(fc::unsigned_int(0));                                             //creator_action_ordinal
+         append(false);                                                           //receipt
+         append(receiver.to_uint64_t());
+         append(receiver.to_uint64_t());                                          //account
+         append(action.to_uint64_t());
+         append(std::vector<permission_level>{{receiver, config::active_name}});
+         append(std::vector<char>{'d', 'a', 't', 'a'});
+         append(false);                                                           //context_free
+         append(int64_t(20));                                                     //elapsed
+         append(std::string("console"));
+         append(fc::unsigned_int(0));                                             //account_ram_deltas
+         append(false);                                                           //except
+         append(false);                                                           //error_code
+         for(unsigned i = 0; i < 5; ++i)
+            append(false);                     //account_ram_delta, except, error_code, failed_dtrx_trace, partial
+      };
+      append(fc::unsigned_int(3));
+      append_trace("other"_n, "addnumobj"_n);
+      append_trace("tester"_n, "addnumobj"_n);
+      append_trace("tester"_n, "addhashobj"_n);
+
+      const eosio::state_history::log_entry_filter filter({}, {{.receiver = "tester"_n, .action = "addnumobj"_n}});
+      namespace bio = boost::iostreams;
+      bio::stream_buffer<bio::array_source> traces_source(traces_bin.data(), traces_bin.size());
+      const std::vector<char> filtered_bin = filter.filter_traces(traces_source);
+
+      std::vector<eosio::ship_protocol::transaction_trace> filtered_traces;
+      eosio::input_stream filtered_stream{filtered_bin.data(), filtered_bin.data() + filtered_bin.size()};
+      BOOST_REQUIRE_NO_THROW(from_bin(filtered_traces, filtered_stream));
+      BOOST_REQUIRE_EQUAL(filtered_stream.remaining(), 0u);
+      BOOST_REQUIRE_EQUAL(filtered_traces.size(), 1u);
+      const auto& action_traces = std::get<eosio::ship_protocol::transaction_trace_v0>(filtered_traces[0]).action_traces;
+      BOOST_REQUIRE_EQUAL(action_traces.size(), 1u);
+      const auto& at = std::get<eosio::ship_protocol::action_trace_v0>(action_traces[0]);
+      BOOST_REQUIRE_EQUAL(at.receiver.to_string(), "tester");
+      BOOST_REQUIRE_EQUAL(at.act.name.to_string(), "addnumobj");
+      BOOST_REQUIRE_EQUAL(std::string(at.console), "console");
+   }
+
 struct state_history_tester_logs  {
    state_history_tester_logs(const std::filesystem::path& dir, const eosio::state_history::state_history_log_config& config)
       : traces_log(dir, config, "trace_history") , chain_state_log(dir, config, "chain_state_history") {}
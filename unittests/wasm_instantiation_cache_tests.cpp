@@ -0,0 +1,96 @@
+#include <eosio/chain/wasm_instantiation_cache.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace eosio::chain;
+
+namespace {
+   struct test_module : wasm_instantiated_module_interface {
+      void apply(apply_context&) override {}
+   };
+
+   digest_type make_hash(const std::string& name) {
+      return digest_type::hash(name);
+   }
+
+   // builds a module charged size bytes, counting the builds
+   struct builder {
+      uint64_t size;
+      int&     builds;
+      std::pair<wasm_instantiation_cache::module_ptr, uint64_t> operator()() const {
+         ++builds;
+         return {std::make_unique<test_module>(), size};
+      }
+   };
+}
+
+BOOST_AUTO_TEST_SUITE(wasm_instantiation_cache_tests)
+
+BOOST_AUTO_TEST_CASE(build_once) {
+   wasm_instantiation_cache cache(1024);
+   const digest_type a = make_hash("a");
+   int builds = 0;
+
+   const auto& m = cache.get_or_build(a, 0, 0, true, builder{100, builds});
+   BOOST_TEST(!!m);
+   BOOST_TEST(&cache.get_or_build(a, 0, 0, false, builder{100, builds}) == &m);
+   BOOST_TEST(builds == 1);
+   BOOST_TEST(cache.contains(a, 0, 0));
+   BOOST_TEST(!cache.contains(a, 0, 1));
+   BOOST_TEST(cache.bytes() == 100u);
+   BOOST_TEST(cache.size() == 1u);
+}
+
+BOOST_AUTO_TEST_CASE(evict_least_used) {
+   wasm_instantiation_cache cache(100);
+   const digest_type a = make_hash("a"), b = make_hash("b"), c = make_hash("c");
+   int builds = 0;
+
+   for(int i = 0; i < 3; ++i)
+      cache.get_or_build(a, 0, 0, false, builder{40, builds});
+   cache.get_or_build(b, 0, 0, false, builder{40, builds});
+   cache.evict_to_fit();
+   BOOST_TEST(cache.size() == 2u);
+
+   // c goes over the limit; b was used less than a, and c itself is kept
+   const auto& mc = cache.get_or_build(c, 0, 0, false, builder{40, builds});
+   BOOST_TEST(cache.bytes() == 120u);
+   cache.evict_to_fit(&mc);
+   BOOST_TEST(cache.contains(a, 0, 0));
+   BOOST_TEST(!cache.contains(b, 0, 0));
+   BOOST_TEST(cache.contains(c, 0, 0));
+   BOOST_TEST(cache.bytes() == 80u);
+   BOOST_TEST(cache.evictions() == 1u);
+
+   // a's count was halved, so once c is used more, a is evicted next
+   for(int i = 0; i < 3; ++i)
+      cache.get_or_build(c, 0, 0, false, builder{40, builds});
+   const auto& mb = cache.get_or_build(b, 0, 0, false, builder{40, builds});
+   cache.evict_to_fit(&mb);
+   BOOST_TEST(!cache.contains(a, 0, 0));
+   BOOST_TEST(cache.contains(b, 0, 0));
+   BOOST_TEST(cache.contains(c, 0, 0));
+   BOOST_TEST(builds == 4);
+}
+
+BOOST_AUTO_TEST_CASE(evict_replaced_code_at_lib) {
+   wasm_instantiation_cache cache(1024);
+   const digest_type a = make_hash("a"), b = make_hash("b");
+   int builds = 0;
+   cache.get_or_build(a, 0, 0, false, builder{100, builds});
+   cache.get_or_build(b, 0, 0, false, builder{100, builds});
+
+   cache.code_block_num_last_used(a, 0, 0, 10);
+   std::vector<digest_type> evicted;
+   auto on_evict = [&](const digest_type& code_hash, uint8_t) { evicted.push_back(code_hash); };
+   cache.current_lib(9, on_evict);
+   BOOST_TEST(evicted.empty());
+   cache.current_lib(10, on_evict);
+   BOOST_REQUIRE_EQUAL(evicted.size(), 1u);
+   BOOST_TEST(evicted[0] == a);
+   BOOST_TEST(!cache.contains(a, 0, 0));
+   BOOST_TEST(cache.contains(b, 0, 0));
+   BOOST_TEST(cache.bytes() == 100u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()